@@ -13,15 +13,38 @@
 #include <string>
 #include <unordered_map>
 #include "../../render/objects/shaders/shaderpack.h"
+#include "../../utils/thread_pool.h"
 
 namespace nova {
+    /*!
+     * \brief Everything read from a shaderpack's files, before any of it goes to the driver
+     */
+    struct shaderpack_sources {
+        std::string name;
+        nlohmann::json shaders_json;
+        std::vector<shader_definition> shaders;
+    };
+
+    /*!
+     * \brief Reads and preprocesses every shader in the shaderpack with the given name
+     *
+     * Doesn't touch OpenGL, so it can run on any thread. Making a shaderpack out of what it reads does need the
+     * render thread
+     *
+     * \param shaderpack_name The name of the shaderpack to load
+     * \param workers The threads to read and preprocess the shaders on. Don't call this from one of their own tasks
+     * \return The shaders that could be read. The ones that couldn't are logged and left out
+     */
+    shaderpack_sources load_shaderpack_sources(const std::string &shaderpack_name, thread_pool &workers);
+
     /*!
      * \brief Loads the shaderpack with the given name
      *
      * \param shaderpack_name The name of the shaderpack to load
+     * \param workers The threads to read and preprocess the shaders on
      * \return The loaded shaderpack
      */
-    shaderpack load_shaderpack(const std::string &shaderpack_name);
+    shaderpack load_shaderpack(const std::string &shaderpack_name, thread_pool &workers);
 }
 
 #endif //RENDERER_LOADERS_H
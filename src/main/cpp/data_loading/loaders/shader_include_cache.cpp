@@ -0,0 +1,320 @@
+/*!
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include "shader_include_cache.h"
+#include "loaders.h"
+#include "shader_loading.h"
+#include "zip_archive.h"
+
+namespace nova {
+    /*!
+     * \brief Takes the "." and "dir/.." bits out of a path, so that every way of naming a file gets the same cache entry
+     */
+    static std::string normalize_path(const std::string &path) {
+        std::vector<std::string> parts;
+        std::size_t part_start = 0;
+        while(part_start <= path.size()) {
+            auto part_end = std::min(path.find('/', part_start), path.size());
+            auto part = path.substr(part_start, part_end - part_start);
+
+            if(part == "..") {
+                if(!parts.empty() && !parts.back().empty() && parts.back() != "..") {
+                    parts.pop_back();
+                } else {
+                    parts.push_back(part);
+                }
+            } else if(part != "." && !(part.empty() && !parts.empty())) {
+                parts.push_back(part);
+            }
+
+            part_start = part_end + 1;
+        }
+
+        std::string normalized;
+        for(std::size_t i = 0; i < parts.size(); i++) {
+            normalized += (i == 0 ? "" : "/") + parts[i];
+        }
+
+        // A leading empty part is the root of an absolute path
+        return normalized.empty() && !path.empty() && path[0] == '/' ? "/" : normalized;
+    }
+
+    static bool is_blank(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    /*!
+     * \brief The index of the first character in line at or after start that isn't a space or tab, or the size of the
+     * line if there isn't one
+     */
+    static std::size_t skip_blanks(const string_ref &line, std::size_t start) {
+        while(start < line.size && is_blank(line.data[start])) {
+            start++;
+        }
+        return start;
+    }
+
+    static bool starts_with(const string_ref &line, std::size_t start, const char* prefix) {
+        auto prefix_length = std::strlen(prefix);
+        return line.size - start >= prefix_length && std::memcmp(line.data + start, prefix, prefix_length) == 0;
+    }
+
+    static bool contains(const string_ref &line, std::size_t start, const char* needle) {
+        const char* end = line.data + line.size;
+        return std::search(line.data + start, end, needle, needle + std::strlen(needle)) != end;
+    }
+
+    /*!
+     * \brief Splits a preprocessor directive like `#ifndef FOO` into its name and its first argument. Lines that aren't
+     * directives get an empty name
+     */
+    static void parse_directive(const string_ref &line, std::string &name, std::string &argument) {
+        name.clear();
+        argument.clear();
+
+        auto hash = skip_blanks(line, 0);
+        if(hash == line.size || line.data[hash] != '#') {
+            return;
+        }
+
+        auto name_start = skip_blanks(line, hash + 1);
+        auto name_end = name_start;
+        while(name_end < line.size && !is_blank(line.data[name_end])) {
+            name_end++;
+        }
+        name.assign(line.data + name_start, name_end - name_start);
+
+        auto argument_start = skip_blanks(line, name_end);
+        auto argument_end = argument_start;
+        while(argument_end < line.size && !is_blank(line.data[argument_end]) && line.data[argument_end] != '/') {
+            argument_end++;
+        }
+        argument.assign(line.data + argument_start, argument_end - argument_start);
+    }
+
+    /*!
+     * \brief Finds the lines that aren't blank or comments. Comments that start partway through a line with code on it
+     * don't count, since an include guard never looks like that
+     */
+    static std::vector<std::uint32_t> find_code_lines(const shader_source_file &file) {
+        std::vector<std::uint32_t> code_lines;
+        bool in_block_comment = false;
+        for(std::uint32_t i = 0; i < file.get_num_lines(); i++) {
+            auto line = file.get_line(i);
+            auto first_char = skip_blanks(line, 0);
+
+            if(in_block_comment) {
+                in_block_comment = !contains(line, 0, "*/");
+                continue;
+            }
+
+            if(first_char == line.size || starts_with(line, first_char, "//")) {
+                continue;
+            }
+
+            if(starts_with(line, first_char, "/*")) {
+                in_block_comment = !contains(line, first_char + 2, "*/");
+                continue;
+            }
+
+            code_lines.push_back(i);
+        }
+
+        return code_lines;
+    }
+
+    static std::string find_include_guard(const shader_source_file &file) {
+        auto code_lines = find_code_lines(file);
+        if(code_lines.size() < 3) {
+            return "";
+        }
+
+        std::string ifndef, guard, define, defined_macro, endif, unused;
+        parse_directive(file.get_line(code_lines[0]), ifndef, guard);
+        parse_directive(file.get_line(code_lines[1]), define, defined_macro);
+        parse_directive(file.get_line(code_lines.back()), endif, unused);
+
+        if(ifndef != "ifndef" || define != "define" || guard != defined_macro || endif != "endif" || guard.empty()) {
+            return "";
+        }
+
+        // The #endif at the bottom has to be the one for the #ifndef at the top, or the guard doesn't cover the file
+        int depth = 0;
+        std::string directive, argument;
+        for(std::size_t i = 0; i + 1 < code_lines.size(); i++) {
+            parse_directive(file.get_line(code_lines[i]), directive, argument);
+            if(directive == "if" || directive == "ifdef" || directive == "ifndef") {
+                depth++;
+            } else if(directive == "endif") {
+                depth--;
+                if(depth == 0) {
+                    return "";
+                }
+            }
+        }
+
+        return guard;
+    }
+
+    shader_include_cache::shader_include_cache(std::shared_ptr<const zip_archive> archive, std::string archive_path,
+                                               std::string archive_root) :
+            archive(std::move(archive)), archive_path(std::move(archive_path)), archive_root(std::move(archive_root)) {}
+
+    std::shared_ptr<const shader_source_file> shader_include_cache::get_file(const std::string &path) {
+        auto normalized_path = normalize_path(path);
+        {
+            std::lock_guard<std::mutex> lock(files_lock);
+            auto file = files.find(normalized_path);
+            if(file != files.end()) {
+                return file->second;
+            }
+        }
+
+        std::string text;
+        if(!read_text(normalized_path, text)) {
+            return nullptr;
+        }
+
+        auto file = parse_file(std::move(text), normalized_path);
+
+        // Someone else might have read it while we were, in which case everyone should use their copy
+        std::lock_guard<std::mutex> lock(files_lock);
+        num_files_read++;
+        return files.emplace(normalized_path, std::move(file)).first->second;
+    }
+
+    std::shared_ptr<const shader_source_file> shader_include_cache::add_file(std::istream &stream, const std::string &path) {
+        std::string text{std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+        std::shared_ptr<const shader_source_file> file = parse_file(std::move(text), path);
+
+        std::lock_guard<std::mutex> lock(files_lock);
+        num_files_read++;
+        files[path] = file;
+        return file;
+    }
+
+    bool shader_include_cache::read_binary_file(const std::string &path, std::string &data) const {
+        return read_text(normalize_path(path), data, true);
+    }
+
+    bool shader_include_cache::read_text(const std::string &path, std::string &text, bool binary) const {
+        if(archive) {
+            // Anything outside the zip's folder can't be in the zip
+            if(path.compare(0, archive_path.size(), archive_path) != 0) {
+                return false;
+            }
+            return archive->read_file(archive_root + path.substr(archive_path.size()), text);
+        }
+
+        std::ifstream stream(path, binary ? std::ios::in | std::ios::binary : std::ios::in);
+        if(!stream.good()) {
+            return false;
+        }
+        text.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    std::shared_ptr<shader_source_file> shader_include_cache::parse_file(std::string text, const std::string &path) {
+        auto file = std::make_shared<shader_source_file>(path, std::move(text));
+
+        std::string directive, argument;
+        for(std::uint32_t i = 0; i < file->get_num_lines(); i++) {
+            auto line = file->get_line(i);
+            if(starts_with(line, 0, "#include")) {
+                auto line_text = line.to_string();
+                file->directives.push_back({i, get_included_file_path(path, get_filename_from_include(line_text))});
+                continue;
+            }
+
+            parse_directive(line, directive, argument);
+            if(directive == "pragma" && argument == "once") {
+                file->pragma_once = true;
+                file->directives.push_back({i, ""});
+            }
+        }
+
+        file->include_guard = find_include_guard(*file);
+
+        return file;
+    }
+
+    void shader_include_cache::read_includes(const std::shared_ptr<const shader_source_file> &file) {
+        std::unordered_set<std::string> seen = {file->path};
+        std::vector<std::shared_ptr<const shader_source_file>> to_read = {file};
+        while(!to_read.empty()) {
+            auto including_file = to_read.back();
+            to_read.pop_back();
+
+            for(const auto& directive : including_file->directives) {
+                if(directive.included_path.empty() || !seen.insert(directive.included_path).second) {
+                    continue;
+                }
+
+                auto included_file = get_file(directive.included_path);
+                if(included_file) {
+                    to_read.push_back(included_file);
+                }
+            }
+        }
+    }
+
+    shader_source shader_include_cache::expand(const std::shared_ptr<const shader_source_file> &file) {
+        expansion_state state;
+        shader_source source;
+        expand(file, state, source);
+        return source;
+    }
+
+    void shader_include_cache::expand(const std::shared_ptr<const shader_source_file> &file, expansion_state &state,
+                                      shader_source &source) {
+        if(file->pragma_once && !state.included_once.insert(file->path).second) {
+            return;
+        }
+
+        if(!file->include_guard.empty() && !state.defined_guards.insert(file->include_guard).second) {
+            return;
+        }
+
+        if(std::find(state.include_stack.begin(), state.include_stack.end(), file->path) != state.include_stack.end()) {
+            std::string cycle;
+            for(const auto& including_file : state.include_stack) {
+                cycle += including_file + " -> ";
+            }
+            throw std::runtime_error("Include cycle: " + cycle + file->path + ". Use #pragma once or an include guard");
+        }
+
+        state.include_stack.push_back(file->path);
+
+        // Everything between the directives goes in as-is
+        auto file_id = source.add_file(file);
+        std::uint32_t next_line = 0;
+        for(const auto& directive : file->directives) {
+            source.add_lines(file_id, next_line, directive.line);
+            next_line = directive.line + 1;
+
+            if(!directive.included_path.empty()) {
+                auto included_file = get_file(directive.included_path);
+                if(!included_file) {
+                    throw std::runtime_error("Could not load included file " + directive.included_path);
+                }
+
+                expand(included_file, state, source);
+            }
+        }
+        source.add_lines(file_id, next_line, (std::uint32_t) file->get_num_lines());
+
+        state.include_stack.pop_back();
+    }
+
+    std::size_t shader_include_cache::get_num_files_read() const {
+        std::lock_guard<std::mutex> lock(files_lock);
+        return num_files_read;
+    }
+}
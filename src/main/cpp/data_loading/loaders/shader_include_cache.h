@@ -0,0 +1,140 @@
+/*!
+ * \brief Reads shader files and expands their #includes, reading each file only once
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_SHADER_INCLUDE_CACHE_H
+#define RENDERER_SHADER_INCLUDE_CACHE_H
+
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "shader_source_structs.h"
+
+namespace nova {
+    class zip_archive;
+
+    /*!
+     * \brief Every shader file read while loading a shaderpack
+     *
+     * Most shaderpacks have a few headers that every shader includes, sometimes through several other headers. Without
+     * this, each of those would be opened, read and split into lines again for every stage of every shader
+     *
+     * Make one of these per shaderpack load and throw it away afterwards, so that editing a file and reloading the pack
+     * picks up the change
+     *
+     * Several threads can read and expand files at once. If two of them ask for the same new file at the same time
+     * it may be read twice, but they both get the same copy of it back
+     */
+    class shader_include_cache {
+    public:
+        /*!
+         * \brief Makes a cache that reads files from disk
+         */
+        shader_include_cache() = default;
+
+        /*!
+         * \brief Makes a cache that reads files from a zip file instead of from disk
+         *
+         * Files are still asked for by the path they'd have if the zip was a folder, so #includes resolve the same way
+         * for both
+         *
+         * \param archive The zip file to read from
+         * \param archive_path The path the zip file stands in for, like "shaderpacks/pack.zip/"
+         * \param archive_root Where that path is in the zip. Usually empty, but some zips have everything in a folder
+         */
+        shader_include_cache(std::shared_ptr<const zip_archive> archive, std::string archive_path, std::string archive_root);
+
+        /*!
+         * \brief Returns a file, reading it if this is the first time anyone's asked for it
+         *
+         * \param path The path to the file
+         * \return The file, or nullptr if it can't be read
+         */
+        std::shared_ptr<const shader_source_file> get_file(const std::string &path);
+
+        /*!
+         * \brief Reads a file from a stream and remembers it as the file at the given path
+         */
+        std::shared_ptr<const shader_source_file> add_file(std::istream &stream, const std::string &path);
+
+        /*!
+         * \brief Reads a file that isn't shader source, like a SPIR-V module, from wherever this cache reads files from.
+         * It isn't parsed or kept
+         *
+         * \param path The path to the file
+         * \param data Where to put the file's bytes
+         * \return False if the file can't be read
+         */
+        bool read_binary_file(const std::string &path, std::string &data) const;
+
+        /*!
+         * \brief Reads everything that a file includes, and everything they include, without expanding anything
+         *
+         * #expand reads files as it needs them, so this is only useful for timing reading files and expanding them
+         * separately. Files that can't be read are skipped, and #expand says so when it gets to them
+         */
+        void read_includes(const std::shared_ptr<const shader_source_file> &file);
+
+        /*!
+         * \brief Makes the full source of a shader, with the contents of every included file in place of its #include
+         *
+         * A file with `#pragma once` is only included the first time. A file with an include guard is skipped if its
+         * guard macro was already defined by an earlier include. Files that include themselves without either of those
+         * would go on forever, so they throw a std::runtime_error that says how they got there
+         *
+         * \param file The shader to expand
+         * \return The shader's lines, and the lines of everything it includes
+         */
+        shader_source expand(const std::shared_ptr<const shader_source_file> &file);
+
+        /*!
+         * \brief How many files have been read from disk or from the zip file. Mostly so you can see the cache doing its job
+         */
+        std::size_t get_num_files_read() const;
+
+    private:
+        std::unordered_map<std::string, std::shared_ptr<const shader_source_file>> files;
+
+        std::size_t num_files_read = 0;
+
+        std::shared_ptr<const zip_archive> archive;
+        std::string archive_path;
+        std::string archive_root;
+
+        /*!
+         * \brief Guards files and num_files_read. Files are read and parsed without holding it
+         */
+        mutable std::mutex files_lock;
+
+        /*!
+         * \brief Gets a file's text from disk or the zip file
+         *
+         * \param binary True to leave line endings alone. Files in the zip file are always read as they are
+         * \return False if the file isn't there
+         */
+        bool read_text(const std::string &path, std::string &text, bool binary = false) const;
+
+        static std::shared_ptr<shader_source_file> parse_file(std::string text, const std::string &path);
+
+        /*!
+         * \brief What one call to #expand has seen so far
+         */
+        struct expansion_state {
+            std::vector<std::string> include_stack;
+            std::unordered_set<std::string> included_once;
+            std::unordered_set<std::string> defined_guards;
+        };
+
+        void expand(const std::shared_ptr<const shader_source_file> &file, expansion_state &state, shader_source &source);
+    };
+}
+
+#endif //RENDERER_SHADER_INCLUDE_CACHE_H
@@ -5,13 +5,19 @@
  * \date 03-Sep-16.
  */
 
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <unordered_set>
 #include <easylogging++.h>
 
 #include "loaders.h"
 #include "shader_loading.h"
 #include "loader_utils.h"
+#include "zip_archive.h"
 #include "../../render/objects/shaders/shaderpack.h"
 #include "../../utils/utils.h"
+#include "../../utils/thread_pool.h"
 
 namespace nova {
     /*!
@@ -25,29 +31,48 @@ namespace nova {
 
     std::vector<std::string> fragment_extensions = {
             ".fsh",
-            ".frag",
-            ".frag.spv"
+            ".frag"
     };
 
     std::vector<std::string> vertex_extensions = {
             ".vsh",
-            ".vert",
+            ".vert"
+    };
+
+    /*!
+     * \brief SPIR-V is binary, so it's loaded separately from the GLSL and can sit right next to it
+     */
+    std::vector<std::string> spirv_fragment_extensions = {
+            ".frag.spv"
+    };
+
+    std::vector<std::string> spirv_vertex_extensions = {
             ".vert.spv"
     };
 
-    shaderpack load_shaderpack(const std::string &shaderpack_name) {
+    static const std::uint32_t SPIRV_MAGIC = 0x07230203;
+
+    static shaderpack_sources read_sources_from_zip_file(const std::string &shaderpack_name, thread_pool &workers);
+
+    static shaderpack_sources read_sources_from_folder(const std::string &shaderpack_name, thread_pool &workers);
+
+    shaderpack_sources load_shaderpack_sources(const std::string &shaderpack_name, thread_pool &workers) {
         LOG(DEBUG) << "Loading shaderpack " << shaderpack_name;
-        auto shader_sources = std::unordered_map<std::string, shader_definition>{};
-        if(is_zip_file(shaderpack_name)) {
+        if(is_zip_file("shaderpacks/" + shaderpack_name)) {
             LOG(TRACE) << "Loading shaderpack " << shaderpack_name << " from a zip file";
-            return load_sources_from_zip_file(shaderpack_name, shader_names);
+            return read_sources_from_zip_file(shaderpack_name, workers);
 
         } else {
             LOG(TRACE) << "Loading shaderpack " << shaderpack_name << " from a regular folder";
-            return load_sources_from_folder(shaderpack_name, shader_names);
+            return read_sources_from_folder(shaderpack_name, workers);
         }
     }
 
+    shaderpack load_shaderpack(const std::string &shaderpack_name, thread_pool &workers) {
+        auto sources = load_shaderpack_sources(shaderpack_name, workers);
+        return shaderpack(sources.name, sources.shaders_json, sources.shaders);
+    }
+
     std::vector<shader_definition> get_shader_definitions(nlohmann::json &shaders_json) {
         // Check if the top-level element is an array or an object. If it's
         // an array, load all the elements of the array into shader
@@ -68,15 +93,100 @@ namespace nova {
         return definitions;
     }
 
-    shaderpack load_sources_from_folder(const std::string &shaderpack_name, const std::vector<std::string> &shader_names) {
+    /*!
+     * \brief Reads and preprocesses the given shaders, from wherever the include cache reads files from
+     *
+     * \return The shaders that loaded, in the same order. The others are logged and left out
+     */
+    static std::vector<shader_definition> load_shader_sources(const std::string &shaderpack_name, std::vector<shader_definition> &shaders,
+                                                              shader_include_cache &includes, thread_pool &workers) {
+        // Reading and preprocessing doesn't touch GL, so every shader can do it at once. The shaderpack makes the GL
+        // objects afterwards, on this thread
+        // Not a vector<bool>, since the workers set elements next to each other at the same time
+        std::vector<char> loaded(shaders.size(), false);
+        auto load_start = std::chrono::high_resolution_clock::now();
+        workers.parallel_for(0, shaders.size(), 1, [&](std::size_t begin, std::size_t end) {
+            for(std::size_t i = begin; i < end; i++) {
+                auto& shader = shaders[i];
+                try {
+                    // All shaderpacks are in the shaderpacks folder. Zipped ones pretend to be a folder named
+                    // after the zip file
+                    auto shader_path = "shaderpacks/" + shaderpack_name + "/shaders/" + shader.name;
+
+                    auto start = std::chrono::high_resolution_clock::now();
+                    shader.vertex_spirv = load_spirv_file(shader_path, spirv_vertex_extensions, includes);
+                    shader.fragment_spirv = load_spirv_file(shader_path, spirv_fragment_extensions, includes);
+
+                    // The GLSL can be left out if there's SPIR-V for both stages, but then only drivers that take
+                    // SPIR-V can use the shader
+                    std::shared_ptr<const shader_source_file> vertex_file, fragment_file;
+                    try {
+                        vertex_file = find_shader_file(shader_path, vertex_extensions, includes);
+                        fragment_file = find_shader_file(shader_path, fragment_extensions, includes);
+                        includes.read_includes(vertex_file);
+                        includes.read_includes(fragment_file);
+                    } catch(resource_not_found&) {
+                        if(!shader.vertex_spirv || !shader.fragment_spirv) {
+                            throw;
+                        }
+                        LOG(INFO) << "Shader " << shader.name << " only has SPIR-V";
+                        vertex_file = nullptr;
+                        fragment_file = nullptr;
+                    }
+                    auto read_end = std::chrono::high_resolution_clock::now();
+
+                    if(vertex_file && fragment_file) {
+                        shader.vertex_source = includes.expand(vertex_file);
+                        shader.fragment_source = includes.expand(fragment_file);
+                    }
+                    auto preprocess_end = std::chrono::high_resolution_clock::now();
+
+                    shader.load_times.load = std::chrono::duration_cast<std::chrono::microseconds>(read_end - start);
+                    shader.load_times.preprocess = std::chrono::duration_cast<std::chrono::microseconds>(preprocess_end - read_end);
+                    loaded[i] = true;
+                } catch(std::exception& e) {
+                    LOG(ERROR) << "Could not load shader " << shader.name << ". Reason: " << e.what();
+                }
+            }
+        });
+        auto load_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - load_start);
+
         std::vector<shader_definition> sources;
+        sources.reserve(shaders.size());
+        for(std::size_t i = 0; i < shaders.size(); i++) {
+            if(loaded[i]) {
+                sources.push_back(std::move(shaders[i]));
+            }
+        }
 
-        // First, load in the shaders.json file so we can see what we're
-        // dealing with
-        std::ifstream shaders_json_file("shaderpacks/" + shaderpack_name + "/shaders.json");
+        LOG(INFO) << "Read " << includes.get_num_files_read() << " shader files for " << sources.size() << " shaders in "
+                  << load_time.count() << "us";
+
+        return sources;
+    }
+
+    /*!
+     * \brief Reads and preprocesses every shader in shaders_json
+     */
+    static shaderpack_sources read_shaders(const std::string &shaderpack_name, nlohmann::json &shaders_json, shader_include_cache &includes,
+                                           thread_pool &workers) {
+        // Figure out all the shader files that we need to load
+        auto shaders = get_shader_definitions(shaders_json);
+        auto sources = load_shader_sources(shaderpack_name, shaders, includes, workers);
+
+        warn_for_missing_fallbacks(sources);
+
+        return {shaderpack_name, shaders_json, std::move(sources)};
+    }
+
+    /*!
+     * \brief Reads a folder shaderpack's shaders.json, or the default one if it doesn't have one
+     */
+    static nlohmann::json load_shaders_json_from_folder(const std::string &shaderpack_name) {
         // TODO: Load a default shaders.json file, store it somewhere
         // accessable, and load it if there isn't a shaders.json in the
         // shaderpack
+        std::ifstream shaders_json_file("shaderpacks/" + shaderpack_name + "/shaders.json");
         nlohmann::json shaders_json;
         if(shaders_json_file.is_open()) {
             shaders_json_file >> shaders_json;
@@ -85,40 +195,53 @@ namespace nova {
             shaders_json = get_default_shaders_json();
         }
 
-        // Figure out all the shader files that we need to load
-        auto shaders = get_shader_definitions(shaders_json);
+        return shaders_json;
+    }
 
-        for(auto &shader : shaders) {
-            try {
-                // All shaderpacks are in the shaderpacks folder
-                auto shader_path = "shaderpacks/" + shaderpack_name + "/shaders/" + shader.name;
+    static shaderpack_sources read_sources_from_folder(const std::string &shaderpack_name, thread_pool &workers) {
+        // First, load in the shaders.json file so we can see what we're
+        // dealing with
+        auto shaders_json = load_shaders_json_from_folder(shaderpack_name);
+
+        // Shared by every shader, so that headers they all include are only read once
+        shader_include_cache includes;
+
+        return read_shaders(shaderpack_name, shaders_json, includes, workers);
+    }
+
+    shaderpack load_sources_from_folder(const std::string &shaderpack_name, const std::vector<std::string> &shader_names,
+                                        thread_pool &workers) {
+        auto sources = read_sources_from_folder(shaderpack_name, workers);
+        return shaderpack(sources.name, sources.shaders_json, sources.shaders);
+    }
 
-                shader.vertex_source = load_shader_file(shader_path, vertex_extensions);
-                shader.fragment_source = load_shader_file(shader_path, fragment_extensions);
+    std::vector<shader_definition> reload_shaders_from_folder(const std::string &shaderpack_name,
+                                                              const std::unordered_set<std::string> &shader_names,
+                                                              thread_pool &workers) {
+        auto shaders_json = load_shaders_json_from_folder(shaderpack_name);
 
-                sources.push_back(shader);
-            } catch(std::exception& e) {
-                LOG(ERROR) << "Could not load shader " << shader.name << ". Reason: " << e.what();
+        std::vector<shader_definition> shaders;
+        for(auto& shader : get_shader_definitions(shaders_json)) {
+            if(shader_names.find(shader.name) != shader_names.end()) {
+                shaders.push_back(std::move(shader));
             }
         }
 
-        warn_for_missing_fallbacks(sources);
-
-        return shaderpack(shaderpack_name, shaders_json, sources);
+        // A new cache, so the files are read again and the edits are picked up
+        shader_include_cache includes;
+        return load_shader_sources(shaderpack_name, shaders, includes, workers);
     }
 
-    void warn_for_missing_fallbacks(std::vector<shader_definition> sources) {
+    void warn_for_missing_fallbacks(const std::vector<shader_definition> &sources) {
+        std::unordered_set<std::string> shader_names;
+        for(const auto& def : sources) {
+            shader_names.insert(def.name);
+        }
+
         // Verify that all the fallbacks exist
-        for(auto def : sources) {
+        for(const auto& def : sources) {
             if(def.fallback_name) {
-                bool found_fallback = false;
-                for(auto test : sources) {
-                    if(test.name == *def.fallback_name) {
-                        found_fallback = true;
-                    }
-                }
-
-                if(!found_fallback) {
+                if(shader_names.find(*def.fallback_name) == shader_names.end()) {
                     LOG(WARNING) << "Could not find fallback shader " << *def.fallback_name << " for shader " << def.name
                                  << ".";
                 }
@@ -159,7 +282,7 @@ namespace nova {
         return include_line.substr(quote_pos + 1, include_line.size() - quote_pos - 2);
     }
 
-    auto get_included_file_path(const std::string &shader_path, const std::string &included_file_name) {
+    std::string get_included_file_path(const std::string &shader_path, const std::string &included_file_name) {
         if(included_file_name[0] == '/') {
             
             // This is an absolute include and it should be relative to the root directory
@@ -177,15 +300,27 @@ namespace nova {
         }
     }
 
-    std::vector<shader_line> load_shader_file(const std::string &shader_path, const std::vector<std::string> &extensions) {
+    shader_source load_shader_file(const std::string &shader_path, const std::vector<std::string> &extensions) {
+        shader_include_cache includes;
+        return load_shader_file(shader_path, extensions, includes);
+    }
+
+    shader_source load_shader_file(const std::string &shader_path, const std::vector<std::string> &extensions,
+                                   shader_include_cache &includes) {
+        return includes.expand(find_shader_file(shader_path, extensions, includes));
+    }
+
+    std::shared_ptr<const shader_source_file> find_shader_file(const std::string &shader_path,
+                                                               const std::vector<std::string> &extensions,
+                                                               shader_include_cache &includes) {
         for(auto &extension : extensions) {
             auto full_shader_path = shader_path + extension;
             LOG(TRACE) << "Trying to load shader file " << full_shader_path;
 
-            std::ifstream stream(full_shader_path, std::ios::in);
-            if(stream.good()) {
+            auto file = includes.get_file(full_shader_path);
+            if(file) {
                 LOG(INFO) << "Loading shader file " << full_shader_path;
-                return read_shader_stream(stream, full_shader_path);
+                return file;
             } else {
                 LOG(WARNING) << "Could not read file " << full_shader_path;
             }
@@ -194,40 +329,105 @@ namespace nova {
         throw resource_not_found(shader_path);
     }
 
-    std::vector<shader_line> read_shader_stream(std::istream &stream, const std::string &shader_path) {
-        std::vector<shader_line> file_source;
-        std::string line;
-        auto line_counter = 1;
-        while(std::getline(stream, line, '\n')) {
-            if(line.find("#include") == 0) { 
-                auto included_file = load_included_file(shader_path, line);
-                file_source.insert(file_source.end(), std::begin(included_file), std::end(included_file));
+    optional<spirv_module> load_spirv_file(const std::string &shader_path, const std::vector<std::string> &extensions,
+                                           const shader_include_cache &includes) {
+        for(auto &extension : extensions) {
+            auto full_shader_path = shader_path + extension;
+            std::string data;
+            if(!includes.read_binary_file(full_shader_path, data)) {
+                continue;
+            }
 
-            } else {
-                file_source.push_back({line_counter, shader_path, line});
+            // SPIR-V is a list of 32-bit words, and the first one says which way round their bytes are. Modules made on
+            // a machine with the other byte order would need swapping, and no compiler makes those
+            if(data.size() < 5 * sizeof(std::uint32_t) || data.size() % sizeof(std::uint32_t) != 0) {
+                throw std::runtime_error(full_shader_path + " is not a SPIR-V module, since its size isn't a whole number of words");
+            }
+
+            spirv_module module;
+            module.path = full_shader_path;
+            module.words.resize(data.size() / sizeof(std::uint32_t));
+            std::memcpy(module.words.data(), data.data(), data.size());
+            if(module.words[0] != SPIRV_MAGIC) {
+                throw std::runtime_error(full_shader_path + " is not a SPIR-V module, or is for a machine with the other byte order");
             }
 
-            line_counter++;
+            LOG(INFO) << "Loading SPIR-V file " << full_shader_path;
+            return module;
         }
 
-        return file_source;
+        return {};
     }
 
-    std::vector<shader_line> load_included_file(const std::string &shader_path, const std::string &line) {
+    shader_source read_shader_stream(std::istream &stream, const std::string &shader_path) {
+        shader_include_cache includes;
+        auto file = includes.add_file(stream, shader_path);
+        return includes.expand(file);
+    }
+
+    shader_source load_included_file(const std::string &shader_path, const std::string &line) {
         auto included_file_name = get_filename_from_include(line);
         auto file_to_include = get_included_file_path(shader_path, included_file_name);
         LOG(TRACE) << "Dealing with included file " << file_to_include;
 
-        try {
-            return load_shader_file(file_to_include, {""});
-        } catch(resource_not_found& e) {
+        shader_include_cache includes;
+        auto file = includes.get_file(file_to_include);
+        if(!file) {
             throw std::runtime_error("Could not load included file " + file_to_include);
         }
+
+        return includes.expand(file);
+    }
+
+    /*!
+     * \brief Finds the folder in a zip that has the shaderpack in it, since zipping a folder up usually puts the folder
+     * itself in the zip. That's whichever folder with a shaders folder in it is nearest the top
+     */
+    static std::string find_archive_root(const zip_archive &archive) {
+        std::string root;
+        bool found = false;
+        for(const auto& name : archive.get_file_names()) {
+            for(auto shaders_pos = name.find("shaders/"); shaders_pos != std::string::npos; shaders_pos = name.find("shaders/", shaders_pos + 1)) {
+                if(shaders_pos == 0 || name[shaders_pos - 1] == '/') {
+                    if(!found || shaders_pos < root.size()) {
+                        root = name.substr(0, shaders_pos);
+                        found = true;
+                    }
+                    break;
+                }
+            }
+        }
+
+        return root;
+    }
+
+    static shaderpack_sources read_sources_from_zip_file(const std::string &shaderpack_name, thread_pool &workers) {
+        // The central directory is read once, here. Everything after this only decompresses the files it asks for
+        auto archive = std::make_shared<zip_archive>("shaderpacks/" + shaderpack_name);
+        if(!archive->is_open()) {
+            throw resource_not_found("shaderpacks/" + shaderpack_name);
+        }
+        auto archive_root = find_archive_root(*archive);
+
+        nlohmann::json shaders_json;
+        std::string shaders_json_text;
+        if(archive->read_file(archive_root + "shaders.json", shaders_json_text)) {
+            std::istringstream shaders_json_stream(shaders_json_text);
+            shaders_json_stream >> shaders_json;
+
+        } else {
+            shaders_json = get_default_shaders_json();
+        }
+
+        shader_include_cache includes(archive, "shaderpacks/" + shaderpack_name + "/", archive_root);
+
+        return read_shaders(shaderpack_name, shaders_json, includes, workers);
     }
 
-    shaderpack load_sources_from_zip_file(const std::string &shaderpack_name, const std::vector<std::string> &shader_names) {
-        LOG(FATAL) << "Cannot load zipped shaderpack " << shaderpack_name;
-        throw std::runtime_error("Zipped shaderpacks not yet supported");
+    shaderpack load_sources_from_zip_file(const std::string &shaderpack_name, const std::vector<std::string> &shader_names,
+                                          thread_pool &workers) {
+        auto sources = read_sources_from_zip_file(shaderpack_name, workers);
+        return shaderpack(sources.name, sources.shaders_json, sources.shaders);
     }
 
     nlohmann::json& get_default_shaders_json() {
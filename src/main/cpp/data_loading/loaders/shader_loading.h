@@ -11,8 +11,11 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "shader_source_structs.h"
+#include "shader_include_cache.h"
+#include "../../utils/thread_pool.h"
 
 namespace nova {
     /*!
@@ -21,11 +24,17 @@ namespace nova {
      * This will only work if the shaderpack is a zip file. If the shaderpack is just a folder, this will probably
      * fail in strange ways
      *
-     * \param shaderpack_name The name of the shaderpack to load the shaders from
+     * Only the files that the shaders need are decompressed. Files in the zip have the same paths they would if the
+     * zip was a folder called shaderpacks/<shaderpack_name>, so #includes work the same way for both. A zip that has
+     * everything inside one folder is read as if that folder was the shaderpack
+     *
+     * \param shaderpack_name The name of the zip file in the shaderpacks folder, like "pack.zip"
      * \param shader_names The list of names of shaders to load
+     * \param workers The threads to read and preprocess the shaders on
      * \return A map from shader name to shader source
      */
-    shaderpack load_sources_from_zip_file(const std::string &shaderpack_name, const std::vector<std::string> &shader_names);
+    shaderpack load_sources_from_zip_file(const std::string &shaderpack_name, const std::vector<std::string> &shader_names,
+                                          thread_pool &workers);
 
     /*!
      * \brief Loads the source file of all the shaders with the provided names
@@ -35,9 +44,23 @@ namespace nova {
      *
      * \param shaderpack_name The name of the shaderpack to load the shaders from
      * \param shader_names The list of names of shaders to load
+     * \param workers The threads to read and preprocess the shaders on
      * \return A map from shader name to shader source
      */
-    shaderpack load_sources_from_folder(const std::string &shaderpack_name, const std::vector<std::string> &shader_names);
+    shaderpack load_sources_from_folder(const std::string &shaderpack_name, const std::vector<std::string> &shader_names,
+                                        thread_pool &workers);
+
+    /*!
+     * \brief Reads and preprocesses some of the shaders in a folder shaderpack again, like after they've been edited
+     *
+     * \param shaderpack_name The name of the shaderpack's folder
+     * \param shader_names The names of the shaders to read again
+     * \param workers The threads to read and preprocess the shaders on
+     * \return The shaders that could be read. The ones that couldn't are logged and left out
+     */
+    std::vector<shader_definition> reload_shaders_from_folder(const std::string &shaderpack_name,
+                                                              const std::unordered_set<std::string> &shader_names,
+                                                              thread_pool &workers);
 
     /*!
      * \brief Tries to load a single shader file from a folder
@@ -50,28 +73,64 @@ namespace nova {
      * \param extensions A list of extensions to try
      * \return The full source of the shader file
      */
-    std::vector<shader_line> load_shader_file(const std::string &shader_path, const std::vector<std::string> &extensions);
+    shader_source load_shader_file(const std::string &shader_path, const std::vector<std::string> &extensions);
+
+    /*!
+     * \brief Tries to load a single shader file from a folder, getting it and everything it includes from the given
+     * cache
+     *
+     * \param shader_path The path to the shader
+     * \param extensions A list of extensions to try
+     * \param includes The files read so far in this shaderpack load
+     * \return The full source of the shader file
+     */
+    shader_source load_shader_file(const std::string &shader_path, const std::vector<std::string> &extensions,
+                                   shader_include_cache &includes);
+
+    /*!
+     * \brief Finds and reads the top-level file of a shader, without reading anything it includes
+     *
+     * \param shader_path The path to the shader, without an extension
+     * \param extensions A list of extensions to try
+     * \param includes The files read so far in this shaderpack load
+     * \return The first file that exists with one of the extensions. Throws resource_not_found if none of them do
+     */
+    std::shared_ptr<const shader_source_file> find_shader_file(const std::string &shader_path,
+                                                               const std::vector<std::string> &extensions,
+                                                               shader_include_cache &includes);
+
+    /*!
+     * \brief Reads a stage that was compiled to SPIR-V ahead of time
+     *
+     * \param shader_path The path to the shader, without an extension
+     * \param extensions A list of extensions to try
+     * \param includes Where to read the file from
+     * \return The first file that exists with one of the extensions, or nothing if none of them do. Throws a
+     * std::runtime_error if the file isn't SPIR-V
+     */
+    optional<spirv_module> load_spirv_file(const std::string &shader_path, const std::vector<std::string> &extensions,
+                                           const shader_include_cache &includes);
 
     /*!
      * \brief Loads the shader file from the provided istream
      *
      * \param stream The istream to load the shader file from
      * \param shader_path The path to the shader file (useful mostly for includes)
-     * \return A list of shader_line objects
+     * \return The lines of the shader, with its includes expanded
      */
-    std::vector<shader_line> read_shader_stream(std::istream &stream, const std::string &shader_path);
+    shader_source read_shader_stream(std::istream &stream, const std::string &shader_path);
 
     /*!
      * \brief Loads a file that was requested through a #include statement
      *
-     * This function will recursively include files. There's nothing to check for an infinite include loop, so try to
-     * not have any
+     * This function will recursively include files. Include loops are only allowed if the files in them use
+     * `#pragma once` or include guards, otherwise a std::runtime_error is thrown
      *
      * \param shader_path The path to the shader that includes the file
      * \param line The line in the shader that contains the #include statement
      * \return The full source of the included file
      */
-    std::vector<shader_line> load_included_file(const std::string &shader_path, const std::string &line);
+    shader_source load_included_file(const std::string &shader_path, const std::string &line);
 
     /*!
      * \brief Determines the full file path of an included file
@@ -80,7 +139,7 @@ namespace nova {
      * \param included_file_name The name of the file to include
      * \return The path to the included file
      */
-    auto get_included_file_path(const std::string &shader_path, const std::string &included_file_name);
+    std::string get_included_file_path(const std::string &shader_path, const std::string &included_file_name);
 
     /*!
      * \brief Extracts the filename from the #include line
@@ -110,7 +169,7 @@ namespace nova {
      *
      * \param shaders The list of shader definitions from the shaders.json file
      */
-    void warn_for_missing_fallbacks(std::vector<shader_definition> shaders);
+    void warn_for_missing_fallbacks(const std::vector<shader_definition> &shaders);
 
     /*!
      * \brief Loads the default shader.json file from disk
@@ -20,16 +20,124 @@ namespace nova {
         }
     }
 
-    el::base::Writer& operator<<(el::base::Writer& out, const std::vector<shader_line>& lines) {
+    std::string string_ref::to_string() const {
+        return std::string(data, size);
+    }
+
+    bool string_ref::operator==(const std::string &other) const {
+        return other.size() == size && other.compare(0, size, data, size) == 0;
+    }
+
+    shader_source_file::shader_source_file(std::string path, std::string text) : path(std::move(path)), text(std::move(text)) {
+        if(!this->text.empty() && this->text.back() != '\n') {
+            this->text.push_back('\n');
+        }
+
+        line_starts.push_back(0);
+        for(std::size_t i = 0; i < this->text.size(); i++) {
+            if(this->text[i] == '\n') {
+                line_starts.push_back((std::uint32_t) i + 1);
+            }
+        }
+    }
+
+    std::size_t shader_source_file::get_num_lines() const {
+        return line_starts.size() - 1;
+    }
+
+    string_ref shader_source_file::get_line(std::size_t line) const {
+        return {text.data() + line_starts[line], line_starts[line + 1] - line_starts[line] - 1};
+    }
+
+    shader_source::shader_source(std::shared_ptr<const shader_source_file> file) {
+        auto num_lines = (std::uint32_t) file->get_num_lines();
+        add_lines(add_file(file), 0, num_lines);
+    }
+
+    std::uint32_t shader_source::add_file(const std::shared_ptr<const shader_source_file> &file) {
+        // Shaders only include a handful of files, so looking through all of them is quicker than hashing
+        for(std::size_t i = 0; i < files.size(); i++) {
+            if(files[i] == file) {
+                return (std::uint32_t) i;
+            }
+        }
+
+        files.push_back(file);
+        return (std::uint32_t) files.size() - 1;
+    }
+
+    void shader_source::add_lines(std::uint32_t file_id, std::uint32_t first_line, std::uint32_t end_line) {
+        for(std::uint32_t line = first_line; line < end_line; line++) {
+            lines.push_back({file_id, line});
+        }
+    }
+
+    void shader_source::insert_file(std::size_t position, const std::shared_ptr<const shader_source_file> &file) {
+        auto file_id = add_file(file);
+        std::vector<shader_line> file_lines;
+        for(std::uint32_t line = 0; line < file->get_num_lines(); line++) {
+            file_lines.push_back({file_id, line});
+        }
+        lines.insert(lines.begin() + position, file_lines.begin(), file_lines.end());
+    }
+
+    std::size_t shader_source::size() const {
+        return lines.size();
+    }
+
+    bool shader_source::empty() const {
+        return lines.empty();
+    }
+
+    string_ref shader_source::get_line(std::size_t line) const {
+        return files[lines[line].file_id]->get_line(lines[line].line);
+    }
+
+    const std::string &shader_source::get_file_name(std::size_t line) const {
+        return files[lines[line].file_id]->path;
+    }
+
+    int shader_source::get_line_num(std::size_t line) const {
+        return (int) lines[line].line + 1;
+    }
+
+    std::string shader_source::get_text() const {
+        std::size_t text_size = 0;
         for(const auto& line : lines) {
-            out << line;
+            const auto& starts = files[line.file_id]->line_starts;
+            text_size += starts[line.line + 1] - starts[line.line];
         }
 
-        return out;
+        std::string text;
+        text.reserve(text_size);
+        for(std::size_t run_start = 0; run_start < lines.size(); ) {
+            // Find how many lines in a row come straight from the same part of the same file
+            std::size_t run_end = run_start + 1;
+            while(run_end < lines.size() && lines[run_end].file_id == lines[run_start].file_id &&
+                  lines[run_end].line == lines[run_end - 1].line + 1) {
+                run_end++;
+            }
+
+            const auto& file = *files[lines[run_start].file_id];
+            auto first_char = file.line_starts[lines[run_start].line];
+            auto end_char = file.line_starts[lines[run_end - 1].line + 1];
+            text.append(file.text, first_char, end_char - first_char);
+
+            run_start = run_end;
+        }
+
+        return text;
+    }
+
+    const std::vector<std::shared_ptr<const shader_source_file>> &shader_source::get_files() const {
+        return files;
     }
 
-    el::base::Writer& operator<<(el::base::Writer& out, const shader_line& line) {
-        out << "\t" << line.line_num << "(" << line.shader_name << ") " << line.line << "\n";
+    el::base::Writer& operator<<(el::base::Writer& out, const shader_source& source) {
+        for(std::size_t i = 0; i < source.size(); i++) {
+            out << "\t" << source.get_line_num(i) << "(" << source.get_file_name(i) << ") " << source.get_line(i).to_string() << "\n";
+        }
+
         return out;
     }
-}
\ No newline at end of file
+}
@@ -8,6 +8,8 @@
 #ifndef RENDERER_SHADER_SOURCE_STRUCTS_H
 #define RENDERER_SHADER_SOURCE_STRUCTS_H
 
+#include <chrono>
+#include <cstdint>
 #include <string>
 #include <memory>
 #include <vector>
@@ -22,15 +24,179 @@ using namespace std::experimental;
 
 namespace nova {
     /*!
-     * \brief Holds a line number and file name
+     * \brief A piece of a string that lives somewhere else, like std::string_view
+     */
+    struct string_ref {
+        const char* data;
+        std::size_t size;
+
+        std::string to_string() const;
+
+        bool operator==(const std::string &other) const;
+    };
+
+    /*!
+     * \brief One shader file, exactly as it is on disk, with its #includes still in it
      *
-     * This struct is used to create a map from the line of code in the shader sent to the driver and the line of
-     * code on disk
+     * The whole file is kept in one string, and its lines are found through a table of where each one starts, so a
+     * line doesn't cost anything more than the characters in it
+     */
+    struct shader_source_file {
+        std::string path;
+
+        /*!
+         * \brief The text of the file. Every line ends in a '\n', even the last one
+         */
+        std::string text;
+
+        /*!
+         * \brief Where each line starts in text, plus one more entry for the end of the last line
+         */
+        std::vector<std::uint32_t> line_starts;
+
+        /*!
+         * \brief A line that isn't sent to the driver as-is
+         */
+        struct directive {
+            std::uint32_t line;         //!< Which line it is, counting from 0
+            std::string included_path;  //!< The path of the file it includes, or empty if it's dropped like #pragma once
+        };
+
+        /*!
+         * \brief The #include and #pragma once lines, in the order they're in the file
+         */
+        std::vector<directive> directives;
+
+        /*!
+         * \brief True if the file has a `#pragma once` in it
+         */
+        bool pragma_once = false;
+
+        /*!
+         * \brief The macro the file's include guard checks, or empty if it doesn't have one
+         *
+         * An include guard is an #ifndef and a #define of the same macro before anything else in the file, and an
+         * #endif after everything else
+         */
+        std::string include_guard;
+
+        /*!
+         * \brief Splits the text into lines. Doesn't look for directives, that's the include cache's job
+         */
+        shader_source_file(std::string path, std::string text);
+
+        std::size_t get_num_lines() const;
+
+        /*!
+         * \brief The text of a line, without its '\n'
+         */
+        string_ref get_line(std::size_t line) const;
+    };
+
+    /*!
+     * \brief How long each step of getting a shader ready took, so that slow shaderpack loads can be tracked down
+     */
+    struct shader_load_times {
+        std::chrono::microseconds load{0};          //!< Finding and reading the shader's files
+        std::chrono::microseconds preprocess{0};    //!< Expanding #includes
+        std::chrono::microseconds compile{0};       //!< Handing every stage to the driver to compile
+        std::chrono::microseconds link{0};          //!< Linking and checking for errors, or handing the driver a cached binary
+        std::chrono::microseconds ready{0};         //!< From starting to compile until the program could be used
+
+        bool from_binary_cache = false;             //!< True if the program came from the program binary cache
+    };
+
+    /*!
+     * \brief Where a line of a shader came from
      */
     struct shader_line {
-        int line_num;               //!< The line number in the original source file
-        std::string shader_name;    //!< The name of the original source file
-        std::string line;           //!< The actual line
+        std::uint32_t file_id;  //!< Which of the shader's files the line is in
+        std::uint32_t line;     //!< Which line of the file it is, counting from 0
+    };
+
+    /*!
+     * \brief The full source of one shader stage, with its includes expanded
+     *
+     * The text isn't copied. Each line is a reference into the file it came from, and each file is only kept once no
+     * matter how many shaders include it
+     */
+    class shader_source {
+    public:
+        shader_source() = default;
+
+        /*!
+         * \brief Makes a source out of the whole of a single file, without expanding anything
+         */
+        explicit shader_source(std::shared_ptr<const shader_source_file> file);
+
+        /*!
+         * \brief Adds a file to the table of files, if it isn't already there
+         *
+         * \return The file's ID
+         */
+        std::uint32_t add_file(const std::shared_ptr<const shader_source_file> &file);
+
+        /*!
+         * \brief Adds some lines of one of the shader's files to the end of the source
+         *
+         * \param file_id The file's ID, from add_file
+         * \param first_line The first line to add, counting from 0
+         * \param end_line One past the last line to add
+         */
+        void add_lines(std::uint32_t file_id, std::uint32_t first_line, std::uint32_t end_line);
+
+        /*!
+         * \brief Puts every line of a file in before one of the source's lines
+         *
+         * \param position The line to put the file before. The size of the source puts it at the end
+         * \param file The file to put in
+         */
+        void insert_file(std::size_t position, const std::shared_ptr<const shader_source_file> &file);
+
+        std::size_t size() const;
+
+        bool empty() const;
+
+        string_ref get_line(std::size_t line) const;
+
+        /*!
+         * \brief The path of the file that a line came from
+         */
+        const std::string &get_file_name(std::size_t line) const;
+
+        /*!
+         * \brief The line number that a line has in the file it came from, counting from 1 like editors do
+         */
+        int get_line_num(std::size_t line) const;
+
+        /*!
+         * \brief Puts the whole source together, to send to the driver
+         *
+         * Lines that follow each other in the same file are copied all at once
+         */
+        std::string get_text() const;
+
+        /*!
+         * \brief Every file that any of the lines came from
+         */
+        const std::vector<std::shared_ptr<const shader_source_file>> &get_files() const;
+
+    private:
+        std::vector<std::shared_ptr<const shader_source_file>> files;
+
+        std::vector<shader_line> lines;
+    };
+
+    /*!
+     * \brief A stage that was compiled to SPIR-V ahead of time, for drivers that can take it instead of GLSL
+     */
+    struct spirv_module {
+        std::string path;
+
+        /*!
+         * \brief The module, starting with the SPIR-V magic number
+         */
+        std::vector<std::uint32_t> words;
     };
 
     /*!
@@ -43,10 +209,19 @@ namespace nova {
 
         optional<std::shared_ptr<shader_definition>> fallback_def;
 
-        std::vector<shader_line> vertex_source;
-        std::vector<shader_line> fragment_source;
+        shader_source vertex_source;
+        shader_source fragment_source;
+
+        /*!
+         * \brief The stages as SPIR-V, if the shaderpack has a .vert.spv and .frag.spv for this shader. The GLSL
+         * source can be left out when these are here, but then drivers without SPIR-V support can't use the shader
+         */
+        optional<spirv_module> vertex_spirv;
+        optional<spirv_module> fragment_spirv;
         // TODO: Figure out how to handle geometry and tessellation shaders
 
+        shader_load_times load_times;
+
         /*!
          * \brief The framebuffer attachments that this shader writes to
          */
@@ -55,9 +230,7 @@ namespace nova {
         shader_definition(nlohmann::json &json);
     };
 
-    el::base::Writer& operator<<(el::base::Writer& out, const std::vector<shader_line>& lines);
-
-    el::base::Writer& operator<<(el::base::Writer& out, const shader_line& line);
+    el::base::Writer& operator<<(el::base::Writer& out, const shader_source& source);
 }
 
 #endif //RENDERER_SHADER_SOURCE_STRUCTS_H
@@ -0,0 +1,120 @@
+/*!
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <easylogging++.h>
+#include "shaderpack_watcher.h"
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace nova {
+    shaderpack_watcher::shaderpack_watcher(std::string folder) : folder(std::move(folder)) {
+#if defined(__linux__)
+        inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if(inotify_fd < 0) {
+            LOG(ERROR) << "Could not start watching " << this->folder << " for changes";
+            return;
+        }
+
+        watch_folder(this->folder);
+        LOG(INFO) << "Watching " << watched_folders.size() << " folders in " << this->folder << " for changes";
+#else
+        LOG(WARNING) << "Shaders can only be reloaded when their files change on Linux, so " << this->folder << " won't be watched";
+#endif
+    }
+
+    shaderpack_watcher::~shaderpack_watcher() {
+#if defined(__linux__)
+        if(inotify_fd >= 0) {
+            // Closing it removes all the watches
+            close(inotify_fd);
+        }
+#endif
+    }
+
+    void shaderpack_watcher::watch_folder(const std::string &path) {
+#if defined(__linux__)
+        // Editors that save by writing a new file and renaming it over the old one show up as IN_MOVED_TO
+        auto watch = inotify_add_watch(inotify_fd, path.c_str(), IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
+        if(watch < 0) {
+            LOG(WARNING) << "Could not watch " << path << " for changes";
+            return;
+        }
+        watched_folders[watch] = path;
+
+        // inotify only watches the folder it's given, so every folder inside it needs its own watch
+        auto dir = opendir(path.c_str());
+        if(!dir) {
+            return;
+        }
+        while(auto entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if(entry->d_type == DT_DIR && name != "." && name != "..") {
+                watch_folder(path + "/" + name);
+            }
+        }
+        closedir(dir);
+#endif
+    }
+
+    void shaderpack_watcher::read_events() {
+#if defined(__linux__)
+        if(inotify_fd < 0) {
+            return;
+        }
+
+        alignas(inotify_event) char buffer[4096];
+        while(true) {
+            auto num_read = read(inotify_fd, buffer, sizeof(buffer));
+            if(num_read <= 0) {
+                // EAGAIN, since there's nothing left and the descriptor doesn't block
+                break;
+            }
+
+            for(char* pos = buffer; pos < buffer + num_read; pos += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(pos)->len) {
+                auto event = reinterpret_cast<inotify_event*>(pos);
+                if((event->mask & IN_IGNORED) != 0) {
+                    // The folder was deleted, so its watch is gone
+                    watched_folders.erase(event->wd);
+                    continue;
+                }
+
+                auto watched_folder = watched_folders.find(event->wd);
+                if(watched_folder == watched_folders.end() || event->len == 0) {
+                    continue;
+                }
+
+                auto path = watched_folder->second + "/" + event->name;
+                if((event->mask & IN_ISDIR) != 0) {
+                    // A new folder might have shaders put in it later
+                    if((event->mask & (IN_CREATE | IN_MOVED_TO)) != 0) {
+                        watch_folder(path);
+                    }
+                    continue;
+                }
+
+                changed_files.insert(path);
+                last_change = std::chrono::steady_clock::now();
+            }
+        }
+#endif
+    }
+
+    std::unordered_set<std::string> shaderpack_watcher::get_changed_files() {
+        read_events();
+
+        // A copy, since binding SETTLE_TIME_MS to the duration's constructor would need it defined somewhere
+        int settle_time_ms = SETTLE_TIME_MS;
+        std::unordered_set<std::string> changed;
+        if(!changed_files.empty() && std::chrono::steady_clock::now() - last_change >= std::chrono::milliseconds(settle_time_ms)) {
+            changed.swap(changed_files);
+        }
+
+        return changed;
+    }
+}
@@ -0,0 +1,71 @@
+/*!
+ * \brief Watches a shaderpack's folder for edits, so the shaders that changed can be reloaded while the game runs
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_SHADERPACK_WATCHER_H
+#define RENDERER_SHADERPACK_WATCHER_H
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace nova {
+    /*!
+     * \brief Tells you which files in a folder, or any folder inside it, have been written to
+     *
+     * This uses inotify, so it only does anything on Linux. Everywhere else it never sees any changes
+     *
+     * Editors often save a file in a few steps, like writing a new copy and renaming it over the old one, so changes
+     * aren't given out until the folder has been quiet for SETTLE_TIME_MS
+     */
+    class shaderpack_watcher {
+    public:
+        static const int SETTLE_TIME_MS = 20;
+
+        /*!
+         * \param folder The folder to watch, like "shaderpacks/default"
+         */
+        explicit shaderpack_watcher(std::string folder);
+
+        ~shaderpack_watcher();
+
+        shaderpack_watcher(const shaderpack_watcher &other) = delete;
+        shaderpack_watcher &operator=(const shaderpack_watcher &other) = delete;
+
+        /*!
+         * \brief Gets the files that were changed, made, deleted or renamed since the last time this gave any out.
+         * Never waits
+         *
+         * \return The path of each changed file, starting with the folder being watched, like
+         * "shaderpacks/default/shaders/gui.frag". Empty if nothing changed or the folder's still being written to
+         */
+        std::unordered_set<std::string> get_changed_files();
+
+    private:
+        std::string folder;
+
+        int inotify_fd = -1;
+
+        /*!
+         * \brief The folder that each inotify watch is for
+         */
+        std::unordered_map<int, std::string> watched_folders;
+
+        std::unordered_set<std::string> changed_files;
+
+        std::chrono::steady_clock::time_point last_change;
+
+        /*!
+         * \brief Watches a folder and every folder inside it
+         */
+        void watch_folder(const std::string &path);
+
+        void read_events();
+    };
+}
+
+#endif //RENDERER_SHADERPACK_WATCHER_H
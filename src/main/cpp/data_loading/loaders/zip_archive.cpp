@@ -0,0 +1,195 @@
+/*!
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#define MINIZ_HEADER_FILE_ONLY
+#include "miniz.c"
+#include <cstring>
+#include <easylogging++.h>
+#include "zip_archive.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nova {
+    static const std::uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+    static const std::size_t LOCAL_HEADER_SIZE = 30;
+
+    static std::uint32_t read_u16(const std::uint8_t* bytes) {
+        return (std::uint32_t) bytes[0] | (std::uint32_t) bytes[1] << 8;
+    }
+
+    static std::uint32_t read_u32(const std::uint8_t* bytes) {
+        return read_u16(bytes) | read_u16(bytes + 2) << 16;
+    }
+
+    zip_archive::zip_archive(const std::string &path) {
+        map_file(path);
+        if(data) {
+            read_central_directory(path);
+        }
+    }
+
+    zip_archive::~zip_archive() {
+#if defined(_WIN32)
+        if(data) {
+            UnmapViewOfFile(data);
+        }
+        if(mapping_handle) {
+            CloseHandle(mapping_handle);
+        }
+        if(file_handle && file_handle != INVALID_HANDLE_VALUE) {
+            CloseHandle(file_handle);
+        }
+#else
+        if(data) {
+            munmap(const_cast<std::uint8_t*>(data), size);
+        }
+#endif
+    }
+
+    void zip_archive::map_file(const std::string &path) {
+#if defined(_WIN32)
+        file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if(file_handle == INVALID_HANDLE_VALUE) {
+            return;
+        }
+
+        LARGE_INTEGER file_size;
+        if(!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0) {
+            return;
+        }
+
+        mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(!mapping_handle) {
+            return;
+        }
+
+        data = static_cast<const std::uint8_t*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+        if(data) {
+            size = (std::size_t) file_size.QuadPart;
+        }
+#else
+        int file = open(path.c_str(), O_RDONLY);
+        if(file < 0) {
+            return;
+        }
+
+        // The mapping keeps the file alive by itself, so the descriptor can go as soon as it's made
+        struct stat file_info;
+        void* mapping = MAP_FAILED;
+        if(fstat(file, &file_info) == 0 && file_info.st_size > 0) {
+            mapping = mmap(nullptr, (std::size_t) file_info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        }
+        close(file);
+
+        if(mapping != MAP_FAILED) {
+            data = static_cast<const std::uint8_t*>(mapping);
+            size = (std::size_t) file_info.st_size;
+        }
+#endif
+    }
+
+    void zip_archive::read_central_directory(const std::string &path) {
+        mz_zip_archive zip = {};
+        if(!mz_zip_reader_init_mem(&zip, data, size, 0)) {
+            LOG(ERROR) << "Could not read " << path << " as a zip file";
+            return;
+        }
+
+        auto num_files = mz_zip_reader_get_num_files(&zip);
+        for(mz_uint i = 0; i < num_files; i++) {
+            mz_zip_archive_file_stat stat;
+            if(!mz_zip_reader_file_stat(&zip, i, &stat) || mz_zip_reader_is_file_a_directory(&zip, i)) {
+                continue;
+            }
+
+            // Only stored and deflated files, without encryption, are any use to us
+            if((stat.m_method != 0 && stat.m_method != MZ_DEFLATED) || (stat.m_bit_flag & 1) != 0) {
+                LOG(WARNING) << "Skipping " << stat.m_filename << " in " << path << " because it's compressed in a way I can't read";
+                continue;
+            }
+
+            // The central directory doesn't say where the data starts, because the local header in front of it can
+            // have a different amount of extra data
+            auto header_offset = (std::size_t) stat.m_local_header_ofs;
+            if(header_offset > size || size - header_offset < LOCAL_HEADER_SIZE ||
+                    read_u32(data + header_offset) != LOCAL_HEADER_SIGNATURE) {
+                LOG(WARNING) << "Skipping " << stat.m_filename << " in " << path << " because its header is damaged";
+                continue;
+            }
+
+            auto data_offset = header_offset + LOCAL_HEADER_SIZE + read_u16(data + header_offset + 26) + read_u16(data + header_offset + 28);
+            auto compressed_size = (std::size_t) stat.m_comp_size;
+            if(data_offset > size || size - data_offset < compressed_size) {
+                LOG(WARNING) << "Skipping " << stat.m_filename << " in " << path << " because it runs off the end of the file";
+                continue;
+            }
+
+            entries[stat.m_filename] = {data_offset, compressed_size, (std::size_t) stat.m_uncomp_size, (std::uint32_t) stat.m_crc32,
+                                        stat.m_method == MZ_DEFLATED};
+        }
+
+        mz_zip_reader_end(&zip);
+    }
+
+    bool zip_archive::is_open() const {
+        return data != nullptr;
+    }
+
+    bool zip_archive::has_file(const std::string &name) const {
+        return entries.find(name) != entries.end();
+    }
+
+    std::vector<std::string> zip_archive::get_file_names() const {
+        std::vector<std::string> names;
+        names.reserve(entries.size());
+        for(const auto& entry : entries) {
+            names.push_back(entry.first);
+        }
+
+        return names;
+    }
+
+    bool zip_archive::read_file(const std::string &name, std::string &text) const {
+        auto found = entries.find(name);
+        if(found == entries.end()) {
+            return false;
+        }
+
+        const auto& file = found->second;
+        const auto* file_data = data + file.data_offset;
+        if(file.is_compressed) {
+            // Straight from the mapping into the string. tinfl doesn't keep any state between calls, unlike the
+            // zip reader, so any number of threads can do this at once
+            text.resize(file.size);
+            auto decompressed_size = tinfl_decompress_mem_to_mem(&text[0], text.size(), file_data, file.compressed_size, 0);
+            if(decompressed_size != file.size) {
+                LOG(WARNING) << "Could not decompress " << name;
+                return false;
+            }
+
+        } else {
+            if(file.compressed_size != file.size) {
+                return false;
+            }
+            text.assign(reinterpret_cast<const char*>(file_data), file.size);
+        }
+
+        if(mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const unsigned char*>(text.data()), text.size()) != file.crc32) {
+            LOG(WARNING) << "Could not read " << name << " because it's damaged";
+            return false;
+        }
+
+        return true;
+    }
+}
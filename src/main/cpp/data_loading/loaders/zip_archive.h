@@ -0,0 +1,89 @@
+/*!
+ * \brief Reads files out of a zip file without extracting it anywhere first
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_ZIP_ARCHIVE_H
+#define RENDERER_ZIP_ARCHIVE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace nova {
+    /*!
+     * \brief A zip file, mapped into memory, with an index of everything in it
+     *
+     * The central directory is only read once, when the archive is opened. After that, reading a file only touches
+     * that file's bytes. Files that are stored without compression are copied straight out of the mapping, and
+     * compressed ones are inflated straight into the string they're read into
+     *
+     * Reading doesn't change anything, so several threads can read from one archive at once
+     */
+    class zip_archive {
+    public:
+        /*!
+         * \brief Opens a zip file and reads its central directory
+         *
+         * \param path The path to the zip file
+         */
+        explicit zip_archive(const std::string &path);
+
+        ~zip_archive();
+
+        zip_archive(const zip_archive &other) = delete;
+        zip_archive &operator=(const zip_archive &other) = delete;
+
+        /*!
+         * \brief False if the file couldn't be opened or isn't a zip file
+         */
+        bool is_open() const;
+
+        bool has_file(const std::string &name) const;
+
+        /*!
+         * \brief The names of every file in the archive, without the directories
+         */
+        std::vector<std::string> get_file_names() const;
+
+        /*!
+         * \brief Reads a file from the archive
+         *
+         * \param name The file's name in the archive, like "shaders/gui.frag"
+         * \param text Where to put the file's contents
+         * \return True if the file was read. False if it isn't there, is encrypted, or is damaged
+         */
+        bool read_file(const std::string &name, std::string &text) const;
+
+    private:
+        /*!
+         * \brief Where a file's data is in the mapping, and how to get it out
+         */
+        struct entry {
+            std::size_t data_offset;
+            std::size_t compressed_size;
+            std::size_t size;
+            std::uint32_t crc32;
+            bool is_compressed;     //!< True for deflate, false for stored
+        };
+
+        std::unordered_map<std::string, entry> entries;
+
+        const std::uint8_t* data = nullptr;
+        std::size_t size = 0;
+
+#if defined(_WIN32)
+        void* file_handle = nullptr;
+        void* mapping_handle = nullptr;
+#endif
+
+        void map_file(const std::string &path);
+
+        void read_central_directory(const std::string &path);
+    };
+}
+
+#endif //RENDERER_ZIP_ARCHIVE_H
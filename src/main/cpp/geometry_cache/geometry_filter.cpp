@@ -0,0 +1,293 @@
+/*!
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <stdexcept>
+#include <easylogging++.h>
+#include "geometry_filter.h"
+
+namespace nova {
+    filter_matches::filter_matches(std::size_t num_filters, std::size_t num_items) :
+            num_items(num_items), num_words((num_items + 63) / 64), bits(num_filters * num_words, 0) {}
+
+    bool filter_matches::matches(std::size_t filter, std::size_t item) const {
+        return (get_words(filter)[item / 64] & (1ull << (item % 64))) != 0;
+    }
+
+    std::vector<std::size_t> filter_matches::get_matching_items(std::size_t filter) const {
+        std::vector<std::size_t> items;
+        auto words = get_words(filter);
+        for(std::size_t word = 0; word < num_words; word++) {
+            auto bits_left = words[word];
+            while(bits_left != 0) {
+                // Counting trailing zeros by hand, since there's no portable way to ask the CPU
+                std::size_t bit = 0;
+                while((bits_left & (1ull << bit)) == 0) {
+                    bit++;
+                }
+                items.push_back(word * 64 + bit);
+                bits_left &= bits_left - 1;
+            }
+        }
+
+        return items;
+    }
+
+    const std::uint64_t *filter_matches::get_words(std::size_t filter) const {
+        return bits.data() + filter * num_words;
+    }
+
+    std::uint64_t *filter_matches::get_words(std::size_t filter) {
+        return bits.data() + filter * num_words;
+    }
+
+    std::size_t filter_matches::get_num_words() const {
+        return num_words;
+    }
+
+    std::size_t filter_matches::get_num_items() const {
+        return num_items;
+    }
+
+    geometry_filter_set::geometry_filter_set(const std::vector<std::pair<std::string, std::string>> &filters) {
+        auto num_types = static_cast<std::uint32_t>(geometry_type::all_values().size());
+        transparent_attribute = num_types;
+        emissive_attribute = num_types + 1;
+        num_attributes = num_types + 2;
+
+        for(const auto& filter : filters) {
+            compiled_filter compiled;
+            compiled.shader_name = filter.first;
+            compiled.expression = filter.second;
+            try {
+                compiled.program = compile(filter.second);
+            } catch(std::runtime_error& e) {
+                LOG(ERROR) << "Could not compile the filter '" << filter.second << "' of shader " << filter.first
+                           << ", so it won't get any geometry: " << e.what();
+            }
+            this->filters.push_back(std::move(compiled));
+        }
+    }
+
+    std::vector<geometry_filter_set::instruction> geometry_filter_set::compile(const std::string &expression) {
+        std::vector<std::string> tokens;
+        std::stringstream stream(expression);
+        std::string token;
+        while(stream >> token) {
+            tokens.push_back(token);
+        }
+
+        if(tokens.size() % 2 == 0) {
+            throw std::runtime_error("A filter needs a term, then any number of AND or OR and another term");
+        }
+
+        std::vector<instruction> program;
+        program.push_back(compile_term(tokens[0], op::load));
+        for(std::size_t i = 1; i < tokens.size(); i += 2) {
+            if(tokens[i] == "AND") {
+                program.push_back(compile_term(tokens[i + 1], op::and_));
+            } else if(tokens[i] == "OR") {
+                program.push_back(compile_term(tokens[i + 1], op::or_));
+            } else {
+                throw std::runtime_error("Expected AND or OR but got " + tokens[i]);
+            }
+        }
+
+        return program;
+    }
+
+    geometry_filter_set::instruction geometry_filter_set::compile_term(const std::string &term, op operation) {
+        static const std::string type_prefix = "geometry_type::";
+        static const std::string name_prefix = "name::";
+        static const std::string name_part_prefix = "name_part::";
+
+        if(term.compare(0, type_prefix.size(), type_prefix) == 0) {
+            // The Java code doesn't care what case the type is in
+            auto type_name = term.substr(type_prefix.size());
+            std::transform(type_name.begin(), type_name.end(), type_name.begin(), [](unsigned char c) { return std::tolower(c); });
+            try {
+                auto type = geometry_type::from_string(type_name);
+                return {operation, false, static_cast<std::uint32_t>(type.get_value())};
+            } catch(geometry_type::Exception&) {
+                throw std::runtime_error("There's no geometry type called " + type_name);
+            }
+
+        } else if(term.compare(0, name_prefix.size(), name_prefix) == 0) {
+            auto name = term.substr(name_prefix.size());
+            auto itr = name_attributes.find(name);
+            if(itr == name_attributes.end()) {
+                itr = name_attributes.emplace(name, num_attributes++).first;
+            }
+            return {operation, false, itr->second};
+
+        } else if(term.compare(0, name_part_prefix.size(), name_part_prefix) == 0) {
+            auto name_part = term.substr(name_part_prefix.size());
+            auto itr = std::find_if(name_part_attributes.begin(), name_part_attributes.end(),
+                                    [&](const auto& part) { return part.first == name_part; });
+            if(itr == name_part_attributes.end()) {
+                name_part_attributes.emplace_back(name_part, num_attributes++);
+                itr = name_part_attributes.end() - 1;
+            }
+            return {operation, false, itr->second};
+
+        } else if(term == "transparent") {
+            return {operation, false, transparent_attribute};
+
+        } else if(term == "not_transparent") {
+            return {operation, true, transparent_attribute};
+
+        } else if(term == "emissive") {
+            return {operation, false, emissive_attribute};
+
+        } else if(term == "not_emissive") {
+            return {operation, true, emissive_attribute};
+        }
+
+        throw std::runtime_error("Don't know what to do with the term " + term);
+    }
+
+    std::size_t geometry_filter_set::get_num_filters() const {
+        return filters.size();
+    }
+
+    const std::string &geometry_filter_set::get_shader_name(std::size_t filter) const {
+        return filters[filter].shader_name;
+    }
+
+    const std::string &geometry_filter_set::get_expression(std::size_t filter) const {
+        return filters[filter].expression;
+    }
+
+    bool geometry_filter_set::is_valid(std::size_t filter) const {
+        return !filters[filter].program.empty();
+    }
+
+    std::vector<std::uint32_t> geometry_filter_set::get_name_attributes(const std::string &name) const {
+        std::vector<std::uint32_t> attributes;
+        auto itr = name_attributes.find(name);
+        if(itr != name_attributes.end()) {
+            attributes.push_back(itr->second);
+        }
+        for(const auto& name_part : name_part_attributes) {
+            if(name.find(name_part.first) != std::string::npos) {
+                attributes.push_back(name_part.second);
+            }
+        }
+
+        return attributes;
+    }
+
+    bool geometry_filter_set::has_attribute(const geometry_attributes &item, const std::vector<std::uint32_t> &name_attributes, std::uint32_t attribute) const {
+        if(attribute == transparent_attribute) {
+            return item.is_transparent;
+
+        } else if(attribute == emissive_attribute) {
+            return item.is_emissive;
+
+        } else if(attribute < transparent_attribute) {
+            return static_cast<std::uint32_t>(item.type.get_value()) == attribute;
+        }
+
+        return std::find(name_attributes.begin(), name_attributes.end(), attribute) != name_attributes.end();
+    }
+
+    bool geometry_filter_set::matches(std::size_t filter, const geometry_attributes &item) const {
+        const auto& program = filters[filter].program;
+        if(program.empty()) {
+            return false;
+        }
+
+        auto item_name_attributes = get_name_attributes(item.name);
+        bool result = false;
+        for(const auto& instruction : program) {
+            auto value = has_attribute(item, item_name_attributes, instruction.attribute) != instruction.negate;
+            switch(instruction.operation) {
+                case op::load:
+                    result = value;
+                    break;
+                case op::and_:
+                    result = result && value;
+                    break;
+                case op::or_:
+                    result = result || value;
+                    break;
+            }
+        }
+
+        return result;
+    }
+
+    filter_matches geometry_filter_set::classify(const std::vector<geometry_attributes> &items) const {
+        filter_matches result(filters.size(), items.size());
+        auto num_words = result.get_num_words();
+        if(filters.empty() || items.empty()) {
+            return result;
+        }
+
+        // One bitset per attribute, saying which items have it. Then each instruction works on 64 items at once,
+        // in loops simple enough for the compiler to turn into SIMD instructions
+        std::vector<std::uint64_t> columns(num_attributes * num_words, 0);
+        std::unordered_map<std::string, std::vector<std::uint32_t>> seen_names;
+        for(std::size_t i = 0; i < items.size(); i++) {
+            const auto& item = items[i];
+            auto word = i / 64;
+            auto bit = 1ull << (i % 64);
+
+            auto type = static_cast<std::uint32_t>(item.type.get_value());
+            if(type < transparent_attribute) {
+                columns[type * num_words + word] |= bit;
+            }
+            if(item.is_transparent) {
+                columns[transparent_attribute * num_words + word] |= bit;
+            }
+            if(item.is_emissive) {
+                columns[emissive_attribute * num_words + word] |= bit;
+            }
+
+            // A chunk has thousands of blocks but only a few kinds of them, so each name's only checked once
+            auto name = seen_names.find(item.name);
+            if(name == seen_names.end()) {
+                name = seen_names.emplace(item.name, get_name_attributes(item.name)).first;
+            }
+            for(auto attribute : name->second) {
+                columns[attribute * num_words + word] |= bit;
+            }
+        }
+
+        for(std::size_t filter = 0; filter < filters.size(); filter++) {
+            auto words = result.get_words(filter);
+            for(const auto& instruction : filters[filter].program) {
+                const auto* column = columns.data() + instruction.attribute * num_words;
+                auto flip = instruction.negate ? ~0ull : 0ull;
+                switch(instruction.operation) {
+                    case op::load:
+                        for(std::size_t word = 0; word < num_words; word++) {
+                            words[word] = column[word] ^ flip;
+                        }
+                        break;
+                    case op::and_:
+                        for(std::size_t word = 0; word < num_words; word++) {
+                            words[word] &= column[word] ^ flip;
+                        }
+                        break;
+                    case op::or_:
+                        for(std::size_t word = 0; word < num_words; word++) {
+                            words[word] |= column[word] ^ flip;
+                        }
+                        break;
+                }
+            }
+
+            // Negated attributes set the bits past the last item, which aren't items at all
+            if(items.size() % 64 != 0) {
+                words[num_words - 1] &= (1ull << (items.size() % 64)) - 1;
+            }
+        }
+
+        return result;
+    }
+}
@@ -0,0 +1,178 @@
+/*!
+ * \brief Compiles the filter expressions from shaders.json, and uses them to sort lots of geometry into shaders at once
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_GEOMETRY_FILTER_H
+#define RENDERER_GEOMETRY_FILTER_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../render/objects/render_object.h"
+
+namespace nova {
+    /*!
+     * \brief The things about a block or render object that filters can look at
+     */
+    struct geometry_attributes {
+        std::string name;
+        geometry_type type;
+        bool is_transparent;
+        bool is_emissive;
+    };
+
+    /*!
+     * \brief Which items matched which filters, from geometry_filter_set::classify
+     *
+     * Each filter has a bitset with one bit per item, 64 items to a word. Item 0 is the lowest bit of the first word
+     */
+    class filter_matches {
+    public:
+        filter_matches(std::size_t num_filters, std::size_t num_items);
+
+        bool matches(std::size_t filter, std::size_t item) const;
+
+        /*!
+         * \brief The index of every item that matched the given filter, lowest first
+         */
+        std::vector<std::size_t> get_matching_items(std::size_t filter) const;
+
+        /*!
+         * \brief The bitset for the given filter. It's get_num_words() long, and the bits after the last item are 0
+         */
+        const std::uint64_t* get_words(std::size_t filter) const;
+
+        std::uint64_t* get_words(std::size_t filter);
+
+        std::size_t get_num_words() const;
+
+        std::size_t get_num_items() const;
+
+    private:
+        std::size_t num_items;
+        std::size_t num_words;
+        std::vector<std::uint64_t> bits;
+    };
+
+    /*!
+     * \brief The filters of every shader in a shaderpack, compiled into small programs
+     *
+     * Filters are expressions like "geometry_type::particle" or "name::sun OR name::moon". Each term is one of
+     * geometry_type::<type>, name::<name>, name_part::<part of a name>, transparent, not_transparent, emissive or
+     * not_emissive. Terms are joined with AND or OR, which are applied from left to right with no precedence, the same
+     * as the filters in the Java code
+     *
+     * Each term becomes a test of one attribute: one per geometry_type, one for transparency, one for emission, and one
+     * for each name and name part that a filter mentions. A filter's program loads, ANDs or ORs those attributes in
+     * order, and classify runs each program over 64 items at a time
+     *
+     * Nothing changes after the constructor, so any number of threads can use a filter set at once
+     */
+    class geometry_filter_set {
+    public:
+        geometry_filter_set() = default;
+
+        /*!
+         * \param filters The name of each shader and its filter expression. A filter that can't be compiled is
+         * logged and matches nothing
+         */
+        explicit geometry_filter_set(const std::vector<std::pair<std::string, std::string>> &filters);
+
+        std::size_t get_num_filters() const;
+
+        const std::string &get_shader_name(std::size_t filter) const;
+
+        /*!
+         * \brief The filter's expression, as it was given to the constructor
+         */
+        const std::string &get_expression(std::size_t filter) const;
+
+        /*!
+         * \brief False if the filter's expression couldn't be compiled, so it never matches anything
+         */
+        bool is_valid(std::size_t filter) const;
+
+        /*!
+         * \brief Checks one item against one filter. Use classify to check lots of things
+         */
+        bool matches(std::size_t filter, const geometry_attributes &item) const;
+
+        /*!
+         * \brief Checks every item against every filter
+         *
+         * Each distinct name is only compared against the filters' names once, however many items have it
+         */
+        filter_matches classify(const std::vector<geometry_attributes> &items) const;
+
+    private:
+        enum class op : std::uint8_t {
+            load,
+            and_,
+            or_
+        };
+
+        /*!
+         * \brief One step of a filter's program. The attribute is flipped before it's used if negate is set
+         */
+        struct instruction {
+            op operation;
+            bool negate;
+            std::uint32_t attribute;
+        };
+
+        struct compiled_filter {
+            std::string shader_name;
+            std::string expression;
+            std::vector<instruction> program;
+        };
+
+        std::vector<compiled_filter> filters;
+
+        /*!
+         * \brief Each geometry_type is the attribute with its value, then come these two, then every name and name
+         * part that a filter mentions, in the order they're first mentioned
+         */
+        std::uint32_t transparent_attribute = 0;
+        std::uint32_t emissive_attribute = 0;
+
+        std::unordered_map<std::string, std::uint32_t> name_attributes;
+
+        /*!
+         * \brief Each name part a filter looks for, and its attribute
+         */
+        std::vector<std::pair<std::string, std::uint32_t>> name_part_attributes;
+
+        std::uint32_t num_attributes = 0;
+
+        /*!
+         * \brief Turns an expression into a program, adding any names it mentions to the attributes
+         *
+         * \throws std::runtime_error if the expression doesn't make sense
+         */
+        std::vector<instruction> compile(const std::string &expression);
+
+        /*!
+         * \brief Turns a single term, like name::sun, into the instruction that tests it
+         */
+        instruction compile_term(const std::string &term, op operation);
+
+        /*!
+         * \brief The name and name part attributes that the given name has
+         */
+        std::vector<std::uint32_t> get_name_attributes(const std::string &name) const;
+
+        /*!
+         * \brief Whether the item has the given attribute
+         *
+         * \param name_attributes What get_name_attributes said about the item's name
+         */
+        bool has_attribute(const geometry_attributes &item, const std::vector<std::uint32_t> &name_attributes, std::uint32_t attribute) const;
+    };
+}
+
+#endif //RENDERER_GEOMETRY_FILTER_H
@@ -13,16 +13,40 @@
 #include "../../../render/nova_renderer.h"
 
 namespace nova {
-    std::vector<render_object>& mesh_store::get_meshes_for_shader(std::string shader_name) {
-        return renderables_grouped_by_shader[shader_name];
+    mesh_store::renderables::reader mesh_store::get_renderables_for_frame() {
+        return renderables_grouped_by_shader.read();
+    }
+
+    void mesh_store::reclaim_old_renderables() {
+        renderables_grouped_by_shader.reclaim();
     }
 
     void mesh_store::add_gui_buffers(mc_gui_geometry* command) {
+        renderables_grouped_by_shader.add({{"gui", {make_gui_render_object(command)}}});
+    }
+
+    void mesh_store::add_gui_buffers(std::vector<mc_gui_geometry> &commands) {
+        if(commands.empty()) {
+            return;
+        }
+
+        renderables::bucket new_gui;
+        new_gui.reserve(commands.size());
+        for(auto& command : commands) {
+            new_gui.push_back(make_gui_render_object(&command));
+        }
+
+        // Publish every element in one go so that we only make one new version per frame
+        renderables_grouped_by_shader.add({{"gui", std::move(new_gui)}});
+    }
+
+    std::shared_ptr<render_object> mesh_store::make_gui_render_object(mc_gui_geometry* command) {
         std::string texture_name(command->texture_name);
         texture_name = std::regex_replace(texture_name, std::regex("^textures/"), "");
         texture_name = std::regex_replace(texture_name, std::regex(".png$"), "");
         texture_name = "minecraft:" + texture_name;
-        const texture_manager::texture_location tex_location = nova_renderer::instance->get_texture_manager().get_texture_location(texture_name);
+        auto& textures = nova_renderer::instance->get_texture_manager();
+        const texture_manager::texture_location tex_location = textures.get_texture_location(texture_name);
         glm::vec2 tex_size = tex_location.max - tex_location.min;
 
         mesh_definition cur_screen_buffer = {};
@@ -52,45 +76,62 @@ namespace nova {
         gui.type = geometry_type::gui;
         gui.name = "gui";
         gui.color_texture = command->atlas_name;
+        gui.color_texture_handle = textures.get_texture_handle(gui.color_texture);
 
         // TODO: Something more intelligent
-        renderables_grouped_by_shader["gui"].push_back(std::move(gui));
+        return std::make_shared<render_object>(std::move(gui));
     }
 
     void mesh_store::remove_gui_render_objects() {
         remove_render_objects([](auto& render_obj) {return render_obj.type == geometry_type::gui;});
     }
 
-    void mesh_store::remove_render_objects(std::function<bool(render_object&)> filter) {
-        for(auto& group : renderables_grouped_by_shader) {
-            auto removed_elements = std::remove_if(group.second.begin(), group.second.end(), filter);
-            group.second.erase(removed_elements, group.second.end());
-        }
+    void mesh_store::remove_render_objects(std::function<bool(const render_object&)> filter) {
+        renderables_grouped_by_shader.remove_if(filter);
     }
 
     void mesh_store::upload_new_geometry() {
+        std::unordered_map<std::string, renderables::bucket> new_renderables;
+
+        // Null unless block textures come from the block texture array, in which case the chunks need their UVs
+        // turned into layers
+        auto& textures = nova_renderer::instance->get_texture_manager();
+        const block_layer_table* block_layers = textures.get_block_layers();
+        texture_handle block_atlas = textures.get_texture_handle(texture_manager::BLOCK_ATLAS_NAME);
+        texture_handle block_array = textures.get_texture_handle(texture_manager::BLOCK_ARRAY_NAME);
+
         chunk_parts_to_upload_lock.lock();
         while(!chunk_parts_to_upload.empty()) {
-            const auto& entry = chunk_parts_to_upload.front();
-            const auto& def = std::get<1>(entry);
+            auto& entry = chunk_parts_to_upload.front();
+            auto& def = std::get<1>(entry);
 
             render_object obj = {};
+            if(block_layers && block_layers->remap_vertices(def)) {
+                obj.color_texture = texture_manager::BLOCK_ARRAY_NAME;
+                obj.color_texture_handle = block_array;
+            } else {
+                obj.color_texture = texture_manager::BLOCK_ATLAS_NAME;
+                obj.color_texture_handle = block_atlas;
+            }
+
             obj.geometry = std::make_unique<gl_mesh>(def);
             obj.type = geometry_type::block;
             obj.name = "chunk";
             obj.parent_id = def.id;
-            obj.color_texture = "block_color";
             obj.position = def.position;
             obj.bounding_box.center = def.position;
             obj.bounding_box.center.y = 128;
             obj.bounding_box.extents = {16, 128, 16};   // TODO: Make these values come from Minecraft
 
             const std::string& shader_name = std::get<0>(entry);
-            renderables_grouped_by_shader[shader_name].push_back(std::move(obj));
+            new_renderables[shader_name].push_back(std::make_shared<render_object>(std::move(obj)));
 
             chunk_parts_to_upload.pop();
         }
         chunk_parts_to_upload_lock.unlock();
+
+        // Publish everything in one go so that we only make one new version per frame
+        renderables_grouped_by_shader.add(new_renderables);
     }
 
     void mesh_store::add_chunk_render_object(std::string filter_name, mc_chunk_render_object &chunk) {
@@ -125,6 +166,6 @@ namespace nova {
     }
 
     void mesh_store::remove_render_objects_with_parent(long parent_id) {
-        remove_render_objects([&](render_object& obj) { return obj.parent_id == parent_id; });
+        remove_render_objects([&](const render_object& obj) { return obj.parent_id == parent_id; });
     }
 }
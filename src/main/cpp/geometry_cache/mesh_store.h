@@ -17,17 +17,33 @@
 #include "../render/objects/shaders/shaderpack.h"
 #include "../mc_interface/mc_gui_objects.h"
 #include "../mc_interface/mc_objects.h"
+#include "versioned_buckets.h"
 
 namespace nova {
     /*!
          * \brief Provides access to the meshes that Nova will want to deal with
          *
          * The primary way it does this is by allowing the user to specify
+         *
+         * Render objects are kept in a versioned_buckets, so the render thread can iterate over them while other threads
+         * add and remove things. The render thread pins a version at the start of each frame with
+         * get_renderables_for_frame, and deletes versions nobody can see any more with reclaim_old_renderables once the
+         * frame is done. Reclaiming deletes meshes, so it has to happen on the thread with the OpenGL context
          */
     class mesh_store {
     public:
+        using renderables = versioned_buckets<render_object>;
+
         void add_gui_buffers(mc_gui_geometry* command);
 
+        /*!
+         * \brief Adds a whole screen's worth of GUI elements at once
+         *
+         * Each call to add_gui_buffers makes a new version of the render objects, so adding the elements one by one
+         * would copy the GUI bucket once per element
+         */
+        void add_gui_buffers(std::vector<mc_gui_geometry> &commands);
+
         /*!
          * \brief Adds a chunk to the mesh store if the chunk doesn't exist, or replaces the chunks if it does exist
          *
@@ -36,12 +52,17 @@ namespace nova {
         void add_chunk_render_object(std::string filter_name, mc_chunk_render_object &chunk);
 
         /*!
-         * \brief Retrieves the list of meshes that the shader with the provided name should render
+         * \brief Pins the current set of render objects. Nothing in it will change or be deleted until the returned
+         * reader is destroyed
          *
-         * \param shader_name The name of the shader to get meshes for
-         * \return All the meshes that should be rendered with the given name
+         * Use the reader's get method to retrieve the list of meshes that a given shader should render
          */
-        std::vector<render_object>& get_meshes_for_shader(std::string shader_name);
+        renderables::reader get_renderables_for_frame();
+
+        /*!
+         * \brief Deletes all the render objects that were removed and that no frame can see any more
+         */
+        void reclaim_old_renderables();
 
         /*!
          * \brief Takes geometry that's been added in the last frame and sends it to the GPU
@@ -63,7 +84,7 @@ namespace nova {
         void remove_render_objects_with_parent(long parent_id);
 
     private:
-        std::unordered_map<std::string, std::vector<render_object>> renderables_grouped_by_shader;
+        renderables renderables_grouped_by_shader;
 
         std::mutex chunk_parts_to_upload_lock;
         /*!
@@ -82,7 +103,12 @@ namespace nova {
          *
          * \param filter The function to use to decide which (if any) objects to remove
          */
-        void remove_render_objects(std::function<bool(render_object&)> fitler);
+        void remove_render_objects(std::function<bool(const render_object&)> filter);
+
+        /*!
+         * \brief Turns a GUI element from Minecraft into a render object, without adding it anywhere
+         */
+        std::shared_ptr<render_object> make_gui_render_object(mc_gui_geometry* command);
     };
 
 };
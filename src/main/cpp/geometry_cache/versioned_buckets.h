@@ -0,0 +1,167 @@
+/*!
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_VERSIONED_BUCKETS_H
+#define RENDERER_VERSIONED_BUCKETS_H
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../utils/epoch_reclaimer.h"
+
+namespace nova {
+    /*!
+     * \brief A map from name to list of things that one thread can render from while other threads change it
+     *
+     * Every change makes a new version of the map. Only the buckets that change get copied, and they only copy
+     * pointers, so the things themselves are shared between versions. Readers pin the current version with read, and
+     * see exactly that version until they let go of it, no matter what writers do in the meantime. Reading never takes
+     * a lock. Writers take a lock amongst themselves.
+     *
+     * Old versions, and the things that only they referenced, are deleted by reclaim. Call reclaim from the thread that
+     * should delete things - for render_objects that's the thread with the OpenGL context
+     *
+     * \tparam T The type of thing to put in the buckets
+     */
+    template <typename T>
+    class versioned_buckets {
+    public:
+        using bucket = std::vector<std::shared_ptr<T>>;
+        using bucket_map = std::unordered_map<std::string, std::shared_ptr<const bucket>>;
+
+        /*!
+         * \brief One version of the buckets, pinned for as long as this object lives
+         */
+        class reader {
+        public:
+            /*!
+             * \brief Returns the bucket with the given name, or an empty bucket if there's no such bucket
+             */
+            const bucket& get(const std::string& name) const {
+                static const bucket empty_bucket;
+
+                auto itr = buckets->find(name);
+                if(itr == buckets->end()) {
+                    return empty_bucket;
+                }
+
+                return *itr->second;
+            }
+
+            const bucket_map& get_all() const {
+                return *buckets;
+            }
+
+        private:
+            friend class versioned_buckets;
+
+            reader(epoch_guard&& guard, const bucket_map* buckets) : guard(std::move(guard)), buckets(buckets) {}
+
+            epoch_guard guard;
+            const bucket_map* buckets;
+        };
+
+        versioned_buckets() : current(new bucket_map()) {}
+
+        /*!
+         * \brief Make sure there are no readers left when you destroy this
+         */
+        ~versioned_buckets() {
+            delete current.load();
+        }
+
+        reader read() {
+            // Pin before loading the pointer, or the version we load could be deleted before we pin it
+            auto guard = reclaimer.pin();
+            return reader(std::move(guard), current.load());
+        }
+
+        /*!
+         * \brief Adds things to the buckets with the given names, publishing a single new version
+         *
+         * \param additions A map from bucket name to the things to add to that bucket
+         */
+        void add(const std::unordered_map<std::string, bucket>& additions) {
+            if(additions.empty()) {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(writer_lock);
+            auto new_version = std::make_unique<bucket_map>(*current.load());
+
+            for(const auto& addition : additions) {
+                auto& old_bucket = (*new_version)[addition.first];
+
+                auto new_bucket = old_bucket ? std::make_shared<bucket>(*old_bucket) : std::make_shared<bucket>();
+                new_bucket->insert(new_bucket->end(), addition.second.begin(), addition.second.end());
+                old_bucket = std::move(new_bucket);
+            }
+
+            publish(std::move(new_version));
+        }
+
+        /*!
+         * \brief Removes everything that the filter returns true for from every bucket
+         *
+         * If nothing matches, no new version is published
+         */
+        void remove_if(const std::function<bool(const T&)>& filter) {
+            std::lock_guard<std::mutex> lock(writer_lock);
+            const bucket_map* old_version = current.load();
+            std::unique_ptr<bucket_map> new_version;
+
+            for(const auto& entry : *old_version) {
+                const bucket& old_bucket = *entry.second;
+                auto first_removed = std::find_if(old_bucket.begin(), old_bucket.end(), [&](const std::shared_ptr<T>& thing) {
+                    return filter(*thing);
+                });
+                if(first_removed == old_bucket.end()) {
+                    continue;
+                }
+
+                auto new_bucket = std::make_shared<bucket>(old_bucket.begin(), first_removed);
+                std::copy_if(first_removed, old_bucket.end(), std::back_inserter(*new_bucket), [&](const std::shared_ptr<T>& thing) {
+                    return !filter(*thing);
+                });
+
+                if(!new_version) {
+                    new_version = std::make_unique<bucket_map>(*old_version);
+                }
+                (*new_version)[entry.first] = std::move(new_bucket);
+            }
+
+            if(new_version) {
+                publish(std::move(new_version));
+            }
+        }
+
+        /*!
+         * \brief Deletes every old version that no reader can see any more, on the calling thread
+         *
+         * \return The number of versions deleted
+         */
+        std::size_t reclaim() {
+            return reclaimer.reclaim();
+        }
+
+    private:
+        std::mutex writer_lock;
+        std::atomic<const bucket_map*> current;
+        epoch_reclaimer reclaimer;
+
+        void publish(std::unique_ptr<bucket_map> new_version) {
+            const bucket_map* old_version = current.exchange(new_version.release());
+            reclaimer.retire([old_version]() { delete old_version; });
+        }
+    };
+}
+
+#endif //RENDERER_VERSIONED_BUCKETS_H
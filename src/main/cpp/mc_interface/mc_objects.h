@@ -206,4 +206,23 @@ struct window_size {
     int height;
     int width;
 };
+
+/*!
+ * \brief How far along Nova is in switching to a new shaderpack
+ */
+struct shaderpack_loading_status {
+    int is_loading;         //!< 1 from when a new shaderpack is asked for until it's in use, 0 otherwise
+    int num_shaders;        //!< How many shaders the new shaderpack has. 0 until its files have been read
+    int num_shaders_done;   //!< How many of them have compiled or failed to
+};
+
+/*!
+ * \brief A block or other thing to be sorted into shaders by their filters
+ */
+struct mc_geometry_attributes {
+    const char* name;       //!< The name that name:: and name_part:: filters look at, like "stone"
+    int type;               //!< The value of its geometry_type, like 0 for a block
+    int is_transparent;
+    int is_emissive;
+};
 #endif //RENDERER_MC_OBJECTS_H
@@ -50,6 +50,24 @@ NOVA_API void send_lightmap_texture(int* data, int count, int width, int height)
  */
 NOVA_API void add_texture(mc_atlas_texture & texture);
 
+/*!
+ * \brief Adds a single texture for Nova to pack into one of its own atlases
+ *
+ * Use this instead of add_texture and add_texture_location when you'd rather Nova decide where everything goes. The
+ * sprite can't be used until finalize_textures is called
+ *
+ * \param sprite The texture to pack. Its name is the name that its location will be stored under
+ */
+NOVA_API void add_sprite(mc_atlas_texture & sprite);
+
+/*!
+ * \brief Packs all the sprites sent with add_sprite since the last call into atlases, and figures out their texture
+ * locations
+ *
+ * Can be called more than once. Sprites that were already packed stay where they are
+ */
+NOVA_API void finalize_textures();
+
 /*!
  * \brief Adds the given location to the list of texture locations
  *
@@ -171,10 +189,32 @@ NOVA_API struct key_press_event  get_next_key_press_event();
 
 NOVA_API struct key_char_event  get_next_key_char_event();
 
+/*!
+ * \brief Says how far along loading a new shaderpack is
+ *
+ * Shaderpacks load in the background, and the old one keeps being used until the new one's ready. Once is_loading goes
+ * back to 0, get_shaders_and_filters has the new shaderpack's filters
+ */
+NOVA_API struct shaderpack_loading_status get_shaderpack_loading_status();
+
 NOVA_API int get_num_loaded_shaders();
 
 NOVA_API char* get_shaders_and_filters();
 
+/*!
+ * \brief Checks lots of blocks or other things against the filter of every shader at once
+ *
+ * \param items The things to check
+ * \param num_items How many things there are
+ * \param matches Where to write which things each filter matched. Each filter gets (num_items + 63) / 64 words, one bit
+ * per thing with the first thing in the lowest bit of the first word. The filters are in the same order as
+ * get_shaders_and_filters gives them, since both read the shaderpack's one list of filters. That only goes wrong if a new
+ * shaderpack finished loading in between, which get_shaderpack_loading_status tells you about
+ * \param max_filters How many filters matches has room for
+ * \return How many filters were written to matches
+ */
+NOVA_API int classify_geometry(const struct mc_geometry_attributes* items, int num_items, std::uint64_t* matches, int max_filters);
+
 };  // End extern C
     // I don't like doing this, but I just saw this closing curly brace and freaked out a little bit.
     // Random closing braces are not okay.
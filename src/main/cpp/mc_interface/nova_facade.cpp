@@ -9,13 +9,19 @@
  * The function in this file simply set data. Data is copied out of Minecraft objects. This might be a bit slow, but I
  * don't want to save a pointer that gets re-allocated by the JVM. I don't trust it enough (although maybe I should?)
  *
+ * These functions are called from the Minecraft thread, but the OpenGL context lives on the render thread. Anything
+ * that changes what gets rendered goes into the next frame's snapshot, and anything that needs OpenGL or the window
+ * goes in as a task for the render thread to run before it renders that frame
+ *
  * \author David
  */
 
+#include <algorithm>
 #include "glad/glad.h"
 #include "nova.h"
 #include "../utils/export.h"
 #include "../render/nova_renderer.h"
+#include "../render/render_thread.h"
 #include "../render/objects/textures/texture_manager.h"
 #include "../data_loading/settings.h"
 #include "../input/InputHandler.h"
@@ -32,42 +38,82 @@ using namespace nova;
 #define TEXTURE_MANAGER NOVA_RENDERER->get_texture_manager()
 #define INPUT_HANDLER NOVA_RENDERER->get_input_handler()
 #define MESH_STORE NOVA_RENDERER->get_mesh_store()
+#define NEXT_FRAME render_thread::instance->get_next_frame()
 
 #define PROFILER nova::profiler
-// runs in thread 5
 
 NOVA_API void initialize() {
     PROFILER::start("initialize");
-    nova_renderer::init();
+    render_thread::start();
     PROFILER::end("initialize");
 }
 
 NOVA_API void add_texture(mc_atlas_texture & texture) {
     PROFILER::start("add_texture");
-    TEXTURE_MANAGER.add_texture(texture);
+    // Copy the data out of the JVM now, but leave converting and uploading it to the texture streamer
+    auto request = std::make_shared<texture_upload_request>();
+    request->name = texture.name;
+    request->width = texture.width;
+    request->height = texture.height;
+    request->num_components = texture.num_components;
+    request->data.assign(texture.texture_data, texture.texture_data + texture.width * texture.height * texture.num_components);
+
+    NEXT_FRAME.render_thread_tasks.push_back([request]() {
+        TEXTURE_MANAGER.add_texture_async(std::move(*request));
+    });
     PROFILER::end("add_texture");
 }
 
+NOVA_API void add_sprite(mc_atlas_texture & sprite) {
+    PROFILER::start("add_sprite");
+    std::string name = sprite.name;
+    mc_atlas_texture sprite_copy = sprite;
+    std::vector<unsigned char> pixels(sprite.texture_data, sprite.texture_data + sprite.width * sprite.height * sprite.num_components);
+
+    NEXT_FRAME.render_thread_tasks.push_back([=]() mutable {
+        sprite_copy.name = name.c_str();
+        sprite_copy.texture_data = pixels.data();
+        TEXTURE_MANAGER.add_sprite(sprite_copy);
+    });
+    PROFILER::end("add_sprite");
+}
+
+NOVA_API void finalize_textures() {
+    NEXT_FRAME.render_thread_tasks.push_back([]() {
+        TEXTURE_MANAGER.finalize_textures();
+    });
+}
+
 NOVA_API void reset_texture_manager() {
     PROFILER::start("reset_texture_manager");
-    TEXTURE_MANAGER.reset();
-    PROFILER::end("reset_texture_mamager");
+    NEXT_FRAME.render_thread_tasks.push_back([]() {
+        TEXTURE_MANAGER.reset();
+    });
+    PROFILER::end("reset_texture_manager");
 }
 
 NOVA_API void send_lightmap_texture(int* data, int count, int width, int height) {
-    auto size = glm::ivec2{width, height};
-    TEXTURE_MANAGER.update_texture("lightmap", data, size, GL_BGRA, GL_UNSIGNED_BYTE);
-    auto& lightmap = TEXTURE_MANAGER.get_texture("lightmap");
-    lightmap.bind(4);
+    std::vector<int> lightmap_data(data, data + count);
+    NEXT_FRAME.render_thread_tasks.push_back([=]() {
+        // No need to bind it here. render_shader binds the lightmap to unit 3 for every draw
+        TEXTURE_MANAGER.update_lightmap(lightmap_data.data(), {width, height});
+    });
 }
 
 NOVA_API void add_texture_location(mc_texture_atlas_location location) {
     PROFILER::start("add_texture_location");
-    TEXTURE_MANAGER.add_texture_location(location);
+    mc_texture_atlas_location location_copy = location;
+    std::string name = location.name;
+
+    NEXT_FRAME.render_thread_tasks.push_back([=]() mutable {
+        location_copy.name = name.c_str();
+        TEXTURE_MANAGER.add_texture_location(location_copy);
+    });
     PROFILER::end("add_texture_location");
 }
 
 NOVA_API int get_max_texture_size() {
+    // The render thread asks OpenGL for this when it starts up, so this just returns the cached value
     return TEXTURE_MANAGER.get_max_texture_size();
 }
 
@@ -79,7 +125,7 @@ NOVA_API void add_chunk_geometry_for_filter(const char* filter_name, mc_chunk_re
 
 NOVA_API void execute_frame() {
     PROFILER::start("execute_frame");
-    NOVA_RENDERER->render_frame();
+    render_thread::instance->submit_frame();
     PROFILER::end("execute_frame");
 }
 
@@ -89,7 +135,9 @@ NOVA_API void set_fullscreen(int fullscreen) {
     if(fullscreen == 1) {
         temp_bool = true;
     }
-    NOVA_RENDERER->get_game_window().set_fullscreen(temp_bool);
+    NEXT_FRAME.render_thread_tasks.push_back([=]() {
+        NOVA_RENDERER->get_game_window().set_fullscreen(temp_bool);
+    });
     PROFILER::end("set_fullscreen");
 }
 
@@ -103,7 +151,7 @@ NOVA_API bool display_is_active() {
 
 NOVA_API void add_gui_geometry(mc_gui_geometry * gui_geometry) {
     PROFILER::start("add_gui_geometry");
-    NOVA_RENDERER->get_mesh_store().add_gui_buffers(gui_geometry);
+    NEXT_FRAME.gui_geometry.emplace_back(*gui_geometry);
     PROFILER::end("add_gui_geometry");
 }
 
@@ -115,32 +163,30 @@ NOVA_API struct window_size get_window_size()
 
 NOVA_API void clear_gui_buffers() {
     PROFILER::start("clear_gui_buffers");
-    NOVA_RENDERER->get_mesh_store().remove_gui_render_objects();
+    auto& next_frame = NEXT_FRAME;
+    next_frame.gui_was_cleared = true;
+    next_frame.gui_geometry.clear();
     PROFILER::end("clear_gui_buffers");
 }
 
 NOVA_API void set_string_setting(const char * setting_name, const char * setting_value) {
     PROFILER::start("set_string_setting");
-    settings& settings = NOVA_RENDERER->get_render_settings();
-    settings.get_options()["settings"][setting_name] = setting_value;
-    settings.update_config_changed();
+    NEXT_FRAME.changed_settings[setting_name] = setting_value;
     PROFILER::end("set_string_setting");
 }
 
 NOVA_API void set_float_setting(const char * setting_name, float setting_value) {
     PROFILER::start("set_float_setting");
-    settings& settings = NOVA_RENDERER->get_render_settings();
-    settings.get_options()["settings"][setting_name] = setting_value;
-    settings.update_config_changed();
+    NEXT_FRAME.changed_settings[setting_name] = setting_value;
     PROFILER::end("set_float_setting");
 }
 
 NOVA_API void set_player_camera_transform(double x, double y, double z, float yaw, float pitch) {
     PROFILER::start("set_player_camera_transform");
-    auto& player_camera = NOVA_RENDERER->get_player_camera();
-
-    player_camera.position = {x, y, z};
-    player_camera.rotation = {yaw, pitch};
+    auto& next_frame = NEXT_FRAME;
+    next_frame.has_camera_transform = true;
+    next_frame.camera_position = {x, y, z};
+    next_frame.camera_rotation = {yaw, pitch};
     PROFILER::end("set_player_camera_transform");
 }
 
@@ -167,7 +213,14 @@ NOVA_API struct key_char_event get_next_key_char_event()
 }
 
 NOVA_API void set_mouse_grabbed(int grabbed) {
-    NOVA_RENDERER->get_game_window().set_mouse_grabbed(grabbed != 0);
+    NEXT_FRAME.render_thread_tasks.push_back([=]() {
+        NOVA_RENDERER->get_game_window().set_mouse_grabbed(grabbed != 0);
+    });
+}
+
+NOVA_API struct shaderpack_loading_status get_shaderpack_loading_status() {
+    auto progress = NOVA_RENDERER->get_shaderpack_loading_progress();
+    return {progress.is_loading ? 1 : 0, static_cast<int>(progress.num_shaders), static_cast<int>(progress.num_shaders_done)};
 }
 
 NOVA_API int get_num_loaded_shaders() {
@@ -176,26 +229,31 @@ NOVA_API int get_num_loaded_shaders() {
 
 NOVA_API char* get_shaders_and_filters() {
     PROFILER::start("set_shaders_and_filters");
-    auto& shaders = NOVA_RENDERER->get_shaders()->get_loaded_shaders();
+    // Hold on to the shaderpack so the render thread can't free it out from under us. The shaders come out in the
+    // filters' order, which is the order classify_geometry writes its matches in
+    auto loaded_shaderpack = NOVA_RENDERER->get_shaders();
+    const auto& shader_filters = loaded_shaderpack->get_filters();
 
     int num_chars = 0;
-    for(auto& s : shaders) {
-        num_chars += s.first.size();
-        num_chars += s.second.get_filter().size();
+    for(std::size_t i = 0; i < shader_filters.get_num_filters(); i++) {
+        num_chars += shader_filters.get_shader_name(i).size();
+        num_chars += shader_filters.get_expression(i).size();
         num_chars += 2;
     }
 
     auto* filters = new char[num_chars];
     int write_pos = 0;
-    for(auto& entry : shaders) {
-        std::strcpy(&filters[write_pos], entry.first.data());
-        write_pos += entry.first.size();
+    for(std::size_t i = 0; i < shader_filters.get_num_filters(); i++) {
+        const auto& name = shader_filters.get_shader_name(i);
+        std::strcpy(&filters[write_pos], name.data());
+        write_pos += name.size();
 
         filters[write_pos] = '\n';
         write_pos++;
 
-        std::strcpy(&filters[write_pos], entry.second.get_filter().data());
-        write_pos += entry.second.get_filter().size();
+        const auto& expression = shader_filters.get_expression(i);
+        std::strcpy(&filters[write_pos], expression.data());
+        write_pos += expression.size();
 
         filters[write_pos] = '\n';
         write_pos++;
@@ -205,3 +263,26 @@ NOVA_API char* get_shaders_and_filters() {
     PROFILER::end("set_shaders_and_filters");
     return filters;
 }
+
+NOVA_API int classify_geometry(const mc_geometry_attributes* items, int num_items, std::uint64_t* matches, int max_filters) {
+    PROFILER::start("classify_geometry");
+    // Hold on to the shaderpack so the render thread can't free it out from under us
+    auto loaded_shaderpack = NOVA_RENDERER->get_shaders();
+    const auto& filters = loaded_shaderpack->get_filters();
+
+    std::vector<geometry_attributes> attributes;
+    attributes.reserve(static_cast<std::size_t>(num_items));
+    for(int i = 0; i < num_items; i++) {
+        attributes.push_back({items[i].name, geometry_type(items[i].type), items[i].is_transparent != 0, items[i].is_emissive != 0});
+    }
+
+    auto result = filters.classify(attributes);
+    auto num_filters = std::min(static_cast<int>(filters.get_num_filters()), max_filters);
+    for(int filter = 0; filter < num_filters; filter++) {
+        auto words = result.get_words(static_cast<std::size_t>(filter));
+        std::copy(words, words + result.get_num_words(), matches + filter * result.get_num_words());
+    }
+
+    PROFILER::end("classify_geometry");
+    return num_filters;
+}
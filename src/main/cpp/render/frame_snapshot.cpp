@@ -0,0 +1,59 @@
+/*!
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <iterator>
+#include "frame_snapshot.h"
+
+namespace nova {
+    gui_geometry_snapshot::gui_geometry_snapshot(const mc_gui_geometry& geometry) :
+            texture_name(geometry.texture_name),
+            atlas_name(geometry.atlas_name),
+            vertex_buffer(geometry.vertex_buffer, geometry.vertex_buffer + geometry.vertex_buffer_size),
+            index_buffer(geometry.index_buffer, geometry.index_buffer + geometry.index_buffer_size) {}
+
+    mc_gui_geometry gui_geometry_snapshot::to_mc_gui_geometry() {
+        mc_gui_geometry geometry = {};
+        geometry.texture_name = texture_name.c_str();
+        geometry.atlas_name = atlas_name.c_str();
+        geometry.vertex_buffer = vertex_buffer.data();
+        geometry.vertex_buffer_size = (int) vertex_buffer.size();
+        geometry.index_buffer = index_buffer.data();
+        geometry.index_buffer_size = (int) index_buffer.size();
+
+        return geometry;
+    }
+
+    void frame_snapshot::merge_newer(frame_snapshot&& newer) {
+        if(newer.has_camera_transform) {
+            has_camera_transform = true;
+            camera_position = newer.camera_position;
+            camera_rotation = newer.camera_rotation;
+        }
+
+        if(newer.gui_was_cleared) {
+            gui_was_cleared = true;
+            gui_geometry = std::move(newer.gui_geometry);
+
+        } else {
+            gui_geometry.insert(gui_geometry.end(), std::make_move_iterator(newer.gui_geometry.begin()),
+                                std::make_move_iterator(newer.gui_geometry.end()));
+        }
+
+        for(auto itr = newer.changed_settings.begin(); itr != newer.changed_settings.end(); ++itr) {
+            changed_settings[itr.key()] = itr.value();
+        }
+
+        render_thread_tasks.insert(render_thread_tasks.end(), std::make_move_iterator(newer.render_thread_tasks.begin()),
+                                   std::make_move_iterator(newer.render_thread_tasks.end()));
+    }
+
+    void frame_snapshot::clear() {
+        has_camera_transform = false;
+        gui_was_cleared = false;
+        gui_geometry.clear();
+        changed_settings = nlohmann::json::object();
+        render_thread_tasks.clear();
+    }
+}
@@ -0,0 +1,84 @@
+/*!
+ * \brief Everything that the game thread tells the render thread about a single frame
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_FRAME_SNAPSHOT_H
+#define RENDERER_FRAME_SNAPSHOT_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <json.hpp>
+#include "../mc_interface/mc_objects.h"
+
+namespace nova {
+    /*!
+     * \brief A copy of a piece of GUI geometry that was sent to us by Minecraft
+     *
+     * The pointers in mc_gui_geometry belong to the JVM and are only valid during the call that gave them to us, so
+     * we have to copy the data before the call returns
+     */
+    struct gui_geometry_snapshot {
+        std::string texture_name;
+        std::string atlas_name;
+        std::vector<float> vertex_buffer;
+        std::vector<int> index_buffer;
+
+        gui_geometry_snapshot() = default;
+
+        explicit gui_geometry_snapshot(const mc_gui_geometry& geometry);
+
+        /*!
+         * \brief Makes an mc_gui_geometry that points into this snapshot, so the mesh_store can read it as if it came
+         * straight from Minecraft
+         */
+        mc_gui_geometry to_mc_gui_geometry();
+    };
+
+    /*!
+     * \brief All the state that Minecraft changed since the last frame
+     *
+     * The game thread fills one of these in as Minecraft calls into Nova, then publishes it when Minecraft calls
+     * execute_frame. The render thread applies it right before rendering. Once published, a snapshot isn't changed by
+     * the game thread until the render thread hands it back
+     */
+    struct frame_snapshot {
+        bool has_camera_transform = false;
+        glm::vec3 camera_position;
+        glm::vec2 camera_rotation;
+
+        /*!
+         * \brief If true, all the GUI geometry from previous frames should be thrown away before adding gui_geometry
+         */
+        bool gui_was_cleared = false;
+        std::vector<gui_geometry_snapshot> gui_geometry;
+
+        /*!
+         * \brief The settings that changed this frame, as a JSON object from setting name to new value
+         */
+        nlohmann::json changed_settings = nlohmann::json::object();
+
+        /*!
+         * \brief Things that have to run on the render thread because they touch OpenGL or the window, in the order
+         * that Minecraft asked for them
+         */
+        std::vector<std::function<void()>> render_thread_tasks;
+
+        /*!
+         * \brief Folds a snapshot from a later frame into this one, for when the render thread falls behind the game
+         * thread
+         *
+         * The newer camera transform wins, the newer GUI replaces the old GUI if it was cleared, and settings and tasks
+         * are appended so none of them get lost
+         */
+        void merge_newer(frame_snapshot&& newer);
+
+        void clear();
+    };
+}
+
+#endif //RENDERER_FRAME_SNAPSHOT_H
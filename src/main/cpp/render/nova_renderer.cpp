@@ -5,6 +5,8 @@
 #include "nova_renderer.h"
 #include "../utils/utils.h"
 #include "../data_loading/loaders/loaders.h"
+#include "../data_loading/loaders/loader_utils.h"
+#include "../data_loading/loaders/shader_loading.h"
 #include "../utils/profiler.h"
 
 #include <easylogging++.h>
@@ -20,6 +22,7 @@ namespace nova {
         enable_debug();
         ubo_manager = std::make_unique<uniform_buffer_store>();
         textures = std::make_unique<texture_manager>();
+        lightmap_handle = textures->get_texture_handle("lightmap");
         meshes = std::make_unique<mesh_store>();
         inputs = std::make_unique<input_handler>();
 		render_settings->register_change_listener(ubo_manager.get());
@@ -54,6 +57,12 @@ namespace nova {
     }
 
     nova_renderer::~nova_renderer() {
+        // Everything's going away with the context, so there's no need to wait for the GPU
+        for(auto& retired : retired_shaderpacks) {
+            glDeleteSync(retired.fence);
+        }
+        retired_shaderpacks.clear();
+
         inputs.reset();
         meshes.reset();
         textures.reset();
@@ -63,34 +72,56 @@ namespace nova {
 
     void nova_renderer::render_frame() {
         profiler::log_all_profiler_data();
-        player_camera.recalculate_frustum();
+
+        // Chunks need the block texture array to be up to date before they can use it
+        textures->update_block_texture_array();
 
         // Make geometry for any new chunks
         meshes->upload_new_geometry();
 
+        reload_edited_shaders();
+
+        // A new shaderpack compiles alongside the loaded one, which is drawn with until the new one's ready
+        update_pending_shaderpack();
 
-        // upload shadow UBO things
+        // Shaders that aren't ready yet are drawn with their fallbacks, so this never waits long for the driver
+        link_up_uniform_buffers(loaded_shaderpack->update_programs(), *ubo_manager);
 
-        render_shadow_pass();
+        // Send the next bit of any textures that are streaming in
+        textures->upload_streamed_textures();
 
-        // main_framebuffer->bind();
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        update_gbuffer_ubos();
+        {
+            // Everything we render this frame comes from this version of the render objects, no matter what other
+            // threads add or remove while we're rendering
+            auto renderables = meshes->get_renderables_for_frame();
 
-        render_gbuffers();
+            // upload shadow UBO things
 
-        render_composite_passes();
+            render_shadow_pass();
 
-        //glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        //glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        render_final_pass();
+            // main_framebuffer->bind();
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            update_gbuffer_ubos();
 
-        // We want to draw the GUI on top of the other things, so we'll render it last
-        // Additionally, I could use the stencil buffer to not draw MC underneath the GUI. Could be a fun
-        // optimization - I'd have to watch out for when the user hides the GUI, though. I can just re-render the
-        // stencil buffer when the GUI screen changes
-        render_gui();
+            render_gbuffers(renderables);
+
+            render_composite_passes();
+
+            //glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            //glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            render_final_pass();
+
+            // We want to draw the GUI on top of the other things, so we'll render it last
+            // Additionally, I could use the stencil buffer to not draw MC underneath the GUI. Could be a fun
+            // optimization - I'd have to watch out for when the user hides the GUI, though. I can just re-render the
+            // stencil buffer when the GUI screen changes
+            render_gui(renderables);
+        }
 
+        // Now that we're done with the frame, delete anything that was removed while we rendered it
+        meshes->reclaim_old_renderables();
+
+        player_camera.end_frame();
         game_window->end_frame();
     }
 
@@ -98,14 +129,12 @@ namespace nova {
         LOG(TRACE) << "Rendering shadow pass";
     }
 
-    void nova_renderer::render_gbuffers() {
+    void nova_renderer::render_gbuffers(const mesh_store::renderables::reader& renderables) {
         LOG(TRACE) << "Rendering gbuffer pass";
 
         // TODO: Get shaders with gbuffers prefix, draw transparents last, etc
-        auto& terrain_shader = loaded_shaderpack->get_shader("gbuffers_terrain");
-        render_shader(terrain_shader);
-        auto& water_shader = loaded_shaderpack->get_shader("gbuffers_water");
-        render_shader(water_shader);
+        render_shader("gbuffers_terrain", renderables);
+        render_shader("gbuffers_water", renderables);
     }
 
     void nova_renderer::render_composite_passes() {
@@ -118,22 +147,25 @@ namespace nova {
         //meshes->get_fullscreen_quad->draw();
     }
 
-    void nova_renderer::render_gui() {
+    void nova_renderer::render_gui(const mesh_store::renderables::reader& renderables) {
         LOG(TRACE) << "Rendering GUI";
         glClear(GL_DEPTH_BUFFER_BIT);
 
         // Bind all the GUI data
         auto &gui_shader = loaded_shaderpack->get_shader("gui");
+        if(!gui_shader.is_ready()) {
+            return;
+        }
         gui_shader.bind();
 
         upload_gui_model_matrix(gui_shader);
 
         // Render GUI objects
-        std::vector<render_object>& gui_geometry = meshes->get_meshes_for_shader("gui");
-        for(const auto& geom : gui_geometry) {
-            if (!geom.color_texture.empty()) {
-                auto color_texture = textures->get_texture(geom.color_texture);
-                color_texture.bind(0);
+        const auto& gui_geometry = renderables.get("gui");
+        for(const auto& geom_ptr : gui_geometry) {
+            const auto& geom = *geom_ptr;
+            if (geom.color_texture_handle != NO_TEXTURE) {
+                textures->get_texture(geom.color_texture_handle).bind(0);
             }
             geom.geometry->set_active();
             geom.geometry->draw();
@@ -234,22 +266,92 @@ namespace nova {
     }
 
     void nova_renderer::on_config_change(nlohmann::json &new_config) {
+        float view_width = new_config["viewWidth"];
+        float view_height = new_config["viewHeight"];
+        if(view_width > 0 && view_height > 0) {
+            player_camera.set_aspect_ratio(view_width / view_height);
+        }
+
+        if(new_config.find("textureCompression") != new_config.end()) {
+            textures->set_atlas_compression(texture_compression_from_string(new_config["textureCompression"]));
+        }
+
+        if(new_config.find("blockTextures") != new_config.end()) {
+            textures->set_block_texture_mode(block_texture_mode_from_string(new_config["blockTextures"]));
+        }
+
 		auto& shaderpack_name = new_config["loadedShaderpack"];
         LOG(INFO) << "Shaderpack in settings: " << shaderpack_name;
 
         if(!loaded_shaderpack) {
             LOG(DEBUG) << "There's currenty no shaderpack, so we're loading a new one";
             load_new_shaderpack(shaderpack_name);
+
+        } else {
+            // A shaderpack that's still loading is the one that'll be used, so it's the one to compare against
+            auto current_name = pending_shaderpack_name.empty() ? loaded_shaderpack->get_name() : pending_shaderpack_name;
+            if(shaderpack_name != current_name) {
+                LOG(DEBUG) << "Shaderpack " << shaderpack_name << " is about to replace shaderpack " << current_name;
+                load_new_shaderpack(shaderpack_name);
+            }
+        }
+
+        LOG(DEBUG) << "Finished dealing with possible new shaderpack";
+
+        if(new_config.find("shaderpackOptions") != new_config.end()) {
+            loaded_shaderpack->set_options(new_config["shaderpackOptions"]);
+            if(pending_shaderpack) {
+                pending_shaderpack->set_options(new_config["shaderpackOptions"]);
+            }
+        }
+
+        bool hot_reload = new_config.find("shaderHotReload") != new_config.end() && new_config["shaderHotReload"].get<bool>();
+        if(hot_reload != (shaderpack_files != nullptr)) {
+            watch_shaderpack_files(hot_reload);
+        }
+    }
+
+    void nova_renderer::watch_shaderpack_files(bool should_watch) {
+        shaderpack_files.reset();
+        if(!should_watch || !loaded_shaderpack) {
             return;
         }
 
-        bool shaderpack_in_settings_is_new = shaderpack_name != loaded_shaderpack->get_name();
-        if(shaderpack_in_settings_is_new) {
-            LOG(DEBUG) << "Shaderpack " << shaderpack_name << " is about to replace shaderpack " << loaded_shaderpack->get_name();
+        auto shaderpack_path = "shaderpacks/" + loaded_shaderpack->get_name();
+        if(is_zip_file(shaderpack_path)) {
+            LOG(WARNING) << "Shaderpack " << loaded_shaderpack->get_name() << " is zipped, so it can't be reloaded when it's edited";
+            return;
+        }
+
+        shaderpack_files = std::make_unique<shaderpack_watcher>(shaderpack_path);
+    }
+
+    void nova_renderer::reload_edited_shaders() {
+        if(!shaderpack_files) {
+            return;
+        }
+
+        auto changed_files = shaderpack_files->get_changed_files();
+        if(changed_files.empty()) {
+            return;
+        }
+
+        auto shaderpack_name = loaded_shaderpack->get_name();
+        if(changed_files.find("shaderpacks/" + shaderpack_name + "/shaders.json") != changed_files.end()) {
+            // Shaders, filters and fallbacks could all be different, so nothing from the old pack can be kept
+            LOG(INFO) << "shaders.json changed, so reloading all of " << shaderpack_name;
             load_new_shaderpack(shaderpack_name);
+            return;
         }
 
-        LOG(DEBUG) << "Finished dealing with possible new shaderpack";
+        auto edited_shaders = loaded_shaderpack->get_shaders_using(changed_files);
+        if(edited_shaders.empty()) {
+            return;
+        }
+
+        LOG(INFO) << "Reloading " << edited_shaders.size() << " shaders that use the " << changed_files.size() << " changed files";
+        auto shaders = reload_shaders_from_folder(shaderpack_name, edited_shaders, shader_workers);
+        loaded_shaderpack->reload_shaders(shaders);
     }
 
     void nova_renderer::on_config_loaded(nlohmann::json &config) {
@@ -279,17 +381,148 @@ namespace nova {
     void nova_renderer::load_new_shaderpack(const std::string &new_shaderpack_name) {
 		LOG(INFO) << "Loading a new shaderpack";
         LOG(INFO) << "Name of shaderpack " << new_shaderpack_name;
-        loaded_shaderpack = std::make_shared<shaderpack>(load_shaderpack(new_shaderpack_name));
+
+        if(!loaded_shaderpack) {
+            // There's nothing to draw with in the meantime, so there's no point reading it on another thread
+            auto sources = load_shaderpack_sources(new_shaderpack_name, shader_workers);
+            create_pending_shaderpack(sources);
+            swap_in_pending_shaderpack();
+            return;
+        }
+
+        // A shaderpack that was loading is replaced by this one. It was never drawn with, so it can go straight away
+        if(pending_shaderpack) {
+            pending_shaderpack->delete_programs();
+            pending_shaderpack.reset();
+            pending_main_framebuffer.reset();
+            pending_shadow_framebuffer.reset();
+        }
+
+        pending_shaderpack_name = new_shaderpack_name;
+        set_loading_progress(true, 0, 0);
+
+        // If the files of an earlier one are still being read, this one's read once they're done
+        if(!pending_sources.valid()) {
+            pending_sources = shaderpack_reader.submit([this, new_shaderpack_name]() {
+                return load_shaderpack_sources(new_shaderpack_name, shader_workers);
+            });
+        }
+    }
+
+    void nova_renderer::update_pending_shaderpack() {
+        delete_retired_shaderpacks();
+
+        if(pending_sources.valid()) {
+            if(pending_sources.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                return;
+            }
+
+            try {
+                auto sources = pending_sources.get();
+                if(sources.name != pending_shaderpack_name) {
+                    // The shaderpack was changed again while these were being read
+                    auto shaderpack_name = pending_shaderpack_name;
+                    pending_sources = shaderpack_reader.submit([this, shaderpack_name]() {
+                        return load_shaderpack_sources(shaderpack_name, shader_workers);
+                    });
+                    return;
+                }
+
+                create_pending_shaderpack(sources);
+
+            } catch(std::exception& e) {
+                LOG(ERROR) << "Could not load shaderpack " << pending_shaderpack_name << " because " << e.what()
+                           << ", so " << loaded_shaderpack->get_name() << " is still being used";
+                pending_shaderpack_name.clear();
+                set_loading_progress(false, 0, 0);
+                return;
+            }
+        }
+
+        if(!pending_shaderpack) {
+            return;
+        }
+
+        link_up_uniform_buffers(pending_shaderpack->update_programs(), *ubo_manager);
+
+        auto num_shaders = pending_shaderpack->get_loaded_shaders().size();
+        set_loading_progress(true, num_shaders, num_shaders - pending_shaderpack->get_num_unfinished());
+
+        if(pending_shaderpack->is_done_compiling()) {
+            swap_in_pending_shaderpack();
+        }
+    }
+
+    void nova_renderer::create_pending_shaderpack(shaderpack_sources &sources) {
+        pending_shaderpack = std::make_shared<shaderpack>(sources.name, sources.shaders_json, sources.shaders);
         LOG(DEBUG) << "Shaderpack loaded, wiring everything together";
-        LOG(INFO) << "Loading complete";
-		
-        link_up_uniform_buffers(loaded_shaderpack->get_loaded_shaders(), *ubo_manager);
-        LOG(DEBUG) << "Linked up UBOs";
 
-        create_framebuffers_from_shaderpack();
+        // Before anything's compiled, so only the variants for these options are
+        auto& settings = render_settings->get_options()["settings"];
+        if(settings.find("shaderpackOptions") != settings.end()) {
+            pending_shaderpack->set_options(settings["shaderpackOptions"]);
+        }
+
+        create_framebuffers_from_shaderpack(pending_main_framebuffer, pending_shadow_framebuffer);
+
+        set_loading_progress(true, pending_shaderpack->get_loaded_shaders().size(), 0);
+    }
+
+    void nova_renderer::swap_in_pending_shaderpack() {
+        if(loaded_shaderpack) {
+            // Every frame that drew with the old shaderpack was sent to the driver before this fence
+            retired_shaderpacks.push_back({loaded_shaderpack, std::move(main_framebuffer), std::move(shadow_framebuffer),
+                                           glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)});
+        }
+
+        main_framebuffer = std::move(pending_main_framebuffer);
+        shadow_framebuffer = std::move(pending_shadow_framebuffer);
+
+        // The game thread reads the shaderpack to tell Minecraft about its filters, so swap it in atomically
+        std::atomic_store(&loaded_shaderpack, pending_shaderpack);
+        pending_shaderpack.reset();
+        pending_shaderpack_name.clear();
+        set_loading_progress(false, 0, 0);
+        LOG(INFO) << "Now using shaderpack " << loaded_shaderpack->get_name();
+
+        // The old pack's folder isn't the one to watch anymore
+        if(shaderpack_files) {
+            watch_shaderpack_files(true);
+        }
     }
 
-    void nova_renderer::create_framebuffers_from_shaderpack() {
+    void nova_renderer::delete_retired_shaderpacks() {
+        while(!retired_shaderpacks.empty()) {
+            auto& retired = retired_shaderpacks.front();
+
+            GLenum status = glClientWaitSync(retired.fence, 0, 0);
+            if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+                // Fences are signaled in order, so if this one isn't then none of the later ones are either
+                break;
+            }
+
+            glDeleteSync(retired.fence);
+            retired.pack->delete_programs();
+            LOG(DEBUG) << "Deleted the programs and framebuffers of shaderpack " << retired.pack->get_name();
+
+            // The framebuffers delete themselves
+            retired_shaderpacks.pop_front();
+        }
+    }
+
+    void nova_renderer::set_loading_progress(bool is_loading, std::size_t num_shaders, std::size_t num_shaders_done) {
+        std::lock_guard<std::mutex> lock(loading_progress_lock);
+        loading_progress.is_loading = is_loading;
+        loading_progress.num_shaders = num_shaders;
+        loading_progress.num_shaders_done = num_shaders_done;
+    }
+
+    shaderpack_loading_progress nova_renderer::get_shaderpack_loading_progress() {
+        std::lock_guard<std::mutex> lock(loading_progress_lock);
+        return loading_progress;
+    }
+
+    void nova_renderer::create_framebuffers_from_shaderpack(std::unique_ptr<framebuffer> &main, std::unique_ptr<framebuffer> &shadow) {
         // TODO: Examine the shaderpack and determine what's needed
         // For now, just create framebuffers with all possible attachments
 
@@ -305,7 +538,7 @@ namespace nova {
                                 .enable_color_attachment(6)
                                 .enable_color_attachment(7);
 
-        main_framebuffer = std::make_unique<framebuffer>(main_framebuffer_builder.build());
+        main = std::make_unique<framebuffer>(main_framebuffer_builder.build());
 
         shadow_framebuffer_builder.set_framebuffer_size(settings["shadowMapResolution"], settings["shadowMapResolution"])
                                   .enable_color_attachment(0)
@@ -313,7 +546,7 @@ namespace nova {
                                   .enable_color_attachment(2)
                                   .enable_color_attachment(3);
 
-        shadow_framebuffer = std::make_unique<framebuffer>(shadow_framebuffer_builder.build());
+        shadow = std::make_unique<framebuffer>(shadow_framebuffer_builder.build());
 
     }
 
@@ -321,16 +554,27 @@ namespace nova {
         instance.release();
     }
 
-    void nova_renderer::render_shader(gl_shader_program &shader) {
-        LOG(TRACE) << "Rendering everything for shader " << shader.get_name();
-        profiler::start(shader.get_name());
+    void nova_renderer::render_shader(const std::string &shader_name, const mesh_store::renderables::reader& renderables) {
+        // Until the shader's ready this is one of its fallbacks, which draws the shader's geometry for it
+        auto& shader = loaded_shaderpack->get_shader(shader_name);
+        if(!shader.is_ready()) {
+            // Neither the shader nor any of its fallbacks have finished compiling
+            return;
+        }
+
+        LOG(TRACE) << "Rendering everything for shader " << shader_name;
+        profiler::start(shader_name);
         shader.bind();
 
         profiler::start("get_meshes_for_shader");
-        auto& geometry = meshes->get_meshes_for_shader(shader.get_name());
+        const auto& geometry = renderables.get(shader_name);
         profiler::end("get_meshes_for_shader");
+        // The lightmap is the same for everything, so it only needs binding once
+        textures->get_texture(lightmap_handle).bind(3);
+
         profiler::start("process_all");
-        for(auto& geom : geometry) {
+        for(const auto& geom_ptr : geometry) {
+            auto& geom = *geom_ptr;
             profiler::start("process_renderable");
 
             // if(!player_camera.has_object_in_frustum(geom.bounding_box)) {
@@ -338,21 +582,23 @@ namespace nova {
             // }
 
             if(geom.geometry->has_data()) {
-                if(!geom.color_texture.empty()) {
-                    auto color_texture = textures->get_texture(geom.color_texture);
-                    color_texture.bind(0);
+                if(geom.color_texture_handle != NO_TEXTURE) {
+                    auto color_array = textures->get_texture_array(geom.color_texture_handle);
+                    if(color_array) {
+                        color_array->bind(0);
+                    } else {
+                        textures->get_texture(geom.color_texture_handle).bind(0);
+                    }
                 }
 
-                if(geom.normalmap) {
-                    textures->get_texture(*geom.normalmap).bind(1);
+                if(geom.normalmap_handle != NO_TEXTURE) {
+                    textures->get_texture(geom.normalmap_handle).bind(1);
                 }
 
-                if(geom.data_texture) {
-                    textures->get_texture(*geom.data_texture).bind(2);
+                if(geom.data_texture_handle != NO_TEXTURE) {
+                    textures->get_texture(geom.data_texture_handle).bind(2);
                 }
 
-                textures->get_texture("lightmap").bind(3);
-
                 upload_model_matrix(geom, shader);
 
                 profiler::start("drawcall");
@@ -366,7 +612,7 @@ namespace nova {
         }
         profiler::end("process_all");
 
-        profiler::end(shader.get_name());
+        profiler::end(shader_name);
     }
 
     inline void nova_renderer::upload_model_matrix(render_object &geom, gl_shader_program &program) const {
@@ -398,11 +644,18 @@ namespace nova {
 
         auto& per_frame_ubo = ubo_manager->get_per_frame_uniforms();
 
-        auto per_frame_uniform_data = per_frame_uniforms{};
-        per_frame_uniform_data.gbufferProjection = player_camera.get_projection_matrix();
-        per_frame_uniform_data.gbufferModelView = player_camera.get_view_matrix();
+        per_frame_ubo.set(&per_frame_uniforms::gbufferProjection, player_camera.get_projection_matrix());
+        per_frame_ubo.set(&per_frame_uniforms::gbufferProjectionInverse, player_camera.get_inverse_projection_matrix());
+        per_frame_ubo.set(&per_frame_uniforms::gbufferPreviousProjection, player_camera.get_previous_projection_matrix());
 
-        per_frame_ubo.send_data(per_frame_uniform_data);
+        per_frame_ubo.set(&per_frame_uniforms::gbufferModelView, player_camera.get_view_matrix());
+        per_frame_ubo.set(&per_frame_uniforms::gbufferModelViewInverse, player_camera.get_inverse_view_matrix());
+        per_frame_ubo.set(&per_frame_uniforms::gbufferPreviousModelView, player_camera.get_previous_view_matrix());
+
+        per_frame_ubo.set(&per_frame_uniforms::cameraPosition, player_camera.get_position());
+        per_frame_ubo.set(&per_frame_uniforms::previousCameraPosition, player_camera.get_previous_position());
+
+        ubo_manager->update();
     }
 
     camera &nova_renderer::get_player_camera() {
@@ -410,11 +663,44 @@ namespace nova {
     }
 
     std::shared_ptr<shaderpack> nova_renderer::get_shaders() {
-        return loaded_shaderpack;
+        return std::atomic_load(&loaded_shaderpack);
+    }
+
+    void nova_renderer::apply_frame_snapshot(frame_snapshot &frame) {
+        profiler::start("apply_frame_snapshot");
+        for(auto& task : frame.render_thread_tasks) {
+            task();
+        }
+
+        if(!frame.changed_settings.empty()) {
+            auto& options = render_settings->get_options()["settings"];
+            for(auto itr = frame.changed_settings.begin(); itr != frame.changed_settings.end(); ++itr) {
+                options[itr.key()] = itr.value();
+            }
+            render_settings->update_config_changed();
+        }
+
+        if(frame.has_camera_transform) {
+            player_camera.set_position(frame.camera_position);
+            player_camera.set_rotation(frame.camera_rotation);
+        }
+
+        if(frame.gui_was_cleared) {
+            meshes->remove_gui_render_objects();
+        }
+        std::vector<mc_gui_geometry> gui_geometry;
+        gui_geometry.reserve(frame.gui_geometry.size());
+        for(auto& snapshot_geometry : frame.gui_geometry) {
+            gui_geometry.push_back(snapshot_geometry.to_mc_gui_geometry());
+        }
+        meshes->add_gui_buffers(gui_geometry);
+        profiler::end("apply_frame_snapshot");
     }
 
-    void link_up_uniform_buffers(std::unordered_map<std::string, gl_shader_program> &shaders, uniform_buffer_store &ubos) {
-        nova::foreach(shaders, [&](auto shader) { ubos.register_all_buffers_with_shader(shader.second); });
+    void link_up_uniform_buffers(const std::vector<gl_shader_program*> &shaders, uniform_buffer_store &ubos) {
+        for(auto shader : shaders) {
+            ubos.register_all_buffers_with_shader(*shader);
+        }
     }
 }
 
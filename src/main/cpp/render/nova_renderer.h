@@ -5,7 +5,10 @@
 #ifndef RENDERER_VULKAN_MOD_H
 #define RENDERER_VULKAN_MOD_H
 
+#include <deque>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include "objects/shaders/gl_shader_program.h"
 #include "objects/uniform_buffers/uniform_buffer_store.h"
@@ -15,8 +18,26 @@
 #include "../input/InputHandler.h"
 #include "objects/framebuffer.h"
 #include "objects/camera.h"
+#include "frame_snapshot.h"
+#include "../data_loading/loaders/shaderpack_watcher.h"
+#include "../data_loading/loaders/loaders.h"
+#include "../utils/thread_pool.h"
 
 namespace nova {
+    /*!
+     * \brief How far along switching to a new shaderpack is
+     */
+    struct shaderpack_loading_progress {
+        bool is_loading = false;            //!< True from when a new shaderpack is asked for until it's in use
+
+        /*!
+         * \brief How many shaders the new shaderpack has. Zero until its files have been read
+         */
+        std::size_t num_shaders = 0;
+
+        std::size_t num_shaders_done = 0;   //!< How many of them have compiled or failed to
+    };
+
     /*!
      * \brief Initializes everything this mod needs, creating its own window
      *
@@ -61,12 +82,20 @@ namespace nova {
         /*!
          * \brief Renders a single frame
          *
-         * This method runs in a separate thread from the rest of the methods in this class. This is because the other
-         * methods are called by Minecraft, from the Minecraft thread, while this method is run in a separate thread. This
-         * is done to keep the OpenGL contexts separate. Hopefully it'll work
+         * This method has to be called from the thread that owns the OpenGL context, which is the render thread when
+         * Nova is running inside Minecraft
          */
         void render_frame();
 
+        /*!
+         * \brief Applies everything that Minecraft changed since the last frame
+         *
+         * Called on the render thread right before render_frame
+         *
+         * \param frame The changes to apply
+         */
+        void apply_frame_snapshot(frame_snapshot& frame);
+
         /*!
          * \brief determines whether or not the Nova Renderer, and by extension Minecraft, should shut down. Called directly
          * by the C interface
@@ -87,8 +116,16 @@ namespace nova {
 
         camera& get_player_camera();
 
+        /*!
+         * \brief Returns the currently loaded shaderpack. Safe to call from any thread
+         */
         std::shared_ptr<shaderpack> get_shaders();
 
+        /*!
+         * \brief How far along loading the shaderpack that'll replace the current one is. Safe to call from any thread
+         */
+        shaderpack_loading_progress get_shaderpack_loading_progress();
+
         // Overrides from iconfig_listener
 
         void on_config_change(nlohmann::json& new_config);
@@ -103,8 +140,60 @@ namespace nova {
 
         std::shared_ptr<shaderpack> loaded_shaderpack;
 
+        /*!
+         * \brief Reads and preprocesses shaders for every shaderpack load and reload. Kept around so that each load
+         * doesn't start its own threads. Declared before shaderpack_reader, whose tasks use it, so it outlives them
+         */
+        thread_pool shader_workers;
+
+        /*!
+         * \brief Reads new shaderpacks' files, so the render thread can keep drawing with the old one meanwhile
+         */
+        thread_pool shaderpack_reader{1};
+
+        /*!
+         * \brief The shaderpack that should replace loaded_shaderpack, or empty if it shouldn't be replaced
+         */
+        std::string pending_shaderpack_name;
+
+        /*!
+         * \brief The files of a new shaderpack, while they're being read. Might be for an older pending_shaderpack_name
+         * than the current one, if the shaderpack was changed again while they were being read
+         */
+        std::future<shaderpack_sources> pending_sources;
+
+        /*!
+         * \brief The new shaderpack while its programs compile, and the framebuffers made for it
+         */
+        std::shared_ptr<shaderpack> pending_shaderpack;
+        std::unique_ptr<framebuffer> pending_main_framebuffer;
+        std::unique_ptr<framebuffer> pending_shadow_framebuffer;
+
+        /*!
+         * \brief A shaderpack that was replaced, and a fence for the last frame that drew with it. Its OpenGL objects
+         * are deleted once the fence is signaled
+         */
+        struct retired_shaderpack {
+            std::shared_ptr<shaderpack> pack;
+            std::unique_ptr<framebuffer> main_framebuffer;
+            std::unique_ptr<framebuffer> shadow_framebuffer;
+            GLsync fence;
+        };
+
+        std::deque<retired_shaderpack> retired_shaderpacks;
+
+        std::mutex loading_progress_lock;
+        shaderpack_loading_progress loading_progress;
+
+        /*!
+         * \brief Watches the loaded shaderpack's folder when the shaderHotReload setting is on
+         */
+        std::unique_ptr<shaderpack_watcher> shaderpack_files;
+
         std::unique_ptr<texture_manager> textures;
 
+        texture_handle lightmap_handle;
+
         std::unique_ptr<input_handler> inputs;
 
         std::unique_ptr<mesh_store> meshes;
@@ -124,11 +213,11 @@ namespace nova {
         /*!
          * \brief Renders the GUI of Minecraft
          */
-        void render_gui();
+        void render_gui(const mesh_store::renderables::reader& renderables);
 
         void render_shadow_pass();
 
-        void render_gbuffers();
+        void render_gbuffers(const mesh_store::renderables::reader& renderables);
 
         void render_composite_passes();
 
@@ -138,16 +227,57 @@ namespace nova {
 
         void init_opengl_state() const;
 
+        /*!
+         * \brief Starts loading a shaderpack to replace the current one, which keeps being drawn with until the new
+         * one's programs have all compiled. With no shaderpack loaded yet, its files are read straight away
+         */
         void load_new_shaderpack(const std::string &new_shaderpack_name);
 
-        void create_framebuffers_from_shaderpack();
+        /*!
+         * \brief Moves the pending shaderpack along, from reading its files to compiling its programs, and swaps it in
+         * once it's done
+         */
+        void update_pending_shaderpack();
+
+        /*!
+         * \brief Makes a shaderpack out of the files that were read, and the framebuffers to go with it
+         */
+        void create_pending_shaderpack(shaderpack_sources &sources);
+
+        /*!
+         * \brief Replaces the loaded shaderpack and its framebuffers with the pending ones. The old ones are deleted
+         * when the GPU is done with them
+         */
+        void swap_in_pending_shaderpack();
+
+        /*!
+         * \brief Deletes the OpenGL objects of replaced shaderpacks that the GPU has finished drawing with
+         */
+        void delete_retired_shaderpacks();
+
+        void set_loading_progress(bool is_loading, std::size_t num_shaders, std::size_t num_shaders_done);
+
+        void create_framebuffers_from_shaderpack(std::unique_ptr<framebuffer> &main, std::unique_ptr<framebuffer> &shadow);
+
+        /*!
+         * \brief Starts or stops watching the loaded shaderpack's files
+         *
+         * \param should_watch True to watch them. Zipped shaderpacks are never watched
+         */
+        void watch_shaderpack_files(bool should_watch);
+
+        /*!
+         * \brief Reads and compiles any shaders whose files were edited, leaving the rest of the shaderpack alone
+         */
+        void reload_edited_shaders();
 
         /*!
          * \brief Renders all the geometry that uses the specified shader, setting up textures and whatnot
          *
-         * \param shader The shader to render things with
+         * \param shader_name The shader to render things with. If it's not compiled yet, its fallback is used instead
+         * \param renderables The render objects to draw this frame
          */
-        void render_shader(gl_shader_program& shader);
+        void render_shader(const std::string& shader_name, const mesh_store::renderables::reader& renderables);
 
         inline void upload_gui_model_matrix(gl_shader_program &program);
 
@@ -156,7 +286,10 @@ namespace nova {
         void update_gbuffer_ubos();
     };
 
-    void link_up_uniform_buffers(std::unordered_map<std::string, gl_shader_program> &shaders, uniform_buffer_store &ubos);
+    /*!
+     * \brief Points the given shaders at Nova's uniform buffers. Call it for each shader once it's linked
+     */
+    void link_up_uniform_buffers(const std::vector<gl_shader_program*> &shaders, uniform_buffer_store &ubos);
 }
 
 #endif //RENDERER_VULKAN_MOD_H
@@ -8,43 +8,151 @@
 #include <utility>
 
 namespace nova {
-    glm::mat4& camera::get_projection_matrix() {
-        if(projection_matrix_is_dirty) {
-            projection_matrix = glm::perspective(glm::radians(fov), aspect_ratio, near_plane, far_plane);
-            projection_matrix_is_dirty = false;
+    void camera::set_position(const glm::vec3& new_position) {
+        if(new_position != position) {
+            position = new_position;
+            view_matrix_is_dirty = true;
         }
+    }
 
-        return projection_matrix;
+    void camera::set_rotation(const glm::vec2& new_rotation) {
+        if(new_rotation != rotation) {
+            rotation = new_rotation;
+            view_matrix_is_dirty = true;
+        }
+    }
+
+    void camera::set_fov(float new_fov) {
+        if(new_fov != fov) {
+            fov = new_fov;
+            projection_matrix_is_dirty = true;
+        }
+    }
+
+    void camera::set_aspect_ratio(float new_aspect_ratio) {
+        if(new_aspect_ratio != aspect_ratio) {
+            aspect_ratio = new_aspect_ratio;
+            projection_matrix_is_dirty = true;
+        }
+    }
+
+    void camera::set_clip_planes(float new_near_plane, float new_far_plane) {
+        if(new_near_plane != near_plane || new_far_plane != far_plane) {
+            near_plane = new_near_plane;
+            far_plane = new_far_plane;
+            projection_matrix_is_dirty = true;
+        }
+    }
+
+    const glm::vec3& camera::get_position() const {
+        return position;
     }
 
-    glm::mat4 camera::get_view_matrix() {
-        glm::mat4 view_matrix;
-        view_matrix = glm::rotate(view_matrix, glm::radians(180.0f), {0, 1, 0});
-        view_matrix = glm::rotate(view_matrix, glm::radians(-rotation.y), { 1, 0, 0 });
-        view_matrix = glm::rotate(view_matrix, glm::radians(rotation.x), { 0, 1, 0 });
-        view_matrix = glm::translate(view_matrix, -position);
+    const glm::vec2& camera::get_rotation() const {
+        return rotation;
+    }
+
+    const glm::mat4& camera::get_projection_matrix() {
+        update_matrices();
+        return projection_matrix;
+    }
 
+    const glm::mat4& camera::get_view_matrix() {
+        update_matrices();
         return view_matrix;
     }
 
+    const glm::mat4& camera::get_view_projection_matrix() {
+        update_matrices();
+        return view_projection_matrix;
+    }
+
+    const glm::mat4& camera::get_inverse_projection_matrix() {
+        update_matrices();
+        return inverse_projection_matrix;
+    }
+
+    const glm::mat4& camera::get_inverse_view_matrix() {
+        update_matrices();
+        return inverse_view_matrix;
+    }
+
+    const glm::mat4& camera::get_inverse_view_projection_matrix() {
+        update_matrices();
+        return inverse_view_projection_matrix;
+    }
+
     glm::vec3 camera::get_view_direction() {
-        glm::mat4 view_matrix;
-        view_matrix = glm::rotate(view_matrix, glm::radians(180.0f), {0, 1, 0});
-        view_matrix = glm::rotate(view_matrix, glm::radians(-rotation.y), { 1, 0, 0 });
-        view_matrix = glm::rotate(view_matrix, glm::radians(rotation.x), { 0, 1, 0 });
+        update_matrices();
+        return view_direction;
+    }
+
+    const glm::mat4& camera::get_previous_projection_matrix() {
+        if(!has_previous_frame) {
+            return get_projection_matrix();
+        }
+        return previous_projection_matrix;
+    }
+
+    const glm::mat4& camera::get_previous_view_matrix() {
+        if(!has_previous_frame) {
+            return get_view_matrix();
+        }
+        return previous_view_matrix;
+    }
+
+    const glm::vec3& camera::get_previous_position() {
+        if(!has_previous_frame) {
+            return position;
+        }
+        return previous_position;
+    }
+
+    void camera::end_frame() {
+        update_matrices();
+
+        previous_projection_matrix = projection_matrix;
+        previous_view_matrix = view_matrix;
+        previous_position = position;
+        has_previous_frame = true;
+    }
 
-        return glm::mat3(view_matrix) * glm::vec3{0, 0, 1};
+    void camera::update_matrices() {
+        if(!projection_matrix_is_dirty && !view_matrix_is_dirty) {
+            return;
+        }
+
+        if(projection_matrix_is_dirty) {
+            projection_matrix = glm::perspective(glm::radians(fov), aspect_ratio, near_plane, far_plane);
+            inverse_projection_matrix = glm::inverse(projection_matrix);
+            projection_matrix_is_dirty = false;
+        }
+
+        if(view_matrix_is_dirty) {
+            glm::mat4 rotation_matrix(1);
+            rotation_matrix = glm::rotate(rotation_matrix, glm::radians(180.0f), {0, 1, 0});
+            rotation_matrix = glm::rotate(rotation_matrix, glm::radians(-rotation.y), { 1, 0, 0 });
+            rotation_matrix = glm::rotate(rotation_matrix, glm::radians(rotation.x), { 0, 1, 0 });
+
+            view_direction = glm::mat3(rotation_matrix) * glm::vec3{0, 0, 1};
+            view_matrix = glm::translate(rotation_matrix, -position);
+
+            // The view matrix is a rotation and a translation, so we can invert it without a general inverse
+            inverse_view_matrix = glm::translate(glm::mat4(1), position) * glm::transpose(rotation_matrix);
+            view_matrix_is_dirty = false;
+        }
+
+        view_projection_matrix = projection_matrix * view_matrix;
+        inverse_view_projection_matrix = inverse_view_matrix * inverse_projection_matrix;
+
+        recalculate_frustum();
     }
 
     void camera::recalculate_frustum() {
-        glm::mat4 proj = get_projection_matrix();
-        glm::mat4 modl = get_view_matrix();
-        glm::mat4 clip;
+        const glm::mat4& clip = view_projection_matrix;
 
         float t;
 
-        clip = proj * modl;
-
         /* Extract the numbers for the RIGHT plane */
         frustum[0][0] = clip[0][3] - clip[0][0];
         frustum[0][1] = clip[1][3] - clip[1][0];
@@ -125,6 +233,8 @@ namespace nova {
     }
 
     bool camera::has_object_in_frustum(aabb &bounding_box) {
+        update_matrices();
+
         float x = bounding_box.center.x;
         float y = bounding_box.center.y;
         float z = bounding_box.center.z;
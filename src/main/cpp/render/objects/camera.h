@@ -14,30 +14,82 @@ namespace nova {
      * \brief A camera that can render things.
      *
      * There's one camera for the shadow map and one camera for the player. Other cameras are possible but I don't wanna
+     *
+     * The camera's matrices are only rebuilt when something that affects them changes, so all the setters go through
+     * methods that flag the right matrices as dirty. The camera also remembers the matrices that it had at the end of
+     * the last frame, for shaders that need to reproject things from the previous frame
      */
     struct camera {
-        float fov = 75;
-        float aspect_ratio = 16.f / 9.f;
-        float near_plane = 0.01f;
-        float far_plane = 1000.f;
-        glm::vec2 rotation;
-        glm::vec3 position;
+        void set_position(const glm::vec3& new_position);
+        void set_rotation(const glm::vec2& new_rotation);
+
+        void set_fov(float new_fov);
+        void set_aspect_ratio(float new_aspect_ratio);
+        void set_clip_planes(float new_near_plane, float new_far_plane);
 
-        glm::mat4& get_projection_matrix();
-        glm::mat4 get_view_matrix();
+        const glm::vec3& get_position() const;
+        const glm::vec2& get_rotation() const;
+
+        const glm::mat4& get_projection_matrix();
+        const glm::mat4& get_view_matrix();
+        const glm::mat4& get_view_projection_matrix();
+
+        const glm::mat4& get_inverse_projection_matrix();
+        const glm::mat4& get_inverse_view_matrix();
+        const glm::mat4& get_inverse_view_projection_matrix();
 
         glm::vec3 get_view_direction();
 
-        void recalculate_frustum();
+        /*!
+         * \brief The matrices and position that the camera had when end_frame was last called. Before the first call to
+         * end_frame these are the same as the current ones
+         */
+        const glm::mat4& get_previous_projection_matrix();
+        const glm::mat4& get_previous_view_matrix();
+        const glm::vec3& get_previous_position();
+
+        /*!
+         * \brief Saves the current matrices as the previous frame's matrices. Call this once per frame, after
+         * everything that needs this frame's matrices has read them
+         */
+        void end_frame();
 
         bool has_object_in_frustum(aabb& bounding_box);
 
     private:
-        bool projection_matrix_is_dirty;
+        float fov = 75;
+        float aspect_ratio = 16.f / 9.f;
+        float near_plane = 0.01f;
+        float far_plane = 1000.f;
+        glm::vec2 rotation = glm::vec2(0);
+        glm::vec3 position = glm::vec3(0);
+
+        bool projection_matrix_is_dirty = true;
+        bool view_matrix_is_dirty = true;
+        bool has_previous_frame = false;
+
+        glm::mat4 projection_matrix = glm::mat4(1);
+        glm::mat4 view_matrix = glm::mat4(1);
+        glm::mat4 view_projection_matrix = glm::mat4(1);
 
-        glm::mat4 projection_matrix;
+        glm::mat4 inverse_projection_matrix = glm::mat4(1);
+        glm::mat4 inverse_view_matrix = glm::mat4(1);
+        glm::mat4 inverse_view_projection_matrix = glm::mat4(1);
+
+        glm::vec3 view_direction = glm::vec3(0, 0, 1);
+
+        glm::mat4 previous_projection_matrix = glm::mat4(1);
+        glm::mat4 previous_view_matrix = glm::mat4(1);
+        glm::vec3 previous_position = glm::vec3(0);
 
         float frustum[6][4];
+
+        /*!
+         * \brief Rebuilds whichever matrices are dirty, along with everything derived from them
+         */
+        void update_matrices();
+
+        void recalculate_frustum();
     };
 }
 
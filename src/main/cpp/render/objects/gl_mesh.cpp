@@ -142,6 +142,27 @@ namespace nova {
                 // tangent
                 glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 13 * sizeof(GLfloat), (void *) (44 * sizeof(GLbyte)));
 
+                break;
+
+            case format::POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT_LAYER:
+                glEnableVertexAttribArray(0);   // Position
+                glEnableVertexAttribArray(1);   // Texture UV, within the layer
+                glEnableVertexAttribArray(2);   // Lightmap UV
+                glEnableVertexAttribArray(3);   // Normal
+                glEnableVertexAttribArray(4);   // Tangent
+                glEnableVertexAttribArray(5);   // Color
+                glEnableVertexAttribArray(6);   // Texture array layer
+
+                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), nullptr);
+                glVertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_FALSE, 14 * sizeof(GLfloat), (void *) (12 * sizeof(GLbyte)));
+                glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (void *) (16 * sizeof(GLbyte)));
+                glVertexAttribPointer(2, 2, GL_SHORT, GL_FALSE, 14 * sizeof(GLfloat), (void *) (24 * sizeof(GLbyte)));
+                glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (void *) (28 * sizeof(GLbyte)));
+                glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (void *) (40 * sizeof(GLbyte)));
+
+                // An integer, so that the shader gets the exact layer with no rounding
+                glVertexAttribIPointer(6, 1, GL_INT, 14 * sizeof(GLfloat), (void *) (52 * sizeof(GLbyte)));
+
                 break;
         }
     }
@@ -8,32 +8,48 @@ namespace nova {
     render_object::render_object(render_object &&other) noexcept {
         parent_id = other.parent_id;
         type = other.type;
+        name = std::move(other.name);
         geometry = std::move(other.geometry);
         color_texture = std::move(other.color_texture);
         normalmap = std::move(other.normalmap);
         data_texture = std::move(other.data_texture);
+        color_texture_handle = other.color_texture_handle;
+        normalmap_handle = other.normalmap_handle;
+        data_texture_handle = other.data_texture_handle;
         position = other.position;
+        bounding_box = other.bounding_box;
 
         other.parent_id = 0;
         other.geometry.reset();
         other.normalmap = std::experimental::optional<std::string>();
         other.data_texture = std::experimental::optional<std::string>();
+        other.color_texture_handle = NO_TEXTURE;
+        other.normalmap_handle = NO_TEXTURE;
+        other.data_texture_handle = NO_TEXTURE;
         other.position = {0, 0, 0};
     }
 
     render_object &render_object::operator=(render_object && other) noexcept {
         parent_id = other.parent_id;
         type = other.type;
+        name = std::move(other.name);
         geometry = std::move(other.geometry);
         color_texture = std::move(other.color_texture);
         normalmap = std::move(other.normalmap);
         data_texture = std::move(other.data_texture);
+        color_texture_handle = other.color_texture_handle;
+        normalmap_handle = other.normalmap_handle;
+        data_texture_handle = other.data_texture_handle;
         position = other.position;
+        bounding_box = other.bounding_box;
 
         other.parent_id = 0;
         other.geometry.reset();
         other.normalmap = std::experimental::optional<std::string>();
         other.data_texture = std::experimental::optional<std::string>();
+        other.color_texture_handle = NO_TEXTURE;
+        other.normalmap_handle = NO_TEXTURE;
+        other.data_texture_handle = NO_TEXTURE;
         other.position = {0, 0, 0};
 
         return *this;
@@ -76,6 +76,14 @@ namespace nova {
         std::experimental::optional<std::string> normalmap;
         std::experimental::optional<std::string> data_texture;
 
+        /*!
+         * \brief The handles of the textures above, looked up when the render object is made so that drawing it
+         * doesn't need to hash any names. NO_TEXTURE if there's no texture of that kind
+         */
+        texture_handle color_texture_handle = NO_TEXTURE;
+        texture_handle normalmap_handle = NO_TEXTURE;
+        texture_handle data_texture_handle = NO_TEXTURE;
+
         glm::vec3 position;
 
         aabb bounding_box;
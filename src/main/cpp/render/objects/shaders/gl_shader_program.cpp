@@ -5,57 +5,400 @@
 
 #include <cstdlib>
 #include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <regex>
+#include <sstream>
 
 #include <easylogging++.h>
 #include "gl_shader_program.h"
 
 namespace nova {
-    gl_shader_program::gl_shader_program(const shader_definition &source) : name(source.name) {
+    static bool is_identifier_char(char c) {
+        return std::isalnum((unsigned char) c) || c == '_';
+    }
+
+    /*!
+     * \brief True if the word is somewhere in the text, and not just as part of a longer identifier
+     */
+    static bool mentions_word(const std::string &text, const std::string &word) {
+        for(auto pos = text.find(word); pos != std::string::npos; pos = text.find(word, pos + 1)) {
+            auto end = pos + word.size();
+            if((pos == 0 || !is_identifier_char(text[pos - 1])) && (end == text.size() || !is_identifier_char(text[end]))) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    static const std::size_t SPIRV_HEADER_WORDS = 5;
+    static const std::uint32_t SPIRV_OP_NAME = 5;
+    static const std::uint32_t SPIRV_OP_DECORATE = 71;
+    static const std::uint32_t SPIRV_DECORATION_SPEC_ID = 1;
+
+    /*!
+     * \brief Reads a string out of a SPIR-V instruction. Strings are packed four characters to a word, starting with
+     * the lowest byte, and end with a '\0'
+     */
+    static std::string read_spirv_string(const std::uint32_t* words, std::size_t num_words) {
+        std::string text;
+        for(std::size_t i = 0; i < num_words; i++) {
+            for(int byte = 0; byte < 4; byte++) {
+                auto c = (char) ((words[i] >> (byte * 8)) & 0xff);
+                if(c == '\0') {
+                    return text;
+                }
+                text += c;
+            }
+        }
+
+        return text;
+    }
+
+    gl_shader_program::gl_shader_program(const shader_definition &source, const program_binary_cache *binaries,
+                                         const std::vector<std::string> &option_names, std::uint64_t options) :
+            name(source.name), stage_sources{source.vertex_source, source.fragment_source}, option_names(option_names),
+            binaries(binaries) {
         LOG(TRACE) << "Creating shader with filter expression " << source.filter_expression;
         filter = source.filter_expression;
         LOG(TRACE) << "Created filter expression " << filter;
-        create_shader(source.vertex_source, GL_VERTEX_SHADER);
-        LOG(TRACE) << "Creatd vertex shader";
-        create_shader(source.fragment_source, GL_FRAGMENT_SHADER);
-        LOG(TRACE) << "Created fragment shader";
 
-        link();
+        // Only options the shader mentions go in a variant's key, so the others don't make copies that are all the same
+        std::vector<std::string> stage_texts;
+        for(const auto& stage : stage_sources) {
+            stage_texts.push_back(stage.get_text());
+        }
+        for(std::size_t i = 0; i < this->option_names.size() && i < 64; i++) {
+            for(const auto& text : stage_texts) {
+                if(mentions_word(text, this->option_names[i])) {
+                    used_options |= 1ull << i;
+                    break;
+                }
+            }
+        }
+
+        if(source.vertex_spirv && source.fragment_spirv) {
+            stage_spirv.push_back(find_option_constants(*source.vertex_spirv));
+            stage_spirv.push_back(find_option_constants(*source.fragment_spirv));
+        }
+
+        wanted_variant = options & used_options;
+        drawn_variant = wanted_variant;
+        variants[wanted_variant].load_times = source.load_times;
     }
 
     gl_shader_program::gl_shader_program(gl_shader_program &&other) noexcept :
-            name(std::move(other.name)), filter(std::move(other.filter)) {
+            name(std::move(other.name)), stage_sources(std::move(other.stage_sources)), stage_spirv(std::move(other.stage_spirv)),
+            option_names(std::move(other.option_names)), used_options(other.used_options),
+            variants(std::move(other.variants)), wanted_variant(other.wanted_variant), drawn_variant(other.drawn_variant),
+            binaries(other.binaries), filter(std::move(other.filter)) {
+        // Make the other shader not a thing
+        other.variants.clear();
+    }
 
-        this->gl_name = other.gl_name;
+    spirv_stage gl_shader_program::find_option_constants(const spirv_module &module) {
+        spirv_stage stage;
+        stage.words = module.words;
+
+        // Specialization constants are only known by their ID, so their names have to be matched up with their IDs
+        // through the debug info. Modules with their debug info stripped can't have options
+        const auto& words = module.words;
+        std::unordered_map<std::uint32_t, std::string> names;
+        std::unordered_map<std::uint32_t, std::uint32_t> constant_ids;
+        for(std::size_t pos = SPIRV_HEADER_WORDS; pos < words.size();) {
+            auto num_words = words[pos] >> 16;
+            auto opcode = words[pos] & 0xffff;
+            if(num_words == 0 || pos + num_words > words.size()) {
+                LOG(WARNING) << module.path << " is cut off, so some shaderpack options might not work in it";
+                break;
+            }
 
-        // Make the other shader not a thing
-        other.gl_name = 0;
-        other.added_shaders.clear();
+            if(opcode == SPIRV_OP_NAME && num_words >= 3) {
+                names[words[pos + 1]] = read_spirv_string(&words[pos + 2], num_words - 2);
+
+            } else if(opcode == SPIRV_OP_DECORATE && num_words >= 4 && words[pos + 2] == SPIRV_DECORATION_SPEC_ID) {
+                constant_ids[words[pos + 1]] = words[pos + 3];
+            }
+
+            pos += num_words;
+        }
+
+        for(const auto& constant : constant_ids) {
+            auto constant_name = names.find(constant.first);
+            if(constant_name == names.end()) {
+                continue;
+            }
+
+            for(std::size_t i = 0; i < option_names.size() && i < 64; i++) {
+                if(option_names[i] == constant_name->second) {
+                    stage.option_bits.push_back(i);
+                    stage.constant_ids.push_back(constant.second);
+                    used_options |= 1ull << i;
+                    break;
+                }
+            }
+        }
+
+        return stage;
     }
 
-    void gl_shader_program::link() {
-        gl_name = glCreateProgram();
-        glObjectLabel(GL_PROGRAM, gl_name, (GLsizei) name.length(), name.c_str());
-        LOG(TRACE) << "Created shader program " << gl_name;
+    bool gl_shader_program::uses_spirv() const noexcept {
+        return !stage_spirv.empty() && (GLAD_GL_VERSION_4_6 || GLAD_GL_ARB_gl_spirv);
+    }
+
+    void gl_shader_program::set_options(std::uint64_t options) {
+        wanted_variant = options & used_options;
+
+        // Emplacing does nothing if the variant's already there, compiled or not
+        const auto& variant = variants.emplace(wanted_variant, program_variant()).first->second;
+        if(variant.status == program_status::ready) {
+            drawn_variant = wanted_variant;
+        }
+    }
+
+    shader_source gl_shader_program::add_option_defines(const shader_source &source, std::uint64_t options) const {
+        if(options == 0) {
+            return source;
+        }
+
+        std::string defines;
+        for(std::size_t i = 0; i < option_names.size() && i < 64; i++) {
+            if((options & (1ull << i)) != 0) {
+                defines += "#define " + option_names[i] + "\n";
+            }
+        }
+
+        // Right after the #version line, since nothing but comments can come before that. As a file of their own, so
+        // errors on the lines after them still point at the right place
+        shader_source with_defines = source;
+        with_defines.insert_file(std::min<std::size_t>(1, source.size()), std::make_shared<shader_source_file>("<shaderpack options>", defines));
+        return with_defines;
+    }
+
+    void gl_shader_program::start_compiling() {
+        auto& variant = variants[wanted_variant];
+        if(variant.status != program_status::not_started) {
+            return;
+        }
+
+        variant.compile_start = std::chrono::high_resolution_clock::now();
+        variant.status = program_status::compiling;
+
+        try {
+            bool spirv = uses_spirv();
+            std::vector<std::string> stage_texts;
+            if(spirv) {
+                for(const auto& stage : stage_spirv) {
+                    // There's no source for errors to point into, and the options aren't in the module, so they go in
+                    // the binary cache's key separately
+                    variant.stage_sources.emplace_back();
+                    stage_texts.emplace_back(reinterpret_cast<const char*>(stage.words.data()), stage.words.size() * sizeof(std::uint32_t));
+                    stage_texts.back() += "\nspecialized with options " + std::to_string(wanted_variant);
+                }
+
+            } else {
+                for(const auto& source : stage_sources) {
+                    if(source.empty()) {
+                        throw std::runtime_error("it only has SPIR-V, and the driver needs GL_ARB_gl_spirv or OpenGL 4.6 to use that");
+                    }
+                    variant.stage_sources.push_back(add_option_defines(source, wanted_variant));
+                    stage_texts.push_back(variant.stage_sources.back().get_text());
+                }
+            }
+
+            if(binaries) {
+                // The #defines or specialization constants are in the text, so every variant gets its own key
+                variant.binary_key = binaries->get_key(stage_texts);
+                if(link_from_binary(variant, *binaries, variant.binary_key)) {
+                    auto now = std::chrono::high_resolution_clock::now();
+                    variant.load_times.link = std::chrono::duration_cast<std::chrono::microseconds>(now - variant.compile_start);
+                    variant.load_times.ready = variant.load_times.link;
+                    variant.load_times.from_binary_cache = true;
+                    variant.status = program_status::ready;
+                    variant.stage_sources.clear();
+                    drawn_variant = wanted_variant;
+                    LOG(DEBUG) << "Program " << name << " loaded from the program binary cache";
+                    return;
+                }
+            }
+
+            const GLenum stage_types[] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER};
+            for(std::size_t i = 0; i < variant.stage_sources.size(); i++) {
+                if(spirv) {
+                    create_spirv_shader(variant, stage_spirv[i], wanted_variant, stage_types[i]);
+                } else {
+                    create_shader(variant, variant.stage_sources[i], stage_texts[i], stage_types[i]);
+                }
+            }
+            LOG(TRACE) << "Created vertex and fragment shaders from " << (spirv ? "SPIR-V" : "GLSL");
+
+            auto link_start = std::chrono::high_resolution_clock::now();
+            link(variant, binaries != nullptr);
+
+            variant.load_times.compile = std::chrono::duration_cast<std::chrono::microseconds>(link_start - variant.compile_start);
+            variant.load_times.link = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - link_start);
+        } catch(std::exception& e) {
+            LOG(ERROR) << "Could not load shader " << name << " because " << e.what();
+            variant.status = program_status::failed;
+            release_shaders(variant);
+        }
+    }
+
+    program_status gl_shader_program::finish_compiling(bool wait) {
+        auto& variant = variants[wanted_variant];
+        if(variant.status != program_status::compiling) {
+            return variant.status;
+        }
+
+        if(!wait && GLAD_GL_ARB_parallel_shader_compile) {
+            GLint is_done = GL_FALSE;
+            glGetProgramiv(variant.gl_name, GL_COMPLETION_STATUS_ARB, &is_done);
+            if(is_done == GL_FALSE) {
+                return variant.status;
+            }
+        }
+
+        auto finish_start = std::chrono::high_resolution_clock::now();
+        try {
+            // The shaders go first, so that errors can point at the line they're on
+            for(std::size_t i = 0; i < variant.added_shaders.size(); i++) {
+                check_for_shader_errors(variant.added_shaders[i], variant.stage_sources[i]);
+            }
+            check_for_linking_errors(variant);
+            LOG(DEBUG) << "Program " << name << " linked successfully";
+
+            if(binaries) {
+                store_binary(variant, *binaries, variant.binary_key);
+            }
+            variant.status = program_status::ready;
+            drawn_variant = wanted_variant;
 
-        for(GLuint shader : added_shaders) {
-            glAttachShader(gl_name, shader);
+        } catch(std::exception& e) {
+            LOG(ERROR) << "Could not load shader " << name << " because " << e.what();
+            variant.status = program_status::failed;
         }
 
-        glLinkProgram(gl_name);
-        check_for_linking_errors();
+        release_shaders(variant);
 
-        LOG(DEBUG) << "Program " << name << " linked successfully";
+        auto now = std::chrono::high_resolution_clock::now();
+        variant.load_times.link += std::chrono::duration_cast<std::chrono::microseconds>(now - finish_start);
+        variant.load_times.ready = std::chrono::duration_cast<std::chrono::microseconds>(now - variant.compile_start);
+
+        return variant.status;
+    }
 
-        for(GLuint shader : added_shaders) {
+    void gl_shader_program::release_shaders(program_variant &variant) {
+        for(GLuint shader : variant.added_shaders) {
             // Clean up our resources. I'm told that this is a good thing.
-            glDetachShader(gl_name, shader);
+            if(variant.gl_name != 0) {
+                glDetachShader(variant.gl_name, shader);
+            }
             glDeleteShader(shader);
         }
+        variant.added_shaders.clear();
+        variant.stage_sources.clear();
+
+        if(variant.status == program_status::failed && variant.gl_name != 0) {
+            glDeleteProgram(variant.gl_name);
+            variant.gl_name = 0;
+        }
+    }
+
+    void gl_shader_program::take_program_from(gl_shader_program &other) {
+        std::swap(stage_sources, other.stage_sources);
+        std::swap(stage_spirv, other.stage_spirv);
+        std::swap(used_options, other.used_options);
+        std::swap(variants, other.variants);
+        std::swap(wanted_variant, other.wanted_variant);
+        std::swap(drawn_variant, other.drawn_variant);
+
+        other.delete_variants();
+    }
+
+    void gl_shader_program::delete_variants() {
+        for(auto& variant : variants) {
+            release_shaders(variant.second);
+            if(variant.second.gl_name != 0) {
+                glDeleteProgram(variant.second.gl_name);
+            }
+        }
+        variants.clear();
+    }
+
+    program_status gl_shader_program::get_status() const noexcept {
+        auto variant = variants.find(wanted_variant);
+        return variant == variants.end() ? program_status::not_started : variant->second.status;
+    }
+
+    bool gl_shader_program::is_ready() const noexcept {
+        auto variant = variants.find(drawn_variant);
+        return variant != variants.end() && variant->second.status == program_status::ready;
+    }
+
+    std::uint64_t gl_shader_program::get_used_options() const noexcept {
+        return used_options;
+    }
+
+    void gl_shader_program::link(program_variant &variant, bool keep_binary) {
+        variant.gl_name = glCreateProgram();
+        glObjectLabel(GL_PROGRAM, variant.gl_name, (GLsizei) name.length(), name.c_str());
+        LOG(TRACE) << "Created shader program " << variant.gl_name;
+
+        if(keep_binary) {
+            glProgramParameteri(variant.gl_name, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
 
-        LOG(DEBUG) << "Cleaned up resources";
+        for(GLuint shader : variant.added_shaders) {
+            glAttachShader(variant.gl_name, shader);
+        }
+
+        glLinkProgram(variant.gl_name);
     }
 
-    void gl_shader_program::check_for_shader_errors(GLuint shader_to_check, const std::vector<shader_line>& line_map) {
+    bool gl_shader_program::link_from_binary(program_variant &variant, const program_binary_cache &binaries, std::uint64_t key) {
+        auto binary = binaries.load(key);
+        if(!binary) {
+            return false;
+        }
+
+        variant.gl_name = glCreateProgram();
+        glObjectLabel(GL_PROGRAM, variant.gl_name, (GLsizei) name.length(), name.c_str());
+        glProgramBinary(variant.gl_name, binary->format, binary->data.data(), (GLsizei) binary->data.size());
+
+        // Drivers can turn a binary down whenever they like, even one they made themselves. That's not an error, it
+        // just means compiling it again
+        GLint is_linked = 0;
+        glGetProgramiv(variant.gl_name, GL_LINK_STATUS, &is_linked);
+        if(is_linked == GL_FALSE) {
+            LOG(INFO) << "The driver didn't take the cached binary for program " << name << ", so I'll compile it again";
+            glDeleteProgram(variant.gl_name);
+            variant.gl_name = 0;
+            binaries.remove(key);
+            return false;
+        }
+
+        return true;
+    }
+
+    void gl_shader_program::store_binary(program_variant &variant, const program_binary_cache &binaries, std::uint64_t key) {
+        GLint binary_length = 0;
+        glGetProgramiv(variant.gl_name, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+        if(binary_length <= 0) {
+            // Some drivers don't do program binaries at all
+            return;
+        }
+
+        program_binary binary;
+        binary.data.resize((std::size_t) binary_length);
+        GLenum format = 0;
+        glGetProgramBinary(variant.gl_name, binary_length, nullptr, &format, binary.data.data());
+        binary.format = format;
+
+        binaries.store(key, binary);
+    }
+
+    void gl_shader_program::check_for_shader_errors(GLuint shader_to_check, const shader_source& source) {
         GLint success = 0;
 
         glGetShaderiv(shader_to_check, GL_COMPILE_STATUS, &success);
@@ -68,38 +411,39 @@ namespace nova {
             glGetShaderInfoLog(shader_to_check, log_size, &log_size, &error_log[0]);
 
             if(log_size > 0) {
-                glDeleteShader(shader_to_check);
                 LOG(ERROR) << error_log.data();
-                throw compilation_error(error_log.data(), line_map);
+                throw compilation_error(error_log.data(), source);
             }
         }
     }
 
-    void gl_shader_program::check_for_linking_errors() {
+    void gl_shader_program::check_for_linking_errors(program_variant &variant) {
         GLint is_linked = 0;
-        glGetProgramiv(gl_name, GL_LINK_STATUS, &is_linked);
+        glGetProgramiv(variant.gl_name, GL_LINK_STATUS, &is_linked);
 
         if(is_linked == GL_FALSE) {
             GLint log_length = 0;
-            glGetProgramiv(gl_name, GL_INFO_LOG_LENGTH, &log_length);
+            glGetProgramiv(variant.gl_name, GL_INFO_LOG_LENGTH, &log_length);
 
-            GLchar *info_log = (GLchar *) malloc(log_length * sizeof(GLchar));
-            glGetProgramInfoLog(gl_name, log_length, &log_length, info_log);
+            std::vector<GLchar> info_log((std::size_t) std::max(log_length, 1));
+            glGetProgramInfoLog(variant.gl_name, log_length, &log_length, info_log.data());
 
             if(log_length > 0) {
-                glDeleteProgram(gl_name);
-
-                LOG(ERROR) << "Error linking program " << gl_name << ":\n" << info_log;
-
-                throw program_linking_failure(name);
+                LOG(ERROR) << "Error linking program " << variant.gl_name << ":\n" << info_log.data();
             }
 
+            throw program_linking_failure(name);
         }
     }
 
     void gl_shader_program::bind() noexcept {
         //LOG(INFO) << "Binding program " << name;
-        glUseProgram(gl_name);
+        glUseProgram(get_gl_name());
+    }
+
+    GLuint gl_shader_program::get_gl_name() const noexcept {
+        auto variant = variants.find(drawn_variant);
+        return variant == variants.end() ? 0 : variant->second.gl_name;
     }
 
     gl_shader_program::~gl_shader_program() {
@@ -108,35 +452,52 @@ namespace nova {
         //glDeleteProgram(gl_name);
     }
 
-    void gl_shader_program::create_shader(const std::vector<shader_line>& shader_source, const GLenum shader_type) {
-        LOG(TRACE) << "Creating a shader from source\n" << shader_source;
+    void gl_shader_program::create_shader(program_variant &variant, const shader_source& source, const std::string& text,
+                                          const GLenum shader_type) {
+        LOG(TRACE) << "Creating a shader from source\n" << source;
 
-        std::string full_shader_source;
-        auto& version_line = shader_source[0].line;
-        LOG(TRACE) << "Version line: '" << version_line << "'";
-
-        if(version_line == "#version 450") {
-            // GLSL 450 code! This is the simplest: just concatenate all the lines in the shader file
-            std::for_each(
-                    std::begin(shader_source), std::end(shader_source),
-                    [&](auto &line) { full_shader_source.append(line.line + "\n"); }
-            );
-
-        } else {
-            throw wrong_shader_version(shader_source[0].line);
+        if(source.empty() || !(source.get_line(0) == "#version 450")) {
+            // GLSL 450 code is the only code we take, since it can go to the driver exactly as it is
+            throw wrong_shader_version(source.empty() ? "" : source.get_line(0).to_string());
         }
 
         auto shader_name = glCreateShader(shader_type);
 
-        const char *shader_source_char = full_shader_source.c_str();
+        const char *shader_source_char = text.c_str();
 
         glShaderSource(shader_name, 1, &shader_source_char, nullptr);
 
         glCompileShader(shader_name);
 
-        check_for_shader_errors(shader_name, shader_source);
+        variant.added_shaders.push_back(shader_name);
+    }
+
+    void gl_shader_program::create_spirv_shader(program_variant &variant, const spirv_stage &stage, std::uint64_t options,
+                                                const GLenum shader_type) {
+        LOG(TRACE) << "Creating a shader from " << stage.words.size() << " words of SPIR-V";
 
-        added_shaders.push_back(shader_name);
+        auto shader_name = glCreateShader(shader_type);
+
+        glShaderBinary(1, &shader_name, GL_SHADER_BINARY_FORMAT_SPIR_V, stage.words.data(),
+                       (GLsizei) (stage.words.size() * sizeof(std::uint32_t)));
+
+        std::vector<GLuint> constant_values;
+        for(auto option_bit : stage.option_bits) {
+            constant_values.push_back((GLuint) ((options >> option_bit) & 1));
+        }
+
+        // Specializing stands in for glCompileShader, and its errors are checked the same way. Drivers that only have
+        // the extension only load the extension's function
+        auto specialize_shader = GLAD_GL_VERSION_4_6 ? glSpecializeShader : glSpecializeShaderARB;
+        specialize_shader(shader_name, "main", (GLuint) stage.constant_ids.size(), stage.constant_ids.data(), constant_values.data());
+
+        variant.added_shaders.push_back(shader_name);
+    }
+
+    const shader_load_times& gl_shader_program::get_load_times() const noexcept {
+        static const shader_load_times no_load_times;
+        auto variant = variants.find(drawn_variant);
+        return variant == variants.end() ? no_load_times : variant->second.load_times;
     }
 
     std::string & gl_shader_program::get_filter() noexcept {
@@ -148,9 +509,11 @@ namespace nova {
     }
 
     GLint gl_shader_program::get_uniform_location(const std::string uniform_name) {
+        // Each variant is its own program, so the locations can be different
+        auto& uniform_locations = variants[drawn_variant].uniform_locations;
         auto location_in_uniform_locations = uniform_locations.find(uniform_name);
         if(location_in_uniform_locations == uniform_locations.end()) {
-            uniform_locations[uniform_name] = glGetUniformLocation(gl_name, uniform_name.c_str());
+            uniform_locations[uniform_name] = glGetUniformLocation(get_gl_name(), uniform_name.c_str());
         }
 
         return uniform_locations[uniform_name];
@@ -161,13 +524,29 @@ namespace nova {
                     "Invalid version line: '" + version_line + "'. Please only use GLSL version 450 (NOT compatibility profile)"
             ) {}
 
-    compilation_error::compilation_error(const std::string &error_message,
-                                         const std::vector<shader_line> source_lines) :
-            std::runtime_error(error_message + get_original_line_message(error_message, source_lines)) {}
+    compilation_error::compilation_error(const std::string &error_message, const shader_source &source) :
+            std::runtime_error(error_message + get_original_line_message(error_message, source)) {}
 
-    std::string compilation_error::get_original_line_message(const std::string &error_message,
-                                                             const std::vector<shader_line> source_lines) {
-        return "This logic isn't implemented yet";
-    }
+    std::string compilation_error::get_original_line_message(const std::string &error_message, const shader_source &source) {
+        // Drivers say which line is wrong as 0(12) (Nvidia) or 0:12 (everyone else), where 0 is the string's index
+        static const std::regex line_number_regex(R"((?:^|[^\w])\d+[:(](\d+))");
+
+        std::string message;
+        std::istringstream error_lines(error_message);
+        std::string error_line;
+        std::smatch match;
+        while(std::getline(error_lines, error_line)) {
+            if(!std::regex_search(error_line, match, line_number_regex)) {
+                continue;
+            }
 
+            auto line = std::stoul(match[1].str());
+            if(line >= 1 && line <= source.size()) {
+                message += "\nLine " + std::to_string(line) + " is line " + std::to_string(source.get_line_num(line - 1))
+                           + " of " + source.get_file_name(line - 1) + ": " + source.get_line(line - 1).to_string();
+            }
+        }
+
+        return message;
+    }
 }
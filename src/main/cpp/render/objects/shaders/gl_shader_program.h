@@ -8,6 +8,8 @@
 #ifndef RENDERER_GL_SHADER_H
 #define RENDERER_GL_SHADER_H
 
+#include <chrono>
+#include <cstdint>
 #include <istream>
 #include <unordered_map>
 #include <vector>
@@ -15,6 +17,7 @@
 #include <glad/glad.h>
 #include "../../../utils/export.h"
 #include "../../../data_loading/loaders/shader_source_structs.h"
+#include "program_binary_cache.h"
 
 
 namespace nova {
@@ -24,19 +27,17 @@ namespace nova {
     class compilation_error : public std::runtime_error {
     public:
         /*!
-         * \brief Constructs a compilation_error with the provided message, using the given list of shader_lines to
-         * map from line number in the error message to line number and shader file on disk
+         * \brief Constructs a compilation_error with the provided message, using the given shader source to map
+         * from line number in the error message to line number and shader file on disk
          *
          * \param error_message The compilation message, straight from the driver
-         * \param source_lines The list of source_line objects that maps from line in the shader sent to the driver
-         * to the line number and shader file on disk
+         * \param source The source that was sent to the driver, which knows where each of its lines came from
          */
-        compilation_error(const std::string &error_message, const std::vector<shader_line> source_lines);
+        compilation_error(const std::string &error_message, const shader_source &source);
 
     private:
 
-        std::string
-        get_original_line_message(const std::string &error_message, const std::vector<shader_line> source_lines);
+        std::string get_original_line_message(const std::string &error_message, const shader_source &source);
     };
 
     class wrong_shader_version : public std::runtime_error {
@@ -49,6 +50,57 @@ namespace nova {
         program_linking_failure(const std::string name) : std::runtime_error("Program " + name + " failed to link") {};
     };
 
+    /*!
+     * \brief Where a gl_shader_program is in getting compiled
+     */
+    enum class program_status {
+        not_started,
+        compiling,      //!< The driver has the source, but might not be done with it yet
+        ready,
+        failed
+    };
+
+    /*!
+     * \brief A stage's SPIR-V, and which of its specialization constants are shaderpack options
+     */
+    struct spirv_stage {
+        std::vector<std::uint32_t> words;
+
+        /*!
+         * \brief The option that each specialization constant in constant_ids is for, as its bit in an option mask
+         */
+        std::vector<std::size_t> option_bits;
+
+        std::vector<GLuint> constant_ids;
+    };
+
+    /*!
+     * \brief One compiled copy of a shader, with one set of options turned on
+     */
+    struct program_variant {
+        GLuint gl_name = 0;
+
+        program_status status = program_status::not_started;
+
+        shader_load_times load_times;
+
+        std::uint64_t binary_key = 0;
+
+        std::chrono::high_resolution_clock::time_point compile_start;
+
+        /*!
+         * \brief The source of each stage with the options' #defines put in, until the variant's compiled
+         */
+        std::vector<shader_source> stage_sources;
+
+        /*!
+         * \brief The shader objects for each of stage_sources, until the program's linked
+         */
+        std::vector<GLuint> added_shaders;
+
+        std::unordered_map<std::string, GLint> uniform_locations;
+    };
+
     /*!
      * \brief Represents an OpenGL shader program
      *
@@ -62,15 +114,32 @@ namespace nova {
      * this shader. There's a good chance that I won't end up with uniform and attribute information. This class will also
      * hold the map from line in the shader sent to the compiler and the line number and shader file that the line came from
      * on disk
+     *
+     * Shaderpack options are compile-time switches. Each option that's turned on is `#define`d right after the #version
+     * line, so code behind an `#ifdef` for an option that's off never reaches the GPU. Every combination of options
+     * needs its own OpenGL program, called a variant. Variants are keyed by a bitmask of the options that are on, and
+     * only the options that the shader's source mentions go in the key, so options that a shader doesn't care about
+     * don't make more copies of it. A variant is only compiled once its options are picked, and the last variant that
+     * was ready keeps being used until then
+     *
+     * Shaders that come with SPIR-V for every stage skip the GLSL compiler when the driver has GL_ARB_gl_spirv or
+     * OpenGL 4.6. Options are specialization constants there: a constant named after an option, like
+     * `layout(constant_id = 0) const bool SOFT_SHADOWS = false;`, is set to 1 or 0 for each variant. Other drivers get
+     * the GLSL, if the shaderpack has it
      */
     class gl_shader_program {
     public:
-        GLuint gl_name;
-
         /*!
-         * \brief Constructs a gl_shader_program
+         * \brief Constructs a gl_shader_program. Nothing is sent to the driver until start_compiling is called
+         *
+         * \param source The shader's preprocessed source
+         * \param binaries Where to look for an already-linked copy of this program, and to put it once it's linked.
+         * nullptr means always compile from source
+         * \param option_names The shaderpack's options. The first one is bit 0 of an option mask, and so on
+         * \param options The options to compile with first
          */
-        explicit gl_shader_program(const shader_definition &source);
+        explicit gl_shader_program(const shader_definition &source, const program_binary_cache *binaries = nullptr,
+                                   const std::vector<std::string> &option_names = {}, std::uint64_t options = 0);
 
         /*!
          * \brief Default copy constructor
@@ -94,11 +163,56 @@ namespace nova {
          */
         ~gl_shader_program();
 
+        /*!
+         * \brief Picks which options the shader should be drawn with
+         *
+         * If the shader hasn't got a variant for them yet, one is made, and start_compiling will compile it. The
+         * variant that's in use now stays in use until the new one is ready
+         *
+         * \param options A bitmask of the shaderpack's options. Options the shader doesn't use are ignored
+         */
+        void set_options(std::uint64_t options);
+
+        /*!
+         * \brief Hands the wanted variant's source to the driver, or the cached binary if there is one, without
+         * waiting for it to be compiled
+         *
+         * Drivers with GL_ARB_parallel_shader_compile compile in the background. Others might do all the work in here,
+         * or might leave it for finish_compiling
+         */
+        void start_compiling();
+
+        /*!
+         * \brief Checks whether the driver is done with the wanted variant and, if it is, checks it for errors. Once
+         * it's ready, it's the one that's drawn with
+         *
+         * \param wait If false and the driver can say whether it's done, returns straight away when it isn't.
+         * Otherwise this waits for the driver
+         * \return The wanted variant's status after checking
+         */
+        program_status finish_compiling(bool wait);
+
+        /*!
+         * \brief Where the variant for the last options picked is in getting compiled
+         */
+        program_status get_status() const noexcept;
+
+        /*!
+         * \brief True if some variant is linked and can be used to draw things. It might not be the one for the last
+         * options picked, if that one isn't ready yet or failed
+         */
+        bool is_ready() const noexcept;
+
         /*!
          * \brief Sets this shader as the currently active shader
          */
         void bind() noexcept;
 
+        /*!
+         * \brief The OpenGL name of the variant that's drawn with
+         */
+        GLuint get_gl_name() const noexcept;
+
         std::string& get_filter() noexcept;
 
         std::string& get_name() noexcept;
@@ -115,12 +229,62 @@ namespace nova {
          */
         GLint get_uniform_location(std::string uniform_name);
 
+        /*!
+         * \brief Swaps this program's variants for another one's, like when the shader's been edited and compiled
+         * again, and deletes the old ones
+         *
+         * The name and filter stay as they are, since the game thread reads the filter while the render thread does this
+         *
+         * \param other A program for the same shader. It doesn't have any variants afterwards
+         */
+        void take_program_from(gl_shader_program &other);
+
+        /*!
+         * \brief Deletes the OpenGL program of every variant. Nothing can be drawn with this afterwards, so only do
+         * this once the GPU is done with them
+         */
+        void delete_variants();
+
+        /*!
+         * \brief How long it took to load, preprocess, compile and link the variant that's drawn with
+         */
+        const shader_load_times& get_load_times() const noexcept;
+
+        /*!
+         * \brief A bitmask of the options that the shader's source mentions
+         */
+        std::uint64_t get_used_options() const noexcept;
+
     private:
         std::string name;
 
-        std::vector<GLuint> added_shaders;
+        /*!
+         * \brief The vertex and fragment source without any options, kept so more variants can be made from them
+         */
+        std::vector<shader_source> stage_sources;
 
-        std::unordered_map<std::string, GLint> uniform_locations;
+        /*!
+         * \brief The vertex and fragment SPIR-V, or nothing if any stage doesn't have any
+         */
+        std::vector<spirv_stage> stage_spirv;
+
+        std::vector<std::string> option_names;
+
+        std::uint64_t used_options = 0;
+
+        std::unordered_map<std::uint64_t, program_variant> variants;
+
+        /*!
+         * \brief The variant for the last options picked
+         */
+        std::uint64_t wanted_variant = 0;
+
+        /*!
+         * \brief The variant that bind uses. The same as wanted_variant unless that one isn't ready
+         */
+        std::uint64_t drawn_variant = 0;
+
+        const program_binary_cache *binaries = nullptr;
 
         /*!
          * \brief The filter that the renderer should use to get the geometry for this shader
@@ -130,13 +294,52 @@ namespace nova {
          */
         std::string filter;
 
-        void create_shader(const std::vector<shader_line>& shader_source, GLenum shader_type);
+        /*!
+         * \brief The source of a stage with the #defines for some options put in after the #version line
+         */
+        shader_source add_option_defines(const shader_source &source, std::uint64_t options) const;
+
+        /*!
+         * \brief True if the shader has SPIR-V and the driver can take it
+         */
+        bool uses_spirv() const noexcept;
 
-        void check_for_shader_errors(GLuint shader_to_check, const std::vector<shader_line>& line_map);
+        /*!
+         * \brief Finds the specialization constants in a stage's SPIR-V that have the same name as an option
+         */
+        spirv_stage find_option_constants(const spirv_module &module);
 
-        void link();
+        void create_shader(program_variant &variant, const shader_source& source, const std::string& text, GLenum shader_type);
+
+        /*!
+         * \brief Makes a shader object out of SPIR-V, with the specialization constants set for the variant's options
+         */
+        void create_spirv_shader(program_variant &variant, const spirv_stage &stage, std::uint64_t options, GLenum shader_type);
+
+        void check_for_shader_errors(GLuint shader_to_check, const shader_source& source);
+
+        /*!
+         * \brief Starts linking. Doesn't check for errors, since that would wait for the driver
+         *
+         * \param keep_binary True if the driver should keep the linked program around for glGetProgramBinary
+         */
+        void link(program_variant &variant, bool keep_binary);
+
+        /*!
+         * \brief Makes the program from a binary in the cache
+         *
+         * \return True if it worked, false if the cache doesn't have the program or the driver wouldn't take it
+         */
+        bool link_from_binary(program_variant &variant, const program_binary_cache &binaries, std::uint64_t key);
+
+        void store_binary(program_variant &variant, const program_binary_cache &binaries, std::uint64_t key);
+
+        /*!
+         * \brief Deletes the shader objects once they're not needed, and the program too if it failed
+         */
+        void release_shaders(program_variant &variant);
 
-        void check_for_linking_errors();
+        void check_for_linking_errors(program_variant &variant);
     };
 }
 
@@ -0,0 +1,119 @@
+/*!
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <glad/glad.h>
+#include <easylogging++.h>
+#include "program_binary_cache.h"
+#include "../../../utils/file_cache.h"
+
+namespace nova {
+    static const char CACHE_FILE_MAGIC[4] = {'N', 'V', 'P', 'B'};
+
+    /*!
+     * \brief The start of every cache file. The binary comes right after it
+     */
+    struct cache_file_header {
+        char magic[4];
+        std::uint32_t version;
+        std::uint32_t format;
+        std::uint32_t padding;
+        std::uint64_t size;
+        std::uint64_t checksum;     //!< So a damaged file is ignored here, instead of being handed to the driver
+    };
+
+    program_binary_cache::program_binary_cache(std::string directory, std::string driver) :
+            directory(std::move(directory)), driver(std::move(driver)) {}
+
+    std::string program_binary_cache::get_current_driver() {
+        auto get_string = [](GLenum name) {
+            auto value = reinterpret_cast<const char*>(glGetString(name));
+            return std::string(value ? value : "");
+        };
+
+        std::string driver = get_string(GL_VENDOR) + "\n" + get_string(GL_RENDERER) + "\n" + get_string(GL_VERSION);
+
+        GLint num_formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+        std::vector<GLint> formats((std::size_t) num_formats);
+        if(num_formats > 0) {
+            glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data());
+        }
+        for(auto format : formats) {
+            driver += "\n" + std::to_string(format);
+        }
+
+        return driver;
+    }
+
+    std::uint64_t program_binary_cache::get_key(const std::vector<std::string> &stage_sources) const {
+        std::uint32_t version = VERSION;
+        auto hash = hash_bytes(&version, sizeof(version));
+        hash = hash_bytes(driver.data(), driver.size(), hash);
+        for(const auto& source : stage_sources) {
+            // The length goes in too, so that moving text from the end of one stage to the start of the next changes
+            // the key
+            std::uint64_t length = source.size();
+            hash = hash_bytes(&length, sizeof(length), hash);
+            hash = hash_bytes(source.data(), source.size(), hash);
+        }
+
+        return hash;
+    }
+
+    optional<program_binary> program_binary_cache::load(std::uint64_t key) const {
+        std::string path = get_path(key);
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if(!file.is_open()) {
+            return {};
+        }
+        auto file_size = (std::uint64_t) file.tellg();
+        file.seekg(0);
+
+        cache_file_header header;
+        if(!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, CACHE_FILE_MAGIC, 4) != 0 ||
+                header.version != VERSION || header.size != file_size - sizeof(header)) {
+            LOG(WARNING) << "Ignoring cached program " << path << " because it's not what I expected";
+            return {};
+        }
+
+        program_binary binary;
+        binary.format = header.format;
+        binary.data.resize((std::size_t) header.size);
+        if(!file.read(reinterpret_cast<char*>(binary.data.data()), (std::streamsize) binary.data.size()) ||
+                hash_bytes(binary.data.data(), binary.data.size()) != header.checksum) {
+            LOG(WARNING) << "Ignoring cached program " << path << " because it's been damaged";
+            return {};
+        }
+
+        return binary;
+    }
+
+    void program_binary_cache::store(std::uint64_t key, const program_binary &binary) const {
+        make_directories(directory);
+
+        cache_file_header header = {};
+        std::memcpy(header.magic, CACHE_FILE_MAGIC, 4);
+        header.version = VERSION;
+        header.format = binary.format;
+        header.size = binary.data.size();
+        header.checksum = hash_bytes(binary.data.data(), binary.data.size());
+
+        replace_file(get_path(key), [&](std::ofstream& file) {
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(binary.data.data()), (std::streamsize) binary.data.size());
+        });
+    }
+
+    void program_binary_cache::remove(std::uint64_t key) const {
+        std::remove(get_path(key).c_str());
+    }
+
+    std::string program_binary_cache::get_path(std::uint64_t key) const {
+        return get_cache_file_path(directory, key, ".bin");
+    }
+}
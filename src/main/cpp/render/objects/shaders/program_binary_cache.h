@@ -0,0 +1,87 @@
+/*!
+ * \brief Keeps linked shader programs on disk, so a shaderpack only has to be compiled once per driver
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_PROGRAM_BINARY_CACHE_H
+#define RENDERER_PROGRAM_BINARY_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <optional.hpp>
+
+using namespace std::experimental;
+
+namespace nova {
+    /*!
+     * \brief A linked program, as the driver gave it to us from glGetProgramBinary
+     */
+    struct program_binary {
+        std::uint32_t format;
+        std::vector<std::uint8_t> data;
+    };
+
+    /*!
+     * \brief A directory full of program binaries, named after a hash of everything that went into them
+     *
+     * Compiling and linking every program in a shaderpack is most of the time it takes to load one, and the driver
+     * would give us the same program every time. A binary is only good for the driver that made it, so the driver is
+     * part of the key, and a driver update just means a miss. Drivers can still turn a binary down for reasons of
+     * their own, so anything that loads from here has to be ready to compile from source instead
+     */
+    class program_binary_cache {
+    public:
+        /*!
+         * \brief Bump this whenever what goes into a program changes in a way the source text doesn't show
+         */
+        static const std::uint32_t VERSION = 1;
+
+        /*!
+         * \param directory Where to keep the cache files. Made the first time something is stored
+         * \param driver Which driver the binaries are for, from get_current_driver
+         */
+        program_binary_cache(std::string directory, std::string driver);
+
+        /*!
+         * \brief The vendor, renderer and version strings of the current context, and the binary formats it supports
+         *
+         * Needs a current OpenGL context
+         */
+        static std::string get_current_driver();
+
+        /*!
+         * \brief Hashes the driver, the cache version, and the full source of every stage, after #includes and
+         * #defines have been put in
+         */
+        std::uint64_t get_key(const std::vector<std::string> &stage_sources) const;
+
+        /*!
+         * \brief Reads a program from the cache
+         *
+         * \return The program, or nothing if the cache doesn't have it or the file's been damaged
+         */
+        optional<program_binary> load(std::uint64_t key) const;
+
+        /*!
+         * \brief Writes a program to the cache. Failing to write is logged and otherwise ignored, since the cache is
+         * only ever an optimization
+         */
+        void store(std::uint64_t key, const program_binary &binary) const;
+
+        /*!
+         * \brief Deletes a program from the cache, like when the driver wouldn't take it
+         */
+        void remove(std::uint64_t key) const;
+
+    private:
+        std::string directory;
+        std::string driver;
+
+        std::string get_path(std::uint64_t key) const;
+    };
+}
+
+#endif //RENDERER_PROGRAM_BINARY_CACHE_H
@@ -6,6 +6,7 @@
  */
 
 #include <algorithm>
+#include <chrono>
 #include <utility>
 #include "shaderpack.h"
 
@@ -14,18 +15,307 @@
 namespace nova {
     shaderpack::shaderpack(std::string name, nlohmann::json shaders_json, std::vector<shader_definition> &shaders) {
         this->name = std::move(name);
+
+        binaries = std::make_shared<program_binary_cache>("cache/programs", program_binary_cache::get_current_driver());
+
+        parallel_compile = GLAD_GL_ARB_parallel_shader_compile != 0;
+        if(parallel_compile) {
+            // Let the driver use as many threads as it likes
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        }
+
+        read_options(shaders_json);
+
         for(auto& shader : shaders) {
             LOG(TRACE) << "Adding shader " << shader.name;
-            try {
-                loaded_shaders.emplace(shader.name, gl_shader_program(shader));
-            } catch(std::exception& e) {
-                LOG(ERROR) << "Could not load shader " << shader.name << " because " << e.what();
+            auto added = loaded_shaders.emplace(shader.name, gl_shader_program(shader, binaries.get(), option_names, enabled_options)).second;
+            if(!added) {
+                LOG(WARNING) << "Shaderpack " << this->name << " has more than one shader called " << shader.name << ", so only the first is used";
+                continue;
+            }
+            shader_names.push_back(shader.name);
+            if(shader.fallback_name) {
+                fallback_names[shader.name] = *shader.fallback_name;
             }
+            remember_shader_files(shader);
+        }
+        // Nothing's compiled until the render thread calls update_programs
+        num_unfinished = loaded_shaders.size();
+
+        std::vector<std::pair<std::string, std::string>> shader_filters;
+        for(const auto& shader_name : shader_names) {
+            shader_filters.emplace_back(shader_name, loaded_shaders.at(shader_name).get_filter());
         }
+        filters = geometry_filter_set(shader_filters);
+        programs_start = std::chrono::high_resolution_clock::now();
 
         LOG(TRACE) << "Shaderpack created";
     }
 
+    void shaderpack::read_options(const nlohmann::json &shaders_json) {
+        if(!shaders_json.is_object() || shaders_json.find("options") == shaders_json.end()) {
+            return;
+        }
+
+        options = shaders_json["options"];
+        for(const auto& option : options) {
+            // Either just a name, or an object with a name and whether it's on when nobody's said otherwise
+            auto is_object = option.is_object();
+            std::string option_name = is_object ? option.value("name", "") : option.get<std::string>();
+            if(option_name.empty()) {
+                continue;
+            }
+
+            if(option_names.size() == MAX_OPTIONS) {
+                LOG(WARNING) << "Shaderpack " << name << " has more than " << option_names.size() << " options, so "
+                             << option_name << " will never be turned on";
+                continue;
+            }
+
+            if(is_object && option.value("default", false)) {
+                default_options |= 1ull << option_names.size();
+            }
+            option_names.push_back(option_name);
+        }
+
+        enabled_options = default_options;
+    }
+
+    void shaderpack::set_options(const nlohmann::json &values) {
+        auto new_options = default_options;
+        for(std::size_t i = 0; i < option_names.size(); i++) {
+            auto value = values.find(option_names[i]);
+            if(value != values.end() && value->is_boolean()) {
+                new_options = value->get<bool>() ? (new_options | (1ull << i)) : (new_options & ~(1ull << i));
+            }
+        }
+
+        if(new_options == enabled_options) {
+            return;
+        }
+        enabled_options = new_options;
+
+        // Programs that don't have a variant for these options yet make one, which update_programs compiles while
+        // the old one keeps drawing
+        num_unfinished = 0;
+        for(auto& shader : loaded_shaders) {
+            shader.second.set_options(enabled_options);
+            auto status = shader.second.get_status();
+            if(status == program_status::not_started || status == program_status::compiling) {
+                num_unfinished++;
+            }
+        }
+        for(auto& shader : reloading_shaders) {
+            shader.second.set_options(enabled_options);
+        }
+
+        if(num_unfinished > 0) {
+            LOG(INFO) << "Compiling " << num_unfinished << " programs for the new shaderpack options";
+            programs_start = std::chrono::high_resolution_clock::now();
+        }
+    }
+
+    void shaderpack::remember_shader_files(const shader_definition &shader) {
+        auto& files = shader_files[shader.name];
+        files.clear();
+        for(const auto* source : {&shader.vertex_source, &shader.fragment_source}) {
+            for(const auto& file : source->get_files()) {
+                files.push_back(file->path);
+            }
+        }
+        for(const auto* spirv : {&shader.vertex_spirv, &shader.fragment_spirv}) {
+            if(*spirv) {
+                files.push_back((*spirv)->path);
+            }
+        }
+    }
+
+    std::unordered_set<std::string> shaderpack::get_shaders_using(const std::unordered_set<std::string> &changed_files) const {
+        std::unordered_set<std::string> shaders;
+        for(const auto& shader : shader_files) {
+            for(const auto& file : shader.second) {
+                if(changed_files.find(file) != changed_files.end()) {
+                    shaders.insert(shader.first);
+                    break;
+                }
+            }
+        }
+
+        return shaders;
+    }
+
+    void shaderpack::reload_shaders(std::vector<shader_definition> &shaders) {
+        if(reloading_shaders.empty()) {
+            reload_start = std::chrono::high_resolution_clock::now();
+        }
+
+        for(auto& shader : shaders) {
+            // Shaders that weren't in the pack to begin with need the whole pack reloaded, since the game has to be
+            // told about their filters
+            if(loaded_shaders.find(shader.name) == loaded_shaders.end()) {
+                continue;
+            }
+
+            // A shader that's edited again before it's done compiling starts over with the newest version
+            reloading_shaders.erase(shader.name);
+            reloading_shaders.emplace(shader.name, gl_shader_program(shader, binaries.get(), option_names, enabled_options));
+            remember_shader_files(shader);
+        }
+    }
+
+    void shaderpack::update_reloading_shaders(std::vector<gl_shader_program*> &newly_ready) {
+        // Reloads are for people editing shaders, so they don't wait for the compile budget
+        bool all_done = true;
+        for(auto& shader : reloading_shaders) {
+            auto& program = shader.second;
+            program.start_compiling();
+            if(program.get_status() == program_status::compiling) {
+                program.finish_compiling(false);
+            }
+            all_done = all_done && (program.get_status() == program_status::ready || program.get_status() == program_status::failed);
+        }
+
+        if(!all_done) {
+            return;
+        }
+
+        // Everything goes in together, so a frame never has some shaders with an edit and some without
+        std::size_t num_reloaded = 0;
+        for(auto& shader : reloading_shaders) {
+            if(shader.second.get_status() == program_status::ready) {
+                auto& program = loaded_shaders.at(shader.first);
+                program.take_program_from(shader.second);
+                newly_ready.push_back(&program);
+                num_reloaded++;
+            } else {
+                LOG(ERROR) << "Shader " << shader.first << " didn't compile, so the old version is still being used";
+            }
+        }
+
+        auto reload_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - reload_start);
+        LOG(INFO) << "Reloaded " << num_reloaded << " of " << reloading_shaders.size() << " edited shaders in "
+                  << reload_time.count() << "us";
+
+        reloading_shaders.clear();
+    }
+
+    std::vector<gl_shader_program*> shaderpack::update_programs() {
+        std::vector<gl_shader_program*> newly_ready;
+        if(!reloading_shaders.empty()) {
+            update_reloading_shaders(newly_ready);
+        }
+
+        if(num_unfinished == 0) {
+            return newly_ready;
+        }
+
+        auto update_start = std::chrono::high_resolution_clock::now();
+        auto is_over_budget = [&]() {
+            auto time_spent = std::chrono::high_resolution_clock::now() - update_start;
+            return !parallel_compile && time_spent > std::chrono::microseconds(COMPILE_BUDGET_US);
+        };
+
+        // Finish whatever the driver's done with. Without the extension there's no asking, so this waits for the
+        // driver, but anything here was started on an earlier frame
+        for(auto& shader : loaded_shaders) {
+            auto& program = shader.second;
+            if(program.get_status() != program_status::compiling) {
+                continue;
+            }
+
+            auto status = program.finish_compiling(false);
+            if(status == program_status::ready) {
+                newly_ready.push_back(&program);
+            }
+            if(status == program_status::ready || status == program_status::failed) {
+                num_unfinished--;
+            }
+
+            if(is_over_budget()) {
+                break;
+            }
+        }
+
+        // Start as many new ones as there's time for, which is all of them if the driver compiles in the background
+        for(auto& shader : loaded_shaders) {
+            auto& program = shader.second;
+            if(program.get_status() != program_status::not_started) {
+                continue;
+            }
+
+            if(is_over_budget()) {
+                break;
+            }
+
+            program.start_compiling();
+
+            // Cached binaries are ready straight away, and programs that couldn't be started have already failed
+            if(program.get_status() == program_status::ready) {
+                newly_ready.push_back(&program);
+            }
+            if(program.get_status() != program_status::compiling) {
+                num_unfinished--;
+            }
+        }
+
+        if(num_unfinished == 0) {
+            log_load_times();
+        }
+
+        return newly_ready;
+    }
+
+    bool shaderpack::is_done_compiling() const {
+        return num_unfinished == 0;
+    }
+
+    std::size_t shaderpack::get_num_unfinished() const {
+        return num_unfinished;
+    }
+
+    void shaderpack::delete_programs() {
+        for(auto& shader : loaded_shaders) {
+            shader.second.delete_variants();
+        }
+        for(auto& shader : reloading_shaders) {
+            shader.second.delete_variants();
+        }
+        reloading_shaders.clear();
+        num_unfinished = 0;
+    }
+
+    void shaderpack::log_load_times() const {
+        auto programs_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - programs_start);
+
+        shader_load_times total;
+        std::size_t num_ready = 0;
+        std::size_t num_cached = 0;
+        for(const auto& shader : loaded_shaders) {
+            const auto& times = shader.second.get_load_times();
+            LOG(INFO) << "Shader " << shader.first << ": load " << times.load.count() << "us, preprocess "
+                      << times.preprocess.count() << "us, compile " << times.compile.count() << "us, link "
+                      << times.link.count() << "us, ready after " << times.ready.count() << "us"
+                      << (times.from_binary_cache ? " (from the program binary cache)" : "");
+
+            num_ready += shader.second.is_ready() ? 1 : 0;
+            num_cached += times.from_binary_cache ? 1 : 0;
+            total.load += times.load;
+            total.preprocess += times.preprocess;
+            total.compile += times.compile;
+            total.link += times.link;
+        }
+
+        // Loading and preprocessing happen on several threads at once, so their totals can be more than the time
+        // they took
+        LOG(INFO) << "Shaderpack " << name << " totals: load " << total.load.count() << "us, preprocess "
+                  << total.preprocess.count() << "us, compile " << total.compile.count() << "us, link "
+                  << total.link.count() << "us";
+
+        // When every program comes from the binary cache it's a warm start, when none of them do it's a cold one
+        LOG(INFO) << "Made " << num_ready << " of " << loaded_shaders.size() << " programs in " << programs_time.count()
+                  << "us, " << num_cached << " of them from the program binary cache";
+    }
+
     gl_shader_program &shaderpack::operator[](std::string key) {
         return get_shader(std::move(key));
     }
@@ -34,8 +324,24 @@ namespace nova {
         return loaded_shaders;
     }
 
+    const geometry_filter_set &shaderpack::get_filters() const {
+        return filters;
+    }
+
     void shaderpack::operator=(const shaderpack &other) {
         loaded_shaders = other.loaded_shaders;
+        shader_names = other.shader_names;
+        fallback_names = other.fallback_names;
+        option_names = other.option_names;
+        default_options = other.default_options;
+        enabled_options = other.enabled_options;
+        options = other.options;
+        shader_files = other.shader_files;
+        binaries = other.binaries;
+        parallel_compile = other.parallel_compile;
+        num_unfinished = other.num_unfinished;
+        programs_start = other.programs_start;
+        filters = other.filters;
     }
 
     std::string &shaderpack::get_name() {
@@ -43,6 +349,20 @@ namespace nova {
     }
 
     gl_shader_program &shaderpack::get_shader(std::string key) {
-        return loaded_shaders[key];
+        // There can't be more steps than shaders without going around in a circle
+        for(std::size_t i = 0; i <= loaded_shaders.size(); i++) {
+            auto shader = loaded_shaders.find(key);
+            if(shader != loaded_shaders.end() && shader->second.is_ready()) {
+                return shader->second;
+            }
+
+            auto fallback = fallback_names.find(key);
+            if(fallback == fallback_names.end()) {
+                break;
+            }
+            key = fallback->second;
+        }
+
+        return missing_program;
     }
 }
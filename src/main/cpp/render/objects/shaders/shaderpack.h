@@ -9,16 +9,20 @@
 #define RENDERER_SHADER_INTERFACE_H
 
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <string>
 #include <functional>
 #include <unordered_map>
 #include <initializer_list>
+#include <memory>
 #include <mutex>
 #include <optional.hpp>
 
 #include "gl_shader_program.h"
+#include "program_binary_cache.h"
 #include "../../../data_loading/loaders/shader_source_structs.h"
+#include "../../../geometry_cache/geometry_filter.h"
 
 namespace nova {
     /*!
@@ -42,19 +46,158 @@ namespace nova {
 
         gl_shader_program &operator[](std::string key);
 
+        /*!
+         * \brief Gets the shader with the given name or, if it isn't ready yet, the first of its fallbacks that is
+         *
+         * \return The shader to draw with. If neither the shader nor any of its fallbacks are ready, a program that
+         * isn't ready either, so check is_ready before drawing with it
+         */
         gl_shader_program& get_shader(std::string key);
 
+        /*!
+         * \brief Moves every program along in getting compiled, without holding up the frame for long
+         *
+         * Call this once a frame on the render thread. When the driver compiles in the background, every program is
+         * started at once and only the ones the driver is done with are finished. Otherwise programs are started and
+         * finished a few at a time, until a frame's worth of compile time is used up
+         *
+         * \return The programs that became ready during this call
+         */
+        std::vector<gl_shader_program*> update_programs();
+
+        /*!
+         * \brief True if every program is either ready or has failed
+         */
+        bool is_done_compiling() const;
+
+        /*!
+         * \brief How many programs are still to be compiled, counting ones that are compiling now
+         */
+        std::size_t get_num_unfinished() const;
+
+        /*!
+         * \brief Deletes every program's OpenGL objects, like when another shaderpack has replaced this one and the
+         * GPU is done with it. Names and filters are left alone, since the game thread might still be reading them
+         */
+        void delete_programs();
+
+        /*!
+         * \brief Turns the shaderpack's options on and off
+         *
+         * Each program only needs compiling again if it uses an option that changed, and then only the first time
+         * those options are picked. The old programs are drawn with until the new ones are ready
+         *
+         * \param values Whether each option is on, by name, like {"SOFT_SHADOWS": true}. Options that aren't in here
+         * go back to their defaults
+         */
+        void set_options(const nlohmann::json &values);
+
+        /*!
+         * \brief Finds the shaders that were made from any of the given files, either directly or through an #include
+         *
+         * \param changed_files Paths to shader files, like "shaderpacks/default/shaders/gui.frag"
+         */
+        std::unordered_set<std::string> get_shaders_using(const std::unordered_set<std::string> &changed_files) const;
+
+        /*!
+         * \brief Compiles new versions of some of the shaders, to replace the ones there now
+         *
+         * update_programs compiles them alongside the programs that are in use. Once every one of them has either
+         * compiled or failed, the ones that compiled all replace the old programs at once, and the ones that failed
+         * leave the old programs where they are
+         *
+         * \param shaders The new sources for the shaders
+         */
+        void reload_shaders(std::vector<shader_definition> &shaders);
+
 		std::unordered_map<std::string, gl_shader_program> &get_loaded_shaders();
 
+        /*!
+         * \brief The filter of every shader, compiled, in the order the shaders were given to the constructor. This is
+         * the order the game is told about shaders in, so use the filter's index rather than get_loaded_shaders to go
+         * between them
+         */
+        const geometry_filter_set &get_filters() const;
+
         void operator=(const shaderpack& other);
 
         std::string& get_name();
 
     private:
+        /*!
+         * \brief How long update_programs can spend on compiling when the driver doesn't compile in the background.
+         * A little under a quarter of a 60 FPS frame
+         */
+        static const int COMPILE_BUDGET_US = 4000;
+
+        /*!
+         * \brief How many options fit in an option mask
+         */
+        static const std::size_t MAX_OPTIONS = 64;
+
+        /*!
+         * \brief Every shader in the pack, ready or not. Nothing's added or removed after the constructor, since the
+         * game thread reads the names and filters
+         */
         std::unordered_map<std::string, gl_shader_program> loaded_shaders;
 
+        /*!
+         * \brief The name of every shader, in the order they were given to the constructor. The filters are made in
+         * this order, since loaded_shaders doesn't have one
+         */
+        std::vector<std::string> shader_names;
+
+        /*!
+         * \brief The fallback of every shader that has one
+         */
+        std::unordered_map<std::string, std::string> fallback_names;
+
+        /*!
+         * \brief New versions of edited shaders, until they've all finished compiling
+         */
+        std::unordered_map<std::string, gl_shader_program> reloading_shaders;
+
+        std::chrono::high_resolution_clock::time_point reload_start;
+
+        /*!
+         * \brief The path of every file that went into each shader
+         */
+        std::unordered_map<std::string, std::vector<std::string>> shader_files;
+
+        /*!
+         * \brief What get_shader gives out when nothing it's asked for is ready
+         */
+        gl_shader_program missing_program;
+
+        std::shared_ptr<const program_binary_cache> binaries;
+
+        bool parallel_compile = false;
+
+        std::size_t num_unfinished = 0;
+
+        geometry_filter_set filters;
+
+        std::chrono::high_resolution_clock::time_point programs_start;
+
         std::string name;
 
+        void log_load_times() const;
+
+        void remember_shader_files(const shader_definition &shader);
+
+        /*!
+         * \brief Reads the options array from shaders.json. Each option is either a name, or an object like
+         * {"name": "SOFT_SHADOWS", "default": true}
+         */
+        void read_options(const nlohmann::json &shaders_json);
+
+        /*!
+         * \brief Moves the reloaded shaders along, and swaps them in once they're all done
+         *
+         * \param newly_ready Where to put the programs that were swapped in
+         */
+        void update_reloading_shaders(std::vector<gl_shader_program*> &newly_ready);
+
         /*!
          * \brief The indices of the framebuffer attachments that any of the non-shadow shaders write to
          */
@@ -69,6 +212,18 @@ namespace nova {
          * \brief The options that the shaders in this shaderpack set
          */
         nlohmann::json options;
+
+        /*!
+         * \brief The name of each option. The first one is bit 0 of an option mask, and so on
+         */
+        std::vector<std::string> option_names;
+
+        std::uint64_t default_options = 0;
+
+        /*!
+         * \brief The options that are on now
+         */
+        std::uint64_t enabled_options = 0;
     };
 }
 
@@ -0,0 +1,323 @@
+/*!
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include "atlas_packer.h"
+
+namespace nova {
+    bool atlas_rect::contains(const atlas_rect &other) const {
+        return other.x >= x && other.y >= y && other.x + other.width <= x + width && other.y + other.height <= y + height;
+    }
+
+    bool atlas_rect::intersects(const atlas_rect &other) const {
+        return other.x < x + width && other.x + other.width > x && other.y < y + height && other.y + other.height > y;
+    }
+
+    atlas_page::atlas_page(glm::ivec2 initial_size, int max_size) : size(initial_size), max_size(max_size) {
+        free_rects.push_back({0, 0, size.x, size.y});
+    }
+
+    bool atlas_page::insert(glm::ivec2 rect_size, glm::ivec2 &position) {
+        atlas_rect best;
+        if(!find_position(rect_size, best)) {
+            return false;
+        }
+
+        place(best);
+        position = {best.x, best.y};
+        return true;
+    }
+
+    bool atlas_page::insert_growing(glm::ivec2 rect_size, glm::ivec2 &position) {
+        if(!could_ever_fit(rect_size)) {
+            return false;
+        }
+
+        while(!insert(rect_size, position)) {
+            if(!grow()) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool atlas_page::could_ever_fit(glm::ivec2 rect_size) const {
+        return rect_size.x <= max_size && rect_size.y <= max_size;
+    }
+
+    glm::ivec2 atlas_page::get_size() const {
+        return size;
+    }
+
+    float atlas_page::get_occupancy() const {
+        return (float) ((double) used_area / ((double) size.x * size.y));
+    }
+
+    bool atlas_page::find_position(glm::ivec2 rect_size, atlas_rect &best) const {
+        // Best short side fit: put the rect wherever it leaves the thinnest sliver of free space, so that the space
+        // left over is as big and as square as possible
+        int best_short_side = std::numeric_limits<int>::max();
+        int best_long_side = std::numeric_limits<int>::max();
+
+        for(const auto& free_rect : free_rects) {
+            if(free_rect.width < rect_size.x || free_rect.height < rect_size.y) {
+                continue;
+            }
+
+            int leftover_x = free_rect.width - rect_size.x;
+            int leftover_y = free_rect.height - rect_size.y;
+            int short_side = std::min(leftover_x, leftover_y);
+            int long_side = std::max(leftover_x, leftover_y);
+
+            if(short_side < best_short_side || (short_side == best_short_side && long_side < best_long_side)) {
+                best = {free_rect.x, free_rect.y, rect_size.x, rect_size.y};
+                best_short_side = short_side;
+                best_long_side = long_side;
+            }
+        }
+
+        return best_short_side != std::numeric_limits<int>::max();
+    }
+
+    void atlas_page::place(const atlas_rect &placed) {
+        std::vector<atlas_rect> new_free_rects;
+
+        for(auto itr = free_rects.begin(); itr != free_rects.end();) {
+            const atlas_rect free_rect = *itr;
+            if(!free_rect.intersects(placed)) {
+                ++itr;
+                continue;
+            }
+
+            // Whatever's left of the free rect on each side of the placed rect is still free. The pieces overlap
+            // each other, which is fine. That's what the "max" in MaxRects is about
+            if(placed.x > free_rect.x) {
+                new_free_rects.push_back({free_rect.x, free_rect.y, placed.x - free_rect.x, free_rect.height});
+            }
+            if(placed.x + placed.width < free_rect.x + free_rect.width) {
+                int right = placed.x + placed.width;
+                new_free_rects.push_back({right, free_rect.y, free_rect.x + free_rect.width - right, free_rect.height});
+            }
+            if(placed.y > free_rect.y) {
+                new_free_rects.push_back({free_rect.x, free_rect.y, free_rect.width, placed.y - free_rect.y});
+            }
+            if(placed.y + placed.height < free_rect.y + free_rect.height) {
+                int bottom = placed.y + placed.height;
+                new_free_rects.push_back({free_rect.x, bottom, free_rect.width, free_rect.y + free_rect.height - bottom});
+            }
+
+            itr = free_rects.erase(itr);
+        }
+
+        std::size_t first_new_rect = free_rects.size();
+        free_rects.insert(free_rects.end(), new_free_rects.begin(), new_free_rects.end());
+        prune_free_rects(first_new_rect);
+
+        used_area += (long long) placed.width * placed.height;
+    }
+
+    bool atlas_page::grow() {
+        bool grow_width;
+        if(size.x <= size.y && size.x * 2 <= max_size) {
+            grow_width = true;
+        } else if(size.y * 2 <= max_size) {
+            grow_width = false;
+        } else if(size.x * 2 <= max_size) {
+            grow_width = true;
+        } else {
+            return false;
+        }
+
+        // Anything free that touched the old edge of the page now runs all the way to the new edge. The new strip is
+        // free too, and is only a separate rect if nothing free touched the old edge along its whole length
+        if(grow_width) {
+            int old_width = size.x;
+            size.x *= 2;
+            for(auto& free_rect : free_rects) {
+                if(free_rect.x + free_rect.width == old_width) {
+                    free_rect.width = size.x - free_rect.x;
+                }
+            }
+            free_rects.push_back({old_width, 0, size.x - old_width, size.y});
+
+        } else {
+            int old_height = size.y;
+            size.y *= 2;
+            for(auto& free_rect : free_rects) {
+                if(free_rect.y + free_rect.height == old_height) {
+                    free_rect.height = size.y - free_rect.y;
+                }
+            }
+            free_rects.push_back({0, old_height, size.x, size.y - old_height});
+        }
+
+        // Stretching the old rects can't make one of them contain another, so only the new strip needs checking
+        prune_free_rects(free_rects.size() - 1);
+        return true;
+    }
+
+    void atlas_page::prune_free_rects(std::size_t first_new_rect) {
+        // The old rects can't contain each other, since they were pruned last time. Only the new ones need checking
+        std::vector<bool> removed(free_rects.size(), false);
+        for(std::size_t i = first_new_rect; i < free_rects.size(); i++) {
+            for(std::size_t j = 0; j < free_rects.size(); j++) {
+                if(i == j || removed[j]) {
+                    continue;
+                }
+
+                if(free_rects[j].contains(free_rects[i])) {
+                    removed[i] = true;
+                    break;
+
+                } else if(free_rects[i].contains(free_rects[j])) {
+                    removed[j] = true;
+                }
+            }
+        }
+
+        std::size_t num_kept = 0;
+        for(std::size_t i = 0; i < free_rects.size(); i++) {
+            if(!removed[i]) {
+                free_rects[num_kept++] = free_rects[i];
+            }
+        }
+        free_rects.resize(num_kept);
+    }
+
+    atlas_packer::atlas_packer(int max_page_size, int padding, int initial_page_size, int alignment) :
+            max_page_size(max_page_size), padding(padding), initial_page_size(std::min(initial_page_size, max_page_size)),
+            alignment(alignment) {}
+
+    bool atlas_packer::add(const std::string &name, glm::ivec2 size) {
+        auto existing = sprites.find(name);
+        if(existing != sprites.end()) {
+            if(existing->second.size == size) {
+                return true;
+            }
+
+            // MaxRects can't easily give the old space back, so it's wasted until the packer is cleared
+            sprites.erase(existing);
+        }
+
+        glm::ivec2 cell_size = {size.x + padding * 2, size.y + padding * 2};
+        cell_size.x = (cell_size.x + alignment - 1) / alignment * alignment;
+        cell_size.y = (cell_size.y + alignment - 1) / alignment * alignment;
+        glm::ivec2 position;
+
+        // Squeezing the sprite into the space that a page already has is best, growing a page is second best, and
+        // making a whole new page is the last resort
+        for(std::size_t i = 0; i < pages.size(); i++) {
+            if(pages[i].insert(cell_size, position)) {
+                sprites[name] = make_sprite(i, position, cell_size, size);
+                return true;
+            }
+        }
+
+        for(std::size_t i = 0; i < pages.size(); i++) {
+            if(pages[i].insert_growing(cell_size, position)) {
+                sprites[name] = make_sprite(i, position, cell_size, size);
+                return true;
+            }
+        }
+
+        atlas_page new_page({initial_page_size, initial_page_size}, max_page_size);
+        if(!new_page.insert_growing(cell_size, position)) {
+            return false;
+        }
+
+        pages.push_back(new_page);
+        sprites[name] = make_sprite(pages.size() - 1, position, cell_size, size);
+        return true;
+    }
+
+    std::vector<std::string> atlas_packer::add_all(const std::vector<std::pair<std::string, glm::ivec2>> &new_sprites) {
+        std::vector<const std::pair<std::string, glm::ivec2>*> sorted_sprites;
+        sorted_sprites.reserve(new_sprites.size());
+        for(const auto& sprite : new_sprites) {
+            sorted_sprites.push_back(&sprite);
+        }
+
+        std::stable_sort(sorted_sprites.begin(), sorted_sprites.end(), [](const auto* a, const auto* b) {
+            if(a->second.y != b->second.y) {
+                return a->second.y > b->second.y;
+            }
+            return a->second.x > b->second.x;
+        });
+
+        std::vector<std::string> sprites_that_did_not_fit;
+        for(const auto* sprite : sorted_sprites) {
+            if(!add(sprite->first, sprite->second)) {
+                sprites_that_did_not_fit.push_back(sprite->first);
+            }
+        }
+
+        return sprites_that_did_not_fit;
+    }
+
+    bool atlas_packer::contains(const std::string &name) const {
+        return sprites.find(name) != sprites.end();
+    }
+
+    const packed_sprite &atlas_packer::get_sprite(const std::string &name) const {
+        auto sprite = sprites.find(name);
+        if(sprite == sprites.end()) {
+            throw std::out_of_range("No sprite named " + name + " has been packed");
+        }
+
+        return sprite->second;
+    }
+
+    void atlas_packer::get_uv_bounds(const std::string &name, glm::vec2 &min, glm::vec2 &max) const {
+        const auto& sprite = get_sprite(name);
+        glm::ivec2 page_size = pages[sprite.page].get_size();
+
+        min = {(float) sprite.position.x / page_size.x, (float) sprite.position.y / page_size.y};
+        max = {(float) (sprite.position.x + sprite.size.x) / page_size.x, (float) (sprite.position.y + sprite.size.y) / page_size.y};
+    }
+
+    const std::unordered_map<std::string, packed_sprite> &atlas_packer::get_sprites() const {
+        return sprites;
+    }
+
+    std::size_t atlas_packer::get_num_pages() const {
+        return pages.size();
+    }
+
+    const atlas_page &atlas_packer::get_page(std::size_t page) const {
+        return pages.at(page);
+    }
+
+    float atlas_packer::get_occupancy() const {
+        double used_area = 0;
+        double total_area = 0;
+        for(const auto& page : pages) {
+            double page_area = (double) page.get_size().x * page.get_size().y;
+            used_area += page.get_occupancy() * page_area;
+            total_area += page_area;
+        }
+
+        return total_area > 0 ? (float) (used_area / total_area) : 0.0f;
+    }
+
+    int atlas_packer::get_padding() const {
+        return padding;
+    }
+
+    int atlas_packer::get_alignment() const {
+        return alignment;
+    }
+
+    packed_sprite atlas_packer::make_sprite(std::size_t page, glm::ivec2 cell_position, glm::ivec2 cell_size, glm::ivec2 size) const {
+        return {page, {cell_position.x + padding, cell_position.y + padding}, size, {cell_position.x, cell_position.y, cell_size.x, cell_size.y}};
+    }
+
+    void atlas_packer::clear() {
+        pages.clear();
+        sprites.clear();
+    }
+}
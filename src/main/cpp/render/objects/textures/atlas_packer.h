@@ -0,0 +1,203 @@
+/*!
+ * \brief Decides where in which texture atlas every sprite goes
+ *
+ * This is pure CPU bookkeeping: the packer only deals in rectangles. The texture_manager copies the pixels around and
+ * uploads them
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_ATLAS_PACKER_H
+#define RENDERER_ATLAS_PACKER_H
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace nova {
+    /*!
+     * \brief A rectangle in pixels. Used for both the free space in a page and the sprites placed in it
+     */
+    struct atlas_rect {
+        int x;
+        int y;
+        int width;
+        int height;
+
+        bool contains(const atlas_rect &other) const;
+
+        bool intersects(const atlas_rect &other) const;
+    };
+
+    /*!
+     * \brief One texture atlas, packed with the MaxRects algorithm
+     *
+     * MaxRects keeps a list of every maximal free rectangle in the page. They overlap each other, which is what lets it
+     * find space that a skyline or a guillotine packer would have thrown away. Sprites go wherever they leave the
+     * shortest leftover side, which packs Minecraft's mostly-square textures very tightly
+     *
+     * Pages start out small and double in size, up to the maximum, whenever a sprite doesn't fit. Growing a page
+     * never moves anything already in it, so the UVs that a page hands out only ever shrink by a power of two
+     */
+    class atlas_page {
+    public:
+        /*!
+         * \param initial_size The size the page starts out at. Must be a power of two
+         * \param max_size The biggest the page may get in either dimension
+         */
+        atlas_page(glm::ivec2 initial_size, int max_size);
+
+        /*!
+         * \brief Finds a spot for a rectangle of the given size without growing the page
+         *
+         * \param size The size of the rectangle to place
+         * \param position Where the rectangle ended up, if it fit
+         * \return True if the rectangle fit, false if the page is too full
+         */
+        bool insert(glm::ivec2 size, glm::ivec2 &position);
+
+        /*!
+         * \brief Like insert, but doubles the page as many times as it needs to (and is allowed to) to make room
+         */
+        bool insert_growing(glm::ivec2 size, glm::ivec2 &position);
+
+        /*!
+         * \brief Tells you if a rectangle of the given size could fit in this page if it was as big as it's allowed to
+         * get. Doesn't change anything
+         */
+        bool could_ever_fit(glm::ivec2 size) const;
+
+        glm::ivec2 get_size() const;
+
+        /*!
+         * \brief The fraction of the page's area that has something in it
+         */
+        float get_occupancy() const;
+
+    private:
+        glm::ivec2 size;
+        int max_size;
+        long long used_area = 0;
+
+        std::vector<atlas_rect> free_rects;
+
+        bool find_position(glm::ivec2 size, atlas_rect &best) const;
+
+        void place(const atlas_rect &placed);
+
+        /*!
+         * \brief Doubles the smaller dimension of the page, turning the new space into free rectangles
+         *
+         * \return False if the page is already as big as it can get
+         */
+        bool grow();
+
+        /*!
+         * \brief Removes every free rectangle that's entirely inside another one
+         *
+         * \param first_new_rect The index of the first free rectangle added since the last time this was called
+         */
+        void prune_free_rects(std::size_t first_new_rect);
+    };
+
+    /*!
+     * \brief Where a sprite ended up
+     */
+    struct packed_sprite {
+        std::size_t page;       //!< The index of the page the sprite is in
+        glm::ivec2 position;    //!< The top-left corner of the sprite in the page, not counting padding
+        glm::ivec2 size;        //!< The size of the sprite, not counting padding
+        atlas_rect cell;        //!< All the space set aside for the sprite, including padding and alignment
+    };
+
+    /*!
+     * \brief Packs sprites into as few atlas pages as it can
+     *
+     * Sprites can be added a few at a time. Each new sprite goes in the first page with room for it, so sprites that
+     * were already packed never move and their pixels don't need to be uploaded again. A new page is only made when a
+     * sprite won't fit in any existing page even after growing it to the maximum size
+     *
+     * Every sprite gets a border of padding pixels on every side, so that filtering doesn't pull in texels from the
+     * sprite next to it. The space set aside for a sprite can also be rounded up to a multiple of some alignment. If
+     * every cell's size is a multiple of the alignment then so is every cell's position, since cells are only ever
+     * placed against the edge of the page or of another cell. That's what keeps sprites from bleeding into each other
+     * in the mip levels: a 2^n aligned cell shrinks down to whole texels in each of the first n mip levels
+     */
+    class atlas_packer {
+    public:
+        /*!
+         * \param max_page_size The maximum width and height of a page. Usually texture_manager::get_max_texture_size
+         * \param padding The number of pixels to leave around each sprite
+         * \param initial_page_size The size that new pages start out at
+         * \param alignment What the size of each sprite's cell is rounded up to a multiple of. Must be a power of two
+         * no bigger than initial_page_size
+         */
+        explicit atlas_packer(int max_page_size, int padding = 0, int initial_page_size = 256, int alignment = 1);
+
+        /*!
+         * \brief Finds a place for a single sprite
+         *
+         * If there's already a sprite with this name it keeps its old place, as long as it's the same size
+         *
+         * \return True if the sprite was placed, false if it's bigger than a whole page
+         */
+        bool add(const std::string &name, glm::ivec2 size);
+
+        /*!
+         * \brief Places a whole batch of sprites at once
+         *
+         * The sprites are packed from tallest to shortest, which wastes a lot less space than packing them in whatever
+         * order they came in
+         *
+         * \return The names of the sprites that didn't fit anywhere
+         */
+        std::vector<std::string> add_all(const std::vector<std::pair<std::string, glm::ivec2>> &sprites);
+
+        bool contains(const std::string &name) const;
+
+        const packed_sprite &get_sprite(const std::string &name) const;
+
+        /*!
+         * \brief Gives you the UV coordinates of a sprite, relative to the current size of its page
+         */
+        void get_uv_bounds(const std::string &name, glm::vec2 &min, glm::vec2 &max) const;
+
+        const std::unordered_map<std::string, packed_sprite> &get_sprites() const;
+
+        std::size_t get_num_pages() const;
+
+        const atlas_page &get_page(std::size_t page) const;
+
+        /*!
+         * \brief The fraction of all the pages' area that's covered by sprites, padding included
+         */
+        float get_occupancy() const;
+
+        int get_padding() const;
+
+        int get_alignment() const;
+
+        /*!
+         * \brief Forgets about every sprite and page
+         */
+        void clear();
+
+    private:
+        int max_page_size;
+        int padding;
+        int initial_page_size;
+        int alignment;
+
+        std::vector<atlas_page> pages;
+
+        std::unordered_map<std::string, packed_sprite> sprites;
+
+        packed_sprite make_sprite(std::size_t page, glm::ivec2 cell_position, glm::ivec2 cell_size, glm::ivec2 size) const;
+    };
+}
+
+#endif //RENDERER_ATLAS_PACKER_H
@@ -0,0 +1,942 @@
+/*!
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "block_compression.h"
+
+namespace nova {
+    texture_compression texture_compression_from_string(const std::string &name) {
+        if(name == "bc1") {
+            return texture_compression::bc1;
+        } else if(name == "bc3") {
+            return texture_compression::bc3;
+        } else if(name == "bc7") {
+            return texture_compression::bc7;
+        }
+
+        return texture_compression::none;
+    }
+
+    GLenum get_gl_internal_format(texture_compression compression) {
+        switch(compression) {
+            case texture_compression::bc1:
+                return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+            case texture_compression::bc3:
+                return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            case texture_compression::bc7:
+                return GL_COMPRESSED_RGBA_BPTC_UNORM;
+            default:
+                return GL_RGBA8;
+        }
+    }
+
+    std::size_t get_bytes_per_block(texture_compression compression) {
+        return compression == texture_compression::bc1 ? 8 : 16;
+    }
+
+    std::size_t get_compressed_size(glm::ivec2 size, texture_compression compression) {
+        std::size_t blocks_wide = (std::size_t) (size.x + 3) / 4;
+        std::size_t blocks_high = (std::size_t) (size.y + 3) / 4;
+        return blocks_wide * blocks_high * get_bytes_per_block(compression);
+    }
+
+    /*
+     * Helpers that all the encoders share
+     */
+
+    /*!
+     * \brief Finds the line through a set of colors that they're most spread out along, by power iteration on their
+     * covariance matrix
+     *
+     * \tparam N The number of channels to consider: 3 for RGB, 4 for RGBA
+     * \param mean Gets the mean of the colors
+     * \param axis Gets the direction of the line. Not normalized
+     */
+    template <int N>
+    static void find_principal_axis(const float colors[][4], int num_colors, float mean[4], float axis[4]) {
+        for(int c = 0; c < 4; c++) {
+            mean[c] = 0;
+            axis[c] = 0;
+        }
+        for(int i = 0; i < num_colors; i++) {
+            for(int c = 0; c < N; c++) {
+                mean[c] += colors[i][c];
+            }
+        }
+        for(int c = 0; c < N; c++) {
+            mean[c] /= num_colors;
+        }
+
+        float covariance[4][4] = {};
+        for(int i = 0; i < num_colors; i++) {
+            float diff[4];
+            for(int c = 0; c < N; c++) {
+                diff[c] = colors[i][c] - mean[c];
+            }
+            for(int a = 0; a < N; a++) {
+                for(int b = 0; b < N; b++) {
+                    covariance[a][b] += diff[a] * diff[b];
+                }
+            }
+        }
+
+        // Starting from the biggest diagonal entry's axis converges quickly and never starts out orthogonal to the
+        // answer when there's only one channel that varies
+        int biggest = 0;
+        for(int c = 1; c < N; c++) {
+            if(covariance[c][c] > covariance[biggest][biggest]) {
+                biggest = c;
+            }
+        }
+        axis[biggest] = 1;
+
+        for(int iteration = 0; iteration < 8; iteration++) {
+            float next[4] = {};
+            for(int a = 0; a < N; a++) {
+                for(int b = 0; b < N; b++) {
+                    next[a] += covariance[a][b] * axis[b];
+                }
+            }
+
+            float length = 0;
+            for(int c = 0; c < N; c++) {
+                length = std::max(length, std::abs(next[c]));
+            }
+            if(length < 1e-6f) {
+                break;
+            }
+            for(int c = 0; c < N; c++) {
+                axis[c] = next[c] / length;
+            }
+        }
+    }
+
+    /*!
+     * \brief Puts the endpoints at the ends of the colors' projection onto the principal axis
+     */
+    template <int N>
+    static void find_endpoints(const float colors[][4], int num_colors, float start[4], float end[4]) {
+        float mean[4];
+        float axis[4];
+        find_principal_axis<N>(colors, num_colors, mean, axis);
+
+        float min_t = 0;
+        float max_t = 0;
+        for(int i = 0; i < num_colors; i++) {
+            float t = 0;
+            for(int c = 0; c < N; c++) {
+                t += (colors[i][c] - mean[c]) * axis[c];
+            }
+            min_t = std::min(min_t, t);
+            max_t = std::max(max_t, t);
+        }
+
+        float axis_length_squared = 0;
+        for(int c = 0; c < N; c++) {
+            axis_length_squared += axis[c] * axis[c];
+        }
+        if(axis_length_squared > 0) {
+            min_t /= axis_length_squared;
+            max_t /= axis_length_squared;
+        }
+
+        for(int c = 0; c < 4; c++) {
+            start[c] = c < N ? std::min(std::max(mean[c] + axis[c] * min_t, 0.0f), 255.0f) : 255.0f;
+            end[c] = c < N ? std::min(std::max(mean[c] + axis[c] * max_t, 0.0f), 255.0f) : 255.0f;
+        }
+    }
+
+    /*!
+     * \brief Finds the endpoints that minimize the squared error for the given weights, where each color is
+     * approximated as weight * end + (1 - weight) * start
+     *
+     * \return False if the weights can't tell the endpoints apart, in which case the endpoints aren't touched
+     */
+    template <int N>
+    static bool refine_endpoints(const float colors[][4], const float weights[], int num_colors, float start[4], float end[4]) {
+        float aa = 0, ab = 0, bb = 0;
+        float ax[4] = {}, bx[4] = {};
+        for(int i = 0; i < num_colors; i++) {
+            float b = weights[i];
+            float a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for(int c = 0; c < N; c++) {
+                ax[c] += a * colors[i][c];
+                bx[c] += b * colors[i][c];
+            }
+        }
+
+        float determinant = aa * bb - ab * ab;
+        if(std::abs(determinant) < 1e-6f) {
+            return false;
+        }
+
+        for(int c = 0; c < N; c++) {
+            start[c] = std::min(std::max((bb * ax[c] - ab * bx[c]) / determinant, 0.0f), 255.0f);
+            end[c] = std::min(std::max((aa * bx[c] - ab * ax[c]) / determinant, 0.0f), 255.0f);
+        }
+        return true;
+    }
+
+    static void write_bits(std::uint8_t *dst, int &bit, std::uint32_t value, int num_bits) {
+        for(int i = 0; i < num_bits; i++, bit++) {
+            if(value & (1u << i)) {
+                dst[bit >> 3] |= (std::uint8_t) (1u << (bit & 7));
+            }
+        }
+    }
+
+    static std::uint32_t read_bits(const std::uint8_t *src, int &bit, int num_bits) {
+        std::uint32_t value = 0;
+        for(int i = 0; i < num_bits; i++, bit++) {
+            value |= (std::uint32_t) ((src[bit >> 3] >> (bit & 7)) & 1) << i;
+        }
+        return value;
+    }
+
+    /*
+     * BC1
+     */
+
+    static std::uint16_t to_565(const float color[4]) {
+        auto r = (std::uint16_t) std::lround(color[0] * 31.0f / 255.0f);
+        auto g = (std::uint16_t) std::lround(color[1] * 63.0f / 255.0f);
+        auto b = (std::uint16_t) std::lround(color[2] * 31.0f / 255.0f);
+        return (std::uint16_t) ((r << 11) | (g << 5) | b);
+    }
+
+    static void from_565(std::uint16_t packed, int color[4]) {
+        int r = (packed >> 11) & 31;
+        int g = (packed >> 5) & 63;
+        int b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+        color[3] = 255;
+    }
+
+    static void get_bc1_palette(std::uint16_t color_0, std::uint16_t color_1, bool four_colors, int palette[4][4]) {
+        from_565(color_0, palette[0]);
+        from_565(color_1, palette[1]);
+        for(int c = 0; c < 3; c++) {
+            if(four_colors) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            } else {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+        }
+        palette[2][3] = 255;
+        palette[3][3] = four_colors ? 255 : 0;
+    }
+
+    static int color_distance(const int a[4], const std::uint8_t *b) {
+        int dr = a[0] - b[0];
+        int dg = a[1] - b[1];
+        int db = a[2] - b[2];
+        return dr * dr + dg * dg + db * db;
+    }
+
+    /*!
+     * \brief Picks the closest palette entry for every texel and packs the endpoints and indices into dst
+     *
+     * \return The total squared error of the block
+     */
+    static int write_bc1_block(const std::uint8_t texels[64], std::uint16_t color_0, std::uint16_t color_1, bool four_colors,
+                               std::uint8_t *dst, std::uint8_t indices[16]) {
+        int palette[4][4];
+        get_bc1_palette(color_0, color_1, four_colors, palette);
+
+        int total_error = 0;
+        std::uint32_t packed_indices = 0;
+        for(int i = 0; i < 16; i++) {
+            const std::uint8_t *texel = texels + i * 4;
+            int best_index = 0;
+            int best_error = 1 << 30;
+
+            if(!four_colors && texel[3] < 128) {
+                best_index = 3;
+                best_error = 0;
+            } else {
+                int num_choices = four_colors ? 4 : 3;
+                for(int p = 0; p < num_choices; p++) {
+                    int error = color_distance(palette[p], texel);
+                    if(error < best_error) {
+                        best_error = error;
+                        best_index = p;
+                    }
+                }
+            }
+
+            total_error += best_error;
+            indices[i] = (std::uint8_t) best_index;
+            packed_indices |= (std::uint32_t) best_index << (i * 2);
+        }
+
+        dst[0] = (std::uint8_t) (color_0 & 0xFF);
+        dst[1] = (std::uint8_t) (color_0 >> 8);
+        dst[2] = (std::uint8_t) (color_1 & 0xFF);
+        dst[3] = (std::uint8_t) (color_1 >> 8);
+        std::memcpy(dst + 4, &packed_indices, 4);
+
+        return total_error;
+    }
+
+    /*!
+     * \brief Encodes the color part of a BC1 or BC3 block
+     *
+     * \param allow_transparency True for BC1, where blocks with transparent texels can switch to the three color mode.
+     * False for BC3, which always uses four colors
+     */
+    static void encode_bc1_color(const std::uint8_t texels[64], bool allow_transparency, std::uint8_t *dst) {
+        float colors[16][4];
+        int num_colors = 0;
+        bool has_transparency = false;
+        for(int i = 0; i < 16; i++) {
+            if(allow_transparency && texels[i * 4 + 3] < 128) {
+                has_transparency = true;
+                continue;
+            }
+            for(int c = 0; c < 4; c++) {
+                colors[num_colors][c] = texels[i * 4 + c];
+            }
+            num_colors++;
+        }
+
+        if(num_colors == 0) {
+            // All transparent. Three color mode with every index pointing at transparent black
+            const std::uint8_t transparent_block[8] = {0, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0xFF};
+            std::memcpy(dst, transparent_block, 8);
+            return;
+        }
+
+        float start[4];
+        float end[4];
+        find_endpoints<3>(colors, num_colors, start, end);
+
+        // Four color mode needs color_0 > color_1, three color mode needs color_0 <= color_1
+        std::uint16_t color_0 = to_565(end);
+        std::uint16_t color_1 = to_565(start);
+        bool four_colors = !has_transparency;
+        if(four_colors ? color_0 < color_1 : color_0 > color_1) {
+            std::swap(color_0, color_1);
+        }
+
+        std::uint8_t indices[16];
+        int error = write_bc1_block(texels, color_0, color_1, four_colors, dst, indices);
+
+        if(!four_colors || color_0 == color_1) {
+            return;
+        }
+
+        // One round of least squares usually gets the endpoints a good bit closer than the ends of the axis
+        const float index_weights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+        float weights[16];
+        for(int i = 0; i < 16; i++) {
+            weights[i] = index_weights[indices[i]];
+        }
+
+        float refined_start[4] = {};
+        float refined_end[4] = {};
+        if(!refine_endpoints<3>(colors, weights, 16, refined_start, refined_end)) {
+            return;
+        }
+
+        // Weight 0 is color_0, so refined_start is color_0 here
+        std::uint16_t refined_0 = to_565(refined_start);
+        std::uint16_t refined_1 = to_565(refined_end);
+        if(refined_0 < refined_1) {
+            std::swap(refined_0, refined_1);
+        }
+        if(refined_0 == refined_1) {
+            return;
+        }
+
+        std::uint8_t refined_block[8];
+        if(write_bc1_block(texels, refined_0, refined_1, true, refined_block, indices) < error) {
+            std::memcpy(dst, refined_block, 8);
+        }
+    }
+
+    /*
+     * BC3
+     */
+
+    static void get_bc3_alpha_palette(int alpha_0, int alpha_1, int palette[8]) {
+        palette[0] = alpha_0;
+        palette[1] = alpha_1;
+        if(alpha_0 > alpha_1) {
+            for(int i = 1; i < 7; i++) {
+                palette[i + 1] = ((7 - i) * alpha_0 + i * alpha_1) / 7;
+            }
+        } else {
+            for(int i = 1; i < 5; i++) {
+                palette[i + 1] = ((5 - i) * alpha_0 + i * alpha_1) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    static int write_bc3_alpha_block(const std::uint8_t texels[64], int alpha_0, int alpha_1, std::uint8_t *dst) {
+        int palette[8];
+        get_bc3_alpha_palette(alpha_0, alpha_1, palette);
+
+        std::memset(dst, 0, 8);
+        dst[0] = (std::uint8_t) alpha_0;
+        dst[1] = (std::uint8_t) alpha_1;
+
+        int total_error = 0;
+        int bit = 16;
+        for(int i = 0; i < 16; i++) {
+            int alpha = texels[i * 4 + 3];
+            int best_index = 0;
+            int best_error = 1 << 30;
+            for(int p = 0; p < 8; p++) {
+                int error = (palette[p] - alpha) * (palette[p] - alpha);
+                if(error < best_error) {
+                    best_error = error;
+                    best_index = p;
+                }
+            }
+
+            total_error += best_error;
+            write_bits(dst, bit, (std::uint32_t) best_index, 3);
+        }
+
+        return total_error;
+    }
+
+    static void encode_bc3_alpha(const std::uint8_t texels[64], std::uint8_t *dst) {
+        int min_alpha = 255, max_alpha = 0;
+        int min_inner_alpha = 255, max_inner_alpha = 0;
+        for(int i = 0; i < 16; i++) {
+            int alpha = texels[i * 4 + 3];
+            min_alpha = std::min(min_alpha, alpha);
+            max_alpha = std::max(max_alpha, alpha);
+            if(alpha != 0 && alpha != 255) {
+                min_inner_alpha = std::min(min_inner_alpha, alpha);
+                max_inner_alpha = std::max(max_inner_alpha, alpha);
+            }
+        }
+
+        // Eight interpolated values across the whole range...
+        int error = write_bc3_alpha_block(texels, max_alpha, min_alpha, dst);
+        if(min_alpha == max_alpha || min_inner_alpha > max_inner_alpha) {
+            return;
+        }
+
+        // ...or six across just the values that aren't 0 or 255, with 0 and 255 available exactly
+        std::uint8_t six_value_block[8];
+        if(write_bc3_alpha_block(texels, min_inner_alpha, max_inner_alpha, six_value_block) < error) {
+            std::memcpy(dst, six_value_block, 8);
+        }
+    }
+
+    /*
+     * BC7 mode 6: one subset, RGBA endpoints with 7 bits per channel plus a shared low bit per endpoint, and 4 bit
+     * indices
+     */
+
+    static const int bc7_weights_4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    /*!
+     * \brief Quantizes an endpoint to 7 bits per channel, picking whichever shared low bit gets closer
+     */
+    static void quantize_bc7_endpoint(const float endpoint[4], int quantized[4], int &p_bit) {
+        int best_error = 1 << 30;
+        for(int p = 0; p < 2; p++) {
+            int candidate[4];
+            int error = 0;
+            for(int c = 0; c < 4; c++) {
+                candidate[c] = std::min(std::max((int) std::lround((endpoint[c] - p) / 2.0f), 0), 127);
+                int diff = ((candidate[c] << 1) | p) - (int) std::lround(endpoint[c]);
+
+                // Alpha counts for more, so fully opaque stays fully opaque instead of becoming 254
+                error += diff * diff * (c == 3 ? 16 : 1);
+            }
+
+            if(error < best_error) {
+                best_error = error;
+                p_bit = p;
+                std::memcpy(quantized, candidate, sizeof(candidate));
+            }
+        }
+    }
+
+    static int write_bc7_mode_6_block(const std::uint8_t texels[64], const int quantized_0[4], int p_0,
+                                      const int quantized_1[4], int p_1, std::uint8_t *dst, std::uint8_t indices[16]) {
+        int endpoints[2][4];
+        for(int c = 0; c < 4; c++) {
+            endpoints[0][c] = (quantized_0[c] << 1) | p_0;
+            endpoints[1][c] = (quantized_1[c] << 1) | p_1;
+        }
+
+        int palette[16][4];
+        for(int i = 0; i < 16; i++) {
+            for(int c = 0; c < 4; c++) {
+                palette[i][c] = ((64 - bc7_weights_4[i]) * endpoints[0][c] + bc7_weights_4[i] * endpoints[1][c] + 32) >> 6;
+            }
+        }
+
+        int total_error = 0;
+        for(int i = 0; i < 16; i++) {
+            const std::uint8_t *texel = texels + i * 4;
+            int best_index = 0;
+            int best_error = 1 << 30;
+            // Nobody sees the color of a fully transparent texel, so only its alpha has to match
+            int first_channel = texel[3] == 0 ? 3 : 0;
+            for(int p = 0; p < 16; p++) {
+                int error = 0;
+                for(int c = first_channel; c < 4; c++) {
+                    int diff = palette[p][c] - texel[c];
+                    error += diff * diff;
+                }
+                if(error < best_error) {
+                    best_error = error;
+                    best_index = p;
+                }
+            }
+
+            total_error += best_error;
+            indices[i] = (std::uint8_t) best_index;
+        }
+
+        // The top bit of the first index isn't stored, so it has to be zero. Swapping the endpoints flips every index
+        const int *first = quantized_0;
+        const int *second = quantized_1;
+        std::uint8_t stored_indices[16];
+        std::memcpy(stored_indices, indices, 16);
+        if(indices[0] >= 8) {
+            std::swap(first, second);
+            std::swap(p_0, p_1);
+            for(auto& index : stored_indices) {
+                index = (std::uint8_t) (15 - index);
+            }
+        }
+
+        std::memset(dst, 0, 16);
+        int bit = 0;
+        write_bits(dst, bit, 1u << 6, 7);
+        for(int c = 0; c < 4; c++) {
+            write_bits(dst, bit, (std::uint32_t) first[c], 7);
+            write_bits(dst, bit, (std::uint32_t) second[c], 7);
+        }
+        write_bits(dst, bit, (std::uint32_t) p_0, 1);
+        write_bits(dst, bit, (std::uint32_t) p_1, 1);
+        write_bits(dst, bit, stored_indices[0], 3);
+        for(int i = 1; i < 16; i++) {
+            write_bits(dst, bit, stored_indices[i], 4);
+        }
+
+        return total_error;
+    }
+
+    /*!
+     * \return The error of the block written to dst
+     */
+    static int encode_bc7_mode_6(const std::uint8_t texels[64], std::uint8_t *dst) {
+        float colors[16][4];
+        bool alpha_is_constant = true;
+        for(int i = 0; i < 16; i++) {
+            for(int c = 0; c < 4; c++) {
+                colors[i][c] = texels[i * 4 + c];
+            }
+            alpha_is_constant &= texels[i * 4 + 3] == texels[3];
+        }
+
+        // Most blocks are opaque. Leaving alpha out of the fit keeps it from pulling the endpoints off the colors
+        float start[4];
+        float end[4];
+        if(alpha_is_constant) {
+            find_endpoints<3>(colors, 16, start, end);
+            start[3] = texels[3];
+            end[3] = texels[3];
+        } else {
+            find_endpoints<4>(colors, 16, start, end);
+        }
+
+        int quantized_0[4], quantized_1[4];
+        int p_0, p_1;
+        quantize_bc7_endpoint(start, quantized_0, p_0);
+        quantize_bc7_endpoint(end, quantized_1, p_1);
+
+        std::uint8_t indices[16];
+        int error = write_bc7_mode_6_block(texels, quantized_0, p_0, quantized_1, p_1, dst, indices);
+
+        float weights[16];
+        for(int i = 0; i < 16; i++) {
+            weights[i] = bc7_weights_4[indices[i]] / 64.0f;
+        }
+
+        bool refined = alpha_is_constant ? refine_endpoints<3>(colors, weights, 16, start, end)
+                                         : refine_endpoints<4>(colors, weights, 16, start, end);
+        if(!refined) {
+            return error;
+        }
+
+        quantize_bc7_endpoint(start, quantized_0, p_0);
+        quantize_bc7_endpoint(end, quantized_1, p_1);
+
+        std::uint8_t refined_block[16];
+        int refined_error = write_bc7_mode_6_block(texels, quantized_0, p_0, quantized_1, p_1, refined_block, indices);
+        if(refined_error < error) {
+            std::memcpy(dst, refined_block, 16);
+            error = refined_error;
+        }
+
+        return error;
+    }
+
+    /*
+     * BC7 mode 5: one subset, 7 bit RGB endpoints with 2 bit indices, and separate 8 bit alpha endpoints with their own
+     * 2 bit indices. Color and alpha don't have to share indices, so blocks with holes in them keep their colors
+     */
+
+    static const int bc7_weights_2[4] = {0, 21, 43, 64};
+
+    static int expand_7_bits(int value) {
+        return (value << 1) | (value >> 6);
+    }
+
+    static int write_bc7_mode_5_block(const std::uint8_t texels[64], const int color_0[3], const int color_1[3],
+                                      int alpha_0, int alpha_1, std::uint8_t *dst, std::uint8_t color_indices[16]) {
+        int color_palette[4][3];
+        int alpha_palette[4];
+        for(int i = 0; i < 4; i++) {
+            for(int c = 0; c < 3; c++) {
+                color_palette[i][c] = ((64 - bc7_weights_2[i]) * expand_7_bits(color_0[c]) + bc7_weights_2[i] * expand_7_bits(color_1[c]) + 32) >> 6;
+            }
+            alpha_palette[i] = ((64 - bc7_weights_2[i]) * alpha_0 + bc7_weights_2[i] * alpha_1 + 32) >> 6;
+        }
+
+        int total_error = 0;
+        std::uint8_t alpha_indices[16];
+        for(int i = 0; i < 16; i++) {
+            const std::uint8_t *texel = texels + i * 4;
+
+            int best_alpha_error = 1 << 30;
+            for(int p = 0; p < 4; p++) {
+                int diff = alpha_palette[p] - texel[3];
+                if(diff * diff < best_alpha_error) {
+                    best_alpha_error = diff * diff;
+                    alpha_indices[i] = (std::uint8_t) p;
+                }
+            }
+            total_error += best_alpha_error;
+
+            int best_color_error = 1 << 30;
+            for(int p = 0; p < 4; p++) {
+                int error = 0;
+                for(int c = 0; c < 3; c++) {
+                    int diff = color_palette[p][c] - texel[c];
+                    error += diff * diff;
+                }
+                if(error < best_color_error) {
+                    best_color_error = error;
+                    color_indices[i] = (std::uint8_t) p;
+                }
+            }
+
+            // Same as mode 6, nobody sees the color of a fully transparent texel
+            if(texel[3] != 0) {
+                total_error += best_color_error;
+            }
+        }
+
+        // Both sets of indices have an anchor whose top bit isn't stored, and each gets fixed up on its own
+        const int *first_color = color_0;
+        const int *second_color = color_1;
+        std::uint8_t stored_color_indices[16];
+        std::memcpy(stored_color_indices, color_indices, 16);
+        if(color_indices[0] >= 2) {
+            std::swap(first_color, second_color);
+            for(auto& index : stored_color_indices) {
+                index = (std::uint8_t) (3 - index);
+            }
+        }
+
+        if(alpha_indices[0] >= 2) {
+            std::swap(alpha_0, alpha_1);
+            for(auto& index : alpha_indices) {
+                index = (std::uint8_t) (3 - index);
+            }
+        }
+
+        std::memset(dst, 0, 16);
+        int bit = 0;
+        write_bits(dst, bit, 1u << 5, 6);
+        write_bits(dst, bit, 0, 2);     // No channel rotation
+        for(int c = 0; c < 3; c++) {
+            write_bits(dst, bit, (std::uint32_t) first_color[c], 7);
+            write_bits(dst, bit, (std::uint32_t) second_color[c], 7);
+        }
+        write_bits(dst, bit, (std::uint32_t) alpha_0, 8);
+        write_bits(dst, bit, (std::uint32_t) alpha_1, 8);
+        for(int i = 0; i < 16; i++) {
+            write_bits(dst, bit, stored_color_indices[i], i == 0 ? 1 : 2);
+        }
+        for(int i = 0; i < 16; i++) {
+            write_bits(dst, bit, alpha_indices[i], i == 0 ? 1 : 2);
+        }
+
+        return total_error;
+    }
+
+    static void quantize_to_7_bits(const float color[4], int quantized[3]) {
+        for(int c = 0; c < 3; c++) {
+            quantized[c] = std::min(std::max((int) std::lround(color[c] / 255.0f * 127.0f), 0), 127);
+        }
+    }
+
+    /*!
+     * \return The error of the block written to dst
+     */
+    static int encode_bc7_mode_5(const std::uint8_t texels[64], std::uint8_t *dst) {
+        // Only the colors that can be seen get a say in where the color endpoints go
+        float colors[16][4];
+        int num_colors = 0;
+        int min_alpha = 255;
+        int max_alpha = 0;
+        for(int i = 0; i < 16; i++) {
+            int alpha = texels[i * 4 + 3];
+            min_alpha = std::min(min_alpha, alpha);
+            max_alpha = std::max(max_alpha, alpha);
+            if(alpha != 0) {
+                for(int c = 0; c < 4; c++) {
+                    colors[num_colors][c] = texels[i * 4 + c];
+                }
+                num_colors++;
+            }
+        }
+        if(num_colors == 0) {
+            for(int i = 0; i < 16; i++) {
+                for(int c = 0; c < 4; c++) {
+                    colors[i][c] = texels[i * 4 + c];
+                }
+            }
+            num_colors = 16;
+        }
+
+        float start[4];
+        float end[4];
+        find_endpoints<3>(colors, num_colors, start, end);
+
+        int color_0[3], color_1[3];
+        quantize_to_7_bits(start, color_0);
+        quantize_to_7_bits(end, color_1);
+
+        std::uint8_t color_indices[16];
+        int error = write_bc7_mode_5_block(texels, color_0, color_1, min_alpha, max_alpha, dst, color_indices);
+
+        float weights[16];
+        int num_weights = 0;
+        for(int i = 0; i < 16; i++) {
+            if(texels[i * 4 + 3] != 0 || num_colors == 16) {
+                weights[num_weights++] = bc7_weights_2[color_indices[i]] / 64.0f;
+            }
+        }
+        if(!refine_endpoints<3>(colors, weights, num_colors, start, end)) {
+            return error;
+        }
+
+        quantize_to_7_bits(start, color_0);
+        quantize_to_7_bits(end, color_1);
+
+        std::uint8_t refined_block[16];
+        int refined_error = write_bc7_mode_5_block(texels, color_0, color_1, min_alpha, max_alpha, refined_block, color_indices);
+        if(refined_error < error) {
+            std::memcpy(dst, refined_block, 16);
+            error = refined_error;
+        }
+
+        return error;
+    }
+
+    /*!
+     * \brief Opaque blocks always use mode 6. Blocks with alpha in them try mode 5 as well and keep whichever is
+     * closer
+     */
+    static void encode_bc7(const std::uint8_t texels[64], std::uint8_t *dst) {
+        int mode_6_error = encode_bc7_mode_6(texels, dst);
+
+        bool is_opaque = true;
+        for(int i = 0; i < 16; i++) {
+            is_opaque &= texels[i * 4 + 3] == 255;
+        }
+        if(is_opaque || mode_6_error == 0) {
+            return;
+        }
+
+        std::uint8_t mode_5_block[16];
+        if(encode_bc7_mode_5(texels, mode_5_block) < mode_6_error) {
+            std::memcpy(dst, mode_5_block, 16);
+        }
+    }
+
+    void encode_block(const std::uint8_t texels[64], texture_compression compression, std::uint8_t *dst) {
+        switch(compression) {
+            case texture_compression::bc1:
+                encode_bc1_color(texels, true, dst);
+                break;
+            case texture_compression::bc3:
+                encode_bc3_alpha(texels, dst);
+                encode_bc1_color(texels, false, dst + 8);
+                break;
+            case texture_compression::bc7:
+                encode_bc7(texels, dst);
+                break;
+            default:
+                break;
+        }
+    }
+
+    /*
+     * Decoders
+     */
+
+    static void decode_bc1_color(const std::uint8_t *src, bool allow_transparency, std::uint8_t texels[64]) {
+        std::uint16_t color_0 = (std::uint16_t) (src[0] | (src[1] << 8));
+        std::uint16_t color_1 = (std::uint16_t) (src[2] | (src[3] << 8));
+
+        int palette[4][4];
+        get_bc1_palette(color_0, color_1, !allow_transparency || color_0 > color_1, palette);
+
+        std::uint32_t indices;
+        std::memcpy(&indices, src + 4, 4);
+        for(int i = 0; i < 16; i++) {
+            const int *color = palette[(indices >> (i * 2)) & 3];
+            for(int c = 0; c < 4; c++) {
+                texels[i * 4 + c] = (std::uint8_t) color[c];
+            }
+        }
+    }
+
+    void decode_block(const std::uint8_t *src, texture_compression compression, std::uint8_t texels[64]) {
+        switch(compression) {
+            case texture_compression::bc1:
+                decode_bc1_color(src, true, texels);
+                break;
+
+            case texture_compression::bc3: {
+                decode_bc1_color(src + 8, false, texels);
+
+                int palette[8];
+                get_bc3_alpha_palette(src[0], src[1], palette);
+                int bit = 16;
+                for(int i = 0; i < 16; i++) {
+                    texels[i * 4 + 3] = (std::uint8_t) palette[read_bits(src, bit, 3)];
+                }
+                break;
+            }
+
+            case texture_compression::bc7: {
+                int bit = 0;
+                int mode = 0;
+                while(mode < 8 && read_bits(src, bit, 1) == 0) {
+                    mode++;
+                }
+
+                if(mode == 5) {
+                    int rotation = (int) read_bits(src, bit, 2);
+                    int colors[2][3];
+                    for(int c = 0; c < 3; c++) {
+                        colors[0][c] = expand_7_bits((int) read_bits(src, bit, 7));
+                        colors[1][c] = expand_7_bits((int) read_bits(src, bit, 7));
+                    }
+                    int alpha_0 = (int) read_bits(src, bit, 8);
+                    int alpha_1 = (int) read_bits(src, bit, 8);
+
+                    int color_weights[16];
+                    for(int i = 0; i < 16; i++) {
+                        color_weights[i] = bc7_weights_2[read_bits(src, bit, i == 0 ? 1 : 2)];
+                    }
+                    for(int i = 0; i < 16; i++) {
+                        int alpha_weight = bc7_weights_2[read_bits(src, bit, i == 0 ? 1 : 2)];
+                        for(int c = 0; c < 3; c++) {
+                            texels[i * 4 + c] = (std::uint8_t) (((64 - color_weights[i]) * colors[0][c] + color_weights[i] * colors[1][c] + 32) >> 6);
+                        }
+                        texels[i * 4 + 3] = (std::uint8_t) (((64 - alpha_weight) * alpha_0 + alpha_weight * alpha_1 + 32) >> 6);
+
+                        // Rotation swaps alpha with one of the color channels after decoding
+                        if(rotation != 0) {
+                            std::swap(texels[i * 4 + 3], texels[i * 4 + rotation - 1]);
+                        }
+                    }
+                    break;
+                }
+
+                if(mode != 6) {
+                    // Real decoders handle the other six modes, but nothing here makes them
+                    std::memset(texels, 0, 64);
+                    return;
+                }
+
+                int endpoints[2][4];
+                for(int c = 0; c < 4; c++) {
+                    endpoints[0][c] = (int) read_bits(src, bit, 7) << 1;
+                    endpoints[1][c] = (int) read_bits(src, bit, 7) << 1;
+                }
+                int p_0 = (int) read_bits(src, bit, 1);
+                int p_1 = (int) read_bits(src, bit, 1);
+                for(int c = 0; c < 4; c++) {
+                    endpoints[0][c] |= p_0;
+                    endpoints[1][c] |= p_1;
+                }
+
+                for(int i = 0; i < 16; i++) {
+                    int weight = bc7_weights_4[read_bits(src, bit, i == 0 ? 3 : 4)];
+                    for(int c = 0; c < 4; c++) {
+                        texels[i * 4 + c] = (std::uint8_t) (((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+                    }
+                }
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    void compress_blocks(const rgba8_image &image, texture_compression compression, const atlas_rect &blocks,
+                         std::uint8_t *dst, thread_pool &workers) {
+        std::size_t bytes_per_block = get_bytes_per_block(compression);
+
+        // A 4096 texel wide atlas has 1024 blocks per row, so a few rows per task is plenty
+        std::size_t rows_per_task = std::max<std::size_t>(1, 256 / (std::size_t) std::max(blocks.width, 1));
+        workers.parallel_for(0, (std::size_t) blocks.height, rows_per_task, [&](std::size_t first_row, std::size_t end_row) {
+            std::uint8_t texels[64];
+            for(std::size_t row = first_row; row < end_row; row++) {
+                int block_y = blocks.y + (int) row;
+                for(int column = 0; column < blocks.width; column++) {
+                    int block_x = blocks.x + column;
+
+                    // Blocks that hang off the edge of a small mip level repeat the edge texels
+                    for(int y = 0; y < 4; y++) {
+                        int image_y = std::min(block_y * 4 + y, image.size.y - 1);
+                        for(int x = 0; x < 4; x++) {
+                            int image_x = std::min(block_x * 4 + x, image.size.x - 1);
+                            std::memcpy(texels + (y * 4 + x) * 4, image.pixels.data() + ((std::size_t) image_y * image.size.x + image_x) * 4, 4);
+                        }
+                    }
+
+                    encode_block(texels, compression, dst + (row * blocks.width + column) * bytes_per_block);
+                }
+            }
+        });
+    }
+
+    std::vector<std::uint8_t> compress_image(const rgba8_image &image, texture_compression compression, thread_pool &workers) {
+        std::vector<std::uint8_t> compressed(get_compressed_size(image.size, compression));
+        atlas_rect all_blocks = {0, 0, (image.size.x + 3) / 4, (image.size.y + 3) / 4};
+        compress_blocks(image, compression, all_blocks, compressed.data(), workers);
+        return compressed;
+    }
+}
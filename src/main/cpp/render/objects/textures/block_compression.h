@@ -0,0 +1,81 @@
+/*!
+ * \brief CPU encoders for the BC1, BC3, and BC7 block compressed texture formats
+ *
+ * Every format here splits the image into 4x4 blocks and stores each block in a fixed number of bytes: 8 for BC1, 16
+ * for BC3 and BC7. That's a quarter (or an eighth, for BC1) of what RGBA8 needs, and the GPU decompresses blocks as it
+ * samples them so the savings carry over to texture bandwidth
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_BLOCK_COMPRESSION_H
+#define RENDERER_BLOCK_COMPRESSION_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include "mipmap_generator.h"
+
+namespace nova {
+    enum class texture_compression {
+        none,
+        bc1,    //!< RGB with one bit of alpha. 8 bytes per block. Good for opaque and cutout textures
+        bc3,    //!< BC1's color plus a separate 8-bit alpha channel. 16 bytes per block
+        bc7,    //!< High quality RGBA. 16 bytes per block. Only modes 5 and 6 are used
+    };
+
+    /*!
+     * \brief Reads a compression format from a config string like "bc7". Anything unknown means no compression
+     */
+    texture_compression texture_compression_from_string(const std::string &name);
+
+    /*!
+     * \brief The OpenGL internal format for a compression format, or GL_RGBA8 for none
+     */
+    GLenum get_gl_internal_format(texture_compression compression);
+
+    std::size_t get_bytes_per_block(texture_compression compression);
+
+    /*!
+     * \brief How many bytes an image of the given size takes up once it's compressed. Partial blocks at the right and
+     * bottom edges still take up a whole block
+     */
+    std::size_t get_compressed_size(glm::ivec2 size, texture_compression compression);
+
+    /*!
+     * \brief Compresses a single 4x4 block
+     *
+     * \param texels The block's texels as RGBA8, one row after another
+     * \param compression The format to compress to. Must not be none
+     * \param dst Where the compressed block goes. Must have room for get_bytes_per_block bytes
+     */
+    void encode_block(const std::uint8_t texels[64], texture_compression compression, std::uint8_t *dst);
+
+    /*!
+     * \brief Decompresses a single 4x4 block back to RGBA8. Only needed to check the encoders
+     *
+     * The BC7 decoder only knows modes 5 and 6, since those are the only modes the encoder makes
+     */
+    void decode_block(const std::uint8_t *src, texture_compression compression, std::uint8_t texels[64]);
+
+    /*!
+     * \brief Compresses some of the blocks of an image
+     *
+     * \param image The image to compress
+     * \param compression The format to compress to
+     * \param blocks The blocks to compress, in units of blocks rather than texels
+     * \param dst Where the compressed blocks go, one row of blocks after another
+     * \param workers The threads to split the rows of blocks across
+     */
+    void compress_blocks(const rgba8_image &image, texture_compression compression, const atlas_rect &blocks,
+                         std::uint8_t *dst, thread_pool &workers);
+
+    /*!
+     * \brief Compresses a whole image
+     */
+    std::vector<std::uint8_t> compress_image(const rgba8_image &image, texture_compression compression, thread_pool &workers);
+}
+
+#endif //RENDERER_BLOCK_COMPRESSION_H
@@ -0,0 +1,209 @@
+/*!
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include "block_layer_table.h"
+
+namespace nova {
+    /*!
+     * \brief The smallest power of two that's at least value
+     */
+    static int round_up_to_power_of_two(int value) {
+        int power = 1;
+        while(power < value) {
+            power <<= 1;
+        }
+        return power;
+    }
+
+    void block_layer_table::reset(glm::ivec2 atlas_size) {
+        this->atlas_size = atlas_size;
+        sprites.clear();
+        layers_by_name.clear();
+
+        grid_size = {(atlas_size.x + GRID_CELL_SIZE - 1) / GRID_CELL_SIZE, (atlas_size.y + GRID_CELL_SIZE - 1) / GRID_CELL_SIZE};
+        grid.assign((std::size_t) grid_size.x * grid_size.y, {});
+    }
+
+    void block_layer_table::add_sprite(const std::string &name, glm::vec2 min_uv, glm::vec2 max_uv) {
+        sprite_entry sprite;
+        sprite.min_uv = min_uv;
+        sprite.max_uv = max_uv;
+
+        // Minecraft's UVs are texel edges divided by the atlas size, so rounding gets the exact texels back
+        int min_x = (int) std::lround(min_uv.x * atlas_size.x);
+        int min_y = (int) std::lround(min_uv.y * atlas_size.y);
+        int max_x = (int) std::lround(max_uv.x * atlas_size.x);
+        int max_y = (int) std::lround(max_uv.y * atlas_size.y);
+        sprite.texels = {min_x, min_y, std::max(max_x - min_x, 1), std::max(max_y - min_y, 1)};
+
+        // A sprite that's sent again keeps its layer. Its old grid cells are left alone, since find_layer checks
+        // that the UV really is inside the sprite
+        int layer;
+        auto existing_layer = layers_by_name.find(name);
+        if(existing_layer != layers_by_name.end()) {
+            layer = existing_layer->second;
+            sprites[layer] = sprite;
+        } else {
+            layer = (int) sprites.size();
+            sprites.push_back(sprite);
+            layers_by_name[name] = layer;
+        }
+
+        int first_cell_x = std::max(sprite.texels.x / GRID_CELL_SIZE, 0);
+        int first_cell_y = std::max(sprite.texels.y / GRID_CELL_SIZE, 0);
+        int last_cell_x = std::min((sprite.texels.x + sprite.texels.width - 1) / GRID_CELL_SIZE, grid_size.x - 1);
+        int last_cell_y = std::min((sprite.texels.y + sprite.texels.height - 1) / GRID_CELL_SIZE, grid_size.y - 1);
+        for(int y = first_cell_y; y <= last_cell_y; y++) {
+            for(int x = first_cell_x; x <= last_cell_x; x++) {
+                grid[y * grid_size.x + x].push_back(layer);
+            }
+        }
+    }
+
+    bool block_layer_table::empty() const {
+        return sprites.empty();
+    }
+
+    int block_layer_table::get_num_layers() const {
+        return (int) sprites.size();
+    }
+
+    glm::ivec2 block_layer_table::get_layer_size() const {
+        std::map<std::pair<int, int>, int> num_sprites_by_size;
+        for(const auto& sprite : sprites) {
+            num_sprites_by_size[{sprite.texels.width, sprite.texels.height}]++;
+        }
+
+        std::pair<int, int> most_common_size = {1, 1};
+        int most_sprites = 0;
+        for(const auto& size : num_sprites_by_size) {
+            if(size.second > most_sprites) {
+                most_common_size = size.first;
+                most_sprites = size.second;
+            }
+        }
+
+        return {round_up_to_power_of_two(most_common_size.first), round_up_to_power_of_two(most_common_size.second)};
+    }
+
+    rgba8_image block_layer_table::make_layers(const rgba8_image &atlas, std::vector<mip_tile> &tiles) const {
+        glm::ivec2 layer_size = get_layer_size();
+
+        rgba8_image layers;
+        layers.size = {layer_size.x, layer_size.y * get_num_layers()};
+        layers.pixels.resize((std::size_t) layers.size.x * layers.size.y * 4);
+
+        tiles.clear();
+        tiles.reserve(sprites.size());
+        for(std::size_t layer = 0; layer < sprites.size(); layer++) {
+            const atlas_rect &texels = sprites[layer].texels;
+            std::uint8_t *layer_pixels = layers.pixels.data() + layer * layer_size.x * layer_size.y * 4;
+
+            // Nearest neighbour, which is a straight copy for all the sprites that are already the right size
+            for(int y = 0; y < layer_size.y; y++) {
+                int atlas_y = std::min(texels.y + y * texels.height / layer_size.y, atlas.size.y - 1);
+                for(int x = 0; x < layer_size.x; x++) {
+                    int atlas_x = std::min(texels.x + x * texels.width / layer_size.x, atlas.size.x - 1);
+                    std::memcpy(layer_pixels + ((std::size_t) y * layer_size.x + x) * 4,
+                                atlas.pixels.data() + ((std::size_t) atlas_y * atlas.size.x + atlas_x) * 4, 4);
+                }
+            }
+
+            atlas_rect layer_rect = {0, (int) layer * layer_size.y, layer_size.x, layer_size.y};
+            tiles.push_back({layer_rect, is_cutout(layers.pixels.data(), layers.size.x, layer_rect)});
+        }
+
+        return layers;
+    }
+
+    int block_layer_table::get_layer(const std::string &name) const {
+        auto layer = layers_by_name.find(name);
+        return layer == layers_by_name.end() ? -1 : layer->second;
+    }
+
+    int block_layer_table::find_layer(glm::vec2 atlas_uv) const {
+        int cell_x = (int) std::floor(atlas_uv.x * atlas_size.x) / GRID_CELL_SIZE;
+        int cell_y = (int) std::floor(atlas_uv.y * atlas_size.y) / GRID_CELL_SIZE;
+        if(cell_x < 0 || cell_y < 0 || cell_x >= grid_size.x || cell_y >= grid_size.y) {
+            return -1;
+        }
+
+        for(int layer : grid[cell_y * grid_size.x + cell_x]) {
+            const auto& sprite = sprites[layer];
+            if(atlas_uv.x >= sprite.min_uv.x && atlas_uv.x < sprite.max_uv.x &&
+               atlas_uv.y >= sprite.min_uv.y && atlas_uv.y < sprite.max_uv.y) {
+                return layer;
+            }
+        }
+
+        return -1;
+    }
+
+    bool block_layer_table::remap_vertices(mesh_definition &definition) const {
+        const std::size_t old_stride = 13;
+        const std::size_t new_stride = 14;
+        const std::size_t uv_offset = 4;
+
+        if(definition.vertex_format != format::POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT) {
+            return false;
+        }
+
+        std::size_t num_vertices = definition.vertex_data.size() / old_stride;
+        // UVs are floats, but the vertex data is ints, so the bits get copied across
+        auto get_uv = [&](std::size_t vertex) {
+            float uv[2];
+            std::memcpy(uv, &definition.vertex_data[vertex * old_stride + uv_offset], sizeof(uv));
+            return glm::vec2(uv[0], uv[1]);
+        };
+
+        std::vector<int> vertex_layers(num_vertices, -1);
+        for(std::size_t i = 0; i + 2 < definition.indices.size(); i += 3) {
+            glm::vec2 center = {0, 0};
+            for(std::size_t corner = 0; corner < 3; corner++) {
+                auto vertex = (std::size_t) definition.indices[i + corner];
+                if(vertex >= num_vertices) {
+                    return false;
+                }
+                center += get_uv(vertex) / 3.0f;
+            }
+
+            int layer = find_layer(center);
+            if(layer < 0) {
+                return false;
+            }
+
+            for(std::size_t corner = 0; corner < 3; corner++) {
+                int &vertex_layer = vertex_layers[definition.indices[i + corner]];
+                if(vertex_layer >= 0 && vertex_layer != layer) {
+                    // Two triangles with different sprites share this vertex, so there's no one layer it can have
+                    return false;
+                }
+                vertex_layer = layer;
+            }
+        }
+
+        std::vector<int> new_vertex_data(num_vertices * new_stride);
+        for(std::size_t vertex = 0; vertex < num_vertices; vertex++) {
+            int *new_vertex = &new_vertex_data[vertex * new_stride];
+            std::copy_n(&definition.vertex_data[vertex * old_stride], old_stride, new_vertex);
+
+            int layer = std::max(vertex_layers[vertex], 0);
+            new_vertex[old_stride] = layer;
+
+            const auto& sprite = sprites[layer];
+            glm::vec2 layer_uv = (get_uv(vertex) - sprite.min_uv) / (sprite.max_uv - sprite.min_uv);
+            float uv[2] = {layer_uv.x, layer_uv.y};
+            std::memcpy(&new_vertex[uv_offset], uv, sizeof(uv));
+        }
+
+        definition.vertex_data = std::move(new_vertex_data);
+        definition.vertex_format = format::POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT_LAYER;
+        return true;
+    }
+}
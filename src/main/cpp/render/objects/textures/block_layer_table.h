@@ -0,0 +1,110 @@
+/*!
+ * \brief Splits Minecraft's block atlas up into the layers of a texture array
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_BLOCK_LAYER_TABLE_H
+#define RENDERER_BLOCK_LAYER_TABLE_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "atlas_packer.h"
+#include "mipmap_generator.h"
+#include "../../../geometry_cache/mesh_definition.h"
+
+namespace nova {
+    /*!
+     * \brief Knows which layer of the block texture array each sprite in Minecraft's block atlas went to
+     *
+     * Minecraft builds chunk geometry with UVs into its block atlas. This table takes those UVs, figures out which
+     * sprite they point at, and turns them into a layer index plus a UV inside that one sprite. The sprites
+     * themselves are copied out of the atlas into one image per layer
+     */
+    class block_layer_table {
+    public:
+        /*!
+         * \brief Forgets every sprite, ready for a new atlas
+         *
+         * \param atlas_size The size of the atlas that the sprites are in
+         */
+        void reset(glm::ivec2 atlas_size);
+
+        /*!
+         * \brief Adds a sprite to the table. Its layer is the number of sprites added before it
+         *
+         * \param name The sprite's name
+         * \param min_uv The sprite's minimum UV in the atlas
+         * \param max_uv The sprite's maximum UV in the atlas
+         */
+        void add_sprite(const std::string &name, glm::vec2 min_uv, glm::vec2 max_uv);
+
+        bool empty() const;
+
+        int get_num_layers() const;
+
+        /*!
+         * \brief The size every layer ends up as, which is the most common sprite size rounded up to a power of two
+         * so that every layer can have a full mip chain. Sprites of any other size are scaled to fit
+         */
+        glm::ivec2 get_layer_size() const;
+
+        /*!
+         * \brief Copies every sprite out of the atlas and into its own layer
+         *
+         * \param atlas The atlas the sprites are in
+         * \param tiles Gets one tile per layer, for the mipmap generator
+         * \return Every layer, one after another, so that the image is get_layer_size().x wide and
+         * get_layer_size().y * get_num_layers() tall. That's the same layout glTextureSubImage3D wants
+         */
+        rgba8_image make_layers(const rgba8_image &atlas, std::vector<mip_tile> &tiles) const;
+
+        /*!
+         * \brief The layer that a sprite is in, or -1 if it isn't in the table
+         */
+        int get_layer(const std::string &name) const;
+
+        /*!
+         * \brief The layer of the sprite that covers the given atlas UV, or -1 if no sprite does
+         */
+        int find_layer(glm::vec2 atlas_uv) const;
+
+        /*!
+         * \brief Turns chunk geometry with atlas UVs into geometry with layer UVs and a layer index
+         *
+         * Each triangle's layer is the one under the middle of its UVs, so that UVs right on the edge of a sprite
+         * don't get mistaken for the sprite next to it
+         *
+         * \param definition The geometry to change. It has to be in the POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT format,
+         * and it ends up in the POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT_LAYER format
+         * \return True if it worked. False if the geometry has the wrong format or points at something that isn't a
+         * sprite in the table, in which case the definition isn't changed
+         */
+        bool remap_vertices(mesh_definition &definition) const;
+
+    private:
+        struct sprite_entry {
+            glm::vec2 min_uv;
+            glm::vec2 max_uv;
+            atlas_rect texels;
+        };
+
+        /*!
+         * \brief The sprites are looked up through a grid of cells this big, in texels, so find_layer only has to
+         * look at the few sprites near the UV
+         */
+        static const int GRID_CELL_SIZE = 16;
+
+        glm::ivec2 atlas_size = {0, 0};
+        std::vector<sprite_entry> sprites;
+        std::unordered_map<std::string, int> layers_by_name;
+
+        glm::ivec2 grid_size = {0, 0};
+        std::vector<std::vector<int>> grid;
+    };
+}
+
+#endif //RENDERER_BLOCK_LAYER_TABLE_H
@@ -0,0 +1,197 @@
+/*!
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "mipmap_generator.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NOVA_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace nova {
+    glm::ivec2 get_mip_size(glm::ivec2 base_size, int level) {
+        return {std::max(1, base_size.x >> level), std::max(1, base_size.y >> level)};
+    }
+
+    int get_num_mip_levels(glm::ivec2 base_size) {
+        int biggest_side = std::max(base_size.x, base_size.y);
+        int num_levels = 1;
+        while(biggest_side > 1) {
+            biggest_side >>= 1;
+            num_levels++;
+        }
+
+        return num_levels;
+    }
+
+    /*!
+     * \brief Filters dst pixels [first_pixel, end_pixel) of one row, clamping reads to the edge of the source
+     */
+    static void downsample_row_scalar(const std::uint8_t *src_row_0, const std::uint8_t *src_row_1, int src_width,
+                                      std::uint8_t *dst_row, int first_pixel, int end_pixel) {
+        for(int x = first_pixel; x < end_pixel; x++) {
+            int left = x * 2 * 4;
+            int right = std::min(x * 2 + 1, src_width - 1) * 4;
+
+            for(int c = 0; c < 4; c++) {
+                int sum = src_row_0[left + c] + src_row_0[right + c] + src_row_1[left + c] + src_row_1[right + c];
+                dst_row[x * 4 + c] = (std::uint8_t) ((sum + 2) >> 2);
+            }
+        }
+    }
+
+    void downsample_rgba8_scalar(const std::uint8_t *src, glm::ivec2 src_size, std::uint8_t *dst, int first_row, int end_row) {
+        glm::ivec2 dst_size = get_mip_size(src_size, 1);
+
+        for(int y = first_row; y < end_row; y++) {
+            const std::uint8_t *src_row_0 = src + (std::size_t) (y * 2) * src_size.x * 4;
+            const std::uint8_t *src_row_1 = src + (std::size_t) std::min(y * 2 + 1, src_size.y - 1) * src_size.x * 4;
+            downsample_row_scalar(src_row_0, src_row_1, src_size.x, dst + (std::size_t) y * dst_size.x * 4, 0, dst_size.x);
+        }
+    }
+
+    void downsample_rgba8(const std::uint8_t *src, glm::ivec2 src_size, std::uint8_t *dst, int first_row, int end_row) {
+#ifdef NOVA_HAS_SSE2
+        glm::ivec2 dst_size = get_mip_size(src_size, 1);
+
+        // Only dst pixels whose 2x2 footprint is entirely inside the source can go through SSE
+        int num_full_pixels = src_size.x / 2;
+
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i two = _mm_set1_epi16(2);
+
+        for(int y = first_row; y < end_row; y++) {
+            const std::uint8_t *src_row_0 = src + (std::size_t) (y * 2) * src_size.x * 4;
+            const std::uint8_t *src_row_1 = src + (std::size_t) std::min(y * 2 + 1, src_size.y - 1) * src_size.x * 4;
+            std::uint8_t *dst_row = dst + (std::size_t) y * dst_size.x * 4;
+
+            int x = 0;
+            for(; x + 2 <= num_full_pixels; x += 2) {
+                // Four source pixels from each row make two destination pixels
+                __m128i top = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_row_0 + x * 8));
+                __m128i bottom = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_row_1 + x * 8));
+
+                // Add the rows together as 16-bit values. pixels_01 has source pixels 0 and 1, pixels_23 has 2 and 3
+                __m128i pixels_01 = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+                __m128i pixels_23 = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+
+                // Then add each pixel to its neighbour on the right
+                __m128i sums = _mm_add_epi16(_mm_unpacklo_epi64(pixels_01, pixels_23), _mm_unpackhi_epi64(pixels_01, pixels_23));
+                __m128i averages = _mm_srli_epi16(_mm_add_epi16(sums, two), 2);
+
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst_row + x * 4), _mm_packus_epi16(averages, averages));
+            }
+
+            downsample_row_scalar(src_row_0, src_row_1, src_size.x, dst_row, x, dst_size.x);
+        }
+#else
+        downsample_rgba8_scalar(src, src_size, dst, first_row, end_row);
+#endif
+    }
+
+    bool is_cutout(const std::uint8_t *pixels, int row_length, const atlas_rect &rect) {
+        bool has_transparent_texels = false;
+        for(int y = rect.y; y < rect.y + rect.height; y++) {
+            const std::uint8_t *row = pixels + ((std::size_t) y * row_length + rect.x) * 4;
+            for(int x = 0; x < rect.width; x++) {
+                std::uint8_t alpha = row[x * 4 + 3];
+                if(alpha != 0 && alpha != 255) {
+                    return false;
+                }
+                has_transparent_texels |= alpha == 0;
+            }
+        }
+
+        return has_transparent_texels;
+    }
+
+    float get_alpha_coverage(const std::uint8_t *pixels, int row_length, const atlas_rect &rect, std::uint8_t threshold, float alpha_scale) {
+        long long num_covered = 0;
+        for(int y = rect.y; y < rect.y + rect.height; y++) {
+            const std::uint8_t *row = pixels + ((std::size_t) y * row_length + rect.x) * 4;
+            for(int x = 0; x < rect.width; x++) {
+                // Rounded the same way scale_alpha_to_coverage rounds, so that the coverage it aims for is what it gets
+                if(std::round(row[x * 4 + 3] * alpha_scale) > threshold) {
+                    num_covered++;
+                }
+            }
+        }
+
+        return (float) num_covered / ((float) rect.width * rect.height);
+    }
+
+    void scale_alpha_to_coverage(std::uint8_t *pixels, int row_length, const atlas_rect &rect, std::uint8_t threshold, float target_coverage) {
+        // Coverage only goes up as the scale goes up, so a binary search finds the scale that matches best
+        float min_scale = 0.0f;
+        float max_scale = 4.0f;
+        for(int i = 0; i < 12; i++) {
+            float scale = (min_scale + max_scale) * 0.5f;
+            if(get_alpha_coverage(pixels, row_length, rect, threshold, scale) < target_coverage) {
+                min_scale = scale;
+            } else {
+                max_scale = scale;
+            }
+        }
+
+        // Alpha only has 256 values, so coverage goes up in steps. Take whichever side of the step is closer
+        float coverage_below = get_alpha_coverage(pixels, row_length, rect, threshold, min_scale);
+        float coverage_above = get_alpha_coverage(pixels, row_length, rect, threshold, max_scale);
+        float alpha_scale = target_coverage - coverage_below < coverage_above - target_coverage ? min_scale : max_scale;
+        for(int y = rect.y; y < rect.y + rect.height; y++) {
+            std::uint8_t *row = pixels + ((std::size_t) y * row_length + rect.x) * 4;
+            for(int x = 0; x < rect.width; x++) {
+                float alpha = std::round(row[x * 4 + 3] * alpha_scale);
+                row[x * 4 + 3] = (std::uint8_t) std::min(alpha, 255.0f);
+            }
+        }
+    }
+
+    std::vector<rgba8_image> generate_mip_chain(const rgba8_image &base, int num_levels, const std::vector<mip_tile> &tiles,
+                                                std::uint8_t alpha_threshold, thread_pool &workers) {
+        std::vector<rgba8_image> levels((std::size_t) std::max(num_levels - 1, 0));
+
+        const rgba8_image *previous_level = &base;
+        for(int level = 1; level < num_levels; level++) {
+            auto& mip = levels[level - 1];
+            mip.size = get_mip_size(base.size, level);
+            mip.pixels.resize((std::size_t) mip.size.x * mip.size.y * 4);
+
+            // About 64 KB of output per task, so the small levels don't drown in overhead
+            std::size_t rows_per_task = std::max<std::size_t>(1, 16384 / (std::size_t) mip.size.x);
+            const rgba8_image &src = *previous_level;
+            workers.parallel_for(0, (std::size_t) mip.size.y, rows_per_task, [&](std::size_t first_row, std::size_t end_row) {
+                downsample_rgba8(src.pixels.data(), src.size, mip.pixels.data(), (int) first_row, (int) end_row);
+            });
+
+            previous_level = &mip;
+        }
+
+        // Alpha coverage is fixed up after every level is made, so that each level is filtered from the real alpha of
+        // the level before it rather than from an already-scaled one
+        std::vector<const mip_tile*> cutout_tiles;
+        for(const auto& tile : tiles) {
+            if(tile.preserve_alpha_coverage) {
+                cutout_tiles.push_back(&tile);
+            }
+        }
+
+        workers.parallel_for(0, cutout_tiles.size(), 8, [&](std::size_t first_tile, std::size_t end_tile) {
+            for(std::size_t i = first_tile; i < end_tile; i++) {
+                const atlas_rect &rect = cutout_tiles[i]->rect;
+                float base_coverage = get_alpha_coverage(base.pixels.data(), base.size.x, rect, alpha_threshold);
+
+                for(int level = 1; level < num_levels; level++) {
+                    auto& mip = levels[level - 1];
+                    atlas_rect mip_rect = {rect.x >> level, rect.y >> level, std::max(1, rect.width >> level), std::max(1, rect.height >> level)};
+                    scale_alpha_to_coverage(mip.pixels.data(), mip.size.x, mip_rect, alpha_threshold, base_coverage);
+                }
+            }
+        });
+
+        return levels;
+    }
+}
@@ -0,0 +1,112 @@
+/*!
+ * \brief Makes mip chains for RGBA8 textures on the CPU
+ *
+ * glGenerateMipmap doesn't know anything about atlases, so it happily averages the edge of one sprite with the edge
+ * of the sprite next to it, and it makes cutout textures like leaves and grass fade away in the distance because it
+ * averages their alpha down below the alpha test threshold. Doing it ourselves fixes both of those
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_MIPMAP_GENERATOR_H
+#define RENDERER_MIPMAP_GENERATOR_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "atlas_packer.h"
+#include "../../../utils/thread_pool.h"
+
+namespace nova {
+    /*!
+     * \brief One sprite in an atlas, as far as mipmapping is concerned
+     */
+    struct mip_tile {
+        /*!
+         * \brief The part of the base level that the tile covers. Its position and size should be multiples of
+         * 2^(num_levels - 1), or neighbouring tiles will share texels in the smaller mip levels
+         */
+        atlas_rect rect;
+
+        /*!
+         * \brief If true, each mip level's alpha is scaled so that as much of the tile passes the alpha test as
+         * passes it in the base level
+         */
+        bool preserve_alpha_coverage;
+    };
+
+    struct rgba8_image {
+        glm::ivec2 size;
+        std::vector<std::uint8_t> pixels;
+    };
+
+    /*!
+     * \brief The size of a mip level. Each level is half the size of the one before it, but never smaller than 1x1
+     */
+    glm::ivec2 get_mip_size(glm::ivec2 base_size, int level);
+
+    /*!
+     * \brief The number of levels in a full mip chain, all the way down to 1x1
+     */
+    int get_num_mip_levels(glm::ivec2 base_size);
+
+    /*!
+     * \brief Makes some rows of the next mip level from the one before it with a 2x2 box filter. Odd sizes are
+     * handled by reusing the last row or column
+     *
+     * \param src The pixels of the bigger level
+     * \param src_size The size of the bigger level
+     * \param dst The pixels of the smaller level, which must be get_mip_size(src_size, 1) big
+     * \param first_row The first row of dst to fill in
+     * \param end_row One past the last row of dst to fill in
+     */
+    void downsample_rgba8(const std::uint8_t *src, glm::ivec2 src_size, std::uint8_t *dst, int first_row, int end_row);
+
+    /*!
+     * \brief The same as downsample_rgba8, without any SIMD. Used to check the SIMD version
+     */
+    void downsample_rgba8_scalar(const std::uint8_t *src, glm::ivec2 src_size, std::uint8_t *dst, int first_row, int end_row);
+
+    /*!
+     * \brief True if every texel in rect is either fully opaque or fully transparent, and at least one is fully
+     * transparent, like leaves and flowers. Those are the textures that should keep their alpha coverage when
+     * mipmapped. Translucent things like glass aren't cutouts
+     *
+     * \param pixels The pixels of the whole image
+     * \param row_length The width of the whole image
+     */
+    bool is_cutout(const std::uint8_t *pixels, int row_length, const atlas_rect &rect);
+
+    /*!
+     * \brief Tells you what fraction of the texels in rect would pass an alpha test of alpha > threshold, if their
+     * alpha was multiplied by alpha_scale first
+     *
+     * \param pixels The pixels of the whole image
+     * \param row_length The width of the whole image
+     */
+    float get_alpha_coverage(const std::uint8_t *pixels, int row_length, const atlas_rect &rect, std::uint8_t threshold, float alpha_scale = 1.0f);
+
+    /*!
+     * \brief Scales the alpha of the texels in rect so that get_alpha_coverage returns about target_coverage
+     */
+    void scale_alpha_to_coverage(std::uint8_t *pixels, int row_length, const atlas_rect &rect, std::uint8_t threshold, float target_coverage);
+
+    /*!
+     * \brief Makes every mip level below the base level
+     *
+     * Each level is filtered from the one before it, with its rows split up across the thread pool. Then every tile
+     * that wants its alpha coverage preserved gets fixed up, one tile per task
+     *
+     * \param base The base level
+     * \param num_levels The number of levels in the chain, including the base level
+     * \param tiles The sprites in the image. Only the ones that want their alpha coverage preserved matter
+     * \param alpha_threshold The alpha test threshold that coverage is measured against
+     * \param workers The threads to do it all on
+     * \return Levels 1 through num_levels - 1
+     */
+    std::vector<rgba8_image> generate_mip_chain(const rgba8_image &base, int num_levels, const std::vector<mip_tile> &tiles,
+                                                std::uint8_t alpha_threshold, thread_pool &workers);
+}
+
+#endif //RENDERER_MIPMAP_GENERATOR_H
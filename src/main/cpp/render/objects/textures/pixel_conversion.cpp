@@ -0,0 +1,124 @@
+/*!
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <cstring>
+#include "pixel_conversion.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NOVA_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#define NOVA_HAS_SSSE3
+#include <tmmintrin.h>
+#endif
+
+namespace nova {
+    void expand_to_rgba8_scalar(const std::uint8_t *src, int num_components, std::size_t num_pixels, std::uint8_t *dst) {
+        if(num_components == 4) {
+            std::memcpy(dst, src, num_pixels * 4);
+            return;
+        }
+
+        for(std::size_t i = 0; i < num_pixels; i++) {
+            const std::uint8_t *pixel = src + i * num_components;
+            dst[i * 4 + 0] = pixel[0];
+            dst[i * 4 + 1] = num_components > 1 ? pixel[1] : (std::uint8_t) 0;
+            dst[i * 4 + 2] = num_components > 2 ? pixel[2] : (std::uint8_t) 0;
+            dst[i * 4 + 3] = 255;
+        }
+    }
+
+#ifdef NOVA_HAS_SSE2
+    /*!
+     * \brief Expands 16 R pixels at a time
+     */
+    static std::size_t expand_r_sse2(const std::uint8_t *src, std::size_t num_pixels, std::uint8_t *dst) {
+        const __m128i zero = _mm_setzero_si128();
+        // Each 16-bit lane is the blue and alpha of one pixel: 0 and 255
+        const __m128i blue_alpha = _mm_set1_epi16((short) 0xFF00);
+
+        std::size_t i = 0;
+        for(; i + 16 <= num_pixels; i += 16) {
+            __m128i red = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+            __m128i red_green_lo = _mm_unpacklo_epi8(red, zero);
+            __m128i red_green_hi = _mm_unpackhi_epi8(red, zero);
+
+            auto *out = reinterpret_cast<__m128i*>(dst + i * 4);
+            _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(red_green_lo, blue_alpha));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(red_green_lo, blue_alpha));
+            _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(red_green_hi, blue_alpha));
+            _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(red_green_hi, blue_alpha));
+        }
+
+        return i;
+    }
+
+    /*!
+     * \brief Expands 8 RG pixels at a time
+     */
+    static std::size_t expand_rg_sse2(const std::uint8_t *src, std::size_t num_pixels, std::uint8_t *dst) {
+        const __m128i blue_alpha = _mm_set1_epi16((short) 0xFF00);
+
+        std::size_t i = 0;
+        for(; i + 8 <= num_pixels; i += 8) {
+            __m128i red_green = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+
+            auto *out = reinterpret_cast<__m128i*>(dst + i * 4);
+            _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(red_green, blue_alpha));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(red_green, blue_alpha));
+        }
+
+        return i;
+    }
+#endif
+
+#ifdef NOVA_HAS_SSSE3
+    /*!
+     * \brief Expands 4 RGB pixels at a time
+     */
+    static std::size_t expand_rgb_ssse3(const std::uint8_t *src, std::size_t num_pixels, std::uint8_t *dst) {
+        // Moves each group of three bytes into the bottom of a four-byte lane, and zeroes the top byte
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i alpha = _mm_set1_epi32((int) 0xFF000000);
+
+        // Each iteration reads 16 bytes but only uses 12, so stop while there are still 16 bytes left to read
+        std::size_t i = 0;
+        for(; i + 6 <= num_pixels; i += 4) {
+            __m128i rgb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+            __m128i rgba = _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), rgba);
+        }
+
+        return i;
+    }
+#endif
+
+    void expand_to_rgba8(const std::uint8_t *src, int num_components, std::size_t num_pixels, std::uint8_t *dst) {
+        std::size_t num_done = 0;
+
+        switch(num_components) {
+#ifdef NOVA_HAS_SSE2
+            case 1:
+                num_done = expand_r_sse2(src, num_pixels, dst);
+                break;
+            case 2:
+                num_done = expand_rg_sse2(src, num_pixels, dst);
+                break;
+#endif
+#ifdef NOVA_HAS_SSSE3
+            case 3:
+                num_done = expand_rgb_ssse3(src, num_pixels, dst);
+                break;
+#endif
+            default:
+                break;
+        }
+
+        expand_to_rgba8_scalar(src + num_done * num_components, num_components, num_pixels - num_done, dst + num_done * 4);
+    }
+}
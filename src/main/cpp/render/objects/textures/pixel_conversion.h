@@ -0,0 +1,39 @@
+/*!
+ * \brief Functions to get texture data from Minecraft into a format that OpenGL can upload quickly
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_PIXEL_CONVERSION_H
+#define RENDERER_PIXEL_CONVERSION_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nova {
+    /*!
+     * \brief Expands 8-bit pixels with one, two, three or four components to 8-bit RGBA
+     *
+     * Missing color components are set to 0 and missing alpha is set to 255, which is what OpenGL does when you upload
+     * GL_RED, GL_RG or GL_RGB data to an RGBA texture. We do it ourselves because RGBA rows are always four-byte aligned
+     * and drivers have a fast path for RGBA8, while three-component rows hit the slow path (or break entirely if you
+     * forget about GL_UNPACK_ALIGNMENT)
+     *
+     * Uses SSE2 for one and two components, and SSSE3 for three components when the compiler lets us
+     *
+     * \param src The pixels to expand, num_pixels * num_components bytes
+     * \param num_components The number of components in each source pixel, in [1, 4]
+     * \param num_pixels How many pixels to expand
+     * \param dst Where to write the expanded pixels. Must have room for num_pixels * 4 bytes
+     */
+    void expand_to_rgba8(const std::uint8_t* src, int num_components, std::size_t num_pixels, std::uint8_t* dst);
+
+    /*!
+     * \brief The plain C++ version of expand_to_rgba8. The SIMD kernels use this for the pixels that don't fill a whole
+     * SIMD register, and the tests use it as the reference
+     */
+    void expand_to_rgba8_scalar(const std::uint8_t* src, int num_components, std::size_t num_pixels, std::uint8_t* dst);
+}
+
+#endif //RENDERER_PIXEL_CONVERSION_H
@@ -3,13 +3,15 @@
 //
 
 #include "texture2D.h"
+#include <algorithm>
 #include <stdexcept>
 #include <easylogging++.h>
 #include "../../../utils/utils.h"
 
 namespace nova {
     texture2D::texture2D() : size(0) {
-        glGenTextures(1, &gl_name);
+        // glCreateTextures instead of glGenTextures so that the texture has a target before we give it storage
+        glCreateTextures(GL_TEXTURE_2D, 1, &gl_name);
     }
 
     void texture2D::set_data(void* pixel_data, glm::ivec2 &dimensions, GLenum format, GLenum type, GLenum internal_format) {
@@ -22,6 +24,33 @@ namespace nova {
         glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         
         glBindTexture(GL_TEXTURE_2D, (GLuint) previous_texture);
+
+        size = dimensions;
+        this->format = internal_format;
+    }
+
+    void texture2D::set_storage(glm::ivec2 dimensions, GLenum internal_format, GLsizei num_levels) {
+        if(has_storage) {
+            glDeleteTextures(1, &gl_name);
+            glCreateTextures(GL_TEXTURE_2D, 1, &gl_name);
+        }
+
+        glTextureStorage2D(gl_name, num_levels, internal_format, dimensions.x, dimensions.y);
+        glTextureParameteri(gl_name, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(gl_name, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        size = dimensions;
+        format = internal_format;
+        has_storage = true;
+    }
+
+    void texture2D::set_sub_image(const void* pixel_data, glm::ivec2 offset, glm::ivec2 dimensions, GLenum format, GLenum type, GLint level) {
+        glTextureSubImage2D(gl_name, level, offset.x, offset.y, dimensions.x, dimensions.y, format, type, pixel_data);
+    }
+
+    void texture2D::set_compressed_sub_image(const void* data, glm::ivec2 offset, glm::ivec2 dimensions, GLenum internal_format,
+                                             GLsizei num_bytes, GLint level) {
+        glCompressedTextureSubImage2D(gl_name, level, offset.x, offset.y, dimensions.x, dimensions.y, internal_format, num_bytes, data);
     }
 
     void texture2D::bind(unsigned int binding) {
@@ -47,8 +76,59 @@ namespace nova {
         return format;
     }
 
+    /*!
+     * \brief The most anisotropy the driver allows, or 0 if it can't filter anisotropically at all. Asked for once
+     */
+    static GLfloat get_max_anisotropy() {
+        static const GLfloat max_anisotropy = []() {
+            // Core in 4.6, but the context's only 4.5, so it might just be an extension
+            if(!GLAD_GL_VERSION_4_6 && !GLAD_GL_ARB_texture_filter_anisotropic && !GLAD_GL_EXT_texture_filter_anisotropic) {
+                return 0.0f;
+            }
+
+            GLfloat max = 1;
+            glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &max);
+            return max;
+        }();
+
+        return max_anisotropy;
+    }
+
+    void apply_filtering_parameters(GLuint gl_name, const texture_filtering_params &params) {
+        GLint mag_filter = params.texture_upsample_filter == texture_filtering_params::POINT ? GL_NEAREST : GL_LINEAR;
+
+        GLint min_filter;
+        if(params.num_mipmap_levels > 1) {
+            // Always blend between mip levels, even when the texels themselves are point sampled. Minecraft does the
+            // same, and it hides the line where one level turns into the next
+            switch(params.texture_downsample_filter) {
+                case texture_filtering_params::POINT:
+                    min_filter = GL_NEAREST_MIPMAP_LINEAR;
+                    break;
+                case texture_filtering_params::BILINEAR:
+                    min_filter = GL_LINEAR_MIPMAP_NEAREST;
+                    break;
+                default:
+                    min_filter = GL_LINEAR_MIPMAP_LINEAR;
+                    break;
+            }
+        } else {
+            min_filter = params.texture_downsample_filter == texture_filtering_params::POINT ? GL_NEAREST : GL_LINEAR;
+        }
+
+        glTextureParameteri(gl_name, GL_TEXTURE_MAG_FILTER, mag_filter);
+        glTextureParameteri(gl_name, GL_TEXTURE_MIN_FILTER, min_filter);
+        glTextureParameteri(gl_name, GL_TEXTURE_BASE_LEVEL, 0);
+        glTextureParameteri(gl_name, GL_TEXTURE_MAX_LEVEL, std::max(params.num_mipmap_levels - 1, 0));
+
+        auto max_anisotropy = get_max_anisotropy();
+        if(max_anisotropy > 0) {
+            glTextureParameterf(gl_name, GL_TEXTURE_MAX_ANISOTROPY, std::min(std::max((GLfloat) params.anisotropic_level, 1.0f), max_anisotropy));
+        }
+    }
+
     void texture2D::set_filtering_parameters(texture_filtering_params &params) {
-        // TODO
+        apply_filtering_parameters(gl_name, params);
     }
 
     const unsigned int &texture2D::get_gl_name() {
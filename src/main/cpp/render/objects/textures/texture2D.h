@@ -31,6 +31,14 @@ namespace nova {
         int anisotropic_level;
     };
 
+    /*!
+     * \brief Sets the min and mag filters, the number of mip levels that can be sampled, and the anisotropy of any
+     * kind of texture
+     *
+     * The anisotropy is clamped to what the driver allows, and left alone if the driver can't do anisotropic filtering
+     */
+    void apply_filtering_parameters(GLuint gl_name, const texture_filtering_params &params);
+
     class texture_creation_exception : public std::exception {
     };
 
@@ -79,6 +87,49 @@ namespace nova {
          */
         void set_data(void* pixel_data, glm::ivec2 &dimensions, GLenum format, GLenum type = GL_FLOAT, GLenum internal_format = GL_RGBA);
 
+        /*!
+         * \brief Allocates immutable storage for this texture
+         *
+         * Immutable storage can't be resized, so if this texture already has storage, the old texture object is deleted
+         * and a new one is made. Fill the storage in with set_sub_image
+         *
+         * \param dimensions The size of the base level of the texture
+         * \param internal_format The sized internal format of the texture, like GL_RGBA8
+         * \param num_levels The number of mip levels to allocate
+         */
+        void set_storage(glm::ivec2 dimensions, GLenum internal_format, GLsizei num_levels = 1);
+
+        /*!
+         * \brief Uploads data to part of this texture's storage. Doesn't touch any bindings
+         *
+         * \param pixel_data The pixels to upload
+         * \param offset The texel that the bottom left of pixel_data goes to
+         * \param dimensions The size of the region to upload
+         * \param format The format of pixel_data, like GL_RGBA
+         * \param type The type of each component in pixel_data, like GL_UNSIGNED_BYTE
+         * \param level The mip level to upload to
+         */
+        void set_sub_image(const void* pixel_data, glm::ivec2 offset, glm::ivec2 dimensions, GLenum format, GLenum type, GLint level = 0);
+
+        /*!
+         * \brief Uploads already compressed data to part of this texture's storage. Doesn't touch any bindings
+         *
+         * \param data The compressed blocks to upload
+         * \param offset The texel that the first block goes to. Must be a multiple of the block size
+         * \param dimensions The size of the region to upload. Must be a multiple of the block size, unless the region
+         * runs up against the edge of the mip level
+         * \param internal_format The compressed format of data, which must match the format of the storage
+         * \param num_bytes The size of data
+         * \param level The mip level to upload to
+         */
+        void set_compressed_sub_image(const void* data, glm::ivec2 offset, glm::ivec2 dimensions, GLenum internal_format,
+                                      GLsizei num_bytes, GLint level = 0);
+
+        /*!
+         * \brief Sets the min and mag filters, the number of mip levels that can be sampled, and the anisotropy
+         *
+         * Call this after set_storage, since set_storage makes a new texture object with the default parameters
+         */
         void set_filtering_parameters(texture_filtering_params &params);
 
         /*!
@@ -116,6 +167,7 @@ namespace nova {
         GLuint gl_name;
         GLint current_location = -1;
         std::string name;
+        bool has_storage = false;
     };
 }
 
@@ -0,0 +1,60 @@
+/*!
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include "texture2D_array.h"
+
+namespace nova {
+    texture2D_array::texture2D_array() : layer_size(0) {
+        glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &gl_name);
+    }
+
+    void texture2D_array::set_storage(glm::ivec2 layer_size, int num_layers, GLenum internal_format, GLsizei num_levels) {
+        if(has_storage) {
+            glDeleteTextures(1, &gl_name);
+            glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &gl_name);
+        }
+
+        glTextureStorage3D(gl_name, num_levels, internal_format, layer_size.x, layer_size.y, num_layers);
+        glTextureParameteri(gl_name, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(gl_name, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        this->layer_size = layer_size;
+        this->num_layers = num_layers;
+        has_storage = true;
+    }
+
+    void texture2D_array::set_layers(const void* pixel_data, int first_layer, int num_layers, glm::ivec2 dimensions,
+                                     GLenum format, GLenum type, GLint level) {
+        glTextureSubImage3D(gl_name, level, 0, 0, first_layer, dimensions.x, dimensions.y, num_layers, format, type, pixel_data);
+    }
+
+    void texture2D_array::set_filtering_parameters(texture_filtering_params &params) {
+        apply_filtering_parameters(gl_name, params);
+    }
+
+    void texture2D_array::bind(unsigned int binding) {
+        glBindTextureUnit(binding, gl_name);
+    }
+
+    glm::ivec2 texture2D_array::get_layer_size() const {
+        return layer_size;
+    }
+
+    int texture2D_array::get_num_layers() const {
+        return num_layers;
+    }
+
+    const unsigned int &texture2D_array::get_gl_name() const {
+        return gl_name;
+    }
+
+    void texture2D_array::set_name(const std::string &name) {
+        this->name = name;
+    }
+
+    const std::string &texture2D_array::get_name() const {
+        return name;
+    }
+}
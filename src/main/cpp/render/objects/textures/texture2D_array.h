@@ -0,0 +1,81 @@
+/*!
+ * \brief A GL_TEXTURE_2D_ARRAY, where every layer is the same size
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_TEXTURE2D_ARRAY_H
+#define RENDERER_TEXTURE2D_ARRAY_H
+
+#include <string>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "texture2D.h"
+
+namespace nova {
+    /*!
+     * \brief Lots of same-sized textures that are bound as one
+     *
+     * Unlike an atlas, nothing in one layer can ever bleed into another layer, no matter how many mip levels there are
+     */
+    class texture2D_array {
+    public:
+        /*!
+         * \brief Makes a new texture object on the GPU, with no storage yet
+         */
+        texture2D_array();
+
+        /*!
+         * \brief Allocates immutable storage for every layer
+         *
+         * Like texture2D::set_storage, if the array already has storage then the old texture object is deleted and a
+         * new one is made
+         *
+         * \param layer_size The size of the base level of each layer
+         * \param num_layers How many layers there are
+         * \param internal_format The sized internal format of the texture, like GL_RGBA8
+         * \param num_levels The number of mip levels to allocate
+         */
+        void set_storage(glm::ivec2 layer_size, int num_layers, GLenum internal_format, GLsizei num_levels = 1);
+
+        /*!
+         * \brief Uploads one or more whole layers of one mip level. Doesn't touch any bindings
+         *
+         * \param pixel_data The pixels of each layer, one layer after another
+         * \param first_layer The layer that the start of pixel_data goes to
+         * \param num_layers How many layers are in pixel_data
+         * \param dimensions The size of each layer in this mip level
+         * \param format The format of pixel_data, like GL_RGBA
+         * \param type The type of each component in pixel_data, like GL_UNSIGNED_BYTE
+         * \param level The mip level to upload to
+         */
+        void set_layers(const void* pixel_data, int first_layer, int num_layers, glm::ivec2 dimensions, GLenum format,
+                        GLenum type, GLint level = 0);
+
+        /*!
+         * \copydoc texture2D::set_filtering_parameters
+         */
+        void set_filtering_parameters(texture_filtering_params &params);
+
+        void bind(unsigned int binding);
+
+        glm::ivec2 get_layer_size() const;
+
+        int get_num_layers() const;
+
+        const unsigned int &get_gl_name() const;
+
+        void set_name(const std::string &name);
+        const std::string& get_name() const;
+
+    private:
+        glm::ivec2 layer_size;
+        int num_layers = 0;
+        GLuint gl_name;
+        std::string name;
+        bool has_storage = false;
+    };
+}
+
+#endif //RENDERER_TEXTURE2D_ARRAY_H
@@ -0,0 +1,229 @@
+/*!
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <easylogging++.h>
+#include "texture_cache.h"
+#include "../../../utils/file_cache.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nova {
+    static const char CACHE_FILE_MAGIC[4] = {'N', 'V', 'T', 'C'};
+
+    /*!
+     * \brief The start of every cache file. After it comes one level_header per level, then the levels themselves
+     */
+    struct cache_file_header {
+        char magic[4];
+        std::uint32_t version;
+        std::uint32_t num_levels;
+        std::uint32_t padding;
+    };
+
+    struct level_header {
+        std::uint64_t offset;
+        std::uint64_t size;
+    };
+
+    /*!
+     * \brief Levels start on a multiple of this, which keeps the driver's copy on its fast path
+     */
+    static const std::size_t LEVEL_ALIGNMENT = 64;
+
+    mapped_texture::~mapped_texture() {
+#if defined(_WIN32)
+        if(data) {
+            UnmapViewOfFile(data);
+        }
+        if(mapping_handle) {
+            CloseHandle(mapping_handle);
+        }
+        if(file_handle) {
+            CloseHandle(file_handle);
+        }
+#else
+        if(data) {
+            munmap(const_cast<std::uint8_t*>(data), size);
+        }
+#endif
+    }
+
+    int mapped_texture::get_num_levels() const {
+        return (int) levels.size();
+    }
+
+    const std::uint8_t* mapped_texture::get_level_data(int level) const {
+        return data + levels[level].first;
+    }
+
+    std::size_t mapped_texture::get_level_size(int level) const {
+        return levels[level].second;
+    }
+
+    texture_cache::texture_cache(std::string directory) : directory(std::move(directory)) {}
+
+    std::uint64_t texture_cache::get_key(const rgba8_image &base, const std::vector<mip_tile> &tiles, int num_levels,
+                                         std::uint8_t alpha_threshold, texture_compression compression) {
+        // 64-bit FNV-1a, eight bytes at a time. It's not cryptographic, but a collision only means a wrong-looking
+        // texture, and it's a lot faster than reading the same pixels one byte at a time
+        std::uint64_t hash = FNV_OFFSET_BASIS;
+        auto mix = [&](std::uint64_t value) {
+            hash = hash_word(value, hash);
+        };
+
+        mix(VERSION);
+        mix((std::uint64_t) compression);
+        mix((std::uint64_t) num_levels);
+        mix(alpha_threshold);
+        mix((std::uint64_t) base.size.x << 32 | (std::uint32_t) base.size.y);
+
+        std::size_t num_words = base.pixels.size() / 8;
+        for(std::size_t i = 0; i < num_words; i++) {
+            std::uint64_t word;
+            std::memcpy(&word, base.pixels.data() + i * 8, 8);
+            mix(word);
+        }
+        for(std::size_t i = num_words * 8; i < base.pixels.size(); i++) {
+            mix(base.pixels[i]);
+        }
+
+        // Only the tiles that keep their alpha coverage change the mip levels. They're sorted so that the order
+        // they're given in doesn't matter
+        std::vector<atlas_rect> cutout_rects;
+        for(const auto& tile : tiles) {
+            if(tile.preserve_alpha_coverage) {
+                cutout_rects.push_back(tile.rect);
+            }
+        }
+        std::sort(cutout_rects.begin(), cutout_rects.end(), [](const atlas_rect &a, const atlas_rect &b) {
+            return a.y != b.y ? a.y < b.y : a.x < b.x;
+        });
+        for(const auto& rect : cutout_rects) {
+            mix((std::uint64_t) rect.x << 32 | (std::uint32_t) rect.y);
+            mix((std::uint64_t) rect.width << 32 | (std::uint32_t) rect.height);
+        }
+
+        return hash;
+    }
+
+    std::unique_ptr<mapped_texture> texture_cache::load(std::uint64_t key, const std::vector<std::size_t> &level_sizes) const {
+        std::string path = get_path(key);
+        std::unique_ptr<mapped_texture> texture(new mapped_texture);
+
+#if defined(_WIN32)
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if(file == INVALID_HANDLE_VALUE) {
+            return nullptr;
+        }
+        texture->file_handle = file;
+
+        LARGE_INTEGER file_size;
+        if(!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+            return nullptr;
+        }
+
+        texture->mapping_handle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(!texture->mapping_handle) {
+            return nullptr;
+        }
+
+        texture->data = static_cast<const std::uint8_t*>(MapViewOfFile(texture->mapping_handle, FILE_MAP_READ, 0, 0, 0));
+        if(!texture->data) {
+            return nullptr;
+        }
+        texture->size = (std::size_t) file_size.QuadPart;
+#else
+        int file = open(path.c_str(), O_RDONLY);
+        if(file < 0) {
+            return nullptr;
+        }
+
+        // The mapping keeps the file alive by itself, so the descriptor can go as soon as it's made
+        struct stat file_info;
+        void* mapping = MAP_FAILED;
+        if(fstat(file, &file_info) == 0 && file_info.st_size > 0) {
+            mapping = mmap(nullptr, (std::size_t) file_info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        }
+        close(file);
+
+        if(mapping == MAP_FAILED) {
+            return nullptr;
+        }
+        texture->data = static_cast<const std::uint8_t*>(mapping);
+        texture->size = (std::size_t) file_info.st_size;
+#endif
+
+        auto header_size = sizeof(cache_file_header) + sizeof(level_header) * level_sizes.size();
+        cache_file_header header;
+        if(texture->size < header_size) {
+            LOG(WARNING) << "Ignoring cached texture " << path << " because it's not what I expected";
+            return nullptr;
+        }
+
+        std::memcpy(&header, texture->data, sizeof(header));
+        if(std::memcmp(header.magic, CACHE_FILE_MAGIC, 4) != 0 || header.version != VERSION || header.num_levels != level_sizes.size()) {
+            LOG(WARNING) << "Ignoring cached texture " << path << " because it's not what I expected";
+            return nullptr;
+        }
+
+        for(std::size_t i = 0; i < level_sizes.size(); i++) {
+            level_header level;
+            std::memcpy(&level, texture->data + sizeof(header) + i * sizeof(level), sizeof(level));
+            if(level.size != level_sizes[i] || level.offset > texture->size || level.size > texture->size - level.offset) {
+                LOG(WARNING) << "Ignoring cached texture " << path << " because it's not what I expected";
+                return nullptr;
+            }
+
+            texture->levels.emplace_back((std::size_t) level.offset, (std::size_t) level.size);
+        }
+
+        return texture;
+    }
+
+    void texture_cache::store(std::uint64_t key, const std::vector<std::pair<const std::uint8_t*, std::size_t>> &levels) const {
+        make_directories(directory);
+
+        cache_file_header header = {};
+        std::memcpy(header.magic, CACHE_FILE_MAGIC, 4);
+        header.version = VERSION;
+        header.num_levels = (std::uint32_t) levels.size();
+
+        std::vector<level_header> level_headers;
+        std::size_t offset = sizeof(header) + sizeof(level_header) * levels.size();
+        for(const auto& level : levels) {
+            offset = (offset + LEVEL_ALIGNMENT - 1) / LEVEL_ALIGNMENT * LEVEL_ALIGNMENT;
+            level_headers.push_back({offset, level.second});
+            offset += level.second;
+        }
+
+        replace_file(get_path(key), [&](std::ofstream& file) {
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(level_headers.data()), (std::streamsize) (sizeof(level_header) * level_headers.size()));
+
+            const char padding[LEVEL_ALIGNMENT] = {};
+            for(std::size_t i = 0; i < levels.size() && file; i++) {
+                auto position = (std::size_t) file.tellp();
+                file.write(padding, (std::streamsize) (level_headers[i].offset - position));
+                file.write(reinterpret_cast<const char*>(levels[i].first), (std::streamsize) levels[i].second);
+            }
+        });
+    }
+
+    std::string texture_cache::get_path(std::uint64_t key) const {
+        return get_cache_file_path(directory, key, ".tex");
+    }
+}
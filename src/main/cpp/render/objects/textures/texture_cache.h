@@ -0,0 +1,114 @@
+/*!
+ * \brief Keeps finished textures on disk, so the same resource pack only has to be processed once
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_TEXTURE_CACHE_H
+#define RENDERER_TEXTURE_CACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+#include "block_compression.h"
+
+namespace nova {
+    /*!
+     * \brief A texture from the cache, mapped straight into memory
+     *
+     * Nothing is read until OpenGL reads it, so uploading from here costs one copy, which the driver does anyway. The
+     * file stays mapped until this is destroyed
+     */
+    class mapped_texture {
+    public:
+        mapped_texture(const mapped_texture &other) = delete;
+        mapped_texture &operator=(const mapped_texture &other) = delete;
+
+        ~mapped_texture();
+
+        int get_num_levels() const;
+
+        /*!
+         * \brief The bytes of a mip level, in whatever format the texture was stored in
+         */
+        const std::uint8_t* get_level_data(int level) const;
+
+        std::size_t get_level_size(int level) const;
+
+    private:
+        friend class texture_cache;
+
+        mapped_texture() = default;
+
+        const std::uint8_t* data = nullptr;
+        std::size_t size = 0;
+
+#if defined(_WIN32)
+        void* file_handle = nullptr;
+        void* mapping_handle = nullptr;
+#endif
+
+        /*!
+         * \brief Where each level starts and how long it is, in bytes from the start of the file
+         */
+        std::vector<std::pair<std::size_t, std::size_t>> levels;
+    };
+
+    /*!
+     * \brief A directory full of processed textures, named after a hash of everything that went into them
+     *
+     * An entry holds every mip level of a texture, already converted and compressed, so a hit skips all the CPU work
+     * and goes straight to the GPU. Making an atlas's mip chain and compressing it takes a while, but people load the
+     * same resource packs over and over, so most of the time the answer is already sitting on disk from last time
+     */
+    class texture_cache {
+    public:
+        /*!
+         * \brief Bump this whenever the mipmap generator or the encoders change what they output, so old cache
+         * entries get ignored
+         */
+        static const std::uint32_t VERSION = 2;
+
+        /*!
+         * \param directory Where to keep the cache files. Made the first time something is stored
+         */
+        explicit texture_cache(std::string directory);
+
+        /*!
+         * \brief Hashes everything that decides what a texture ends up as: the base level's size and pixels, the
+         * tiles the mipmap generator treats specially, how many levels there are, the alpha test threshold, the
+         * format, and the cache version
+         */
+        static std::uint64_t get_key(const rgba8_image &base, const std::vector<mip_tile> &tiles, int num_levels,
+                                     std::uint8_t alpha_threshold, texture_compression compression);
+
+        /*!
+         * \brief Maps a texture from the cache into memory
+         *
+         * \param key The key from get_key
+         * \param level_sizes How many bytes each level should be. Entries that don't match are ignored, since they're
+         * either from something else or damaged
+         * \return The texture, or nullptr if the cache doesn't have it
+         */
+        std::unique_ptr<mapped_texture> load(std::uint64_t key, const std::vector<std::size_t> &level_sizes) const;
+
+        /*!
+         * \brief Writes a texture to the cache. Failing to write is logged and otherwise ignored, since the cache is
+         * only ever an optimization
+         *
+         * \param levels The data and size in bytes of every level, biggest first
+         */
+        void store(std::uint64_t key, const std::vector<std::pair<const std::uint8_t*, std::size_t>> &levels) const;
+
+    private:
+        std::string directory;
+
+        std::string get_path(std::uint64_t key) const;
+    };
+}
+
+#endif //RENDERER_TEXTURE_CACHE_H
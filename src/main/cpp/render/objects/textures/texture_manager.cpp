@@ -4,12 +4,23 @@
  */
 
 #include <algorithm>
+#include <cstring>
 #include <easylogging++.h>
 #include "texture_manager.h"
+#include "pixel_conversion.h"
+#include "../../../utils/profiler.h"
 
 namespace nova {
-    texture_manager::texture_manager() {
+    const std::string texture_manager::BLOCK_ATLAS_NAME = "block_color";
+    const std::string texture_manager::BLOCK_ARRAY_NAME = "block_color_array";
+
+    block_texture_mode block_texture_mode_from_string(const std::string &name) {
+        return name == "array" ? block_texture_mode::array : block_texture_mode::atlas;
+    }
+
+    texture_manager::texture_manager() : processed_texture_cache("cache/textures") {
         LOG(INFO) << "Creating the Texture Manager";
+        slots.push_back({"", nullptr, nullptr});
         reset();
         LOG(INFO) << "Texture manager created";
     }
@@ -21,69 +32,481 @@ namespace nova {
     }
 
     void texture_manager::reset() {
-        if(!atlases.empty()) {
-            // Nothing to deallocate, let's just return
-            return;
-        }
         // Gather all the textures into a list so we only need one call to delete them
-        std::vector<GLuint> texture_ids(atlases.size());
-        for(auto tex : atlases) {
+        std::vector<GLuint> texture_ids;
+        texture_ids.reserve(atlases.size());
+        for(auto& tex : atlases) {
             texture_ids.push_back(tex.second.get_gl_name());
         }
+        for(auto& array : texture_arrays) {
+            texture_ids.push_back(array.second.get_gl_name());
+        }
 
         glDeleteTextures((GLsizei) texture_ids.size(), texture_ids.data());
 
         atlases.clear();
+        texture_arrays.clear();
         locations.clear();
 
-        atlases["lightmap"] = texture2D{};
+        // The handles stay, since whatever has them will want the new resource pack's texture with the same name
+        for(auto& slot : slots) {
+            slot.texture = nullptr;
+            slot.array = nullptr;
+        }
+
+        last_added_texture.clear();
+        block_atlas_pixels = {};
+        block_layers.reset({0, 0});
+        block_layers_changed = false;
+
+        pending_sprites.clear();
+        packer.reset();
+        page_pixels.clear();
+
+        if(streamer) {
+            streamer->cancel_all();
+        }
+
+        get_or_add_atlas("lightmap");
+
+        if(placeholder.get_width() == 0) {
+            const std::uint8_t white[] = {255, 255, 255, 255};
+            placeholder.set_name("placeholder");
+            placeholder.set_storage({1, 1}, GL_RGBA8);
+            placeholder.set_sub_image(white, {0, 0}, {1, 1}, GL_RGBA, GL_UNSIGNED_BYTE);
+        }
     }
 
     void texture_manager::update_texture(std::string texture_name, void* data, glm::ivec2 &size, GLenum format, GLenum type, GLenum internal_format) {
-        auto &texture = atlases[texture_name];
+        auto &texture = get_or_add_atlas(texture_name);
         texture.set_data(data, size, format, type, internal_format);
     }
 
+    void texture_manager::update_lightmap(const void* data, glm::ivec2 size) {
+        auto num_bytes = (std::size_t) size.x * size.y * 4;
+
+        // 64-bit FNV-1a, eight bytes at a time. A 16x16 lightmap is only 128 steps
+        std::uint64_t hash = 14695981039346656037ull;
+        auto bytes = static_cast<const std::uint8_t*>(data);
+        for(std::size_t i = 0; i + 8 <= num_bytes; i += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, bytes + i, 8);
+            hash = (hash ^ word) * 1099511628211ull;
+        }
+        for(std::size_t i = num_bytes & ~(std::size_t) 7; i < num_bytes; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+
+        auto& lightmap = get_or_add_atlas("lightmap");
+        bool same_size = lightmap.get_width() == size.x && lightmap.get_height() == size.y;
+        if(same_size && hash == lightmap_hash) {
+            return;
+        }
+
+        if(!same_size) {
+            lightmap.set_name("lightmap");
+            lightmap.set_storage(size, GL_RGBA8);
+        }
+
+        lightmap.set_sub_image(data, {0, 0}, size, GL_BGRA, GL_UNSIGNED_BYTE);
+        lightmap_hash = hash;
+        profiler::record_stat("texture_upload_bytes", (long long) num_bytes);
+    }
+
     void texture_manager::add_texture(mc_atlas_texture &new_texture) {
         LOG(INFO) << "Adding texture " << new_texture.name << " (" << new_texture.width << "x" << new_texture.height << ")";
+        if(new_texture.num_components < 1 || new_texture.num_components > 4) {
+            LOG(ERROR) << "Unsupported number of components. You have " << new_texture.num_components
+                       << " components "
+                       << ", but I need a number in [1,4]";
+            return;
+        }
+
         std::string texture_name = new_texture.name;
         texture2D texture;
         texture.set_name(texture_name);
 
-        std::vector<float> pixel_data(
-                (size_t) (new_texture.width * new_texture.height * new_texture.num_components));
-        for(int i = 0; i < new_texture.width * new_texture.height * new_texture.num_components; i++) {
-            pixel_data[i] = float(new_texture.texture_data[i]) / 255.0f;
+        auto dimensions = glm::ivec2{new_texture.width, new_texture.height};
+        auto num_pixels = (std::size_t) new_texture.width * new_texture.height;
+
+        // Minecraft's textures are already gamma-encoded and shaderpacks expect to read them that way, so they go in
+        // as plain RGBA8. SRGB8_ALPHA8 would have the hardware linearize them when sampled
+        texture.set_storage(dimensions, GL_RGBA8);
+
+        bool is_block_atlas = texture_name == BLOCK_ATLAS_NAME;
+        if(new_texture.num_components == 4 && !is_block_atlas) {
+            // Already RGBA, so we can send Minecraft's bytes as-is
+            texture.set_sub_image(new_texture.texture_data, {0, 0}, dimensions, GL_RGBA, GL_UNSIGNED_BYTE);
+
+        } else {
+            std::vector<std::uint8_t> rgba_data(num_pixels * 4);
+            expand_to_rgba8(new_texture.texture_data, new_texture.num_components, num_pixels, rgba_data.data());
+            texture.set_sub_image(rgba_data.data(), {0, 0}, dimensions, GL_RGBA, GL_UNSIGNED_BYTE);
+
+            if(is_block_atlas) {
+                set_block_atlas_pixels({dimensions, std::move(rgba_data)});
+            }
         }
+        last_added_texture = texture_name;
 
-        auto dimensions = glm::ivec2{new_texture.width, new_texture.height};
+        profiler::record_stat("texture_upload_bytes", (long long) num_pixels * 4);
 
-        GLenum format = GL_RGB;
-        switch(new_texture.num_components) {
-            case 1:
-                format = GL_RED;
-                break;
-            case 2:
-                format = GL_RG;
-                break;
-            case 3:
-                format = GL_RGB;
-                break;
-            case 4:
-                format = GL_RGBA;
-                break;
-            default:
-                LOG(ERROR) << "Unsupported number of components. You have " << new_texture.num_components
-                           << " components "
-                           << ", but I need a number in [1,4]";
-        }
-
-        texture.set_data(pixel_data.data(), dimensions, format);
-
-        atlases[texture_name] = texture;
+        set_atlas(texture_name, texture);
         LOG(DEBUG) << "Texture atlas " << texture_name << " is OpenGL texture " << texture.get_gl_name();
     }
 
+    void texture_manager::add_sprite(mc_atlas_texture &new_sprite) {
+        if(new_sprite.num_components < 1 || new_sprite.num_components > 4) {
+            LOG(ERROR) << "Unsupported number of components for sprite " << new_sprite.name << ". You have "
+                       << new_sprite.num_components << " components, but I need a number in [1,4]";
+            return;
+        }
+
+        if(new_sprite.width <= 0 || new_sprite.height <= 0) {
+            LOG(ERROR) << "Sprite " << new_sprite.name << " has no pixels, so there's nothing to put in an atlas";
+            return;
+        }
+
+        pending_sprite sprite;
+        sprite.name = new_sprite.name;
+        sprite.size = {new_sprite.width, new_sprite.height};
+
+        auto num_pixels = (std::size_t) new_sprite.width * new_sprite.height;
+        sprite.pixels.resize(num_pixels * 4);
+        expand_to_rgba8(new_sprite.texture_data, new_sprite.num_components, num_pixels, sprite.pixels.data());
+
+        sprite.is_cutout = is_cutout(sprite.pixels.data(), sprite.size.x, {0, 0, sprite.size.x, sprite.size.y});
+
+        pending_sprites.push_back(std::move(sprite));
+    }
+
+    void texture_manager::finalize_textures() {
+        if(pending_sprites.empty() && !pages_need_reupload) {
+            return;
+        }
+
+        profiler::start("finalize_textures");
+
+        if(!packer) {
+            packer = std::make_unique<atlas_packer>(get_max_texture_size(), 0, 256, ATLAS_ALIGNMENT);
+        }
+
+        std::vector<std::pair<std::string, glm::ivec2>> sprite_sizes;
+        sprite_sizes.reserve(pending_sprites.size());
+        for(const auto& sprite : pending_sprites) {
+            sprite_sizes.emplace_back(sprite.name, sprite.size);
+        }
+
+        for(const auto& sprite_name : packer->add_all(sprite_sizes)) {
+            LOG(ERROR) << "Sprite " << sprite_name << " is bigger than the biggest texture your GPU supports, so it can't go in an atlas";
+        }
+
+        // Grow the CPU copies of the pages to match the packer. Growing never moves a sprite, so the old rows can be
+        // copied over as-is
+        page_pixels.resize(packer->get_num_pages());
+        std::vector<bool> page_needs_full_upload(page_pixels.size(), false);
+        for(std::size_t i = 0; i < page_pixels.size(); i++) {
+            auto& page = page_pixels[i].image;
+            glm::ivec2 new_size = packer->get_page(i).get_size();
+            if(page.size == new_size) {
+                continue;
+            }
+
+            std::vector<std::uint8_t> new_pixels((std::size_t) new_size.x * new_size.y * 4, 0);
+            for(int y = 0; y < page.size.y; y++) {
+                std::copy_n(page.pixels.begin() + (std::size_t) y * page.size.x * 4, (std::size_t) page.size.x * 4,
+                            new_pixels.begin() + (std::size_t) y * new_size.x * 4);
+            }
+
+            page.size = new_size;
+            page.pixels = std::move(new_pixels);
+            page_needs_full_upload[i] = true;
+        }
+
+        if(pages_need_reupload) {
+            std::fill(page_needs_full_upload.begin(), page_needs_full_upload.end(), true);
+            pages_need_reupload = false;
+        }
+
+        std::vector<bool> page_has_new_sprites(page_pixels.size(), false);
+        std::vector<const packed_sprite*> sprites_to_upload;
+        for(const auto& sprite : pending_sprites) {
+            if(!packer->contains(sprite.name)) {
+                continue;
+            }
+
+            const auto& location = packer->get_sprite(sprite.name);
+            copy_sprite_to_page(sprite, location, page_pixels[location.page]);
+            page_has_new_sprites[location.page] = true;
+            sprites_to_upload.push_back(&location);
+        }
+
+        long long num_bytes_uploaded = 0;
+        for(std::size_t i = 0; i < page_pixels.size(); i++) {
+            if(!page_has_new_sprites[i] && !page_needs_full_upload[i]) {
+                continue;
+            }
+
+            const auto& page = page_pixels[i];
+            int num_levels = std::min(get_num_mip_levels(page.image.size), (int) ATLAS_MIP_LEVELS);
+
+            std::vector<mip_tile> tiles;
+            tiles.reserve(page.tiles.size());
+            for(const auto& tile : page.tiles) {
+                tiles.push_back(tile.second);
+            }
+
+            auto& texture = get_or_add_atlas(get_atlas_page_name(i));
+            if(page_needs_full_upload[i]) {
+                // The page is new, got bigger, or changed format, so it needs new storage
+                texture.set_name(get_atlas_page_name(i));
+                texture.set_storage(page.image.size, get_gl_internal_format(atlas_compression), num_levels);
+                set_atlas_filtering(texture, num_levels);
+
+                num_bytes_uploaded += upload_atlas_page(texture, page.image, tiles, num_levels);
+
+                LOG(DEBUG) << "Atlas " << texture.get_name() << " is now " << page.image.size.x << "x" << page.image.size.y
+                           << " with " << num_levels << " mip levels, and OpenGL texture " << texture.get_gl_name();
+                continue;
+            }
+
+            auto mip_levels = generate_mip_chain(page.image, num_levels, tiles, ALPHA_TEST_THRESHOLD, texture_workers);
+
+            // Cells are aligned to the smallest mip level, so each new sprite's cell can be uploaded on its own in
+            // every level without touching its neighbours
+            for(const auto* sprite : sprites_to_upload) {
+                if(sprite->page != i) {
+                    continue;
+                }
+
+                for(int level = 0; level < num_levels; level++) {
+                    const rgba8_image &image = level == 0 ? page.image : mip_levels[level - 1];
+                    glm::ivec2 offset = {sprite->cell.x >> level, sprite->cell.y >> level};
+                    glm::ivec2 size = {sprite->cell.width >> level, sprite->cell.height >> level};
+                    num_bytes_uploaded += upload_atlas_region(texture, image, offset, size, level);
+                }
+            }
+        }
+
+        // A page that grew changes the UVs of everything in it, so it's easiest to just update every location
+        for(const auto& sprite : packer->get_sprites()) {
+            texture_location location;
+            packer->get_uv_bounds(sprite.first, location.min, location.max);
+            location.atlas = get_atlas_page_name(sprite.second.page);
+            locations[sprite.first] = location;
+        }
+
+        LOG(INFO) << "Packed " << pending_sprites.size() << " sprites. Nova's atlases now hold "
+                  << packer->get_sprites().size() << " sprites in " << packer->get_num_pages() << " page(s), "
+                  << packer->get_occupancy() * 100 << "% full";
+
+        profiler::record_stat("texture_upload_bytes", num_bytes_uploaded);
+        pending_sprites.clear();
+
+        profiler::end("finalize_textures");
+    }
+
+    void texture_manager::copy_sprite_to_page(const pending_sprite &sprite, const packed_sprite &location, atlas_page_pixels &page) {
+        auto& image = page.image;
+        const atlas_rect &cell = location.cell;
+
+        // Every pixel of the cell outside the sprite takes the value of the closest pixel in the sprite, like
+        // GL_CLAMP_TO_EDGE would. That keeps the edges of the sprite from fading into black in the mip levels
+        for(int y = cell.y; y < cell.y + cell.height; y++) {
+            int src_y = std::min(std::max(y - location.position.y, 0), sprite.size.y - 1);
+            const std::uint8_t *src_row = sprite.pixels.data() + (std::size_t) src_y * sprite.size.x * 4;
+            std::uint8_t *dst_row = image.pixels.data() + (std::size_t) y * image.size.x * 4;
+
+            for(int x = cell.x; x < location.position.x; x++) {
+                std::memcpy(dst_row + x * 4, src_row, 4);
+            }
+
+            std::memcpy(dst_row + location.position.x * 4, src_row, (std::size_t) sprite.size.x * 4);
+
+            for(int x = location.position.x + sprite.size.x; x < cell.x + cell.width; x++) {
+                std::memcpy(dst_row + x * 4, src_row + (sprite.size.x - 1) * 4, 4);
+            }
+        }
+
+        page.tiles[sprite.name] = {cell, sprite.is_cutout};
+    }
+
+    void texture_manager::set_atlas_compression(texture_compression compression) {
+        bool has_s3tc = GLAD_GL_EXT_texture_compression_s3tc != 0;
+        if((compression == texture_compression::bc1 || compression == texture_compression::bc3) && !has_s3tc) {
+            LOG(WARNING) << "Your GPU doesn't support BC1 or BC3, so Nova's atlases will use BC7 instead";
+            compression = texture_compression::bc7;
+        }
+
+        if(compression == atlas_compression) {
+            return;
+        }
+
+        atlas_compression = compression;
+        if(!page_pixels.empty()) {
+            pages_need_reupload = true;
+            finalize_textures();
+        }
+    }
+
+    long long texture_manager::upload_atlas_page(texture2D &atlas, const rgba8_image &base, const std::vector<mip_tile> &tiles,
+                                                 int num_levels) {
+        std::vector<std::size_t> level_sizes;
+        for(int level = 0; level < num_levels; level++) {
+            level_sizes.push_back(get_atlas_level_size(get_mip_size(base.size, level)));
+        }
+
+        long long num_bytes_uploaded = 0;
+        auto key = texture_cache::get_key(base, tiles, num_levels, ALPHA_TEST_THRESHOLD, atlas_compression);
+        auto cached = processed_texture_cache.load(key, level_sizes);
+        if(cached) {
+            for(int level = 0; level < num_levels; level++) {
+                num_bytes_uploaded += upload_atlas_level(atlas, cached->get_level_data(level), cached->get_level_size(level),
+                                                         get_mip_size(base.size, level), level);
+            }
+
+            LOG(DEBUG) << "Uploaded atlas " << atlas.get_name() << " from the texture cache";
+            return num_bytes_uploaded;
+        }
+
+        auto mip_levels = generate_mip_chain(base, num_levels, tiles, ALPHA_TEST_THRESHOLD, texture_workers);
+
+        // Uncompressed levels go to the GPU and the cache as they are. Compressed ones are kept here until they've
+        // been written out
+        std::vector<std::vector<std::uint8_t>> compressed_levels;
+        compressed_levels.reserve((std::size_t) num_levels);
+        std::vector<std::pair<const std::uint8_t*, std::size_t>> levels;
+        for(int level = 0; level < num_levels; level++) {
+            const rgba8_image &image = level == 0 ? base : mip_levels[level - 1];
+            if(atlas_compression == texture_compression::none) {
+                levels.emplace_back(image.pixels.data(), image.pixels.size());
+            } else {
+                compressed_levels.push_back(compress_image(image, atlas_compression, texture_workers));
+                levels.emplace_back(compressed_levels.back().data(), compressed_levels.back().size());
+            }
+
+            num_bytes_uploaded += upload_atlas_level(atlas, levels.back().first, levels.back().second, image.size, level);
+        }
+
+        processed_texture_cache.store(key, levels);
+        return num_bytes_uploaded;
+    }
+
+    long long texture_manager::upload_atlas_level(texture2D &atlas, const std::uint8_t* data, std::size_t num_bytes,
+                                                  glm::ivec2 size, int level) {
+        if(atlas_compression == texture_compression::none) {
+            atlas.set_sub_image(data, {0, 0}, size, GL_RGBA, GL_UNSIGNED_BYTE, level);
+        } else {
+            atlas.set_compressed_sub_image(data, {0, 0}, size, get_gl_internal_format(atlas_compression), (GLsizei) num_bytes, level);
+        }
+
+        return (long long) num_bytes;
+    }
+
+    std::size_t texture_manager::get_atlas_level_size(glm::ivec2 size) const {
+        if(atlas_compression == texture_compression::none) {
+            return (std::size_t) size.x * size.y * 4;
+        }
+
+        return get_compressed_size(size, atlas_compression);
+    }
+
+    long long texture_manager::upload_atlas_region(texture2D &atlas, const rgba8_image &image, glm::ivec2 offset,
+                                                   glm::ivec2 size, int level) {
+        if(atlas_compression == texture_compression::none) {
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, image.size.x);
+            auto first_pixel = image.pixels.data() + ((std::size_t) offset.y * image.size.x + offset.x) * 4;
+            atlas.set_sub_image(first_pixel, offset, size, GL_RGBA, GL_UNSIGNED_BYTE, level);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+            return (long long) size.x * size.y * 4;
+        }
+
+        // In the smallest levels a cell is smaller than a block, so the block holds bits of the neighbouring cells
+        // too. Those are already in the image, so compressing them again just gives back the same blocks
+        atlas_rect blocks = {offset.x / 4, offset.y / 4, 0, 0};
+        blocks.width = (offset.x + size.x + 3) / 4 - blocks.x;
+        blocks.height = (offset.y + size.y + 3) / 4 - blocks.y;
+
+        std::vector<std::uint8_t> compressed((std::size_t) blocks.width * blocks.height * get_bytes_per_block(atlas_compression));
+        compress_blocks(image, atlas_compression, blocks, compressed.data(), texture_workers);
+
+        // Blocks that hang off the edge of a small mip level are uploaded with the level's real size
+        glm::ivec2 texel_offset = {blocks.x * 4, blocks.y * 4};
+        glm::ivec2 texel_size = {std::min(blocks.width * 4, image.size.x - texel_offset.x),
+                                 std::min(blocks.height * 4, image.size.y - texel_offset.y)};
+        atlas.set_compressed_sub_image(compressed.data(), texel_offset, texel_size, get_gl_internal_format(atlas_compression),
+                                       (GLsizei) compressed.size(), level);
+        return (long long) compressed.size();
+    }
+
+    void texture_manager::set_atlas_filtering(texture2D &atlas, int num_levels) {
+        // Blocky up close like Minecraft, but blended between mip levels so there's no visible line where the level
+        // changes
+        texture_filtering_params params;
+        params.texture_upsample_filter = texture_filtering_params::POINT;
+        params.texture_downsample_filter = texture_filtering_params::POINT;
+        params.num_mipmap_levels = num_levels;
+        params.anisotropic_level = 1;
+        atlas.set_filtering_parameters(params);
+    }
+
+    void texture_manager::set_atlas_filtering(texture2D_array &atlas, int num_levels) {
+        // Same as the atlases. Layers can't bleed into each other, so there's no reason to filter them differently
+        texture_filtering_params params;
+        params.texture_upsample_filter = texture_filtering_params::POINT;
+        params.texture_downsample_filter = texture_filtering_params::POINT;
+        params.num_mipmap_levels = num_levels;
+        params.anisotropic_level = 1;
+        atlas.set_filtering_parameters(params);
+    }
+
+    std::string texture_manager::get_atlas_page_name(std::size_t page) {
+        return "nova_atlas_" + std::to_string(page);
+    }
+
+    void texture_manager::add_texture_async(texture_upload_request request) {
+        LOG(INFO) << "Streaming texture " << request.name << " (" << request.width << "x" << request.height << ")";
+        if(request.num_components < 1 || request.num_components > 4) {
+            LOG(ERROR) << "Unsupported number of components. You have " << request.num_components
+                       << " components, but I need a number in [1,4]";
+            return;
+        }
+
+        // The locations that Minecraft sends next are in this texture, even though it won't be on the GPU for a while
+        last_added_texture = request.name;
+        if(request.name == BLOCK_ATLAS_NAME) {
+            // The streamer only hands back the OpenGL texture, so the CPU copy has to be taken before it gets the data
+            auto num_pixels = (std::size_t) request.width * request.height;
+            std::vector<std::uint8_t> rgba_data(num_pixels * 4);
+            expand_to_rgba8(request.data.data(), request.num_components, num_pixels, rgba_data.data());
+            set_block_atlas_pixels({{request.width, request.height}, std::move(rgba_data)});
+        }
+
+        if(!streamer) {
+            streamer = std::make_unique<texture_streamer>();
+        }
+
+        streamer->enqueue(std::move(request));
+    }
+
+    void texture_manager::set_block_atlas_pixels(rgba8_image pixels) {
+        // Kept so the block texture array can be made from it, even if that's not turned on yet
+        block_layers.reset(pixels.size);
+        block_atlas_pixels = std::move(pixels);
+        block_layers_changed = true;
+    }
+
+    void texture_manager::upload_streamed_textures() {
+        if(!streamer) {
+            return;
+        }
+
+        for(auto& texture : streamer->upload()) {
+            LOG(DEBUG) << "Texture atlas " << texture.get_name() << " finished streaming as OpenGL texture " << texture.get_gl_name();
+            set_atlas(texture.get_name(), texture);
+        }
+    }
+
     void texture_manager::add_texture_location(mc_texture_atlas_location &location) {
         texture_location tex_loc = {
                 { location.min_u, location.min_v },
@@ -91,6 +514,99 @@ namespace nova {
         };
 
         locations[location.name] = tex_loc;
+
+        if(last_added_texture == BLOCK_ATLAS_NAME) {
+            block_layers.add_sprite(location.name, tex_loc.min, tex_loc.max);
+            block_layers_changed = true;
+        }
+    }
+
+    void texture_manager::set_block_texture_mode(block_texture_mode mode) {
+        if(mode == block_mode) {
+            return;
+        }
+
+        block_mode = mode;
+        block_layers_changed = true;
+        LOG(INFO) << "Block textures now come from " << (mode == block_texture_mode::array ? "a texture array" : "the block atlas");
+    }
+
+    void texture_manager::update_block_texture_array() {
+        if(!block_layers_changed || block_mode != block_texture_mode::array || block_layers.empty()) {
+            return;
+        }
+
+        block_layers_changed = false;
+        int num_layers = block_layers.get_num_layers();
+        if(num_layers > get_max_array_texture_layers()) {
+            LOG(WARNING) << "The block atlas has " << num_layers << " sprites, but a texture array can only have "
+                         << get_max_array_texture_layers() << " layers here, so blocks will use the block atlas instead";
+            set_block_texture_mode(block_texture_mode::atlas);
+            return;
+        }
+
+        profiler::start("update_block_texture_array");
+
+        std::vector<mip_tile> tiles;
+        rgba8_image layers = block_layers.make_layers(block_atlas_pixels, tiles);
+        glm::ivec2 layer_size = block_layers.get_layer_size();
+
+        // Mip levels only go as far as the smaller side of a layer, so that no level of one layer ends up sharing a
+        // row with the layer after it
+        int num_levels = get_num_mip_levels(glm::ivec2(std::min(layer_size.x, layer_size.y)));
+
+        auto& array = get_or_add_texture_array(BLOCK_ARRAY_NAME);
+        array.set_name(BLOCK_ARRAY_NAME);
+        array.set_storage(layer_size, num_layers, GL_RGBA8, num_levels);
+        set_atlas_filtering(array, num_levels);
+
+        // The layers are stacked on top of each other, so each level of the array is just a level of the stack
+        std::vector<std::size_t> level_sizes;
+        for(int level = 0; level < num_levels; level++) {
+            glm::ivec2 level_size = get_mip_size(layers.size, level);
+            level_sizes.push_back((std::size_t) level_size.x * level_size.y * 4);
+        }
+
+        long long num_bytes_uploaded = 0;
+        auto key = texture_cache::get_key(layers, tiles, num_levels, ALPHA_TEST_THRESHOLD, texture_compression::none);
+        auto cached = processed_texture_cache.load(key, level_sizes);
+        if(cached) {
+            for(int level = 0; level < num_levels; level++) {
+                array.set_layers(cached->get_level_data(level), 0, num_layers, get_mip_size(layer_size, level), GL_RGBA, GL_UNSIGNED_BYTE, level);
+                num_bytes_uploaded += (long long) cached->get_level_size(level);
+            }
+
+        } else {
+            auto mip_levels = generate_mip_chain(layers, num_levels, tiles, ALPHA_TEST_THRESHOLD, texture_workers);
+
+            std::vector<std::pair<const std::uint8_t*, std::size_t>> levels;
+            for(int level = 0; level < num_levels; level++) {
+                const rgba8_image &image = level == 0 ? layers : mip_levels[level - 1];
+                array.set_layers(image.pixels.data(), 0, num_layers, get_mip_size(layer_size, level), GL_RGBA, GL_UNSIGNED_BYTE, level);
+                levels.emplace_back(image.pixels.data(), image.pixels.size());
+                num_bytes_uploaded += (long long) image.pixels.size();
+            }
+
+            processed_texture_cache.store(key, levels);
+        }
+
+        LOG(INFO) << "Split the block atlas into " << num_layers << " layers of " << layer_size.x << "x" << layer_size.y
+                  << " with " << num_levels << " mip levels, in OpenGL texture " << array.get_gl_name();
+        profiler::record_stat("texture_upload_bytes", num_bytes_uploaded);
+        profiler::end("update_block_texture_array");
+    }
+
+    const block_layer_table* texture_manager::get_block_layers() const {
+        if(block_mode != block_texture_mode::array || texture_arrays.find(BLOCK_ARRAY_NAME) == texture_arrays.end()) {
+            return nullptr;
+        }
+
+        return &block_layers;
+    }
+
+    texture2D_array* texture_manager::get_texture_array(const std::string &texture_name) {
+        auto array = texture_arrays.find(texture_name);
+        return array == texture_arrays.end() ? nullptr : &array->second;
     }
 
 
@@ -98,8 +614,9 @@ namespace nova {
         // If we haven't explicitly added a texture location for this texture, let's just assume that the texture isn't
         // in an atlas and thus covers the whole (0 - 1) UV space
 
-        if(locations.find(texture_name) != locations.end()) {
-            return locations[texture_name];
+        auto location = locations.find(texture_name);
+        if(location != locations.end()) {
+            return location->second;
 
         } else {
             return {{0, 0}, {1, 1}};
@@ -107,7 +624,84 @@ namespace nova {
     }
 
     texture2D &texture_manager::get_texture(std::string texture_name) {
-        return atlases[texture_name];
+        auto texture = atlases.find(texture_name);
+        if(texture == atlases.end()) {
+            return placeholder;
+        }
+
+        return texture->second;
+    }
+
+    texture_handle texture_manager::get_texture_handle(const std::string &texture_name) {
+        auto handle = handles.find(texture_name);
+        if(handle != handles.end()) {
+            return handle->second;
+        }
+
+        auto texture = atlases.find(texture_name);
+        auto array = texture_arrays.find(texture_name);
+        slots.push_back({texture_name,
+                         texture == atlases.end() ? nullptr : &texture->second,
+                         array == texture_arrays.end() ? nullptr : &array->second});
+
+        auto new_handle = (texture_handle) (slots.size() - 1);
+        handles[texture_name] = new_handle;
+        return new_handle;
+    }
+
+    texture2D &texture_manager::get_texture(texture_handle handle) {
+        texture2D* texture = slots[handle].texture;
+        return texture ? *texture : placeholder;
+    }
+
+    texture2D_array* texture_manager::get_texture_array(texture_handle handle) {
+        return slots[handle].array;
+    }
+
+    texture2D &texture_manager::get_or_add_atlas(const std::string &texture_name) {
+        auto atlas = atlases.find(texture_name);
+        if(atlas != atlases.end()) {
+            return atlas->second;
+        }
+
+        return add_atlas(texture_name, texture2D());
+    }
+
+    void texture_manager::set_atlas(const std::string &texture_name, const texture2D &texture) {
+        auto atlas = atlases.find(texture_name);
+        if(atlas == atlases.end()) {
+            add_atlas(texture_name, texture);
+            return;
+        }
+
+        // The handle already points at this atlas, so only the OpenGL texture changes
+        glDeleteTextures(1, &atlas->second.get_gl_name());
+        atlas->second = texture;
+    }
+
+    texture2D &texture_manager::add_atlas(const std::string &texture_name, const texture2D &texture) {
+        auto& new_atlas = atlases.emplace(texture_name, texture).first->second;
+        auto handle = handles.find(texture_name);
+        if(handle != handles.end()) {
+            slots[handle->second].texture = &new_atlas;
+        }
+
+        return new_atlas;
+    }
+
+    texture2D_array &texture_manager::get_or_add_texture_array(const std::string &texture_name) {
+        auto array = texture_arrays.find(texture_name);
+        if(array != texture_arrays.end()) {
+            return array->second;
+        }
+
+        auto& new_array = texture_arrays[texture_name];
+        auto handle = handles.find(texture_name);
+        if(handle != handles.end()) {
+            slots[handle->second].array = &new_array;
+        }
+
+        return new_array;
     }
 
     int texture_manager::get_max_texture_size() {
@@ -118,4 +712,13 @@ namespace nova {
         }
         return max_texture_size;
     }
+
+    int texture_manager::get_max_array_texture_layers() {
+        if(max_array_texture_layers < 0) {
+            glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_array_texture_layers);
+
+            LOG(DEBUG) << "max array texture layers reported by gpu: " << max_array_texture_layers;
+        }
+        return max_array_texture_layers;
+    }
 }
@@ -6,15 +6,50 @@
 #ifndef RENDERER_TEXTURE_RECEIVER_H
 #define RENDERER_TEXTURE_RECEIVER_H
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include "../../../mc_interface/mc_objects.h"
 #include "texture2D.h"
+#include "texture2D_array.h"
+#include "block_layer_table.h"
+#include "texture_streamer.h"
+#include "atlas_packer.h"
+#include "mipmap_generator.h"
+#include "block_compression.h"
+#include "texture_cache.h"
+#include "../../../utils/thread_pool.h"
 #include "../../../utils/smart_enum.h"
 
 namespace nova {
+    /*!
+     * \brief How block textures get to the shaders
+     */
+    enum class block_texture_mode {
+        atlas,  //!< Minecraft's block atlas, as-is
+        array,  //!< Every block texture in its own layer of a texture array. Shaders sample it with a sampler2DArray
+    };
+
+    block_texture_mode block_texture_mode_from_string(const std::string &name);
+
+    /*!
+     * \brief A texture that's been looked up by name once, so that it can be found again without hashing anything
+     *
+     * Handles stay valid for as long as the texture manager does. If the texture a handle names hasn't been loaded
+     * yet, or was thrown away by #texture_manager::reset, the handle leads to the placeholder texture until a texture
+     * with that name comes back
+     */
+    typedef std::uint32_t texture_handle;
+
+    /*!
+     * \brief The handle for no texture at all. It always leads to the placeholder texture
+     */
+    const texture_handle NO_TEXTURE = 0;
+
     /*!
      * \brief Holds all the textures that the Nova Renderer can deal with
      *
@@ -47,14 +82,26 @@ namespace nova {
          *
          * The name of the texture in the atlas is used as a key in a hash map
          *
-         * The exact atlas is not identified here. That's because I expect the caller to know what kind of texture they
-         * have. if you're making the terrain, you know you need the terrain texture.
+         * Locations that Minecraft sent over don't say which atlas they're in. That's because I expect the caller to
+         * know what kind of texture they have. if you're making the terrain, you know you need the terrain texture.
+         * Sprites that Nova packed itself do know their atlas, since there's no other way to find it
          */
         struct texture_location {
             glm::vec2 min;     //!< The minimum UV coordinate of the requested texture in its atlas
             glm::vec2 max;     //!< The maximum UV coordinate of the requested texture in its atlas
+            std::string atlas; //!< The name of the atlas the texture is in, or empty if Minecraft made the atlas
         };
 
+        /*!
+         * \brief The name Minecraft gives its block atlas
+         */
+        static const std::string BLOCK_ATLAS_NAME;
+
+        /*!
+         * \brief The name of the texture array that the block atlas is split into
+         */
+        static const std::string BLOCK_ARRAY_NAME;
+
         /*!
          * \brief Initializes the texture_manager. Doesn't do anything special.
          *
@@ -88,6 +135,18 @@ namespace nova {
          */
         void update_texture(std::string texture_name, void* data, glm::ivec2 &size, GLenum format, GLenum type = GL_FLOAT, GLenum internal_format = GL_RGBA);
 
+        /*!
+         * \brief Sends Minecraft's lightmap to the GPU
+         *
+         * Minecraft sends the lightmap every tick, but it's usually the same as last time, so nothing is uploaded
+         * unless the data actually changed. The texture is only allocated when the lightmap changes size, which in
+         * practice means once
+         *
+         * \param data The lightmap, as BGRA8
+         * \param size The size of the lightmap, usually 16x16
+         */
+        void update_lightmap(const void* data, glm::ivec2 size);
+
         /*!
          * \brief Adds a texture to this resource manager
          *
@@ -98,6 +157,81 @@ namespace nova {
          */
         void add_texture(mc_atlas_texture &new_texture);
 
+        /*!
+         * \brief Adds a single sprite to be packed into one of Nova's own atlases
+         *
+         * Nothing is packed or uploaded until #finalize_textures is called, so that a whole resource pack's worth of
+         * sprites can be packed in one go
+         *
+         * \param new_sprite The sprite to add. Its name is what get_texture_location will know it by
+         */
+        void add_sprite(mc_atlas_texture &new_sprite);
+
+        /*!
+         * \brief Packs every sprite added since the last call into atlases and uploads them
+         *
+         * Sprites that were packed before stay where they are. Only the new sprites are copied to the GPU, unless an
+         * atlas had to grow to make room for them, in which case the whole atlas is uploaded again and the UVs of
+         * everything in it are updated
+         *
+         * The mip levels of every atlas that got new sprites are made on the CPU, spread across the texture workers.
+         * If the atlases are compressed, that happens on the texture workers too
+         */
+        void finalize_textures();
+
+        /*!
+         * \brief Sets the format that Nova's atlases are kept in on the GPU
+         *
+         * Atlases that already exist are uploaded again in the new format straight away.
+         * BC1 and BC3 need EXT_texture_compression_s3tc, and if that's missing BC7 is used instead
+         */
+        void set_atlas_compression(texture_compression compression);
+
+        /*!
+         * \brief Picks between the block atlas and the block texture array
+         *
+         * Either way the block atlas is uploaded as normal, since other things use it too. Chunks that were already
+         * uploaded stay how they were until Minecraft sends them again
+         */
+        void set_block_texture_mode(block_texture_mode mode);
+
+        /*!
+         * \brief Splits the block atlas into the block texture array, if the block atlas or its sprites changed since
+         * last time and the block texture mode is array
+         *
+         * Minecraft never says when it's done sending sprite locations, so call this once a frame before any chunks
+         * are uploaded. If there are more sprites than get_max_array_texture_layers, the block texture mode goes back
+         * to atlas
+         */
+        void update_block_texture_array();
+
+        /*!
+         * \brief The layers of the block texture array, or nullptr if chunks should use the block atlas
+         */
+        const block_layer_table* get_block_layers() const;
+
+        /*!
+         * \brief Returns the texture array with the given name, or nullptr if there isn't one
+         */
+        texture2D_array* get_texture_array(const std::string &texture_name);
+
+        /*!
+         * \brief Adds a texture without blocking the current frame
+         *
+         * The texture is converted on a worker thread and uploaded a bit at a time by upload_streamed_textures. Until
+         * it's done, get_texture returns a placeholder for it
+         *
+         * \param request The texture to add
+         */
+        void add_texture_async(texture_upload_request request);
+
+        /*!
+         * \brief Sends the next part of any streaming textures to the GPU, and swaps in the ones that are done
+         *
+         * Call this once a frame
+         */
+        void upload_streamed_textures();
+
         /*!
          * \brief Adds the given texture location to the list of texture locations
          *
@@ -117,11 +251,32 @@ namespace nova {
         /*!
          * \brief Returns a pointer to the specified atlas
          *
+         * If there's no texture with that name, perhaps because it's still streaming in, you get a 1x1 white
+         * placeholder texture instead
+         *
          * \param texture_name The name of the texture to get
          * \return A pointer to the atlas texture
          */
         texture2D &get_texture(std::string texture_name);
 
+        /*!
+         * \brief Finds the handle for the texture or texture array with the given name
+         *
+         * This hashes the name, so do it once when something is created rather than every time it's drawn. The
+         * texture doesn't need to exist yet, and asking for one that doesn't won't make one
+         */
+        texture_handle get_texture_handle(const std::string &texture_name);
+
+        /*!
+         * \brief Returns the texture that a handle leads to, or the 1x1 white placeholder if there isn't one
+         */
+        texture2D &get_texture(texture_handle handle);
+
+        /*!
+         * \brief Returns the texture array that a handle leads to, or nullptr if it doesn't lead to a texture array
+         */
+        texture2D_array* get_texture_array(texture_handle handle);
+
         /*!
          * \brief Returns the maximum texture size supported by OpenGL on the current platform
          *
@@ -131,16 +286,209 @@ namespace nova {
          */
         int get_max_texture_size();
 
+        /*!
+         * \brief Returns the most layers a texture array can have on the current platform
+         *
+         * OpenGL only promises 2048, which is fewer than some resource packs have block sprites
+         */
+        int get_max_array_texture_layers();
+
     private:
         std::unordered_map<std::string, texture2D> atlases;
 
+        std::unordered_map<std::string, texture2D_array> texture_arrays;
+
         /*!
          * \brief A map from the name of a texture according to Minecraft and the UV coordinates it takes up in its
          * texture atlas
          */
         std::unordered_map<std::string, texture_location> locations;
 
+        texture2D placeholder;
+
+        /*!
+         * \brief Where the texture with a handle's name lives right now
+         *
+         * Elements of an unordered_map don't move when it grows, so the pointers are only changed when a texture is
+         * added or the maps are cleared
+         */
+        struct texture_slot {
+            std::string name;
+            texture2D* texture;
+            texture2D_array* array;
+        };
+
+        /*!
+         * \brief Indexed by texture_handle. Slots are never removed, so a handle is good forever. Slot 0 is NO_TEXTURE
+         */
+        std::vector<texture_slot> slots;
+
+        std::unordered_map<std::string, texture_handle> handles;
+
+        /*!
+         * \brief A hash of the lightmap that's on the GPU, so the same lightmap isn't uploaded twice
+         */
+        std::uint64_t lightmap_hash = 0;
+
+        /*!
+         * \brief Made the first time someone streams a texture, since it needs an OpenGL context
+         */
+        std::unique_ptr<texture_streamer> streamer;
+
         int max_texture_size = -1;
+
+        int max_array_texture_layers = -1;
+
+        /*!
+         * \brief The number of mip levels in Nova's atlases. Five levels takes a 16x16 block texture down to 1x1,
+         * which is as far as Minecraft goes
+         */
+        static const int ATLAS_MIP_LEVELS = 5;
+
+        /*!
+         * \brief Every sprite's cell in an atlas is a multiple of this, so that no texel in any mip level has more
+         * than one sprite in it. Any space left over in a cell is filled with the sprite's edge pixels
+         */
+        static const int ATLAS_ALIGNMENT = 1 << (ATLAS_MIP_LEVELS - 1);
+
+        /*!
+         * \brief Minecraft's alpha test throws away anything with an alpha of 0.1 or less
+         */
+        static const std::uint8_t ALPHA_TEST_THRESHOLD = 26;
+
+        struct pending_sprite {
+            std::string name;
+            glm::ivec2 size;
+            std::vector<std::uint8_t> pixels;
+
+            /*!
+             * \brief True if every texel is either fully opaque or fully transparent, like leaves and flowers are.
+             * Those keep their alpha coverage in the smaller mip levels. Translucent things like glass don't
+             */
+            bool is_cutout;
+        };
+
+        /*!
+         * \brief The CPU copy of one of Nova's atlases. It's kept around so a page can be re-uploaded when it grows
+         */
+        struct atlas_page_pixels {
+            rgba8_image image;
+
+            /*!
+             * \brief Every sprite in the page, by name, for the mipmap generator
+             */
+            std::unordered_map<std::string, mip_tile> tiles;
+        };
+
+        std::vector<pending_sprite> pending_sprites;
+
+        /*!
+         * \brief Made the first time someone finalizes textures, since it needs the max texture size
+         */
+        std::unique_ptr<atlas_packer> packer;
+
+        std::vector<atlas_page_pixels> page_pixels;
+
+        /*!
+         * \brief Threads for the CPU side of making textures, like mipmapping
+         */
+        thread_pool texture_workers;
+
+        texture_compression atlas_compression = texture_compression::none;
+
+        /*!
+         * \brief Set when the atlas compression changes, so that #finalize_textures re-uploads every page
+         */
+        bool pages_need_reupload = false;
+
+        block_texture_mode block_mode = block_texture_mode::atlas;
+
+        /*!
+         * \brief The name of the last texture given to #add_texture or #add_texture_async. The texture locations that
+         * come after it are in that texture
+         */
+        std::string last_added_texture;
+
+        /*!
+         * \brief A CPU copy of Minecraft's block atlas, for splitting into layers
+         */
+        rgba8_image block_atlas_pixels;
+
+        block_layer_table block_layers;
+
+        /*!
+         * \brief Set when the block atlas or its sprites change, so that #update_block_texture_array knows to do
+         * something
+         */
+        bool block_layers_changed = false;
+
+        /*!
+         * \brief Whole pages and texture arrays from last time, mipped and compressed, so the same resource packs
+         * don't get processed again
+         */
+        texture_cache processed_texture_cache;
+
+        /*!
+         * \brief Finds the atlas with the given name, or makes an empty one and points its handle at it
+         *
+         * Atlases and texture arrays should only ever be added through this, set_atlas and get_or_add_texture_array,
+         * so that no handle is left pointing at the placeholder
+         */
+        texture2D &get_or_add_atlas(const std::string &texture_name);
+
+        /*!
+         * \brief Puts a finished texture in as the atlas with the given name, deleting the OpenGL texture of the atlas
+         * it replaces
+         */
+        void set_atlas(const std::string &texture_name, const texture2D &texture);
+
+        /*!
+         * \brief Adds an atlas that isn't there yet and points its handle at it
+         */
+        texture2D &add_atlas(const std::string &texture_name, const texture2D &texture);
+
+        texture2D_array &get_or_add_texture_array(const std::string &texture_name);
+
+        void copy_sprite_to_page(const pending_sprite &sprite, const packed_sprite &location, atlas_page_pixels &page);
+
+        /*!
+         * \brief Uploads every mip level of an atlas page, straight from the texture cache if it's there. If it's not,
+         * the mip chain is made and compressed and then put in the cache for next time
+         *
+         * \return The number of bytes sent to the GPU
+         */
+        long long upload_atlas_page(texture2D &atlas, const rgba8_image &base, const std::vector<mip_tile> &tiles, int num_levels);
+
+        /*!
+         * \brief Uploads a whole mip level of an atlas that's already in the atlas format
+         *
+         * \return The number of bytes sent to the GPU
+         */
+        long long upload_atlas_level(texture2D &atlas, const std::uint8_t* data, std::size_t num_bytes, glm::ivec2 size, int level);
+
+        /*!
+         * \brief How many bytes a mip level of the given size takes up in the atlas format
+         */
+        std::size_t get_atlas_level_size(glm::ivec2 size) const;
+
+        /*!
+         * \brief Uploads part of a mip level of an atlas. With compression the region is grown out to whole blocks,
+         * and only those blocks are compressed
+         *
+         * \return The number of bytes sent to the GPU
+         */
+        long long upload_atlas_region(texture2D &atlas, const rgba8_image &image, glm::ivec2 offset, glm::ivec2 size, int level);
+
+        static void set_atlas_filtering(texture2D &atlas, int num_levels);
+
+        static void set_atlas_filtering(texture2D_array &atlas, int num_levels);
+
+        /*!
+         * \brief Keeps a copy of Minecraft's block atlas and forgets its old sprites, ready for the new ones
+         */
+        void set_block_atlas_pixels(rgba8_image pixels);
+
+        static std::string get_atlas_page_name(std::size_t page);
     };
 }
 
@@ -0,0 +1,331 @@
+/*!
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <algorithm>
+#include <easylogging++.h>
+#include "texture_streamer.h"
+#include "pixel_conversion.h"
+#include "../../../utils/profiler.h"
+
+namespace nova {
+    /*!
+     * \brief The most bytes that the worker puts in a single slice. Smaller slices mean the per-frame budget can be
+     * followed more closely, bigger slices mean fewer GL calls
+     */
+    static const std::size_t MAX_SLICE_BYTES = 2 * 1024 * 1024;
+
+    upload_ring::upload_ring(std::size_t capacity) : capacity(capacity) {}
+
+    bool upload_ring::allocate(std::size_t num_bytes, std::size_t &offset) {
+        if(num_bytes > capacity) {
+            return false;
+        }
+
+        if(allocations.empty()) {
+            head = 0;
+            offset = 0;
+
+        } else {
+            std::size_t tail = allocations.front().offset;
+
+            if(head > tail) {
+                // The free space is from the head to the end of the ring, then from the start of the ring to the tail
+                if(head + num_bytes <= capacity) {
+                    offset = head;
+                } else if(num_bytes <= tail) {
+                    offset = 0;
+                } else {
+                    return false;
+                }
+
+            } else {
+                // The head has wrapped around, so the only free space is between it and the tail
+                if(head + num_bytes <= tail) {
+                    offset = head;
+                } else {
+                    return false;
+                }
+            }
+        }
+
+        head = offset + num_bytes;
+        allocations.push_back({offset, num_bytes});
+        return true;
+    }
+
+    void upload_ring::free_oldest() {
+        allocations.pop_front();
+    }
+
+    std::size_t upload_ring::get_capacity() const {
+        return capacity;
+    }
+
+    std::size_t upload_ring::get_num_allocations() const {
+        return allocations.size();
+    }
+
+    texture_streamer::texture_streamer(std::size_t ring_size) : ring(ring_size), generation(0), should_stop(false) {
+        const GLbitfield map_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glCreateBuffers(1, &pixel_buffer);
+        glNamedBufferStorage(pixel_buffer, ring_size, nullptr, map_flags);
+        mapped_ring = static_cast<std::uint8_t*>(glMapNamedBufferRange(pixel_buffer, 0, ring_size, map_flags));
+
+        if(mapped_ring == nullptr) {
+            LOG(ERROR) << "Could not map the texture streaming buffer";
+        }
+
+        worker = std::thread(&texture_streamer::run_worker, this);
+    }
+
+    texture_streamer::~texture_streamer() {
+        should_stop = true;
+        {
+            std::lock_guard<std::mutex> lock(requests_lock);
+        }
+        request_added.notify_all();
+        {
+            std::lock_guard<std::mutex> lock(ring_lock);
+        }
+        ring_space_freed.notify_all();
+
+        worker.join();
+
+        for(auto& batch : in_flight_batches) {
+            glDeleteSync(batch.fence);
+            for(auto& texture : batch.finished_textures) {
+                glDeleteTextures(1, &texture.get_gl_name());
+            }
+        }
+
+        for(auto& texture : textures_in_progress) {
+            glDeleteTextures(1, &texture.second.get_gl_name());
+        }
+
+        glUnmapNamedBuffer(pixel_buffer);
+        glDeleteBuffers(1, &pixel_buffer);
+    }
+
+    void texture_streamer::enqueue(texture_upload_request request) {
+        {
+            std::lock_guard<std::mutex> lock(requests_lock);
+            requests.push(std::move(request));
+        }
+        request_added.notify_one();
+    }
+
+    void texture_streamer::run_worker() {
+        while(true) {
+            texture_upload_request request;
+            std::uint64_t request_generation;
+            {
+                std::unique_lock<std::mutex> lock(requests_lock);
+                request_added.wait(lock, [&] { return should_stop || !requests.empty(); });
+                if(should_stop) {
+                    return;
+                }
+
+                request = std::move(requests.front());
+                requests.pop();
+                request_generation = generation;
+                worker_is_busy = true;
+            }
+
+            stage_texture(request, request_generation);
+
+            std::lock_guard<std::mutex> lock(requests_lock);
+            worker_is_busy = false;
+        }
+    }
+
+    void texture_streamer::stage_texture(const texture_upload_request &request, std::uint64_t request_generation) {
+        if(request.width <= 0 || request.height <= 0 || mapped_ring == nullptr) {
+            LOG(WARNING) << "Not streaming texture " << request.name << " (" << request.width << "x" << request.height
+                         << ")";
+            return;
+        }
+
+        const std::size_t row_bytes = (std::size_t) request.width * 4;
+        const std::size_t max_slice_bytes = std::max(std::min(ring.get_capacity() / 4, MAX_SLICE_BYTES), row_bytes);
+        if(row_bytes > ring.get_capacity()) {
+            LOG(ERROR) << "A single row of texture " << request.name << " is bigger than the texture streaming buffer";
+            return;
+        }
+
+        const int rows_per_slice = (int) (max_slice_bytes / row_bytes);
+        const std::size_t src_row_bytes = (std::size_t) request.width * request.num_components;
+
+        for(int first_row = 0; first_row < request.height; first_row += rows_per_slice) {
+            if(generation != request_generation) {
+                // Someone called cancel_all, so don't bother with the rest of this texture
+                return;
+            }
+
+            int num_rows = std::min(rows_per_slice, request.height - first_row);
+            std::size_t slice_bytes = num_rows * row_bytes;
+
+            std::size_t ring_offset;
+            {
+                std::unique_lock<std::mutex> lock(ring_lock);
+                ring_space_freed.wait(lock, [&] { return should_stop || ring.allocate(slice_bytes, ring_offset); });
+                if(should_stop) {
+                    return;
+                }
+            }
+
+            expand_to_rgba8(request.data.data() + first_row * src_row_bytes, request.num_components,
+                            (std::size_t) num_rows * request.width, mapped_ring + ring_offset);
+
+            std::lock_guard<std::mutex> lock(slices_lock);
+            staged_slices.push({request_generation, request.name, {request.width, request.height}, first_row, num_rows,
+                                ring_offset, first_row + num_rows == request.height});
+        }
+    }
+
+    std::vector<texture2D> texture_streamer::upload(std::size_t byte_budget) {
+        std::vector<texture2D> finished_textures;
+        retire_finished_batches(finished_textures);
+
+        in_flight_batch batch = {nullptr, 0, {}};
+        std::size_t bytes_uploaded = 0;
+        bool pixel_buffer_is_bound = false;
+
+        while(true) {
+            staged_slice slice;
+            {
+                std::lock_guard<std::mutex> lock(slices_lock);
+                if(staged_slices.empty() || (batch.num_slices > 0 && bytes_uploaded >= byte_budget)) {
+                    break;
+                }
+
+                slice = std::move(staged_slices.front());
+                staged_slices.pop();
+            }
+
+            // Count the slice even if we skip it, so its ring space gets freed in order with everything else
+            batch.num_slices++;
+
+            if(slice.generation != generation) {
+                continue;
+            }
+
+            if(!pixel_buffer_is_bound) {
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffer);
+                pixel_buffer_is_bound = true;
+            }
+
+            if(slice.first_row == 0) {
+                auto old_texture = textures_in_progress.find(slice.name);
+                if(old_texture != textures_in_progress.end()) {
+                    glDeleteTextures(1, &old_texture->second.get_gl_name());
+                    textures_in_progress.erase(old_texture);
+                }
+
+                texture2D texture;
+                texture.set_name(slice.name);
+                texture.set_storage(slice.texture_size, GL_RGBA8);
+                textures_in_progress.emplace(slice.name, texture);
+            }
+
+            auto texture_itr = textures_in_progress.find(slice.name);
+            if(texture_itr == textures_in_progress.end()) {
+                continue;
+            }
+
+            // With a pixel unpack buffer bound, the data pointer is an offset into the buffer
+            const void* ring_data = reinterpret_cast<const void*>(slice.ring_offset);
+            texture_itr->second.set_sub_image(ring_data, {0, slice.first_row}, {slice.texture_size.x, slice.num_rows},
+                                              GL_RGBA, GL_UNSIGNED_BYTE);
+            bytes_uploaded += (std::size_t) slice.num_rows * slice.texture_size.x * 4;
+
+            if(slice.is_last_slice) {
+                batch.finished_textures.push_back(texture_itr->second);
+                textures_in_progress.erase(texture_itr);
+            }
+        }
+
+        if(pixel_buffer_is_bound) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+
+        if(batch.num_slices > 0) {
+            batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            in_flight_batches.push_back(std::move(batch));
+            profiler::record_stat("texture_stream_bytes", (long long) bytes_uploaded);
+        }
+
+        return finished_textures;
+    }
+
+    void texture_streamer::retire_finished_batches(std::vector<texture2D> &finished_textures) {
+        std::size_t num_slices_freed = 0;
+
+        while(!in_flight_batches.empty()) {
+            auto& batch = in_flight_batches.front();
+
+            GLenum status = glClientWaitSync(batch.fence, 0, 0);
+            if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+                // Batches finish in order, so if this one isn't done then none of the later ones are either
+                break;
+            }
+
+            glDeleteSync(batch.fence);
+            num_slices_freed += batch.num_slices;
+            finished_textures.insert(finished_textures.end(), batch.finished_textures.begin(), batch.finished_textures.end());
+
+            in_flight_batches.pop_front();
+        }
+
+        if(num_slices_freed > 0) {
+            {
+                std::lock_guard<std::mutex> lock(ring_lock);
+                for(std::size_t i = 0; i < num_slices_freed; i++) {
+                    ring.free_oldest();
+                }
+            }
+            ring_space_freed.notify_all();
+        }
+    }
+
+    void texture_streamer::cancel_all() {
+        {
+            std::lock_guard<std::mutex> lock(requests_lock);
+            generation++;
+            std::queue<texture_upload_request>().swap(requests);
+        }
+
+        for(auto& texture : textures_in_progress) {
+            glDeleteTextures(1, &texture.second.get_gl_name());
+        }
+        textures_in_progress.clear();
+
+        // The batches still have to wait for their fences so their ring space can be reused, but their textures are
+        // no longer wanted
+        for(auto& batch : in_flight_batches) {
+            for(auto& texture : batch.finished_textures) {
+                glDeleteTextures(1, &texture.get_gl_name());
+            }
+            batch.finished_textures.clear();
+        }
+    }
+
+    bool texture_streamer::is_idle() {
+        {
+            std::lock_guard<std::mutex> lock(requests_lock);
+            if(!requests.empty() || worker_is_busy) {
+                return false;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(slices_lock);
+            if(!staged_slices.empty()) {
+                return false;
+            }
+        }
+
+        return textures_in_progress.empty() && in_flight_batches.empty();
+    }
+}
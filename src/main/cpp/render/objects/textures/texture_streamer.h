@@ -0,0 +1,197 @@
+/*!
+ * \brief Streams textures to the GPU in the background
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_TEXTURE_STREAMER_H
+#define RENDERER_TEXTURE_STREAMER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+#include "texture2D.h"
+
+namespace nova {
+    /*!
+     * \brief A texture that's waiting to be streamed to the GPU
+     */
+    struct texture_upload_request {
+        std::string name;
+        int width;
+        int height;
+        int num_components;
+
+        /*!
+         * \brief width * height * num_components bytes, one byte per component
+         */
+        std::vector<std::uint8_t> data;
+    };
+
+    /*!
+     * \brief Hands out space in a fixed-size ring buffer
+     *
+     * Allocations have to be freed in the same order they were made, which is how the GPU finishes with them. Doesn't
+     * do any locking, that's up to whoever owns the ring
+     */
+    class upload_ring {
+    public:
+        explicit upload_ring(std::size_t capacity);
+
+        /*!
+         * \brief Tries to find num_bytes of contiguous space
+         *
+         * \param num_bytes How many bytes you need
+         * \param offset Set to the offset of the allocation, if there was space
+         * \return True if there was space, false if you have to free something and try again
+         */
+        bool allocate(std::size_t num_bytes, std::size_t& offset);
+
+        /*!
+         * \brief Frees the oldest allocation
+         */
+        void free_oldest();
+
+        std::size_t get_capacity() const;
+
+        std::size_t get_num_allocations() const;
+
+    private:
+        struct allocation {
+            std::size_t offset;
+            std::size_t size;
+        };
+
+        std::size_t capacity;
+        std::size_t head = 0;
+        std::deque<allocation> allocations;
+    };
+
+    /*!
+     * \brief Gets textures onto the GPU without stalling a frame
+     *
+     * A worker thread converts each requested texture to RGBA8, a few rows at a time, straight into a persistently
+     * mapped pixel unpack buffer. Each frame, the render thread calls upload, which copies as many of those rows into
+     * their textures as the frame's byte budget allows and puts a fence after them. When the fence signals, the rows'
+     * space in the buffer goes back to the worker and any textures that got their last rows are handed back as
+     * finished.
+     *
+     * Only enqueue and the constructor's worker thread are safe to use from other threads. Everything else, and the
+     * destructor, has to be called on the thread with the OpenGL context
+     */
+    class texture_streamer {
+    public:
+        /*!
+         * \brief The default amount of pixel data to send to the GPU each frame
+         */
+        static const std::size_t DEFAULT_BYTES_PER_FRAME = 8 * 1024 * 1024;
+
+        /*!
+         * \param ring_size The size of the pixel unpack buffer. Textures bigger than this are fine, they just take more
+         * than one trip through the ring
+         */
+        explicit texture_streamer(std::size_t ring_size = 32 * 1024 * 1024);
+
+        ~texture_streamer();
+
+        /*!
+         * \brief Queues a texture to be streamed. If a texture with the same name is already streaming, the new one
+         * replaces it when it finishes
+         */
+        void enqueue(texture_upload_request request);
+
+        /*!
+         * \brief Issues uploads for up to byte_budget bytes of texture data, and collects textures that are done
+         *
+         * At least one slice of a texture is uploaded each call even if it's bigger than the budget, so a small budget
+         * can't stall streaming completely
+         *
+         * \param byte_budget How many bytes to upload this frame
+         * \return The textures whose uploads finished on the GPU since the last call. The caller owns their OpenGL
+         * textures now
+         */
+        std::vector<texture2D> upload(std::size_t byte_budget = DEFAULT_BYTES_PER_FRAME);
+
+        /*!
+         * \brief Forgets about every texture that's queued or in the middle of streaming, deleting any partly uploaded
+         * textures
+         */
+        void cancel_all();
+
+        /*!
+         * \brief Returns true if there's nothing left to stream
+         */
+        bool is_idle();
+
+    private:
+        /*!
+         * \brief Some rows of a texture, converted to RGBA8 and waiting in the ring buffer
+         */
+        struct staged_slice {
+            std::uint64_t generation;
+            std::string name;
+            glm::ivec2 texture_size;
+            int first_row;
+            int num_rows;
+            std::size_t ring_offset;
+            bool is_last_slice;
+        };
+
+        /*!
+         * \brief A group of slices that were uploaded in the same frame, and the fence that tells us when the GPU is
+         * done reading them
+         */
+        struct in_flight_batch {
+            GLsync fence;
+            std::size_t num_slices;
+            std::vector<texture2D> finished_textures;
+        };
+
+        GLuint pixel_buffer = 0;
+        std::uint8_t* mapped_ring = nullptr;
+
+        std::mutex ring_lock;
+        std::condition_variable ring_space_freed;
+        upload_ring ring;
+
+        std::mutex requests_lock;
+        std::condition_variable request_added;
+        std::queue<texture_upload_request> requests;
+        bool worker_is_busy = false;
+
+        std::mutex slices_lock;
+        std::queue<staged_slice> staged_slices;
+
+        /*!
+         * \brief Bumped by cancel_all. The worker and the render thread ignore anything from an older generation
+         */
+        std::atomic<std::uint64_t> generation;
+        std::atomic<bool> should_stop;
+
+        // Render thread only from here down
+        std::unordered_map<std::string, texture2D> textures_in_progress;
+        std::deque<in_flight_batch> in_flight_batches;
+
+        std::thread worker;
+
+        void run_worker();
+
+        void stage_texture(const texture_upload_request& request, std::uint64_t request_generation);
+
+        /*!
+         * \brief Gives the ring space of every batch that the GPU is done with back to the worker
+         */
+        void retire_finished_batches(std::vector<texture2D>& finished_textures);
+    };
+}
+
+#endif //RENDERER_TEXTURE_STREAMER_H
@@ -7,40 +7,141 @@
 #define RENDERER_GL_UNIFORM_BUFFER_H
 
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
 #include <glad/glad.h>
 #include "../shaders/gl_shader_program.h"
+#include "uniform_block_layout.h"
 #include <GLFW/glfw3.h>
 
 namespace nova {
     /*!
      * \brief A nice interface for uniform buffer objects
+     *
+     * T has to be declared with NOVA_DEFINE_UNIFORM_BLOCK, so that we know where each of its members lives in the
+     * GLSL block
+     *
+     * The buffer keeps a CPU-side copy of the block. When you #set a member, the new value is compared against the copy,
+     * and only members whose value actually changed are remembered as dirty. #upload then merges the dirty members into
+     * as few byte ranges as it can and sends only those ranges to the GPU. Most of the per-frame uniforms change once
+     * in a blue moon, so most frames that's just the view matrices
      */
     template <typename T>
     class gl_uniform_buffer {
     public:
-        gl_uniform_buffer(std::string name) : name(name) {
+        /*!
+         * \brief Dirty ranges that are separated by less than this many bytes get uploaded as one range, since a
+         * glNamedBufferSubData call costs more than copying a few extra bytes
+         */
+        static const std::size_t MIN_GAP_BETWEEN_UPLOADS = 64;
+
+        gl_uniform_buffer(std::string name) : name(name), data{} {
             glCreateBuffers(1, &gl_name);
-            LOG(TRACE) << "creating ubo " << name << " with size: " << sizeof(T);
-            glNamedBufferStorage(gl_name, sizeof(T), nullptr, GL_DYNAMIC_STORAGE_BIT);
+            LOG(TRACE) << "creating ubo " << name << " with size: " << T::layout::block_size();
+            glNamedBufferStorage(gl_name, T::layout::block_size(), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+            // The GPU buffer starts out as garbage, so the first upload has to send everything
+            mark_range_dirty(0, sizeof(T));
         }
 
         gl_uniform_buffer(gl_uniform_buffer &&old) noexcept {
             gl_name = old.gl_name;
             name = old.name;
+            data = old.data;
+            dirty_ranges = std::move(old.dirty_ranges);
+            bytes_uploaded = old.bytes_uploaded;
 
             old.gl_name = 0;
             old.name = "";
         }
 
         void link_to_shader(const gl_shader_program &shader) {
-            auto ubo_index = glGetUniformBlockIndex(shader.gl_name, name.c_str());
+            if(!validate_block_layout<T>(shader.get_gl_name(), name.c_str())) {
+                LOG(ERROR) << "The layout of uniform block " << name << " in program " << shader.get_gl_name()
+                           << " doesn't match what Nova sends. Expect garbage";
+            }
+
+            auto ubo_index = glGetUniformBlockIndex(shader.get_gl_name(), name.c_str());
             glBindBuffer(GL_UNIFORM_BUFFER, gl_name);
             glBindBufferBase(GL_UNIFORM_BUFFER, ubo_index, gl_name);
         }
 
-        void send_data(T &data) {
+        /*!
+         * \brief Replaces all the data in this buffer and uploads it right away
+         */
+        void send_data(const T &new_data) {
             LOG(TRACE) << "sending date with size: " << sizeof(T) << " to ubo " << name;
+            data = new_data;
+            dirty_ranges.clear();
             glNamedBufferSubData(gl_name, 0, sizeof(T), &data);
+            bytes_uploaded += sizeof(T);
+        }
+
+        /*!
+         * \brief Sets a single member of this buffer's data. The member is only marked as dirty if its value changed
+         *
+         * Nothing is sent to the GPU until you call #upload
+         *
+         * \param member A pointer to the member to set, e.g. &per_frame_uniforms::viewWidth
+         * \param value The new value of the member
+         */
+        template <typename V>
+        void set(V T::*member, const typename std::decay<V>::type &value) {
+            V &current_value = data.*member;
+            if(std::memcmp(&current_value, &value, sizeof(V)) == 0) {
+                return;
+            }
+
+            current_value = value;
+
+            auto offset = (std::size_t) (reinterpret_cast<const char *>(&current_value) - reinterpret_cast<const char *>(&data));
+            mark_range_dirty(offset, offset + sizeof(V));
+        }
+
+        /*!
+         * \brief Returns the CPU-side copy of this buffer's data
+         */
+        const T &get_data() const {
+            return data;
+        }
+
+        /*!
+         * \brief Sends everything that's changed since the last upload to the GPU
+         */
+        void upload() {
+            if(dirty_ranges.empty()) {
+                return;
+            }
+
+            std::sort(dirty_ranges.begin(), dirty_ranges.end());
+
+            auto range_start = dirty_ranges[0].first;
+            auto range_end = dirty_ranges[0].second;
+            for(std::size_t i = 1; i < dirty_ranges.size(); i++) {
+                const auto &range = dirty_ranges[i];
+                if(range.first <= range_end + MIN_GAP_BETWEEN_UPLOADS) {
+                    range_end = std::max(range_end, range.second);
+
+                } else {
+                    upload_range(range_start, range_end);
+                    range_start = range.first;
+                    range_end = range.second;
+                }
+            }
+            upload_range(range_start, range_end);
+
+            dirty_ranges.clear();
+        }
+
+        /*!
+         * \brief Returns the number of bytes this buffer has sent to the GPU since the last time this method was called
+         */
+        std::size_t get_and_reset_bytes_uploaded() {
+            auto uploaded = bytes_uploaded;
+            bytes_uploaded = 0;
+            return uploaded;
         }
 
         void bind() {
@@ -59,6 +160,27 @@ namespace nova {
     private:
         GLuint gl_name;
         std::string name;
+
+        /*!
+         * \brief The CPU-side copy of the data in this buffer
+         */
+        T data;
+
+        /*!
+         * \brief The [begin, end) byte ranges of data that have changed since the last upload
+         */
+        std::vector<std::pair<std::size_t, std::size_t>> dirty_ranges;
+
+        std::size_t bytes_uploaded = 0;
+
+        void mark_range_dirty(std::size_t begin, std::size_t end) {
+            dirty_ranges.emplace_back(begin, end);
+        }
+
+        void upload_range(std::size_t begin, std::size_t end) {
+            glNamedBufferSubData(gl_name, begin, end - begin, reinterpret_cast<const char *>(&data) + begin);
+            bytes_uploaded += end - begin;
+        }
     };
 }
 
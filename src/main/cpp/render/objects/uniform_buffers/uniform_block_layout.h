@@ -0,0 +1,263 @@
+/*!
+ * \brief Compile-time description of the memory layout of GLSL uniform blocks
+ *
+ * The GLSL std140 and std430 rules are a pain to follow by hand: every time someone adds a vec3 to a UBO they have to
+ * remember to add padding, and if they forget then nothing tells them until the shaders read garbage. The templates in
+ * this file compute the offset of every member of a block at compile time, so the C++ struct can be checked against
+ * the rules with a static_assert, and against what the driver actually decided with validate_block_layout when a
+ * program gets linked.
+ *
+ * Uniform blocks are declared with NOVA_DEFINE_UNIFORM_BLOCK and a list of members, like so:
+ *
+ * \code
+ * #define MY_BLOCK_MEMBERS(MEMBER) \
+ *     MEMBER(glm::mat4, modelView, "modelView") \
+ *     MEMBER(glm::vec3, sunPosition, "sunPosition") \
+ *     MEMBER(GLfloat, sunAngle, "sunAngle")
+ *
+ * NOVA_DEFINE_UNIFORM_BLOCK(my_block, nova::block_layout_rules::std140, MY_BLOCK_MEMBERS)
+ * \endcode
+ *
+ * That gives you a struct with one field per member, an enum with the index of each member (modelView_index, etc),
+ * a layout type, and the GLSL name of each member
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_UNIFORM_BLOCK_LAYOUT_H
+#define RENDERER_UNIFORM_BLOCK_LAYOUT_H
+
+#include <cstddef>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <easylogging++.h>
+
+namespace nova {
+    /*!
+     * \brief The packing rules that a uniform or shader storage block is laid out with
+     */
+    enum class block_layout_rules {
+        std140,
+        std430,
+    };
+
+    constexpr std::size_t align_up(std::size_t offset, std::size_t alignment) {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    /*!
+     * \brief Tells you the base alignment and the size of a GLSL type, as seen from C++
+     *
+     * Only types whose C++ representation can match the GLSL representation are specialized. If you try to put
+     * something like a glm::mat3 in a uniform block you'll get a compile error, which is what you want because glm
+     * packs its columns tighter than GLSL does
+     */
+    template <typename T>
+    struct glsl_type_layout;
+
+    template <std::size_t Alignment, std::size_t Size>
+    struct glsl_basic_type_layout {
+        static constexpr std::size_t alignment(block_layout_rules) { return Alignment; }
+        static constexpr std::size_t size(block_layout_rules) { return Size; }
+    };
+
+    template <> struct glsl_type_layout<GLfloat> : glsl_basic_type_layout<4, 4> {};
+    template <> struct glsl_type_layout<GLint> : glsl_basic_type_layout<4, 4> {};
+    template <> struct glsl_type_layout<GLuint> : glsl_basic_type_layout<4, 4> {};
+
+    template <> struct glsl_type_layout<glm::vec2> : glsl_basic_type_layout<8, 8> {};
+    template <> struct glsl_type_layout<glm::ivec2> : glsl_basic_type_layout<8, 8> {};
+    template <> struct glsl_type_layout<glm::uvec2> : glsl_basic_type_layout<8, 8> {};
+
+    // A vec3 is aligned like a vec4 but only takes up three components, so a scalar can live in the fourth one
+    template <> struct glsl_type_layout<glm::vec3> : glsl_basic_type_layout<16, 12> {};
+    template <> struct glsl_type_layout<glm::ivec3> : glsl_basic_type_layout<16, 12> {};
+    template <> struct glsl_type_layout<glm::uvec3> : glsl_basic_type_layout<16, 12> {};
+
+    template <> struct glsl_type_layout<glm::vec4> : glsl_basic_type_layout<16, 16> {};
+    template <> struct glsl_type_layout<glm::ivec4> : glsl_basic_type_layout<16, 16> {};
+    template <> struct glsl_type_layout<glm::uvec4> : glsl_basic_type_layout<16, 16> {};
+
+    // Matrices are arrays of column vectors. The columns of a mat4 are already 16 bytes, so std140 and std430 agree
+    template <> struct glsl_type_layout<glm::mat4> : glsl_basic_type_layout<16, 64> {};
+
+    /*!
+     * \brief Arrays are where std140 and std430 differ: std140 rounds the stride of every element up to a vec4
+     */
+    template <typename T, std::size_t N>
+    struct glsl_type_layout<T[N]> {
+        static constexpr std::size_t alignment(block_layout_rules rules) {
+            return rules == block_layout_rules::std140 ? align_up(glsl_type_layout<T>::alignment(rules), 16)
+                                                       : glsl_type_layout<T>::alignment(rules);
+        }
+
+        static constexpr std::size_t stride(block_layout_rules rules) {
+            return align_up(glsl_type_layout<T>::size(rules), alignment(rules));
+        }
+
+        static constexpr std::size_t size(block_layout_rules rules) {
+            return stride(rules) * N;
+        }
+    };
+
+    /*!
+     * \brief Computes the offset and size of every member of a uniform block
+     *
+     * \tparam Rules The layout rules that the GLSL block is declared with
+     * \tparam Members The types of the block's members, in the order that they're declared in GLSL
+     */
+    template <block_layout_rules Rules, typename... Members>
+    struct uniform_block_layout {
+        static constexpr std::size_t num_members = sizeof...(Members);
+
+        static constexpr std::size_t alignment_of(std::size_t member) {
+            const std::size_t alignments[] = {glsl_type_layout<Members>::alignment(Rules)...};
+            return alignments[member];
+        }
+
+        static constexpr std::size_t size_of(std::size_t member) {
+            const std::size_t sizes[] = {glsl_type_layout<Members>::size(Rules)...};
+            return sizes[member];
+        }
+
+        static constexpr std::size_t offset_of(std::size_t member) {
+            std::size_t offset = 0;
+            for(std::size_t i = 0; i < member; i++) {
+                offset = align_up(offset, alignment_of(i)) + size_of(i);
+            }
+
+            return align_up(offset, alignment_of(member));
+        }
+
+        /*!
+         * \brief The number of bytes that the whole block needs. Blocks are rounded up to the alignment of a vec4
+         */
+        static constexpr std::size_t block_size() {
+            return align_up(offset_of(num_members - 1) + size_of(num_members - 1), 16);
+        }
+
+        /*!
+         * \brief Checks that the given offsets and sizes, one per member, are exactly what the layout rules want
+         *
+         * Used to static_assert that a C++ struct can be memcpy'd straight into a GLSL block
+         */
+        static constexpr bool matches(const std::size_t *offsets, const std::size_t *sizes) {
+            for(std::size_t i = 0; i < num_members; i++) {
+                if(offsets[i] != offset_of(i) || sizes[i] != size_of(i)) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+    };
+
+    /*!
+     * \brief Checks the layout that the driver picked for the named block in the given program against the layout of
+     * the C++ struct Block, logging every member that doesn't line up
+     *
+     * \param program The linked program to query
+     * \param block_name The name of the uniform block in GLSL
+     * \return True if every member that the program uses is where we expect it to be, false otherwise
+     */
+    template <typename Block>
+    bool validate_block_layout(GLuint program, const char *block_name) {
+        using layout = typename Block::layout;
+
+        GLuint block_index = glGetUniformBlockIndex(program, block_name);
+        if(block_index == GL_INVALID_INDEX) {
+            // This program doesn't use the block, so there's nothing that could be wrong
+            return true;
+        }
+
+        bool layout_is_valid = true;
+
+        GLint driver_block_size = 0;
+        glGetActiveUniformBlockiv(program, block_index, GL_UNIFORM_BLOCK_DATA_SIZE, &driver_block_size);
+        if((std::size_t) driver_block_size != layout::block_size()) {
+            LOG(ERROR) << "Uniform block " << block_name << " is " << driver_block_size << " bytes in program "
+                       << program << ", but Nova expects it to be " << layout::block_size() << " bytes";
+            layout_is_valid = false;
+        }
+
+        std::vector<const char *> member_names(layout::num_members);
+        for(std::size_t i = 0; i < layout::num_members; i++) {
+            member_names[i] = Block::glsl_name(i);
+        }
+
+        std::vector<GLuint> member_indices(layout::num_members);
+        glGetUniformIndices(program, (GLsizei) layout::num_members, member_names.data(), member_indices.data());
+
+        for(std::size_t i = 0; i < layout::num_members; i++) {
+            if(member_indices[i] == GL_INVALID_INDEX) {
+                // The shader doesn't use this member, so the driver is free to not tell us where it is
+                continue;
+            }
+
+            GLint driver_offset = 0;
+            glGetActiveUniformsiv(program, 1, &member_indices[i], GL_UNIFORM_OFFSET, &driver_offset);
+            if((std::size_t) driver_offset != layout::offset_of(i)) {
+                LOG(ERROR) << "Member " << member_names[i] << " of uniform block " << block_name << " is at offset "
+                           << driver_offset << " in program " << program << ", but Nova puts it at offset "
+                           << layout::offset_of(i) << ". Make sure the GLSL block declares its members in the same "
+                           << "order as Nova does";
+                layout_is_valid = false;
+            }
+        }
+
+        return layout_is_valid;
+    }
+}
+
+/*
+ * Helpers for NOVA_DEFINE_UNIFORM_BLOCK. Each one is expanded once per member of the block
+ */
+
+#define NOVA_UNIFORM_BLOCK_FIELD(type, name, glsl_name) type name;
+#define NOVA_UNIFORM_BLOCK_INDEX(type, name, glsl_name) name##_index,
+#define NOVA_UNIFORM_BLOCK_TYPE(type, name, glsl_name) , type
+#define NOVA_UNIFORM_BLOCK_GLSL_NAME(type, name, glsl_name) glsl_name,
+#define NOVA_UNIFORM_BLOCK_HOST_OFFSET(type, name, glsl_name) offsetof(self, name),
+#define NOVA_UNIFORM_BLOCK_HOST_SIZE(type, name, glsl_name) sizeof(type),
+
+/*!
+ * \brief Declares a struct that can be uploaded as-is to a GLSL uniform block, and checks at compile time that its
+ * layout follows the given rules
+ *
+ * The members have to be listed in an order that doesn't need any padding, because the C++ compiler isn't going to add
+ * the padding that GLSL wants. Putting a scalar after every vec3 is the easiest way to do that. If you get it wrong, the
+ * static_assert will tell you
+ */
+#define NOVA_DEFINE_UNIFORM_BLOCK(block_name, rules, MEMBERS)                                                   \
+    struct block_name {                                                                                         \
+        using self = block_name;                                                                                \
+                                                                                                                \
+        MEMBERS(NOVA_UNIFORM_BLOCK_FIELD)                                                                       \
+                                                                                                                \
+        enum member {                                                                                           \
+            MEMBERS(NOVA_UNIFORM_BLOCK_INDEX)                                                                   \
+            num_members                                                                                         \
+        };                                                                                                      \
+                                                                                                                \
+        using layout = nova::uniform_block_layout<rules MEMBERS(NOVA_UNIFORM_BLOCK_TYPE)>;                      \
+                                                                                                                \
+        static const char *glsl_name(std::size_t member) {                                                      \
+            static const char *const names[] = { MEMBERS(NOVA_UNIFORM_BLOCK_GLSL_NAME) };                       \
+            return names[member];                                                                               \
+        }                                                                                                       \
+                                                                                                                \
+        static constexpr bool host_layout_matches() {                                                           \
+            const std::size_t offsets[] = { MEMBERS(NOVA_UNIFORM_BLOCK_HOST_OFFSET) };                          \
+            const std::size_t sizes[] = { MEMBERS(NOVA_UNIFORM_BLOCK_HOST_SIZE) };                              \
+            return layout::matches(offsets, sizes);                                                             \
+        }                                                                                                       \
+    };                                                                                                          \
+    static_assert(block_name::host_layout_matches(),                                                            \
+                  #block_name " does not match the " #rules " layout rules. Reorder its members so that the "   \
+                  "C++ struct doesn't need padding");                                                           \
+    static_assert(sizeof(block_name) <= block_name::layout::block_size(),                                       \
+                  #block_name " is bigger than the GLSL block it represents");
+
+#endif //RENDERER_UNIFORM_BLOCK_LAYOUT_H
@@ -19,69 +19,73 @@
 
 #include <easylogging++.h>
 
+#include "uniform_block_layout.h"
+
 namespace nova {
+    /*!
+     * \brief All the members of the per_frame_uniforms block, in the order that they're declared in GLSL
+     *
+     * Every vec3 is followed by a scalar so that the scalar fills the fourth component of the vec3's slot. That's what
+     * std140 does anyways, and it means we don't waste any space on padding
+     */
+#define NOVA_PER_FRAME_UNIFORMS(MEMBER) \
+        MEMBER(glm::mat4, gbufferModelView, "gbufferModelView") \
+        MEMBER(glm::mat4, gbufferModelViewInverse, "gbufferModelViewInverse") \
+        MEMBER(glm::mat4, gbufferPreviousModelView, "gbufferPreviousModelView") \
+        MEMBER(glm::mat4, gbufferProjection, "gbufferProjection") \
+        MEMBER(glm::mat4, gbufferProjectionInverse, "gbufferProjectionInverse") \
+        MEMBER(glm::mat4, gbufferPreviousProjection, "gbufferPreviousProjection") \
+        MEMBER(glm::mat4, shadowProjection, "shadowProjection") \
+        MEMBER(glm::mat4, shadowProjectionInverse, "shadowProjectionInverse") \
+        MEMBER(glm::mat4, shadowModelView, "shadowModelView") \
+        MEMBER(glm::mat4, shadowModelViewInverse, "shadowModelViewInverse") \
+        MEMBER(glm::vec4, entityColor, "entityColor") \
+        MEMBER(glm::vec3, fogColor, "fogColor") \
+        MEMBER(GLfloat, frameTimeCounter, "frameTimeCounter") \
+        MEMBER(glm::vec3, skyColor, "skyColor") \
+        MEMBER(GLfloat, sunAngle, "sunAngle") \
+        MEMBER(glm::vec3, sunPosition, "sunPosition") \
+        MEMBER(GLfloat, shadowAngle, "shadowAngle") \
+        MEMBER(glm::vec3, moonPosition, "moonPosition") \
+        MEMBER(GLfloat, rainStrength, "rainStrength") \
+        MEMBER(glm::vec3, shadowLightPosition, "shadowLightPosition") \
+        MEMBER(GLfloat, aspectRatio, "aspectRatio") \
+        MEMBER(glm::vec3, upPosition, "upPosition") \
+        MEMBER(GLfloat, viewWidth, "viewWidth") \
+        MEMBER(glm::vec3, cameraPosition, "cameraPosition") \
+        MEMBER(GLfloat, viewHeight, "viewHeight") \
+        MEMBER(glm::vec3, previousCameraPosition, "previousCameraPosition") \
+        MEMBER(GLfloat, nearPlane, "near") \
+        MEMBER(glm::ivec2, eyeBrightness, "eyeBrightness") \
+        MEMBER(glm::ivec2, eyeBrightnessSmooth, "eyeBrightnessSmooth") \
+        MEMBER(glm::ivec2, terrainTextureSize, "terrainTextureSize") \
+        MEMBER(glm::ivec2, atlasSize, "atlasSize") \
+        MEMBER(GLint, heldItemId, "heldItemId") \
+        MEMBER(GLint, heldBlockLightValue, "heldBlockLightValue") \
+        MEMBER(GLint, heldItemId2, "heldItemId2") \
+        MEMBER(GLint, heldBlockLightValue2, "heldBlockLightValue2") \
+        MEMBER(GLint, fogMode, "fogMode") \
+        MEMBER(GLint, worldTime, "worldTime") \
+        MEMBER(GLint, moonPhase, "moonPhase") \
+        MEMBER(GLint, terrainIconSize, "terrainIconSize") \
+        MEMBER(GLint, isEyeInWater, "isEyeInWater") \
+        MEMBER(GLint, hideGUI, "hideGUI") \
+        MEMBER(GLint, entityId, "entityId") \
+        MEMBER(GLint, blockEntityId, "blockEntityId") \
+        MEMBER(GLfloat, farPlane, "far") \
+        MEMBER(GLfloat, wetness, "wetness") \
+        MEMBER(GLfloat, eyeAltitude, "eyeAltitude") \
+        MEMBER(GLfloat, centerDepthSmooth, "centerDepthSmooth")
+
     /*!
      * \brief Holds all the uniform variables that are shared by all shader executions
      *
      * The data in the structure should only be uploaded once per frame
+     *
+     * nearPlane and farPlane are called near and far in the shaders. They're re-named because GCC was yelling about
+     * "This line does not declare anything", like it's some great authority on declaring things
      */
-    struct per_frame_uniforms {
-        glm::mat4 gbufferModelView;
-        glm::mat4 gbufferModelViewInverse;
-        glm::mat4 gbufferPreviousModelView;
-        glm::mat4 gbufferProjection;
-        glm::mat4 gbufferProjectionInverse;
-        glm::mat4 gbufferPreviousProjection;
-        glm::mat4 shadowProjection;
-        glm::mat4 shadowProjectionInverse;
-        glm::mat4 shadowModelView;
-        glm::mat4 shadowModelViewInverse;
-        glm::vec4 entityColor;
-        glm::vec3 fogColor;
-        float padding1; // needed to fit the GLSL std140 alignment rules. A future version will pack the data here more efficiently
-        glm::vec3 skyColor;
-        float padding2;
-        glm::vec3 sunPosition;
-        float padding3;
-        glm::vec3 moonPosition;
-        float padding4;
-        glm::vec3 shadowLightPosition;
-        float padding5;
-        glm::vec3 upPosition;
-        float padding6;
-        glm::vec3 cameraPosition;
-        float padding7;
-        glm::vec3 previousCameraPosition;
-        float padding8;
-        glm::ivec2 eyeBrightness;
-        glm::ivec2 eyeBrightnessSmooth;
-        glm::ivec2 terrainTextureSize;
-        glm::ivec2 atlasSize;
-        GLint heldItemId;
-        GLint heldBlockLightValue;
-        GLint heldItemId2;
-        GLint heldBlockLightValue2;
-        GLint fogMode;
-        GLint worldTime;
-        GLint moonPhase;
-        GLint terrainIconSize;
-        GLint isEyeInWater;
-        GLint hideGUI;
-        GLint entityId;
-        GLint blockEntityId;
-        GLfloat frameTimeCounter;
-        GLfloat sunAngle;
-        GLfloat shadowAngle;
-        GLfloat rainStrength;
-        GLfloat aspectRatio;
-        GLfloat viewWidth;
-        GLfloat viewHeight;
-        GLfloat nearPlane;  // near in the shaders. Re-named because GCC was yelling about "This line does not declare anything", like it's some great authority on declaring things
-        GLfloat farPlane;   // far in the shaders
-        GLfloat wetness;
-        GLfloat eyeAltitude;
-        GLfloat centerDepthSmooth;
-    };
+    NOVA_DEFINE_UNIFORM_BLOCK(per_frame_uniforms, block_layout_rules::std140, NOVA_PER_FRAME_UNIFORMS)
 
     /*!
      * \brief Holds all the uniform variables that are specific to shadow passes
@@ -8,6 +8,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "../../nova_renderer.h"
+#include "../../../utils/profiler.h"
 #include "uniform_buffer_store.h"
 
 namespace nova {
@@ -16,7 +17,8 @@ namespace nova {
     }
 
     void uniform_buffer_store::update() {
-        update_per_frame_uniforms(nova_renderer::get_render_settings().get_options());
+        per_frame_uniforms_buffer.upload();
+        profiler::record_stat("per_frame_uniforms_upload_bytes", (long long) per_frame_uniforms_buffer.get_and_reset_bytes_uploaded());
     }
 
     void uniform_buffer_store::on_config_change(nlohmann::json &new_config) {
@@ -34,25 +36,15 @@ namespace nova {
     }
 
     void uniform_buffer_store::update_per_frame_uniforms(nlohmann::json &config) {
-		float view_width = config["viewWidth"];
-		float view_height = config["viewHeight"];
-        float scalefactor = config["scalefactor"];
-        // The GUI matrix is super simple, just a viewport transformation
-        glm::mat4 gui_model_view(1.0f);
-        gui_model_view = glm::translate(gui_model_view, glm::vec3(-1.0f, 1.0f, 0.0f));
-        gui_model_view = glm::scale(gui_model_view, glm::vec3(scalefactor, scalefactor, 1.0f));
-        gui_model_view = glm::scale(gui_model_view, glm::vec3(1.0 / view_width, 1.0 / view_height, 1.0));
-        gui_model_view = glm::scale(gui_model_view, glm::vec3(1.0f, -1.0f, 1.0f));
-
-        per_frame_uniform_variables.gbufferModelView = glm::mat4(1);
-        per_frame_uniform_variables.gbufferProjection = glm::mat4(1);
-        per_frame_uniform_variables.aspectRatio = view_width / view_height;
-        per_frame_uniform_variables.viewHeight = view_height;
-        per_frame_uniform_variables.viewWidth = view_width;
-        per_frame_uniform_variables.frameTimeCounter = 0;
-        per_frame_uniform_variables.hideGUI = 0;
-
-        per_frame_uniforms_buffer.send_data(per_frame_uniform_variables);
+        float view_width = config["viewWidth"];
+        float view_height = config["viewHeight"];
+
+        // Most config changes don't touch the view size, in which case these don't mark anything as dirty
+        per_frame_uniforms_buffer.set(&per_frame_uniforms::aspectRatio, view_width / view_height);
+        per_frame_uniforms_buffer.set(&per_frame_uniforms::viewHeight, view_height);
+        per_frame_uniforms_buffer.set(&per_frame_uniforms::viewWidth, view_width);
+
+        per_frame_uniforms_buffer.upload();
         LOG(DEBUG) << "Updated Per-Frame UBO";
     }
 
@@ -35,6 +35,12 @@ namespace nova {
 
         void register_all_buffers_with_shader(const gl_shader_program &shader) noexcept;
 
+        /*!
+         * \brief Uploads whatever has changed in the uniform buffers since the last update, and records how many bytes
+         * that took in the profiler stat "per_frame_uniforms_upload_bytes"
+         *
+         * Call this once per frame, after you've set all the values you want to set
+         */
         void update();
 
         /*
@@ -47,8 +53,6 @@ namespace nova {
         gl_uniform_buffer<per_frame_uniforms>& get_per_frame_uniforms();
 
     private:
-        per_frame_uniforms per_frame_uniform_variables;
-
         gl_uniform_buffer<per_frame_uniforms> per_frame_uniforms_buffer;
 
         void update_per_frame_uniforms(nlohmann::json &config);
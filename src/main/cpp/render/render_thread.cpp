@@ -0,0 +1,79 @@
+/*!
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <easylogging++.h>
+#include "render_thread.h"
+#include "nova_renderer.h"
+#include "../utils/profiler.h"
+
+namespace nova {
+    std::unique_ptr<render_thread> render_thread::instance;
+
+    void render_thread::start() {
+        instance = std::make_unique<render_thread>();
+    }
+
+    void render_thread::stop() {
+        instance.reset();
+    }
+
+    render_thread::render_thread() {
+        auto initialized = renderer_initialized.get_future();
+        thread = std::thread(&render_thread::run, this);
+
+        // Minecraft is going to start calling into Nova as soon as initialize returns, so the renderer had better exist
+        // by then
+        try {
+            initialized.get();
+        } catch(...) {
+            // The render thread has already given up, and a thread that's still joinable can't be destroyed
+            thread.join();
+            throw;
+        }
+    }
+
+    render_thread::~render_thread() {
+        frames.close();
+        if(thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    frame_snapshot &render_thread::get_next_frame() {
+        return frames.get_back_buffer();
+    }
+
+    void render_thread::submit_frame() {
+        frames.publish();
+    }
+
+    void render_thread::run() {
+        LOG(INFO) << "Render thread started";
+        try {
+            nova_renderer::init();
+
+            // Query this here so that the game thread gets the cached value and never has to touch OpenGL
+            nova_renderer::instance->get_texture_manager().get_max_texture_size();
+
+        } catch(...) {
+            // Hand the failure to the game thread, which is waiting in the constructor and would otherwise wait forever
+            LOG(ERROR) << "Could not start the renderer";
+            renderer_initialized.set_exception(std::current_exception());
+            return;
+        }
+
+        renderer_initialized.set_value();
+
+        while(frame_snapshot *frame = frames.acquire()) {
+            profiler::start("render_thread_frame");
+            nova_renderer::instance->apply_frame_snapshot(*frame);
+            nova_renderer::instance->render_frame();
+            profiler::end("render_thread_frame");
+        }
+
+        nova_renderer::deinit();
+        LOG(INFO) << "Render thread stopped";
+    }
+}
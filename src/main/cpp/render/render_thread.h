@@ -0,0 +1,67 @@
+/*!
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_RENDER_THREAD_H
+#define RENDERER_RENDER_THREAD_H
+
+#include <memory>
+#include <thread>
+#include <future>
+#include "frame_snapshot.h"
+#include "../utils/frame_mailbox.h"
+
+namespace nova {
+    /*!
+     * \brief Runs the nova_renderer on its own thread, so Minecraft doesn't have to wait for a frame to finish
+     *
+     * The render thread creates the window and owns the OpenGL context. Nothing on the game thread is allowed to touch
+     * either of them. Instead, the game thread writes what it wants into the snapshot from get_next_frame, and hands
+     * that snapshot over with submit_frame. The render thread applies the snapshot and renders a frame while Minecraft
+     * gets on with the next tick.
+     *
+     * All the snapshot methods assume that there's only one game thread, which is how Minecraft calls us
+     */
+    class render_thread {
+    public:
+        static std::unique_ptr<render_thread> instance;
+
+        /*!
+         * \brief Starts the render thread, and waits until it's finished initializing the nova_renderer
+         *
+         * \throws Whatever the nova_renderer threw, if it couldn't be initialized. The render thread has stopped by then
+         */
+        static void start();
+
+        /*!
+         * \brief Stops the render thread after it's rendered every frame it's been given
+         */
+        static void stop();
+
+        render_thread();
+
+        ~render_thread();
+
+        /*!
+         * \brief The snapshot that the game thread should write this frame's changes into
+         */
+        frame_snapshot& get_next_frame();
+
+        /*!
+         * \brief Sends the current snapshot to the render thread and starts a new one
+         */
+        void submit_frame();
+
+    private:
+        frame_mailbox<frame_snapshot> frames;
+
+        std::promise<void> renderer_initialized;
+
+        std::thread thread;
+
+        void run();
+    };
+}
+
+#endif //RENDERER_RENDER_THREAD_H
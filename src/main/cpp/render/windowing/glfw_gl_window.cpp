@@ -17,7 +17,7 @@ namespace nova {
         glfw_gl_window::setActive((bool) focused);
     }
 
-    bool glfw_gl_window::active = true;
+    std::atomic<bool> glfw_gl_window::active(true);
 
     glfw_gl_window::glfw_gl_window() {
         initialize_logging();
@@ -125,11 +125,11 @@ namespace nova {
     }
 
     glm::vec2 glfw_gl_window::get_size() {
+        std::lock_guard<std::mutex> lock(window_dimensions_lock);
         return window_dimensions;
     }
 
     void glfw_gl_window::end_frame() {
-        // We're in thread 29
         glfwSwapBuffers(window);
         glfwPollEvents();
 
@@ -145,7 +145,10 @@ namespace nova {
         nlohmann::json &settings = nova_renderer::instance->get_render_settings().get_options();
         settings["settings"]["viewWidth"] = new_framebuffer_size.x;
         settings["settings"]["viewHeight"] = new_framebuffer_size.y;
-        window_dimensions = new_framebuffer_size;
+        {
+            std::lock_guard<std::mutex> lock(window_dimensions_lock);
+            window_dimensions = new_framebuffer_size;
+        }
         glViewport(0, 0, window_dimensions.x, window_dimensions.y);
         nova_renderer::instance->get_render_settings().update_config_changed();
     }
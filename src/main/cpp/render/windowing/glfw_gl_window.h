@@ -6,6 +6,8 @@
 #define RENDERER_GLFW_GL_WINDOW_H
 
 
+#include <atomic>
+#include <mutex>
 #include <glad/glad.h>
 #include <json.hpp>
 #include "GLFW/glfw3.h"
@@ -68,9 +70,14 @@ namespace nova {
         static void setActive(bool active);
 
     private:
-        static bool active;
+        static std::atomic<bool> active;
         GLFWwindow *window;
         glm::ivec2 window_dimensions;
+
+        /*!
+         * \brief Minecraft asks for the size of the window from the game thread, while the render thread resizes it
+         */
+        std::mutex window_dimensions_lock;
         std::unique_ptr<RenderDocManager> renderdoc_manager;
         struct window_parameters windowed_window_parameters;
         void set_framebuffer_size(glm::ivec2 new_framebuffer_size);
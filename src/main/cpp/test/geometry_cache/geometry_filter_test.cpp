@@ -0,0 +1,82 @@
+/*!
+ * \brief Tests compiling filter expressions and sorting geometry with them
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include "../../geometry_cache/geometry_filter.h"
+
+namespace nova {
+    namespace test {
+        geometry_filter_set make_test_filters() {
+            return geometry_filter_set({
+                    {"particles", "geometry_type::PARTICLE"},
+                    {"sky", "name::sun OR name::moon"},
+                    {"glass", "geometry_type::block AND name_part::glass AND transparent"},
+                    {"solid_blocks", "geometry_type::block AND not_transparent OR emissive"},
+                    {"broken", "geometry_type::block AND"},
+                    {"also_broken", "geometry_type::rainbow"}
+            });
+        }
+
+        TEST(geometry_filter, matches_like_the_java_filters) {
+            auto filters = make_test_filters();
+            ASSERT_EQ(filters.get_num_filters(), 6);
+            EXPECT_EQ(filters.get_shader_name(1), "sky");
+            EXPECT_EQ(filters.get_expression(1), "name::sun OR name::moon");
+            EXPECT_TRUE(filters.is_valid(3));
+            EXPECT_FALSE(filters.is_valid(4));
+            EXPECT_FALSE(filters.is_valid(5));
+
+            EXPECT_TRUE(filters.matches(0, {"smoke", geometry_type::particle, false, false}));
+            EXPECT_FALSE(filters.matches(0, {"smoke", geometry_type::lit_particle, false, false}));
+
+            EXPECT_TRUE(filters.matches(1, {"moon", geometry_type::sky_decoration, false, false}));
+            EXPECT_FALSE(filters.matches(1, {"moonstone", geometry_type::sky_decoration, false, false}));
+
+            EXPECT_TRUE(filters.matches(2, {"stained_glass_pane", geometry_type::block, true, false}));
+            EXPECT_FALSE(filters.matches(2, {"stained_glass_pane", geometry_type::block, false, false}));
+            EXPECT_FALSE(filters.matches(2, {"stone", geometry_type::block, true, false}));
+
+            // AND and OR go from left to right, so this is (block AND not_transparent) OR emissive
+            EXPECT_TRUE(filters.matches(3, {"stone", geometry_type::block, false, false}));
+            EXPECT_FALSE(filters.matches(3, {"ice", geometry_type::block, true, false}));
+            EXPECT_TRUE(filters.matches(3, {"blaze", geometry_type::entity, true, true}));
+
+            EXPECT_FALSE(filters.matches(4, {"stone", geometry_type::block, false, false}));
+        }
+
+        TEST(geometry_filter, classify_agrees_with_matches) {
+            auto filters = make_test_filters();
+
+            std::vector<std::string> names = {"stone", "glass", "stained_glass_pane", "sun", "moon", "smoke", "glowstone"};
+            std::vector<geometry_attributes> items;
+            // Not a multiple of 64, so the negated filters have to keep clear of the bits past the end
+            for(std::size_t i = 0; i < 1000; i++) {
+                items.push_back({names[i % names.size()], geometry_type(static_cast<int>(i % 14)), i % 3 == 0, i % 5 == 0});
+            }
+
+            auto matches = filters.classify(items);
+            ASSERT_EQ(matches.get_num_items(), items.size());
+            ASSERT_EQ(matches.get_num_words(), 16);
+
+            for(std::size_t filter = 0; filter < filters.get_num_filters(); filter++) {
+                std::vector<std::size_t> expected_items;
+                for(std::size_t item = 0; item < items.size(); item++) {
+                    auto expected = filters.matches(filter, items[item]);
+                    EXPECT_EQ(matches.matches(filter, item), expected) << "filter " << filter << ", item " << item;
+                    if(expected) {
+                        expected_items.push_back(item);
+                    }
+                }
+                EXPECT_EQ(matches.get_matching_items(filter), expected_items);
+                EXPECT_EQ(matches.get_words(filter)[15] >> (1000 % 64), 0);
+            }
+
+            EXPECT_FALSE(matches.get_matching_items(3).empty());
+            EXPECT_TRUE(matches.get_matching_items(4).empty());
+        }
+    }
+}
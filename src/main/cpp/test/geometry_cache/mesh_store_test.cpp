@@ -16,7 +16,8 @@ namespace nova {
 
         TEST_F(mesh_store_test, add_gui_geometry_test) {
             auto shaderpack_name = "default";
-            auto loaded_shaderpack = std::make_shared<shaderpack>(nova::load_shaderpack(shaderpack_name));
+            nova::thread_pool workers;
+            auto loaded_shaderpack = std::make_shared<shaderpack>(nova::load_shaderpack(shaderpack_name, workers));
 
             nova::mesh_store meshes;
 
@@ -43,18 +44,48 @@ namespace nova {
 
             meshes.add_gui_buffers(&send_gui_buffer_command);
 
-            auto& gui_meshes = meshes.get_meshes_for_shader("gui");
+            auto renderables = meshes.get_renderables_for_frame();
+            auto& gui_meshes = renderables.get("gui");
 
             ASSERT_EQ(1, gui_meshes.size());
 
-            auto& gui_mesh = gui_meshes[0];
+            auto& gui_mesh = *gui_meshes[0];
 
             ASSERT_EQ(0, gui_mesh.parent_id);
             ASSERT_EQ(nova::geometry_type::gui, gui_mesh.type);
             ASSERT_EQ("gui", gui_mesh.name);
             ASSERT_EQ("gui", gui_mesh.color_texture);
-            ASSERT_EQ(false, gui_mesh.normalmap.has_value());
-            ASSERT_EQ(false, gui_mesh.data_texture.has_value());
+            ASSERT_EQ(nova_renderer::instance->get_texture_manager().get_texture_handle("gui"), gui_mesh.color_texture_handle);
+            ASSERT_EQ(NO_TEXTURE, gui_mesh.normalmap_handle);
+            ASSERT_FALSE(static_cast<bool>(gui_mesh.normalmap));
+            ASSERT_FALSE(static_cast<bool>(gui_mesh.data_texture));
+        }
+
+        TEST_F(mesh_store_test, add_whole_gui_screen_test) {
+            nova::mesh_store meshes;
+
+            std::vector<float> vertices(36, 0);
+            std::vector<int> indices = {0, 1, 2, 1, 2, 3};
+
+            std::vector<mc_gui_geometry> screen(3);
+            for(auto& element : screen) {
+                element.texture_name = "gui/widgets";
+                element.atlas_name = "gui";
+                element.vertex_buffer = vertices.data();
+                element.vertex_buffer_size = static_cast<int>(vertices.size());
+                element.index_buffer = indices.data();
+                element.index_buffer_size = static_cast<int>(indices.size());
+            }
+
+            meshes.add_gui_buffers(screen);
+
+            auto renderables = meshes.get_renderables_for_frame();
+            auto& gui_meshes = renderables.get("gui");
+            ASSERT_EQ(3, gui_meshes.size());
+            for(auto& gui_mesh : gui_meshes) {
+                EXPECT_EQ(nova::geometry_type::gui, gui_mesh->type);
+                EXPECT_EQ("gui", gui_mesh->color_texture);
+            }
         }
 
         TEST_F(mesh_store_test, test_set_shaderpack) {
@@ -0,0 +1,193 @@
+/*!
+ * \brief Tests for versioned_buckets and the epoch_reclaimer underneath it
+ *
+ * The stress test is meant to be run under ThreadSanitizer, which is where any races will show up
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <atomic>
+#include <thread>
+#include <gtest/gtest.h>
+#include "../../geometry_cache/versioned_buckets.h"
+
+namespace nova {
+    namespace test {
+        /*!
+         * \brief Stands in for a render_object. Counts how many of it are alive, and poisons itself when it dies so
+         * that readers notice if they look at a dead one
+         */
+        struct counted_thing {
+            static std::atomic<int> num_alive;
+
+            long parent_id;
+            long check_value;
+
+            explicit counted_thing(long parent_id) : parent_id(parent_id), check_value(parent_id * 7) {
+                num_alive++;
+            }
+
+            ~counted_thing() {
+                check_value = -1;
+                num_alive--;
+            }
+        };
+
+        std::atomic<int> counted_thing::num_alive(0);
+
+        using test_buckets = versioned_buckets<counted_thing>;
+
+        std::unordered_map<std::string, test_buckets::bucket> make_things(const std::string& bucket_name, long first_id, long count) {
+            std::unordered_map<std::string, test_buckets::bucket> things;
+            for(long id = first_id; id < first_id + count; id++) {
+                things[bucket_name].push_back(std::make_shared<counted_thing>(id));
+            }
+
+            return things;
+        }
+
+        TEST(versioned_buckets, add_and_remove) {
+            test_buckets buckets;
+            buckets.add(make_things("terrain", 0, 10));
+            buckets.add(make_things("water", 100, 5));
+
+            {
+                auto reader = buckets.read();
+                EXPECT_EQ(10, reader.get("terrain").size());
+                EXPECT_EQ(5, reader.get("water").size());
+                EXPECT_EQ(0, reader.get("gui").size());
+            }
+
+            buckets.remove_if([](const counted_thing& thing) { return thing.parent_id % 2 == 0; });
+
+            auto reader = buckets.read();
+            EXPECT_EQ(5, reader.get("terrain").size());
+            for(const auto& thing : reader.get("terrain")) {
+                EXPECT_EQ(1, thing->parent_id % 2);
+            }
+        }
+
+        TEST(versioned_buckets, readers_keep_their_version) {
+            test_buckets buckets;
+            buckets.add(make_things("terrain", 0, 10));
+
+            auto old_reader = buckets.read();
+            buckets.remove_if([](const counted_thing&) { return true; });
+            buckets.reclaim();
+
+            // The old reader is still pinned, so everything it saw has to still be alive
+            ASSERT_EQ(10, old_reader.get("terrain").size());
+            for(const auto& thing : old_reader.get("terrain")) {
+                EXPECT_EQ(thing->parent_id * 7, thing->check_value);
+            }
+
+            EXPECT_EQ(0, buckets.read().get("terrain").size());
+        }
+
+        TEST(versioned_buckets, reclaim_deletes_removed_things) {
+            int alive_before = counted_thing::num_alive;
+            {
+                test_buckets buckets;
+                buckets.add(make_things("terrain", 0, 10));
+                buckets.reclaim();
+
+                {
+                    auto reader = buckets.read();
+                    buckets.remove_if([](const counted_thing& thing) { return thing.parent_id < 5; });
+                    EXPECT_EQ(0, buckets.reclaim());
+                    EXPECT_EQ(alive_before + 10, counted_thing::num_alive);
+                }
+
+                EXPECT_EQ(1, buckets.reclaim());
+                EXPECT_EQ(alive_before + 5, counted_thing::num_alive);
+            }
+            EXPECT_EQ(alive_before, counted_thing::num_alive);
+        }
+
+        TEST(versioned_buckets, concurrent_add_remove_and_iterate) {
+            const int num_frames = 2000;
+            const long things_per_add = 8;
+
+            test_buckets buckets;
+            std::atomic<bool> done(false);
+            std::atomic<long> things_seen(0);
+            std::atomic<long> bad_things_seen(0);
+
+            // One thread adds chunks, like the chunk builder does
+            std::thread adder([&]() {
+                long next_id = 0;
+                while(!done) {
+                    buckets.add(make_things("terrain", next_id, things_per_add));
+                    next_id += things_per_add;
+                }
+            });
+
+            // Another removes them again, like unloading chunks does
+            std::thread remover([&]() {
+                long parent_id = 0;
+                while(!done) {
+                    buckets.remove_if([&](const counted_thing& thing) { return thing.parent_id <= parent_id; });
+                    parent_id += things_per_add;
+                }
+            });
+
+            // And another thread replaces the GUI over and over
+            std::thread gui_writer([&]() {
+                while(!done) {
+                    buckets.remove_if([](const counted_thing& thing) { return thing.parent_id < 0; });
+                    buckets.add(make_things("gui", -100, 3));
+                }
+            });
+
+            // A second reader, to make sure readers don't interfere with each other
+            std::thread other_reader([&]() {
+                while(!done) {
+                    auto reader = buckets.read();
+                    for(const auto& entry : reader.get_all()) {
+                        for(const auto& thing : *entry.second) {
+                            if(thing->check_value != thing->parent_id * 7) {
+                                bad_things_seen++;
+                            }
+                        }
+                    }
+                }
+            });
+
+            // This thread is the render thread: pin a frame, walk everything, then reclaim
+            for(int frame = 0; frame < num_frames; frame++) {
+                {
+                    auto reader = buckets.read();
+                    for(const auto& name : {"terrain", "gui"}) {
+                        for(const auto& thing : reader.get(name)) {
+                            if(thing->check_value != thing->parent_id * 7) {
+                                bad_things_seen++;
+                            }
+                            things_seen++;
+                        }
+                    }
+                }
+
+                buckets.reclaim();
+            }
+
+            done = true;
+            adder.join();
+            remover.join();
+            gui_writer.join();
+            other_reader.join();
+
+            EXPECT_EQ(0, bad_things_seen);
+            EXPECT_GT(things_seen, 0);
+
+            // With nobody reading any more, everything that was removed should get deleted
+            buckets.reclaim();
+            long num_left = 0;
+            auto reader = buckets.read();
+            for(const auto& entry : reader.get_all()) {
+                num_left += entry.second->size();
+            }
+            EXPECT_EQ(num_left, counted_thing::num_alive);
+        }
+    }
+}
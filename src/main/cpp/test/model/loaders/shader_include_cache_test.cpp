@@ -0,0 +1,195 @@
+/*!
+ * \brief Tests the shader include cache, and checks how much it saves on a pack with deep include trees
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <fstream>
+#include <sstream>
+#include <gtest/gtest.h>
+#include "../../../data_loading/loaders/loaders.h"
+#include "../../../data_loading/loaders/shader_loading.h"
+#include "../../../utils/thread_pool.h"
+
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace nova {
+    namespace test {
+        void make_directory(const std::string &path) {
+#if defined(_WIN32)
+            _mkdir(path.c_str());
+#else
+            mkdir(path.c_str(), 0755);
+#endif
+        }
+
+        void add_test_file(shader_include_cache &cache, const std::string &path, const std::string &source) {
+            std::istringstream stream(source);
+            cache.add_file(stream, path);
+        }
+
+        std::vector<std::string> get_lines(const shader_source &source) {
+            std::vector<std::string> lines;
+            for(std::size_t i = 0; i < source.size(); i++) {
+                lines.push_back(source.get_line(i).to_string());
+            }
+
+            return lines;
+        }
+
+        TEST(shader_include_cache, include_guards_and_pragma_once_stop_repeats) {
+            shader_include_cache cache;
+            add_test_file(cache, "shaderpacks/test/shaders/guarded.glsl",
+                          "// A comment before the guard is fine\n#ifndef GUARDED\n#define GUARDED\nguarded\n#endif\n");
+            add_test_file(cache, "shaderpacks/test/shaders/once.glsl", "#pragma once\nonce\n");
+            add_test_file(cache, "shaderpacks/test/shaders/main.frag",
+                          "#include \"guarded.glsl\"\n#include \"once.glsl\"\n#include \"/guarded.glsl\"\n#include \"once.glsl\"\nmain\n");
+
+            auto lines = get_lines(cache.expand(cache.get_file("shaderpacks/test/shaders/main.frag")));
+
+            std::vector<std::string> expected = {"// A comment before the guard is fine", "#ifndef GUARDED", "#define GUARDED",
+                                                 "guarded", "#endif", "once", "main"};
+            EXPECT_EQ(expected, lines);
+        }
+
+        TEST(shader_include_cache, guard_has_to_cover_the_whole_file) {
+            shader_include_cache cache;
+            add_test_file(cache, "shaderpacks/test/shaders/not_guarded.glsl",
+                          "#ifndef A\n#define A\n#endif\nnot_guarded\n#ifdef B\n#endif\n");
+            add_test_file(cache, "shaderpacks/test/shaders/main.frag",
+                          "#include \"not_guarded.glsl\"\n#include \"not_guarded.glsl\"\n");
+
+            EXPECT_TRUE(cache.get_file("shaderpacks/test/shaders/not_guarded.glsl")->include_guard.empty());
+            EXPECT_EQ(12, cache.expand(cache.get_file("shaderpacks/test/shaders/main.frag")).size());
+        }
+
+        TEST(shader_include_cache, cycles_without_guards_throw) {
+            shader_include_cache cache;
+            add_test_file(cache, "shaderpacks/test/shaders/a.glsl", "#include \"b.glsl\"\n");
+            add_test_file(cache, "shaderpacks/test/shaders/b.glsl", "#include \"a.glsl\"\n");
+
+            EXPECT_THROW(cache.expand(cache.get_file("shaderpacks/test/shaders/a.glsl")), std::runtime_error);
+        }
+
+        TEST(shader_include_cache, cycles_with_guards_stop) {
+            shader_include_cache cache;
+            add_test_file(cache, "shaderpacks/test/shaders/a.glsl", "#pragma once\n#include \"lib/b.glsl\"\na\n");
+            add_test_file(cache, "shaderpacks/test/shaders/lib/b.glsl", "#pragma once\n#include \"../a.glsl\"\nb\n");
+
+            auto lines = get_lines(cache.expand(cache.get_file("shaderpacks/test/shaders/a.glsl")));
+
+            std::vector<std::string> expected = {"b", "a"};
+            EXPECT_EQ(expected, lines);
+        }
+
+        TEST(shader_include_cache, keeps_line_numbers_and_file_names) {
+            shader_include_cache cache;
+            add_test_file(cache, "shaderpacks/test/shaders/lib/common.glsl", "#pragma once\n\ncommon\n");
+            add_test_file(cache, "shaderpacks/test/shaders/main.frag", "#version 450\n#include \"lib/common.glsl\"\nmain\n");
+
+            auto source = cache.expand(cache.get_file("shaderpacks/test/shaders/main.frag"));
+
+            ASSERT_EQ(4, source.size());
+            EXPECT_EQ(3, source.get_line_num(2));
+            EXPECT_EQ("shaderpacks/test/shaders/lib/common.glsl", source.get_file_name(2));
+            EXPECT_EQ(3, source.get_line_num(3));
+            EXPECT_EQ("shaderpacks/test/shaders/main.frag", source.get_file_name(3));
+        }
+
+        TEST(shader_include_cache, text_is_every_line_once) {
+            shader_include_cache cache;
+            add_test_file(cache, "shaderpacks/test/shaders/lib/common.glsl", "#pragma once\ncommon\n");
+            add_test_file(cache, "shaderpacks/test/shaders/main.frag",
+                          "#version 450\n#include \"lib/common.glsl\"\n#include \"lib/common.glsl\"\nvoid main() {}");
+
+            auto source = cache.expand(cache.get_file("shaderpacks/test/shaders/main.frag"));
+
+            // A missing newline at the end of the file gets one, so it doesn't run into whatever comes after it
+            EXPECT_EQ("#version 450\ncommon\nvoid main() {}\n", source.get_text());
+            EXPECT_TRUE(source.get_line(1) == "common");
+        }
+
+        TEST(shader_include_cache, threads_share_one_copy_of_each_file) {
+            const std::string folder = "test_output/include_threads/";
+            make_directory("test_output");
+            make_directory(folder);
+            {
+                std::ofstream common(folder + "common.glsl");
+                common << "#pragma once\nfloat common_value = 1.0;\n";
+            }
+            for(int i = 0; i < 32; i++) {
+                std::ofstream shader(folder + "shader_" + std::to_string(i) + ".frag");
+                shader << "#version 450\n#include \"common.glsl\"\nvoid main() {}\n";
+            }
+
+            shader_include_cache cache;
+            std::vector<shader_source> sources(32);
+            thread_pool workers(4);
+            workers.parallel_for(0, sources.size(), 1, [&](std::size_t begin, std::size_t end) {
+                for(std::size_t i = begin; i < end; i++) {
+                    auto file = find_shader_file(folder + "shader_" + std::to_string(i), {".frag"}, cache);
+                    cache.read_includes(file);
+                    sources[i] = cache.expand(file);
+                }
+            });
+
+            for(const auto& source : sources) {
+                ASSERT_EQ(3, source.size());
+                EXPECT_EQ(folder + "common.glsl", source.get_file_name(1));
+                EXPECT_TRUE(source.get_line(1) == "float common_value = 1.0;");
+            }
+
+            // Two threads might both read common.glsl before either of them adds it, but never more than one per thread
+            EXPECT_LE(cache.get_num_files_read(), 32 + workers.get_num_threads() + 1);
+        }
+
+        TEST(shader_include_cache, shared_cache_reads_deep_include_trees_once) {
+            // Forty shaders that each include the top of a twenty-deep chain of headers, which is about what the big
+            // packs look like
+            const int num_shaders = 40;
+            const int include_depth = 20;
+            const std::string folder = "test_output/deep_includes/";
+            make_directory("test_output");
+            make_directory(folder);
+            make_directory(folder + "lib");
+
+            for(int i = 0; i < include_depth; i++) {
+                std::ofstream header(folder + "lib/header_" + std::to_string(i) + ".glsl");
+                header << "#ifndef HEADER_" << i << "\n#define HEADER_" << i << "\n";
+                if(i + 1 < include_depth) {
+                    header << "#include \"header_" << i + 1 << ".glsl\"\n";
+                }
+                for(int line = 0; line < 50; line++) {
+                    header << "float function_" << i << "_" << line << "(float x) { return x * " << line << ".0; }\n";
+                }
+                header << "#endif\n";
+            }
+            for(int i = 0; i < num_shaders; i++) {
+                std::ofstream shader(folder + "shader_" + std::to_string(i) + ".frag");
+                shader << "#version 450\n#include \"lib/header_0.glsl\"\nvoid main() {}\n";
+            }
+
+            // A new cache for every shader reads everything again, like loading used to
+            std::size_t unshared_files_read = 0;
+            for(int i = 0; i < num_shaders; i++) {
+                shader_include_cache cache;
+                load_shader_file(folder + "shader_" + std::to_string(i), {".frag"}, cache);
+                unshared_files_read += cache.get_num_files_read();
+            }
+
+            shader_include_cache shared_cache;
+            for(int i = 0; i < num_shaders; i++) {
+                auto source = load_shader_file(folder + "shader_" + std::to_string(i), {".frag"}, shared_cache);
+                ASSERT_EQ(2 + include_depth * 53, source.size());
+            }
+
+            EXPECT_EQ(num_shaders * (include_depth + 1), unshared_files_read);
+            EXPECT_EQ(num_shaders + include_depth, shared_cache.get_num_files_read());
+        }
+    }
+}
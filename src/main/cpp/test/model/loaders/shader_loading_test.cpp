@@ -5,6 +5,7 @@
  * \date 26-Oct-16.
  */
 
+#include <algorithm>
 #include <fstream>
 
 #include <gtest/gtest.h>
@@ -30,10 +31,9 @@ namespace nova {
             EXPECT_EQ(shader_file.size(), 70);
         
             // Do the lines we read in make sense? Let's grab a couple and see what's up
-            auto line_5 = shader_file[4];
-            EXPECT_EQ(line_5.line_num, 5);
-            EXPECT_EQ(line_5.shader_name, shader_path);
-            EXPECT_EQ(line_5.line, "layout(std140) uniform per_frame_uniforms {");
+            EXPECT_EQ(shader_file.get_line_num(4), 5);
+            EXPECT_EQ(shader_file.get_file_name(4), shader_path);
+            EXPECT_EQ(shader_file.get_line(4).to_string(), "layout(std140) uniform per_frame_uniforms {");
         }
         
         TEST(shader_loading, read_shader_stream_includes) {
@@ -46,15 +46,13 @@ namespace nova {
         
             EXPECT_EQ(shader_file.size(), 84);
         
-            auto line_5 = shader_file[4];
-            EXPECT_EQ(line_5.line_num, 3);
-            EXPECT_EQ(line_5.shader_name, "shaderpacks/default/shaders/gui.frag");
-            EXPECT_EQ(line_5.line, "layout(binding = 0) uniform sampler2D colortex;");
+            EXPECT_EQ(shader_file.get_line_num(4), 3);
+            EXPECT_EQ(shader_file.get_file_name(4), "shaderpacks/default/shaders/gui.frag");
+            EXPECT_EQ(shader_file.get_line(4).to_string(), "layout(binding = 0) uniform sampler2D colortex;");
         
-            auto line_83 = shader_file[82];
-            EXPECT_EQ(line_83.line_num, 14);
-            EXPECT_EQ(line_83.shader_name, shader_path);
-            EXPECT_EQ(line_83.line, "    color = vec3(1, 0, 1);");
+            EXPECT_EQ(shader_file.get_line_num(82), 14);
+            EXPECT_EQ(shader_file.get_file_name(82), shader_path);
+            EXPECT_EQ(shader_file.get_line(82).to_string(), "    color = vec3(1, 0, 1);");
         }
         
         TEST(shader_loading, get_filename_from_include_relative) {
@@ -81,10 +79,9 @@ namespace nova {
         
             EXPECT_EQ(shader_file.size(), 70);
         
-            auto line_5 = shader_file[4];
-            EXPECT_EQ(line_5.line_num, 5);
-            EXPECT_EQ(line_5.shader_name, "shaderpacks/default/shaders/gui.frag");
-            EXPECT_EQ(line_5.line, "layout(std140) uniform per_frame_uniforms {");
+            EXPECT_EQ(shader_file.get_line_num(4), 5);
+            EXPECT_EQ(shader_file.get_file_name(4), "shaderpacks/default/shaders/gui.frag");
+            EXPECT_EQ(shader_file.get_line(4).to_string(), "layout(std140) uniform per_frame_uniforms {");
         }
         
         TEST(shader_loading, load_shader_file_no_includes_no_extensions) {
@@ -102,10 +99,9 @@ namespace nova {
         
             EXPECT_EQ(shader_file.size(), 70);
         
-            auto line_5 = shader_file[4];
-            EXPECT_EQ(line_5.line_num, 5);
-            EXPECT_EQ(line_5.shader_name, "shaderpacks/default/shaders/gui.frag");
-            EXPECT_EQ(line_5.line, "layout(std140) uniform per_frame_uniforms {");
+            EXPECT_EQ(shader_file.get_line_num(4), 5);
+            EXPECT_EQ(shader_file.get_file_name(4), "shaderpacks/default/shaders/gui.frag");
+            EXPECT_EQ(shader_file.get_line(4).to_string(), "layout(std140) uniform per_frame_uniforms {");
         }
         
         TEST(shader_loading, load_shader_file_no_includes_two_extensions) {
@@ -116,10 +112,9 @@ namespace nova {
         
             EXPECT_EQ(shader_file.size(), 70);
         
-            auto line_5 = shader_file[4];
-            EXPECT_EQ(line_5.line_num, 5);
-            EXPECT_EQ(line_5.shader_name, "shaderpacks/default/shaders/gui.frag");
-            EXPECT_EQ(line_5.line, "layout(std140) uniform per_frame_uniforms {");
+            EXPECT_EQ(shader_file.get_line_num(4), 5);
+            EXPECT_EQ(shader_file.get_file_name(4), "shaderpacks/default/shaders/gui.frag");
+            EXPECT_EQ(shader_file.get_line(4).to_string(), "layout(std140) uniform per_frame_uniforms {");
         }
         
         TEST(shader_loading, load_shader_file_one_include_one_extension) {
@@ -130,32 +125,68 @@ namespace nova {
         
             EXPECT_EQ(shader_file.size(), 84);
         
-            auto line_5 = shader_file[4];
-            EXPECT_EQ(line_5.line_num, 3);
-            EXPECT_EQ(line_5.shader_name, "shaderpacks/default/shaders/gui.frag");
-            EXPECT_EQ(line_5.line, "layout(binding = 0) uniform sampler2D colortex;");
+            EXPECT_EQ(shader_file.get_line_num(4), 3);
+            EXPECT_EQ(shader_file.get_file_name(4), "shaderpacks/default/shaders/gui.frag");
+            EXPECT_EQ(shader_file.get_line(4).to_string(), "layout(binding = 0) uniform sampler2D colortex;");
         
-            auto line_33 = shader_file[82];
-            EXPECT_EQ(line_33.line_num, 14);
-            EXPECT_EQ(line_33.shader_name, "shaderpacks/default/shaders/gui_with_include.frag");
-            EXPECT_EQ(line_33.line, "    color = vec3(1, 0, 1);");
+            EXPECT_EQ(shader_file.get_line_num(82), 14);
+            EXPECT_EQ(shader_file.get_file_name(82), "shaderpacks/default/shaders/gui_with_include.frag");
+            EXPECT_EQ(shader_file.get_line(82).to_string(), "    color = vec3(1, 0, 1);");
         }
         
+        TEST(shader_loading, load_spirv_file) {
+            nova::shader_include_cache includes;
+            EXPECT_FALSE(nova::load_spirv_file("test_spirv", {".frag.spv"}, includes));
+
+            {
+                std::ofstream not_spirv("test_spirv.frag.spv", std::ios::binary);
+                not_spirv << "#version 450\nvoid main() {}\n";
+            }
+            EXPECT_THROW(nova::load_spirv_file("test_spirv", {".frag.spv"}, includes), std::runtime_error);
+
+            const std::uint32_t header[] = {0x07230203, 0x00010000, 0, 1, 0};
+            {
+                std::ofstream spirv("test_spirv.frag.spv", std::ios::binary);
+                spirv.write(reinterpret_cast<const char*>(header), sizeof(header));
+            }
+            auto module = nova::load_spirv_file("test_spirv", {".frag.spv"}, includes);
+            ASSERT_TRUE(module);
+            EXPECT_EQ(module->path, "test_spirv.frag.spv");
+            EXPECT_EQ(module->words, std::vector<std::uint32_t>(std::begin(header), std::end(header)));
+
+            std::remove("test_spirv.frag.spv");
+        }
+
         TEST(shader_loading, load_sources_from_folder) {
             auto shaderpack_name = "default";
             auto shader_names = std::vector<std::string>{"gui"};
         
-            auto shaderpack = nova::load_sources_from_folder(shaderpack_name, shader_names);
+            nova::thread_pool workers;
+            auto shaderpack = nova::load_sources_from_folder(shaderpack_name, shader_names, workers);
         
             auto gui_shader = shaderpack["gui"];
         
             EXPECT_EQ(gui_shader.get_name(), "gui");
         }
         
+        TEST(shader_loading, load_shaderpack_sources_without_opengl) {
+            // Shaderpacks are read on another thread, so this mustn't need a context
+            nova::thread_pool workers;
+            auto sources = nova::load_shaderpack_sources("default", workers);
+
+            EXPECT_EQ(sources.name, "default");
+            auto gui = std::find_if(sources.shaders.begin(), sources.shaders.end(), [](const nova::shader_definition &shader) {
+                return shader.name == "gui";
+            });
+            ASSERT_NE(gui, sources.shaders.end());
+            EXPECT_FALSE(gui->fragment_source.empty());
+        }
+
         TEST_F(shader_loading_test, load_shaderpack_folder) {        
             auto shaderpack_name = "default";
         
-            auto shaderpack = nova::load_shaderpack(shaderpack_name);
+            nova::thread_pool workers;
+            auto shaderpack = nova::load_shaderpack(shaderpack_name, workers);
         
             auto gui_shader = shaderpack["gui"];
         
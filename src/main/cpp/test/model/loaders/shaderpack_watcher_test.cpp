@@ -0,0 +1,72 @@
+/*!
+ * \brief Tests that editing files in a shaderpack is noticed
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <gtest/gtest.h>
+#include "../../../data_loading/loaders/shaderpack_watcher.h"
+
+// The watcher only sees changes on Linux
+#if defined(__linux__)
+#include <sys/stat.h>
+
+namespace nova {
+    namespace test {
+        void make_watched_directory(const std::string &path) {
+            mkdir(path.c_str(), 0755);
+        }
+
+        void write_watched_file(const std::string &path, const std::string &text) {
+            std::ofstream file(path);
+            file << text;
+        }
+
+        /*!
+         * \brief Waits for the watcher to decide the folder's settled, then gets what changed
+         */
+        std::unordered_set<std::string> wait_for_changes(shaderpack_watcher &watcher) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(shaderpack_watcher::SETTLE_TIME_MS * 2));
+            watcher.get_changed_files();
+            std::this_thread::sleep_for(std::chrono::milliseconds(shaderpack_watcher::SETTLE_TIME_MS * 2));
+            return watcher.get_changed_files();
+        }
+
+        TEST(shaderpack_watcher, sees_edits_in_nested_folders) {
+            make_watched_directory("watched_pack");
+            make_watched_directory("watched_pack/shaders");
+            write_watched_file("watched_pack/shaders/gui.frag", "#version 450\n");
+
+            shaderpack_watcher watcher("watched_pack");
+            EXPECT_TRUE(watcher.get_changed_files().empty());
+
+            write_watched_file("watched_pack/shaders/gui.frag", "#version 450\nvoid main() {}\n");
+
+            // Nothing's given out until the folder's been quiet for a bit, so a save that takes a few steps is one change
+            EXPECT_TRUE(watcher.get_changed_files().empty());
+            std::this_thread::sleep_for(std::chrono::milliseconds(shaderpack_watcher::SETTLE_TIME_MS * 2));
+            auto changed = watcher.get_changed_files();
+            EXPECT_EQ(changed, std::unordered_set<std::string>{"watched_pack/shaders/gui.frag"});
+            EXPECT_TRUE(watcher.get_changed_files().empty());
+
+            // Folders made after the watcher was are watched too
+            make_watched_directory("watched_pack/shaders/lib");
+            wait_for_changes(watcher);
+            write_watched_file("watched_pack/shaders/lib/common.glsl", "vec4 color;\n");
+            changed = wait_for_changes(watcher);
+            EXPECT_EQ(changed, std::unordered_set<std::string>{"watched_pack/shaders/lib/common.glsl"});
+
+            std::remove("watched_pack/shaders/lib/common.glsl");
+            std::remove("watched_pack/shaders/lib");
+            std::remove("watched_pack/shaders/gui.frag");
+            std::remove("watched_pack/shaders");
+            std::remove("watched_pack");
+        }
+    }
+}
+
+#endif
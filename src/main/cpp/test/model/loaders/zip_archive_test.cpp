@@ -0,0 +1,81 @@
+/*!
+ * \brief Tests reading files and whole shaderpacks out of zip files
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#define MINIZ_HEADER_FILE_ONLY
+#include "miniz.c"
+#include <gtest/gtest.h>
+#include "../../../data_loading/loaders/loaders.h"
+#include "../../../data_loading/loaders/shader_loading.h"
+#include "../../../data_loading/loaders/zip_archive.h"
+
+namespace nova {
+    namespace test {
+        /*!
+         * \brief Writes a zip file with the given files in it
+         *
+         * \param level 0 stores the files as they are, anything higher deflates them
+         */
+        void write_test_zip(const std::string &path, const std::vector<std::pair<std::string, std::string>> &files, mz_uint level) {
+            mz_zip_archive zip = {};
+            ASSERT_TRUE(mz_zip_writer_init_file(&zip, path.c_str(), 0));
+            for(const auto& file : files) {
+                ASSERT_TRUE(mz_zip_writer_add_mem(&zip, file.first.c_str(), file.second.data(), file.second.size(), level));
+            }
+            ASSERT_TRUE(mz_zip_writer_finalize_archive(&zip));
+            mz_zip_writer_end(&zip);
+        }
+
+        TEST(zip_archive, reads_stored_and_deflated_files) {
+            std::string text = "#version 450\n";
+            for(int i = 0; i < 100; i++) {
+                text += "uniform vec4 value_" + std::to_string(i) + ";\n";
+            }
+
+            for(mz_uint level : {0u, 6u}) {
+                write_test_zip("test_archive.zip", {{"shaders/gui.frag", text}, {"shaders.json", "[]"}}, level);
+
+                zip_archive archive("test_archive.zip");
+                ASSERT_TRUE(archive.is_open());
+                EXPECT_TRUE(archive.has_file("shaders.json"));
+                EXPECT_EQ(archive.get_file_names().size(), 2);
+
+                std::string read_text;
+                EXPECT_TRUE(archive.read_file("shaders/gui.frag", read_text));
+                EXPECT_EQ(read_text, text);
+                EXPECT_FALSE(archive.read_file("shaders/gui.vert", read_text));
+            }
+
+            std::remove("test_archive.zip");
+        }
+
+        TEST(zip_archive, missing_file_is_not_open) {
+            zip_archive archive("there_is_no_zip_here.zip");
+            EXPECT_FALSE(archive.is_open());
+            EXPECT_FALSE(archive.has_file("shaders.json"));
+        }
+
+        TEST(zip_archive, includes_resolve_like_a_folder) {
+            write_test_zip("test_archive.zip", {
+                    {"pack/shaders/gui.frag", "#include \"/lib/common.glsl\"\n#include \"lib/local.glsl\"\nvoid main() {}\n"},
+                    {"pack/shaders/lib/common.glsl", "#pragma once\nvec4 common_color;\n"},
+                    {"pack/shaders/lib/local.glsl", "#include \"common.glsl\"\nvec4 local_color;\n"}
+            }, 6);
+
+            auto archive = std::make_shared<const zip_archive>("test_archive.zip");
+            shader_include_cache includes(archive, "shaderpacks/test_archive.zip/", "pack/");
+            auto source = load_shader_file("shaderpacks/test_archive.zip/shaders/gui", {".frag"}, includes);
+
+            EXPECT_EQ(source.get_text(), "vec4 common_color;\nvec4 local_color;\nvoid main() {}\n");
+            EXPECT_EQ(includes.get_num_files_read(), 3);
+
+            // Files outside the zip's folder aren't in the zip, even if they're on disk
+            EXPECT_EQ(includes.get_file("shaderpacks/test_archive.zip/../default/shaders/gui.frag"), nullptr);
+
+            std::remove("test_archive.zip");
+        }
+    }
+}
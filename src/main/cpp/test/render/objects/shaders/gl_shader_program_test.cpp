@@ -28,6 +28,126 @@ namespace nova {
             nova::nova_renderer::deinit();
         }
 
+        nova::shader_definition make_definition(const std::string &fragment_text) {
+            auto json = get_gui_def_json();
+            nova::shader_definition def(json);
+            def.vertex_source = nova::shader_source(std::make_shared<nova::shader_source_file>(
+                    "test.vert", "#version 450\nvoid main() { gl_Position = vec4(0); }\n"));
+            def.fragment_source = nova::shader_source(std::make_shared<nova::shader_source_file>("test.frag", fragment_text));
+            return def;
+        }
+
+        TEST(gl_shader_program, compiles_when_asked) {
+            nova::nova_renderer::init();
+
+            nova::gl_shader_program shader(make_definition("#version 450\nout vec4 color;\nvoid main() { color = vec4(1); }\n"));
+            EXPECT_EQ(nova::program_status::not_started, shader.get_status());
+
+            shader.start_compiling();
+            EXPECT_EQ(nova::program_status::ready, shader.finish_compiling(true));
+            EXPECT_TRUE(shader.is_ready());
+            EXPECT_NE(0, shader.get_gl_name());
+
+            nova::nova_renderer::deinit();
+        }
+
+        TEST(gl_shader_program, compile_errors_fail_the_program) {
+            nova::nova_renderer::init();
+
+            nova::gl_shader_program shader(make_definition("#version 450\nout vec4 color;\nvoid main() { color = ; }\n"));
+            shader.start_compiling();
+            EXPECT_EQ(nova::program_status::failed, shader.finish_compiling(true));
+            EXPECT_FALSE(shader.is_ready());
+            EXPECT_EQ(0, shader.get_gl_name());
+
+            nova::nova_renderer::deinit();
+        }
+
+        TEST(gl_shader_program, only_options_the_source_mentions_are_used) {
+            auto def = make_definition("#version 450\n#ifdef SOFT_SHADOWS\nfloat soft;\n#endif\nfloat SOFT_SHADOWS_RADIUS;\n");
+
+            // SOFT_SHADOWS_RADIUS is a different identifier, so it doesn't count as using SOFT_SHADOWS_RADI
+            nova::gl_shader_program shader(def, nullptr, {"BLOOM", "SOFT_SHADOWS", "SOFT_SHADOWS_RADI"}, 0);
+            EXPECT_EQ(0b010u, shader.get_used_options());
+        }
+
+        /*!
+         * \brief Packs a string into SPIR-V words, four characters to a word with a '\0' on the end
+         */
+        std::vector<std::uint32_t> spirv_string(const std::string &text) {
+            std::vector<std::uint32_t> words(text.size() / 4 + 1, 0);
+            for(std::size_t i = 0; i < text.size(); i++) {
+                words[i / 4] |= (std::uint32_t) (unsigned char) text[i] << (i % 4 * 8);
+            }
+            return words;
+        }
+
+        TEST(gl_shader_program, spirv_specialization_constants_are_options) {
+            // Just the bits of a module that name things: %5 is a specialization constant named SOFT_SHADOWS with
+            // constant_id 3, and %6 is named BLOOM but isn't a specialization constant
+            nova::spirv_module module;
+            module.path = "test.frag.spv";
+            module.words = {0x07230203, 0x00010000, 0, 7, 0};
+            for(const auto& name : std::vector<std::pair<std::uint32_t, std::string>>{{5, "SOFT_SHADOWS"}, {6, "BLOOM"}}) {
+                auto name_words = spirv_string(name.second);
+                module.words.push_back((std::uint32_t) (2 + name_words.size()) << 16 | 5);
+                module.words.push_back(name.first);
+                module.words.insert(module.words.end(), name_words.begin(), name_words.end());
+            }
+            module.words.insert(module.words.end(), {4 << 16 | 71, 5, 1, 3});
+
+            auto def = make_definition("#version 450\n");
+            def.vertex_spirv = module;
+            def.fragment_spirv = module;
+
+            nova::gl_shader_program shader(def, nullptr, {"BLOOM", "SOFT_SHADOWS"}, 0);
+            EXPECT_EQ(0b10u, shader.get_used_options());
+
+            // Without SPIR-V for every stage it's the GLSL that's used, and that doesn't mention either option
+            def.vertex_spirv = nullopt;
+            nova::gl_shader_program glsl_shader(def, nullptr, {"BLOOM", "SOFT_SHADOWS"}, 0);
+            EXPECT_EQ(0u, glsl_shader.get_used_options());
+        }
+
+        TEST(gl_shader_program, options_are_defined_after_the_version_line) {
+            nova::nova_renderer::init();
+
+            auto def = make_definition("#version 450\nout vec4 color;\nvoid main() {\n#ifdef RED\n color = vec4(1, 0, 0, 1);\n#else\n broken\n#endif\n}\n");
+            nova::gl_shader_program shader(def, nullptr, {"RED"}, 1);
+            shader.start_compiling();
+            EXPECT_EQ(nova::program_status::ready, shader.finish_compiling(true));
+            auto red_program = shader.get_gl_name();
+
+            // The variant without RED doesn't compile, so the red one keeps being drawn with
+            shader.set_options(0);
+            shader.start_compiling();
+            EXPECT_EQ(nova::program_status::failed, shader.finish_compiling(true));
+            EXPECT_TRUE(shader.is_ready());
+            EXPECT_EQ(red_program, shader.get_gl_name());
+
+            // Going back to options that were already compiled doesn't compile anything
+            shader.set_options(1);
+            EXPECT_EQ(nova::program_status::ready, shader.get_status());
+
+            nova::nova_renderer::deinit();
+        }
+
+        TEST(gl_shader_program, compilation_error_finds_original_line) {
+            auto lib = std::make_shared<nova::shader_source_file>("shaders/lib.glsl", "float a;\nfloat b = ;\n");
+            auto main = std::make_shared<nova::shader_source_file>("shaders/main.frag", "#version 450\n#include \"lib.glsl\"\nvoid main() {}\n");
+            nova::shader_source source;
+            source.add_lines(source.add_file(main), 0, 1);
+            source.add_lines(source.add_file(lib), 0, 2);
+            source.add_lines(source.add_file(main), 2, 3);
+
+            // Nvidia and Mesa put the line number in different places
+            std::string nvidia_message = nova::compilation_error("0(3) : error C0000: syntax error\n", source).what();
+            std::string mesa_message = nova::compilation_error("0:4(1): error: syntax error\n", source).what();
+
+            EXPECT_NE(std::string::npos, nvidia_message.find("Line 3 is line 2 of shaders/lib.glsl: float b = ;"));
+            EXPECT_NE(std::string::npos, mesa_message.find("Line 4 is line 3 of shaders/main.frag: void main() {}"));
+        }
+
         nlohmann::json get_gui_def_json() {
             return {
                     {"name",     "gui"},
@@ -37,11 +157,10 @@ namespace nova {
         };
 
         void add_shader_source_to_definition(nova::shader_definition &def) {
-            auto version_line = nova::shader_line{0, "gbuffers_basic.vert", "#version 450"};
-            auto lines = std::vector<nova::shader_line>{version_line};
+            auto source = nova::shader_source(std::make_shared<nova::shader_source_file>("gbuffers_basic.vert", "#version 450\n"));
 
-            def.vertex_source = lines;
-            def.fragment_source = lines;
+            def.vertex_source = source;
+            def.fragment_source = source;
         }
     }
 }
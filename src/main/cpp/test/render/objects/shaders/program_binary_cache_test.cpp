@@ -0,0 +1,73 @@
+/*!
+ * \brief Tests the on-disk cache of linked programs
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include "../../../../render/objects/shaders/program_binary_cache.h"
+
+namespace nova {
+    namespace test {
+        TEST(program_binary_cache, keys_change_with_the_driver_and_the_source) {
+            program_binary_cache cache("test_output/program_cache", "Vendor\nRenderer\n4.6.0 1.0");
+            auto key = cache.get_key({"#version 450\nvoid main() {}\n", "#version 450\nvoid main() {}\n"});
+
+            program_binary_cache updated_driver("test_output/program_cache", "Vendor\nRenderer\n4.6.0 1.1");
+            EXPECT_NE(key, updated_driver.get_key({"#version 450\nvoid main() {}\n", "#version 450\nvoid main() {}\n"}));
+
+            EXPECT_NE(key, cache.get_key({"#version 450\n#define A\nvoid main() {}\n", "#version 450\nvoid main() {}\n"}));
+            EXPECT_NE(key, cache.get_key({"#version 450\nvoid main() {}\n#version 450\n", "void main() {}\n"}));
+            EXPECT_EQ(key, cache.get_key({"#version 450\nvoid main() {}\n", "#version 450\nvoid main() {}\n"}));
+        }
+
+        TEST(program_binary_cache, stores_loads_and_removes) {
+            program_binary_cache cache("test_output/program_cache", "Vendor\nRenderer\n4.6.0");
+            auto key = cache.get_key({"stores_loads_and_removes"});
+
+            program_binary binary = {0x8E21, {1, 2, 3, 4, 5, 6, 7}};
+            cache.store(key, binary);
+
+            auto loaded = cache.load(key);
+            ASSERT_TRUE((bool) loaded);
+            EXPECT_EQ(binary.format, loaded->format);
+            EXPECT_EQ(binary.data, loaded->data);
+
+            cache.remove(key);
+            EXPECT_FALSE((bool) cache.load(key));
+        }
+
+        TEST(program_binary_cache, ignores_damaged_files) {
+            program_binary_cache cache("test_output/program_cache", "Vendor\nRenderer\n4.6.0");
+            auto key = cache.get_key({"ignores_damaged_files"});
+            cache.store(key, {0x8E21, std::vector<std::uint8_t>(64, 9)});
+
+            char name[64];
+            std::snprintf(name, sizeof(name), "test_output/program_cache/%016llx.bin", (unsigned long long) key);
+
+            // Change one byte of the binary
+            {
+                std::fstream file(name, std::ios::in | std::ios::out | std::ios::binary);
+                file.seekp(-1, std::ios::end);
+                file.put(10);
+            }
+            EXPECT_FALSE((bool) cache.load(key));
+
+            // Chop the end off
+            cache.store(key, {0x8E21, std::vector<std::uint8_t>(64, 9)});
+            std::vector<char> contents(1024);
+            std::FILE* file = std::fopen(name, "rb");
+            ASSERT_NE(nullptr, file);
+            auto file_size = std::fread(contents.data(), 1, contents.size(), file);
+            std::fclose(file);
+            file = std::fopen(name, "wb");
+            std::fwrite(contents.data(), 1, file_size - 16, file);
+            std::fclose(file);
+
+            EXPECT_FALSE((bool) cache.load(key));
+        }
+    }
+}
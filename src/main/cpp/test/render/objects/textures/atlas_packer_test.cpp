@@ -0,0 +1,175 @@
+/*!
+ * \brief Tests the MaxRects atlas packer, and checks how tightly it packs a Minecraft-ish set of textures
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../../../../render/objects/textures/atlas_packer.h"
+
+namespace nova {
+    namespace test {
+        /*!
+         * \brief Makes a set of sprites that looks like a resource pack: lots of 16x16 blocks, some bigger GUI and
+         * entity textures, and a handful of odd sizes
+         */
+        std::vector<std::pair<std::string, glm::ivec2>> make_resource_pack_sprites(std::size_t num_sprites) {
+            std::mt19937 rng(4321);
+            std::uniform_int_distribution<int> kind_distribution(0, 9);
+            std::uniform_int_distribution<int> odd_size_distribution(4, 96);
+
+            std::vector<std::pair<std::string, glm::ivec2>> sprites;
+            for(std::size_t i = 0; i < num_sprites; i++) {
+                glm::ivec2 size;
+                int kind = kind_distribution(rng);
+                if(kind < 6) {
+                    size = {16, 16};
+                } else if(kind < 8) {
+                    size = {32, 32};
+                } else if(kind < 9) {
+                    size = {64, 32};
+                } else {
+                    size = {odd_size_distribution(rng), odd_size_distribution(rng)};
+                }
+
+                sprites.emplace_back("sprite_" + std::to_string(i), size);
+            }
+
+            return sprites;
+        }
+
+        void check_packing_is_valid(const atlas_packer &packer) {
+            std::vector<std::vector<atlas_rect>> rects_per_page(packer.get_num_pages());
+
+            for(const auto& sprite : packer.get_sprites()) {
+                ASSERT_LT(sprite.second.page, packer.get_num_pages()) << sprite.first;
+
+                const auto& cell = sprite.second.cell;
+                int padding = packer.get_padding();
+                atlas_rect padded_sprite = {sprite.second.position.x - padding, sprite.second.position.y - padding,
+                                            sprite.second.size.x + padding * 2, sprite.second.size.y + padding * 2};
+                EXPECT_TRUE(cell.contains(padded_sprite)) << sprite.first << " doesn't fit in its cell";
+                auto page_size = packer.get_page(sprite.second.page).get_size();
+                EXPECT_TRUE((atlas_rect{0, 0, page_size.x, page_size.y}.contains(cell))) << sprite.first << " is outside its page";
+
+                for(const auto& other_rect : rects_per_page[sprite.second.page]) {
+                    ASSERT_FALSE(cell.intersects(other_rect)) << sprite.first << " overlaps another sprite";
+                }
+                rects_per_page[sprite.second.page].push_back(cell);
+            }
+        }
+
+        TEST(atlas_packer, packs_without_overlapping) {
+            atlas_packer packer(1024, 1);
+            auto not_packed = packer.add_all(make_resource_pack_sprites(500));
+
+            EXPECT_TRUE(not_packed.empty());
+            EXPECT_EQ(500, packer.get_sprites().size());
+            check_packing_is_valid(packer);
+        }
+
+        TEST(atlas_packer, grows_a_page_before_making_a_new_one) {
+            atlas_packer packer(1024, 0, 16);
+
+            ASSERT_TRUE(packer.add("a", {16, 16}));
+            ASSERT_TRUE(packer.add("b", {16, 16}));
+            ASSERT_TRUE(packer.add("c", {32, 32}));
+
+            EXPECT_EQ(1, packer.get_num_pages());
+            EXPECT_EQ(glm::ivec2(64, 32), packer.get_page(0).get_size());
+            check_packing_is_valid(packer);
+        }
+
+        TEST(atlas_packer, adding_sprites_does_not_move_old_ones) {
+            atlas_packer packer(2048, 1, 64);
+            auto sprites = make_resource_pack_sprites(300);
+
+            std::vector<std::pair<std::string, glm::ivec2>> first_half(sprites.begin(), sprites.begin() + 150);
+            std::vector<std::pair<std::string, glm::ivec2>> second_half(sprites.begin() + 150, sprites.end());
+
+            packer.add_all(first_half);
+            auto old_sprites = packer.get_sprites();
+
+            packer.add_all(second_half);
+            for(const auto& old_sprite : old_sprites) {
+                const auto& new_sprite = packer.get_sprite(old_sprite.first);
+                EXPECT_EQ(old_sprite.second.page, new_sprite.page);
+                EXPECT_EQ(old_sprite.second.position, new_sprite.position);
+            }
+
+            EXPECT_EQ(300, packer.get_sprites().size());
+            check_packing_is_valid(packer);
+        }
+
+        TEST(atlas_packer, makes_new_pages_when_full) {
+            atlas_packer packer(64);
+
+            // Each page holds exactly four of these
+            for(int i = 0; i < 9; i++) {
+                ASSERT_TRUE(packer.add("sprite_" + std::to_string(i), {32, 32}));
+            }
+
+            EXPECT_EQ(3, packer.get_num_pages());
+            check_packing_is_valid(packer);
+        }
+
+        TEST(atlas_packer, rejects_sprites_bigger_than_a_page) {
+            atlas_packer packer(64, 1);
+
+            EXPECT_FALSE(packer.add("too_big", {64, 64}));
+            EXPECT_TRUE(packer.add("just_right", {62, 62}));
+            EXPECT_FALSE(packer.contains("too_big"));
+        }
+
+        TEST(atlas_packer, aligned_cells_start_on_aligned_texels) {
+            atlas_packer packer(2048, 0, 256, 16);
+            packer.add_all(make_resource_pack_sprites(500));
+
+            for(const auto& sprite : packer.get_sprites()) {
+                EXPECT_EQ(0, sprite.second.cell.x % 16) << sprite.first;
+                EXPECT_EQ(0, sprite.second.cell.y % 16) << sprite.first;
+                EXPECT_EQ(0, sprite.second.cell.width % 16) << sprite.first;
+                EXPECT_EQ(0, sprite.second.cell.height % 16) << sprite.first;
+            }
+            check_packing_is_valid(packer);
+        }
+
+        TEST(atlas_packer, uvs_cover_the_sprite) {
+            atlas_packer packer(256, 0, 64);
+            packer.add("a", {32, 16});
+
+            glm::vec2 min, max;
+            packer.get_uv_bounds("a", min, max);
+
+            const auto& sprite = packer.get_sprite("a");
+            EXPECT_FLOAT_EQ(sprite.position.x / 64.0f, min.x);
+            EXPECT_FLOAT_EQ(sprite.position.y / 64.0f, min.y);
+            EXPECT_FLOAT_EQ(32.0f / 64.0f, max.x - min.x);
+            EXPECT_FLOAT_EQ(16.0f / 64.0f, max.y - min.y);
+        }
+
+        TEST(atlas_packer, packs_a_resource_pack_densely) {
+            auto sprites = make_resource_pack_sprites(4000);
+
+            atlas_packer batch_packer(8192, 1);
+            batch_packer.add_all(sprites);
+
+            // Packing a few sprites at a time, like when resource packs get loaded one after another, can't sort
+            // everything up front so it's expected to be a bit worse
+            atlas_packer incremental_packer(8192, 1);
+            for(std::size_t i = 0; i < sprites.size(); i += 100) {
+                auto end = std::min(i + 100, sprites.size());
+                incremental_packer.add_all({sprites.begin() + i, sprites.begin() + end});
+            }
+
+            check_packing_is_valid(batch_packer);
+            check_packing_is_valid(incremental_packer);
+
+            EXPECT_EQ(1, batch_packer.get_num_pages());
+            EXPECT_GT(batch_packer.get_occupancy(), 0.75f);
+        }
+    }
+}
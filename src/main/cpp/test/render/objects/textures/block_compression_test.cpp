@@ -0,0 +1,183 @@
+/*!
+ * \brief Tests the block compression encoders, and checks how good they look
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <gtest/gtest.h>
+#include "../../../../render/objects/textures/block_compression.h"
+
+namespace nova {
+    namespace test {
+        /*!
+         * \brief Makes something that looks like a terrain atlas: 16x16 tiles of a few base colors with noise on
+         * top, and every fourth tile a cutout with transparent holes
+         */
+        rgba8_image make_block_atlas(glm::ivec2 size) {
+            std::mt19937 rng(1357);
+            std::uniform_int_distribution<int> color_distribution(40, 215);
+            std::uniform_int_distribution<int> noise_distribution(-24, 24);
+            std::uniform_int_distribution<int> hole_distribution(0, 2);
+
+            rgba8_image atlas;
+            atlas.size = size;
+            atlas.pixels.resize((std::size_t) size.x * size.y * 4);
+
+            for(int tile_y = 0; tile_y < size.y / 16; tile_y++) {
+                for(int tile_x = 0; tile_x < size.x / 16; tile_x++) {
+                    int base[3] = {color_distribution(rng), color_distribution(rng), color_distribution(rng)};
+                    bool is_cutout = (tile_x + tile_y) % 4 == 0;
+
+                    for(int y = 0; y < 16; y++) {
+                        for(int x = 0; x < 16; x++) {
+                            auto pixel = &atlas.pixels[((std::size_t) (tile_y * 16 + y) * size.x + tile_x * 16 + x) * 4];
+                            int noise = noise_distribution(rng);
+                            for(int c = 0; c < 3; c++) {
+                                pixel[c] = (std::uint8_t) std::min(std::max(base[c] + noise, 0), 255);
+                            }
+                            pixel[3] = (std::uint8_t) (is_cutout && hole_distribution(rng) == 0 ? 0 : 255);
+                        }
+                    }
+                }
+            }
+
+            return atlas;
+        }
+
+        rgba8_image decompress_image(const std::vector<std::uint8_t> &compressed, glm::ivec2 size, texture_compression compression) {
+            rgba8_image image;
+            image.size = size;
+            image.pixels.resize((std::size_t) size.x * size.y * 4);
+
+            int blocks_wide = (size.x + 3) / 4;
+            std::uint8_t texels[64];
+            for(int block_y = 0; block_y < (size.y + 3) / 4; block_y++) {
+                for(int block_x = 0; block_x < blocks_wide; block_x++) {
+                    decode_block(&compressed[(block_y * blocks_wide + block_x) * get_bytes_per_block(compression)], compression, texels);
+                    for(int y = 0; y < 4 && block_y * 4 + y < size.y; y++) {
+                        for(int x = 0; x < 4 && block_x * 4 + x < size.x; x++) {
+                            std::memcpy(&image.pixels[((std::size_t) (block_y * 4 + y) * size.x + block_x * 4 + x) * 4], texels + (y * 4 + x) * 4, 4);
+                        }
+                    }
+                }
+            }
+
+            return image;
+        }
+
+        /*!
+         * \brief Peak signal to noise ratio over the color of opaque texels, in decibels. Higher is better
+         */
+        double get_psnr(const rgba8_image &original, const rgba8_image &decoded) {
+            double squared_error = 0;
+            std::size_t num_samples = 0;
+            for(std::size_t i = 0; i < original.pixels.size(); i += 4) {
+                if(original.pixels[i + 3] == 0) {
+                    continue;
+                }
+                for(int c = 0; c < 3; c++) {
+                    double diff = (double) original.pixels[i + c] - decoded.pixels[i + c];
+                    squared_error += diff * diff;
+                    num_samples++;
+                }
+            }
+
+            double mean_squared_error = squared_error / std::max<std::size_t>(num_samples, 1);
+            return mean_squared_error == 0 ? 100.0 : 10.0 * std::log10(255.0 * 255.0 / mean_squared_error);
+        }
+
+        TEST(block_compression, solid_blocks_survive_exactly) {
+            // These colors are exactly representable in 565 and in BC7's 7 bits plus a shared bit
+            std::uint8_t texels[64];
+            for(int i = 0; i < 16; i++) {
+                texels[i * 4 + 0] = 255;
+                texels[i * 4 + 1] = 130;
+                texels[i * 4 + 2] = 0;
+                texels[i * 4 + 3] = 255;
+            }
+
+            for(auto compression : {texture_compression::bc1, texture_compression::bc3, texture_compression::bc7}) {
+                std::uint8_t block[16];
+                std::uint8_t decoded[64];
+                encode_block(texels, compression, block);
+                decode_block(block, compression, decoded);
+
+                for(int i = 0; i < 64; i++) {
+                    ASSERT_NEAR(texels[i], decoded[i], 1) << "format " << (int) compression << ", byte " << i;
+                }
+            }
+        }
+
+        TEST(block_compression, keeps_cutout_holes) {
+            auto atlas = make_block_atlas({16, 16});
+            thread_pool workers(1);
+
+            for(auto compression : {texture_compression::bc1, texture_compression::bc3, texture_compression::bc7}) {
+                auto decoded = decompress_image(compress_image(atlas, compression, workers), atlas.size, compression);
+
+                for(std::size_t i = 3; i < atlas.pixels.size(); i += 4) {
+                    ASSERT_EQ(atlas.pixels[i] >= 128, decoded.pixels[i] >= 128) << "format " << (int) compression << ", texel " << i / 4;
+                }
+            }
+        }
+
+        TEST(block_compression, bc3_and_bc7_keep_alpha_gradients) {
+            std::uint8_t texels[64];
+            for(int i = 0; i < 16; i++) {
+                texels[i * 4 + 0] = 100;
+                texels[i * 4 + 1] = 150;
+                texels[i * 4 + 2] = 200;
+                texels[i * 4 + 3] = (std::uint8_t) (i * 17);
+            }
+
+            for(auto compression : {texture_compression::bc3, texture_compression::bc7}) {
+                std::uint8_t block[16];
+                std::uint8_t decoded[64];
+                encode_block(texels, compression, block);
+                decode_block(block, compression, decoded);
+
+                // BC3 only has eight alpha values to spread across the whole range, so it can be off by half a step
+                int tolerance = compression == texture_compression::bc3 ? 19 : 10;
+                for(int i = 0; i < 16; i++) {
+                    EXPECT_NEAR(texels[i * 4 + 3], decoded[i * 4 + 3], tolerance) << "format " << (int) compression << ", texel " << i;
+                }
+            }
+        }
+
+        TEST(block_compression, partial_edge_blocks) {
+            // Mip levels smaller than a block still take up a whole block
+            rgba8_image tiny;
+            tiny.size = {2, 1};
+            tiny.pixels = {10, 20, 30, 255, 200, 100, 50, 255};
+
+            thread_pool workers(1);
+            auto compressed = compress_image(tiny, texture_compression::bc7, workers);
+            ASSERT_EQ(16, compressed.size());
+
+            auto decoded = decompress_image(compressed, tiny.size, texture_compression::bc7);
+            for(std::size_t i = 0; i < tiny.pixels.size(); i++) {
+                EXPECT_NEAR(tiny.pixels[i], decoded.pixels[i], 4) << "byte " << i;
+            }
+        }
+
+        TEST(block_compression, keeps_a_block_atlas_looking_right) {
+            auto atlas = make_block_atlas({256, 256});
+            thread_pool workers;
+
+            for(auto compression : {texture_compression::bc1, texture_compression::bc3, texture_compression::bc7}) {
+                auto compressed = compress_image(atlas, compression, workers);
+
+                // BC1 is 8 bytes per 4x4 block, and BC3 and BC7 are 16
+                auto bytes_per_block = compression == texture_compression::bc1 ? 8u : 16u;
+                EXPECT_EQ(atlas.pixels.size() / 64 * bytes_per_block, compressed.size());
+
+                double psnr = get_psnr(atlas, decompress_image(compressed, atlas.size, compression));
+                EXPECT_GT(psnr, 30.0) << "BC" << (compression == texture_compression::bc1 ? 1 : compression == texture_compression::bc3 ? 3 : 7);
+            }
+        }
+    }
+}
@@ -0,0 +1,147 @@
+/*!
+ * \brief Tests splitting the block atlas into texture array layers, and remapping chunk UVs to match
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include "../../../../render/objects/textures/block_layer_table.h"
+
+namespace nova {
+    namespace test {
+        /*!
+         * \brief A 64x32 atlas with a 16x16 sprite in each corner of its left half, and a 32x32 one on the right
+         */
+        block_layer_table make_table() {
+            block_layer_table table;
+            table.reset({64, 32});
+            table.add_sprite("stone", {0, 0}, {0.25f, 0.5f});
+            table.add_sprite("dirt", {0.25f, 0}, {0.5f, 0.5f});
+            table.add_sprite("leaves", {0, 0.5f}, {0.25f, 1});
+            table.add_sprite("big", {0.5f, 0}, {1, 1});
+            return table;
+        }
+
+        /*!
+         * \brief Adds a vertex in the POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT format with the given UV, and zeros for
+         * everything else
+         */
+        void add_vertex(mesh_definition &definition, glm::vec2 uv) {
+            float uv_floats[2] = {uv.x, uv.y};
+            int uv_ints[2];
+            std::memcpy(uv_ints, uv_floats, sizeof(uv_ints));
+
+            std::vector<int> vertex(13, 0);
+            vertex[4] = uv_ints[0];
+            vertex[5] = uv_ints[1];
+            definition.vertex_data.insert(definition.vertex_data.end(), vertex.begin(), vertex.end());
+        }
+
+        glm::vec2 get_uv(const mesh_definition &definition, std::size_t vertex, std::size_t stride) {
+            float uv[2];
+            std::memcpy(uv, &definition.vertex_data[vertex * stride + 4], sizeof(uv));
+            return {uv[0], uv[1]};
+        }
+
+        TEST(block_layer_table, finds_the_sprite_under_a_uv) {
+            auto table = make_table();
+
+            EXPECT_EQ(0, table.find_layer({0.1f, 0.1f}));
+            EXPECT_EQ(1, table.find_layer({0.3f, 0.4f}));
+            EXPECT_EQ(2, table.find_layer({0.1f, 0.9f}));
+            EXPECT_EQ(3, table.find_layer({0.9f, 0.9f}));
+            EXPECT_EQ(-1, table.find_layer({0.3f, 0.9f}));
+            EXPECT_EQ(-1, table.find_layer({1.5f, 0.5f}));
+
+            EXPECT_EQ(2, table.get_layer("leaves"));
+            EXPECT_EQ(-1, table.get_layer("bedrock"));
+        }
+
+        TEST(block_layer_table, copies_sprites_into_layers) {
+            auto table = make_table();
+
+            rgba8_image atlas;
+            atlas.size = {64, 32};
+            atlas.pixels.resize(64 * 32 * 4);
+            for(int y = 0; y < 32; y++) {
+                for(int x = 0; x < 64; x++) {
+                    std::uint8_t *pixel = &atlas.pixels[(y * 64 + x) * 4];
+                    pixel[0] = (std::uint8_t) x;
+                    pixel[1] = (std::uint8_t) y;
+                    pixel[2] = 0;
+
+                    // Holes in the leaves
+                    pixel[3] = (std::uint8_t) (x < 16 && y >= 16 && (x + y) % 2 == 0 ? 0 : 255);
+                }
+            }
+
+            std::vector<mip_tile> tiles;
+            auto layers = table.make_layers(atlas, tiles);
+
+            ASSERT_EQ(glm::ivec2(16, 16), table.get_layer_size());
+            ASSERT_EQ(glm::ivec2(16, 64), layers.size);
+            ASSERT_EQ(4, tiles.size());
+
+            // Dirt is copied as-is
+            const std::uint8_t *dirt = &layers.pixels[(16 * 16 + 3 * 16 + 5) * 4];
+            EXPECT_EQ(16 + 5, dirt[0]);
+            EXPECT_EQ(3, dirt[1]);
+
+            // The big sprite is scaled down to fit
+            const std::uint8_t *big = &layers.pixels[(3 * 16 * 16 + 15 * 16 + 15) * 4];
+            EXPECT_EQ(32 + 30, big[0]);
+            EXPECT_EQ(30, big[1]);
+
+            EXPECT_FALSE(tiles[0].preserve_alpha_coverage);
+            EXPECT_TRUE(tiles[2].preserve_alpha_coverage);
+            EXPECT_EQ(32, tiles[2].rect.y);
+        }
+
+        TEST(block_layer_table, remaps_quads_to_layer_uvs) {
+            auto table = make_table();
+
+            // One quad over all of dirt, with its corners right on the edges of the sprite
+            mesh_definition definition = {};
+            definition.vertex_format = format::POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT;
+            add_vertex(definition, {0.25f, 0});
+            add_vertex(definition, {0.5f, 0});
+            add_vertex(definition, {0.5f, 0.5f});
+            add_vertex(definition, {0.25f, 0.5f});
+            definition.indices = {0, 1, 2, 2, 3, 0};
+
+            ASSERT_TRUE(table.remap_vertices(definition));
+            EXPECT_EQ(format::POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT_LAYER, definition.vertex_format);
+            ASSERT_EQ(4 * 14, definition.vertex_data.size());
+
+            for(std::size_t vertex = 0; vertex < 4; vertex++) {
+                EXPECT_EQ(1, definition.vertex_data[vertex * 14 + 13]);
+            }
+
+            EXPECT_EQ(glm::vec2(0, 0), get_uv(definition, 0, 14));
+            EXPECT_EQ(glm::vec2(1, 1), get_uv(definition, 2, 14));
+            EXPECT_EQ(glm::vec2(0, 1), get_uv(definition, 3, 14));
+        }
+
+        TEST(block_layer_table, leaves_geometry_it_cant_remap_alone) {
+            auto table = make_table();
+
+            // A triangle that's over the empty part of the atlas
+            mesh_definition definition = {};
+            definition.vertex_format = format::POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT;
+            add_vertex(definition, {0.26f, 0.6f});
+            add_vertex(definition, {0.4f, 0.6f});
+            add_vertex(definition, {0.4f, 0.9f});
+            definition.indices = {0, 1, 2};
+            auto original_data = definition.vertex_data;
+
+            EXPECT_FALSE(table.remap_vertices(definition));
+            EXPECT_EQ(format::POS_COLOR_UV_LIGHTMAPUV_NORMAL_TANGENT, definition.vertex_format);
+            EXPECT_EQ(original_data, definition.vertex_data);
+
+            definition.vertex_format = format::POS_UV;
+            EXPECT_FALSE(table.remap_vertices(definition));
+        }
+    }
+}
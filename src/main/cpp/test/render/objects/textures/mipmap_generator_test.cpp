@@ -0,0 +1,169 @@
+/*!
+ * \brief Tests the CPU mip chain generator
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <random>
+#include <gtest/gtest.h>
+#include "../../../../render/objects/textures/mipmap_generator.h"
+
+namespace nova {
+    namespace test {
+        rgba8_image make_noise_image(glm::ivec2 size) {
+            std::mt19937 rng(5678);
+            std::uniform_int_distribution<int> distribution(0, 255);
+
+            rgba8_image image;
+            image.size = size;
+            image.pixels.resize((std::size_t) size.x * size.y * 4);
+            for(auto& component : image.pixels) {
+                component = (std::uint8_t) distribution(rng);
+            }
+
+            return image;
+        }
+
+        void fill_rect(rgba8_image &image, const atlas_rect &rect, std::uint8_t r, std::uint8_t g, std::uint8_t b, std::uint8_t a) {
+            for(int y = rect.y; y < rect.y + rect.height; y++) {
+                for(int x = rect.x; x < rect.x + rect.width; x++) {
+                    auto pixel = &image.pixels[((std::size_t) y * image.size.x + x) * 4];
+                    pixel[0] = r;
+                    pixel[1] = g;
+                    pixel[2] = b;
+                    pixel[3] = a;
+                }
+            }
+        }
+
+        TEST(mipmap_generator, mip_sizes_stop_at_one) {
+            EXPECT_EQ(glm::ivec2(64, 16), get_mip_size({128, 32}, 1));
+            EXPECT_EQ(glm::ivec2(4, 1), get_mip_size({128, 32}, 5));
+            EXPECT_EQ(glm::ivec2(1, 1), get_mip_size({128, 32}, 7));
+            EXPECT_EQ(8, get_num_mip_levels({128, 32}));
+            EXPECT_EQ(1, get_num_mip_levels({1, 1}));
+        }
+
+        TEST(mipmap_generator, box_filter_averages_with_rounding) {
+            rgba8_image image;
+            image.size = {2, 2};
+            image.pixels = {0, 10, 255, 1,    1, 10, 255, 1,
+                            0, 11, 255, 0,    2, 10, 255, 1};
+
+            std::vector<std::uint8_t> mip(4);
+            downsample_rgba8_scalar(image.pixels.data(), image.size, mip.data(), 0, 1);
+            EXPECT_EQ(std::vector<std::uint8_t>({1, 10, 255, 1}), mip);
+        }
+
+        TEST(mipmap_generator, simd_matches_scalar) {
+            // Odd sizes make sure the clamped edges and the leftover columns are right
+            for(glm::ivec2 size : {glm::ivec2(256, 256), glm::ivec2(7, 5), glm::ivec2(1, 9), glm::ivec2(33, 2), glm::ivec2(18, 1)}) {
+                auto image = make_noise_image(size);
+                auto mip_size = get_mip_size(size, 1);
+
+                std::vector<std::uint8_t> expected((std::size_t) mip_size.x * mip_size.y * 4);
+                std::vector<std::uint8_t> actual(expected.size());
+                downsample_rgba8_scalar(image.pixels.data(), size, expected.data(), 0, mip_size.y);
+                downsample_rgba8(image.pixels.data(), size, actual.data(), 0, mip_size.y);
+
+                EXPECT_EQ(expected, actual) << size.x << "x" << size.y;
+            }
+        }
+
+        TEST(mipmap_generator, aligned_tiles_do_not_bleed) {
+            // A checkerboard of 16x16 tiles, each with its own color
+            rgba8_image atlas;
+            atlas.size = {64, 64};
+            atlas.pixels.resize(64 * 64 * 4);
+            for(int ty = 0; ty < 4; ty++) {
+                for(int tx = 0; tx < 4; tx++) {
+                    fill_rect(atlas, {tx * 16, ty * 16, 16, 16}, (std::uint8_t) (tx * 60), (std::uint8_t) (ty * 60), 200, 255);
+                }
+            }
+
+            thread_pool workers(4);
+            auto levels = generate_mip_chain(atlas, 5, {}, 128, workers);
+            ASSERT_EQ(4, levels.size());
+
+            for(int level = 1; level <= 4; level++) {
+                const auto& mip = levels[level - 1];
+                int tile_size = 16 >> level;
+                for(int y = 0; y < mip.size.y; y++) {
+                    for(int x = 0; x < mip.size.x; x++) {
+                        auto pixel = &mip.pixels[((std::size_t) y * mip.size.x + x) * 4];
+                        ASSERT_EQ((x / tile_size) * 60, pixel[0]) << "level " << level << " texel " << x << "," << y;
+                        ASSERT_EQ((y / tile_size) * 60, pixel[1]) << "level " << level << " texel " << x << "," << y;
+                    }
+                }
+            }
+        }
+
+        TEST(mipmap_generator, preserves_alpha_coverage_of_cutout_tiles) {
+            // A sparse cutout texture, like leaves, with about 30% of texels opaque
+            std::mt19937 rng(91011);
+            std::uniform_int_distribution<int> distribution(0, 9);
+
+            rgba8_image atlas;
+            atlas.size = {32, 16};
+            atlas.pixels.assign(32 * 16 * 4, 0);
+            for(int y = 0; y < 16; y++) {
+                for(int x = 0; x < 32; x++) {
+                    if(distribution(rng) < 3) {
+                        atlas.pixels[(y * 32 + x) * 4 + 1] = 150;
+                        atlas.pixels[(y * 32 + x) * 4 + 3] = 255;
+                    }
+                }
+            }
+
+            std::vector<mip_tile> tiles = {
+                    {{0, 0, 16, 16}, true},
+                    {{16, 0, 16, 16}, false},
+            };
+
+            const std::uint8_t threshold = 128;
+            thread_pool workers(2);
+            auto levels = generate_mip_chain(atlas, 4, tiles, threshold, workers);
+
+            float base_coverage = get_alpha_coverage(atlas.pixels.data(), 32, {0, 0, 16, 16}, threshold);
+            for(int level = 1; level < 4; level++) {
+                const auto& mip = levels[level - 1];
+                int tile_size = 16 >> level;
+
+                float preserved = get_alpha_coverage(mip.pixels.data(), mip.size.x, {0, 0, tile_size, tile_size}, threshold);
+                float not_preserved = get_alpha_coverage(mip.pixels.data(), mip.size.x, {tile_size, 0, tile_size, tile_size}, threshold);
+
+                // Alpha that starts out as just 0 or 255 only has a few values after filtering, and the smallest levels
+                // only have a handful of texels, so coverage can only get so close
+                EXPECT_NEAR(base_coverage, preserved, 1.0f / (tile_size * tile_size) + 0.1f) << "level " << level;
+                EXPECT_LT(not_preserved, preserved) << "level " << level;
+            }
+        }
+
+        TEST(mipmap_generator, parallel_chain_matches_scalar) {
+            auto atlas = make_noise_image({512, 512});
+
+            glm::ivec2 size = atlas.size;
+            const rgba8_image *src = &atlas;
+            std::vector<rgba8_image> scalar_levels;
+            scalar_levels.reserve(4);
+            for(int level = 1; level < 5; level++) {
+                rgba8_image mip;
+                mip.size = get_mip_size(size, 1);
+                mip.pixels.resize((std::size_t) mip.size.x * mip.size.y * 4);
+                downsample_rgba8_scalar(src->pixels.data(), src->size, mip.pixels.data(), 0, mip.size.y);
+                scalar_levels.push_back(std::move(mip));
+                src = &scalar_levels.back();
+                size = src->size;
+            }
+
+            thread_pool workers;
+            auto levels = generate_mip_chain(atlas, 5, {}, 26, workers);
+
+            ASSERT_EQ(scalar_levels.size(), levels.size());
+            for(std::size_t i = 0; i < levels.size(); i++) {
+                EXPECT_EQ(scalar_levels[i].pixels, levels[i].pixels);
+            }
+        }
+    }
+}
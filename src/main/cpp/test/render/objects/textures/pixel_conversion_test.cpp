@@ -0,0 +1,61 @@
+/*!
+ * \brief Tests the kernels that expand Minecraft's texture data to RGBA8
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../../../../render/objects/textures/pixel_conversion.h"
+
+namespace nova {
+    namespace test {
+        std::vector<std::uint8_t> make_random_pixels(std::size_t num_bytes) {
+            std::mt19937 rng(1234);
+            std::uniform_int_distribution<int> distribution(0, 255);
+
+            std::vector<std::uint8_t> pixels(num_bytes);
+            for(auto& pixel : pixels) {
+                pixel = (std::uint8_t) distribution(rng);
+            }
+
+            return pixels;
+        }
+
+        void check_expansion(int num_components, std::size_t num_pixels) {
+            auto src = make_random_pixels(num_pixels * num_components);
+            std::vector<std::uint8_t> expected(num_pixels * 4);
+            std::vector<std::uint8_t> actual(num_pixels * 4);
+
+            expand_to_rgba8_scalar(src.data(), num_components, num_pixels, expected.data());
+            expand_to_rgba8(src.data(), num_components, num_pixels, actual.data());
+
+            ASSERT_EQ(expected, actual) << num_components << " components, " << num_pixels << " pixels";
+        }
+
+        TEST(pixel_conversion, scalar_fills_in_missing_components) {
+            std::uint8_t src[] = {10, 20, 30};
+            std::uint8_t dst[4];
+
+            expand_to_rgba8_scalar(src, 1, 1, dst);
+            EXPECT_EQ(std::vector<std::uint8_t>({10, 0, 0, 255}), std::vector<std::uint8_t>(dst, dst + 4));
+
+            expand_to_rgba8_scalar(src, 2, 1, dst);
+            EXPECT_EQ(std::vector<std::uint8_t>({10, 20, 0, 255}), std::vector<std::uint8_t>(dst, dst + 4));
+
+            expand_to_rgba8_scalar(src, 3, 1, dst);
+            EXPECT_EQ(std::vector<std::uint8_t>({10, 20, 30, 255}), std::vector<std::uint8_t>(dst, dst + 4));
+        }
+
+        TEST(pixel_conversion, simd_matches_scalar) {
+            // Sizes that don't fill whole SIMD registers, to make sure the tails are handled
+            for(int num_components = 1; num_components <= 4; num_components++) {
+                for(std::size_t num_pixels : {0, 1, 5, 6, 7, 15, 16, 17, 33, 1000, 1023}) {
+                    check_expansion(num_components, num_pixels);
+                }
+            }
+        }
+    }
+}
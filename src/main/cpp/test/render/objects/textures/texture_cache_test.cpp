@@ -0,0 +1,90 @@
+/*!
+ * \brief Tests the on-disk cache of processed textures
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <gtest/gtest.h>
+#include "../../../../render/objects/textures/texture_cache.h"
+
+namespace nova {
+    namespace test {
+        rgba8_image make_test_image(glm::ivec2 size) {
+            rgba8_image image;
+            image.size = size;
+            image.pixels.resize((std::size_t) size.x * size.y * 4);
+            for(std::size_t i = 0; i < image.pixels.size(); i++) {
+                image.pixels[i] = (std::uint8_t) (i * 7 + i / 5);
+            }
+
+            return image;
+        }
+
+        TEST(texture_cache, keys_change_with_everything_that_changes_the_output) {
+            auto image = make_test_image({32, 32});
+            std::vector<mip_tile> tiles = {{{0, 0, 16, 16}, true}, {{16, 0, 16, 16}, false}};
+            auto key = texture_cache::get_key(image, tiles, 5, 26, texture_compression::bc7);
+
+            EXPECT_NE(key, texture_cache::get_key(image, tiles, 5, 26, texture_compression::bc1));
+            EXPECT_NE(key, texture_cache::get_key(image, tiles, 4, 26, texture_compression::bc7));
+            EXPECT_NE(key, texture_cache::get_key(image, tiles, 5, 128, texture_compression::bc7));
+            EXPECT_NE(key, texture_cache::get_key(image, {}, 5, 26, texture_compression::bc7));
+
+            auto changed_image = image;
+            changed_image.pixels[100]++;
+            EXPECT_NE(key, texture_cache::get_key(changed_image, tiles, 5, 26, texture_compression::bc7));
+
+            // Tiles that don't keep their alpha coverage don't change anything, and neither does their order
+            std::vector<mip_tile> same_tiles = {{{32, 0, 16, 16}, false}, {{0, 0, 16, 16}, true}};
+            EXPECT_EQ(key, texture_cache::get_key(image, same_tiles, 5, 26, texture_compression::bc7));
+        }
+
+        TEST(texture_cache, stores_and_maps_every_level) {
+            texture_cache cache("test_output/texture_cache");
+            auto image = make_test_image({8, 8});
+            auto key = texture_cache::get_key(image, {}, 3, 26, texture_compression::none);
+
+            std::vector<std::uint8_t> level_1(4 * 4 * 4, 17);
+            std::vector<std::uint8_t> level_2(2 * 2 * 4, 42);
+            cache.store(key, {{image.pixels.data(), image.pixels.size()}, {level_1.data(), level_1.size()},
+                              {level_2.data(), level_2.size()}});
+
+            auto mapped = cache.load(key, {image.pixels.size(), level_1.size(), level_2.size()});
+            ASSERT_NE(nullptr, mapped);
+            ASSERT_EQ(3, mapped->get_num_levels());
+            EXPECT_EQ(0, std::memcmp(image.pixels.data(), mapped->get_level_data(0), image.pixels.size()));
+            EXPECT_EQ(0, std::memcmp(level_1.data(), mapped->get_level_data(1), level_1.size()));
+            EXPECT_EQ(0, std::memcmp(level_2.data(), mapped->get_level_data(2), level_2.size()));
+
+            // Different level sizes mean it's from something else, or it's been damaged
+            EXPECT_EQ(nullptr, cache.load(key, {image.pixels.size(), level_1.size()}));
+            EXPECT_EQ(nullptr, cache.load(key, {image.pixels.size(), level_1.size(), level_2.size() + 1}));
+            EXPECT_EQ(nullptr, cache.load(key + 1, {image.pixels.size(), level_1.size(), level_2.size()}));
+        }
+
+        TEST(texture_cache, ignores_truncated_files) {
+            texture_cache cache("test_output/texture_cache");
+            auto image = make_test_image({16, 16});
+            auto key = texture_cache::get_key(image, {}, 1, 26, texture_compression::none);
+            cache.store(key, {{image.pixels.data(), image.pixels.size()}});
+
+            char name[64];
+            std::snprintf(name, sizeof(name), "test_output/texture_cache/%016llx.tex", (unsigned long long) key);
+
+            // Chop the last half of the pixels off
+            std::vector<char> contents(1 << 12);
+            std::FILE* file = std::fopen(name, "rb");
+            ASSERT_NE(nullptr, file);
+            auto file_size = std::fread(contents.data(), 1, contents.size(), file);
+            std::fclose(file);
+            file = std::fopen(name, "wb");
+            std::fwrite(contents.data(), 1, file_size - image.pixels.size() / 2, file);
+            std::fclose(file);
+
+            EXPECT_EQ(nullptr, cache.load(key, {image.pixels.size()}));
+        }
+    }
+}
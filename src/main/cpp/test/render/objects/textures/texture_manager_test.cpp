@@ -1,16 +1,47 @@
 /*!
  * \brief Tests the texture manager
  *
- * \author ddubois 
+ * \author ddubois
  * \date 22-Dec-16.
  */
 
 #include <gtest/gtest.h>
+#include "../../../test_utils.h"
+#include "../../../../render/objects/textures/texture_manager.h"
 
 namespace nova {
     namespace test {
         TEST(texture_manager, get_max_texture_size_gtx_1080) {
 
         }
+
+        class texture_manager_test : public nova_test {};
+
+        TEST_F(texture_manager_test, streamed_block_atlas_fills_block_layers) {
+            texture_manager textures;
+            textures.set_block_texture_mode(block_texture_mode::array);
+
+            // The same order the facade sends things in: the atlas goes to the streamer, then its locations
+            texture_upload_request request;
+            request.name = texture_manager::BLOCK_ATLAS_NAME;
+            request.width = 32;
+            request.height = 16;
+            request.num_components = 4;
+            request.data.assign(32 * 16 * 4, 255);
+            textures.add_texture_async(std::move(request));
+
+            mc_texture_atlas_location stone = {"stone", 0, 0.5f, 0, 1};
+            mc_texture_atlas_location dirt = {"dirt", 0.5f, 1, 0, 1};
+            textures.add_texture_location(stone);
+            textures.add_texture_location(dirt);
+
+            // The array's made from the CPU copy of the atlas, so it doesn't have to wait for the atlas to stream
+            textures.update_block_texture_array();
+
+            auto block_layers = textures.get_block_layers();
+            ASSERT_NE(block_layers, nullptr);
+            EXPECT_EQ(block_layers->get_num_layers(), 2);
+            EXPECT_EQ(block_layers->get_layer_size(), glm::ivec2(16, 16));
+        }
     }
 }
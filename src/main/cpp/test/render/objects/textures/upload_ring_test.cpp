@@ -0,0 +1,65 @@
+/*!
+ * \brief Tests the ring allocator that the texture streamer stages pixels in
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <gtest/gtest.h>
+#include "../../../../render/objects/textures/texture_streamer.h"
+
+namespace nova {
+    namespace test {
+        TEST(upload_ring, allocates_in_order) {
+            upload_ring ring(100);
+            std::size_t offset;
+
+            ASSERT_TRUE(ring.allocate(40, offset));
+            EXPECT_EQ(0, offset);
+            ASSERT_TRUE(ring.allocate(40, offset));
+            EXPECT_EQ(40, offset);
+
+            // Only 20 bytes left at the end, and nothing free at the start
+            EXPECT_FALSE(ring.allocate(30, offset));
+            EXPECT_EQ(2, ring.get_num_allocations());
+        }
+
+        TEST(upload_ring, wraps_around_once_the_start_is_free) {
+            upload_ring ring(100);
+            std::size_t offset;
+
+            ASSERT_TRUE(ring.allocate(40, offset));
+            ASSERT_TRUE(ring.allocate(40, offset));
+            ring.free_oldest();
+
+            // Doesn't fit in the 20 bytes at the end, but does fit in the 40 bytes at the start
+            ASSERT_TRUE(ring.allocate(30, offset));
+            EXPECT_EQ(0, offset);
+
+            // The head is now behind the tail, so only the 10 bytes between them are free
+            EXPECT_FALSE(ring.allocate(20, offset));
+            ASSERT_TRUE(ring.allocate(10, offset));
+            EXPECT_EQ(30, offset);
+            EXPECT_FALSE(ring.allocate(1, offset));
+        }
+
+        TEST(upload_ring, starts_over_when_empty) {
+            upload_ring ring(100);
+            std::size_t offset;
+
+            ASSERT_TRUE(ring.allocate(70, offset));
+            ring.free_oldest();
+
+            ASSERT_TRUE(ring.allocate(100, offset));
+            EXPECT_EQ(0, offset);
+        }
+
+        TEST(upload_ring, rejects_allocations_bigger_than_the_ring) {
+            upload_ring ring(100);
+            std::size_t offset;
+
+            EXPECT_FALSE(ring.allocate(101, offset));
+            EXPECT_EQ(0, ring.get_num_allocations());
+        }
+    }
+}
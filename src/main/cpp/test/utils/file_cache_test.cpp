@@ -0,0 +1,58 @@
+/*!
+ * \brief Tests the helpers the on-disk caches share
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <cstdio>
+#include <iterator>
+#include <gtest/gtest.h>
+#include "../../utils/file_cache.h"
+
+namespace nova {
+    namespace test {
+        TEST(file_cache, hashes_can_be_built_up_a_piece_at_a_time) {
+            std::string text = "geometry_type::block";
+            auto whole = hash_bytes(text.data(), text.size());
+            auto pieces = hash_bytes(text.data() + 4, text.size() - 4, hash_bytes(text.data(), 4));
+
+            EXPECT_EQ(whole, pieces);
+            EXPECT_NE(whole, hash_bytes(text.data(), text.size() - 1));
+            EXPECT_EQ(hash_bytes(nullptr, 0), FNV_OFFSET_BASIS);
+        }
+
+        TEST(file_cache, paths_are_the_key_in_hex) {
+            EXPECT_EQ(get_cache_file_path("cache", 0xbeefull, ".bin"), "cache/000000000000beef.bin");
+        }
+
+        TEST(file_cache, replace_file_replaces_the_whole_file) {
+            make_directories("test_output/file_cache/nested");
+            std::string path = get_cache_file_path("test_output/file_cache/nested", 1, ".txt");
+
+            ASSERT_TRUE(replace_file(path, [](std::ofstream& file) { file << "a long first version"; }));
+            ASSERT_TRUE(replace_file(path, [](std::ofstream& file) { file << "second"; }));
+
+            std::ifstream file(path);
+            std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            EXPECT_EQ(contents, "second");
+            EXPECT_FALSE(std::ifstream(path + ".tmp").is_open());
+        }
+
+        TEST(file_cache, replace_file_keeps_the_old_file_if_writing_fails) {
+            make_directories("test_output/file_cache");
+            std::string path = get_cache_file_path("test_output/file_cache", 2, ".txt");
+
+            ASSERT_TRUE(replace_file(path, [](std::ofstream& file) { file << "old"; }));
+            EXPECT_FALSE(replace_file(path, [](std::ofstream& file) {
+                file << "half of the new";
+                file.setstate(std::ios::badbit);
+            }));
+
+            std::ifstream file(path);
+            std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            EXPECT_EQ(contents, "old");
+            EXPECT_FALSE(std::ifstream(path + ".tmp").is_open());
+        }
+    }
+}
@@ -0,0 +1,53 @@
+/*!
+ * \brief Tests the worker thread pool
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <atomic>
+#include <stdexcept>
+#include <gtest/gtest.h>
+#include "../../utils/thread_pool.h"
+
+namespace nova {
+    namespace test {
+        TEST(thread_pool, submit_returns_the_result) {
+            thread_pool workers(2);
+            auto answer = workers.submit([]() { return 42; });
+            EXPECT_EQ(42, answer.get());
+        }
+
+        TEST(thread_pool, parallel_for_covers_every_index_once) {
+            thread_pool workers(4);
+            std::vector<std::atomic<int>> visits(1000);
+            for(auto& visit : visits) {
+                visit = 0;
+            }
+
+            workers.parallel_for(0, visits.size(), 7, [&](std::size_t begin, std::size_t end) {
+                for(std::size_t i = begin; i < end; i++) {
+                    visits[i]++;
+                }
+            });
+
+            for(std::size_t i = 0; i < visits.size(); i++) {
+                ASSERT_EQ(1, visits[i].load()) << "index " << i;
+            }
+        }
+
+        TEST(thread_pool, parallel_for_rethrows_after_every_chunk_is_done) {
+            thread_pool workers(2);
+            std::atomic<int> num_chunks_done(0);
+
+            EXPECT_THROW(workers.parallel_for(0, 10, 1, [&](std::size_t begin, std::size_t) {
+                if(begin == 3) {
+                    throw std::runtime_error("chunk 3 failed");
+                }
+                num_chunks_done++;
+            }), std::runtime_error);
+
+            EXPECT_EQ(9, num_chunks_done.load());
+        }
+    }
+}
@@ -0,0 +1,108 @@
+/*!
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include "epoch_reclaimer.h"
+
+namespace nova {
+    epoch_guard::epoch_guard(epoch_reclaimer *owner, std::size_t slot) : owner(owner), slot(slot) {}
+
+    epoch_guard::epoch_guard(epoch_guard &&other) noexcept : owner(other.owner), slot(other.slot) {
+        other.owner = nullptr;
+    }
+
+    epoch_guard &epoch_guard::operator=(epoch_guard &&other) noexcept {
+        if(owner != nullptr) {
+            owner->unpin(slot);
+        }
+
+        owner = other.owner;
+        slot = other.slot;
+        other.owner = nullptr;
+
+        return *this;
+    }
+
+    epoch_guard::~epoch_guard() {
+        if(owner != nullptr) {
+            owner->unpin(slot);
+        }
+    }
+
+    epoch_reclaimer::epoch_reclaimer() : global_epoch(0) {
+        for(auto& reader_epoch : reader_epochs) {
+            reader_epoch.store(NOT_PINNED);
+        }
+    }
+
+    epoch_reclaimer::~epoch_reclaimer() {
+        for(auto& thing : retired) {
+            thing.deleter();
+        }
+    }
+
+    epoch_guard epoch_reclaimer::pin() {
+        while(true) {
+            // The epoch might move on between this load and the exchange below. That's fine: pinning an old epoch just
+            // means we hold on to things a little longer than we need to
+            std::uint64_t epoch = global_epoch.load();
+
+            for(std::size_t slot = 0; slot < MAX_READERS; slot++) {
+                std::uint64_t expected = NOT_PINNED;
+                if(reader_epochs[slot].compare_exchange_strong(expected, epoch)) {
+                    return epoch_guard(this, slot);
+                }
+            }
+
+            std::this_thread::yield();
+        }
+    }
+
+    void epoch_reclaimer::unpin(std::size_t slot) {
+        reader_epochs[slot].store(NOT_PINNED);
+    }
+
+    void epoch_reclaimer::retire(std::function<void()> deleter) {
+        // The writer has already swapped in the new version, so anyone who pins after this increment can't see the
+        // old one. Anyone pinned at this epoch or earlier might
+        std::uint64_t epoch = global_epoch.fetch_add(1);
+
+        std::lock_guard<std::mutex> lock(retired_lock);
+        retired.push_back({epoch, std::move(deleter)});
+    }
+
+    std::size_t epoch_reclaimer::reclaim() {
+        std::vector<retired_thing> safe_to_delete;
+        {
+            std::lock_guard<std::mutex> lock(retired_lock);
+
+            std::uint64_t oldest_pinned_epoch = NOT_PINNED;
+            for(auto& reader_epoch : reader_epochs) {
+                oldest_pinned_epoch = std::min(oldest_pinned_epoch, reader_epoch.load());
+            }
+
+            auto still_visible = std::stable_partition(retired.begin(), retired.end(), [&](const retired_thing& thing) {
+                return thing.epoch >= oldest_pinned_epoch;
+            });
+
+            std::move(still_visible, retired.end(), std::back_inserter(safe_to_delete));
+            retired.erase(still_visible, retired.end());
+        }
+
+        // Run the deleters outside the lock so that writers can keep retiring things while we delete
+        for(auto& thing : safe_to_delete) {
+            thing.deleter();
+        }
+
+        return safe_to_delete.size();
+    }
+
+    std::size_t epoch_reclaimer::get_num_retired() {
+        std::lock_guard<std::mutex> lock(retired_lock);
+        return retired.size();
+    }
+}
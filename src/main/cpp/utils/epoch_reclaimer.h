@@ -0,0 +1,116 @@
+/*!
+ * \brief Epoch-based reclamation, so readers can use shared data without taking a lock
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_EPOCH_RECLAIMER_H
+#define RENDERER_EPOCH_RECLAIMER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace nova {
+    class epoch_reclaimer;
+
+    /*!
+     * \brief Keeps the reader that owns it pinned to an epoch. Nothing that was visible when the guard was made will
+     * be deleted until the guard goes away
+     */
+    class epoch_guard {
+    public:
+        epoch_guard(epoch_guard&& other) noexcept;
+        epoch_guard& operator=(epoch_guard&& other) noexcept;
+
+        epoch_guard(const epoch_guard&) = delete;
+        epoch_guard& operator=(const epoch_guard&) = delete;
+
+        ~epoch_guard();
+
+    private:
+        friend class epoch_reclaimer;
+
+        epoch_guard(epoch_reclaimer* owner, std::size_t slot);
+
+        epoch_reclaimer* owner;
+        std::size_t slot;
+    };
+
+    /*!
+     * \brief Decides when it's safe to delete something that readers might still be looking at
+     *
+     * Readers call pin before they load a shared pointer, and keep the guard around for as long as they use whatever
+     * the pointer points to. Pinning only touches an atomic, so readers never wait on writers.
+     *
+     * Writers replace the shared pointer with a new version, then hand the old version to retire. The old version is
+     * deleted by the first call to reclaim after every reader that might have seen it has let go of its guard.
+     *
+     * Deleters are only ever run from reclaim, so whichever thread calls reclaim is the thread that things get
+     * deleted on. The mesh_store relies on that to delete OpenGL objects on the render thread
+     */
+    class epoch_reclaimer {
+    public:
+        /*!
+         * \brief How many readers can be pinned at the same time. If more readers than this try to pin, the extra ones
+         * spin until a slot frees up
+         */
+        static const std::size_t MAX_READERS = 16;
+
+        epoch_reclaimer();
+
+        /*!
+         * \brief Runs every deleter that's still waiting. Make sure nobody is pinned when you destroy this
+         */
+        ~epoch_reclaimer();
+
+        epoch_guard pin();
+
+        /*!
+         * \brief Schedules something to be deleted once no reader can see it any more
+         *
+         * \param deleter The function that deletes the thing
+         */
+        void retire(std::function<void()> deleter);
+
+        /*!
+         * \brief Runs the deleters of everything that no reader can see any more
+         *
+         * \return The number of things that were deleted
+         */
+        std::size_t reclaim();
+
+        /*!
+         * \brief The number of retired things that haven't been deleted yet
+         */
+        std::size_t get_num_retired();
+
+    private:
+        friend class epoch_guard;
+
+        static const std::uint64_t NOT_PINNED = std::numeric_limits<std::uint64_t>::max();
+
+        struct retired_thing {
+            std::uint64_t epoch;
+            std::function<void()> deleter;
+        };
+
+        std::atomic<std::uint64_t> global_epoch;
+
+        /*!
+         * \brief The epoch that each reader pinned, or NOT_PINNED if the slot is free
+         */
+        std::atomic<std::uint64_t> reader_epochs[MAX_READERS];
+
+        std::mutex retired_lock;
+        std::vector<retired_thing> retired;
+
+        void unpin(std::size_t slot);
+    };
+}
+
+#endif //RENDERER_EPOCH_RECLAIMER_H
@@ -0,0 +1,79 @@
+/*!
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <cstdio>
+#include <easylogging++.h>
+#include "file_cache.h"
+
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace nova {
+    static const std::uint64_t FNV_PRIME = 1099511628211ull;
+
+    std::uint64_t hash_bytes(const void* data, std::size_t size, std::uint64_t hash) {
+        auto bytes = static_cast<const std::uint8_t*>(data);
+        for(std::size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+
+        return hash;
+    }
+
+    std::uint64_t hash_word(std::uint64_t word, std::uint64_t hash) {
+        hash ^= word;
+        hash *= FNV_PRIME;
+        return hash;
+    }
+
+    void make_directories(const std::string &path) {
+        for(std::size_t separator = path.find_first_of("/\\", 1); ; separator = path.find_first_of("/\\", separator + 1)) {
+            std::string parent = path.substr(0, separator);
+#if defined(_WIN32)
+            _mkdir(parent.c_str());
+#else
+            mkdir(parent.c_str(), 0755);
+#endif
+            if(separator == std::string::npos) {
+                break;
+            }
+        }
+    }
+
+    std::string get_cache_file_path(const std::string &directory, std::uint64_t key, const std::string &extension) {
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016llx", (unsigned long long) key);
+        return directory + "/" + name + extension;
+    }
+
+    bool replace_file(const std::string &path, const std::function<void(std::ofstream&)> &write) {
+        std::string temp_path = path + ".tmp";
+        bool written;
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            write(file);
+            written = static_cast<bool>(file);
+        }
+
+        if(!written) {
+            LOG(WARNING) << "Could not write " << temp_path;
+            std::remove(temp_path.c_str());
+            return false;
+        }
+
+        std::remove(path.c_str());
+        if(std::rename(temp_path.c_str(), path.c_str()) != 0) {
+            LOG(WARNING) << "Could not move " << temp_path << " to " << path;
+            std::remove(temp_path.c_str());
+            return false;
+        }
+
+        return true;
+    }
+}
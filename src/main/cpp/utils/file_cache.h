@@ -0,0 +1,57 @@
+/*!
+ * \brief The bits that every on-disk cache needs: hashing keys, naming files after them, and writing files so that a
+ * crash never leaves half of one behind
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_FILE_CACHE_H
+#define RENDERER_FILE_CACHE_H
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+
+namespace nova {
+    /*!
+     * \brief Where every 64-bit FNV-1a hash starts
+     */
+    const std::uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+
+    /*!
+     * \brief 64-bit FNV-1a. It's not cryptographic, but cache keys only need to tell different inputs apart
+     *
+     * \param hash The hash so far, so that several buffers can go into one key
+     */
+    std::uint64_t hash_bytes(const void* data, std::size_t size, std::uint64_t hash = FNV_OFFSET_BASIS);
+
+    /*!
+     * \brief Mixes a whole 64-bit word into an FNV-1a hash at once. Much faster than hash_bytes for big buffers, but
+     * gives a different hash for the same bytes
+     */
+    std::uint64_t hash_word(std::uint64_t word, std::uint64_t hash = FNV_OFFSET_BASIS);
+
+    /*!
+     * \brief Makes a directory and any of its parents that don't exist yet. Directories that already exist are fine
+     */
+    void make_directories(const std::string &path);
+
+    /*!
+     * \brief The file a cache keeps the given key in: the key as sixteen hex digits, then the extension
+     */
+    std::string get_cache_file_path(const std::string &directory, std::uint64_t key, const std::string &extension);
+
+    /*!
+     * \brief Writes a file next to the given path, then moves it over the top of whatever's there
+     *
+     * Anything that reads the path sees either the old file or the whole new one, never a truncated one
+     *
+     * \param write Writes the file's contents. If the stream is bad afterwards, the old file is left alone
+     * \return True if the new file is in place, false (after logging why) if not
+     */
+    bool replace_file(const std::string &path, const std::function<void(std::ofstream&)> &write);
+}
+
+#endif //RENDERER_FILE_CACHE_H
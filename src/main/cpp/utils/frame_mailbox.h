@@ -0,0 +1,105 @@
+/*!
+ * \brief A triple buffer that hands whole frames of data from one thread to another
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_FRAME_MAILBOX_H
+#define RENDERER_FRAME_MAILBOX_H
+
+#include <mutex>
+#include <condition_variable>
+#include <utility>
+
+namespace nova {
+    /*!
+     * \brief Lets one thread build up a frame while another thread consumes the previous one
+     *
+     * There are three buffers: the back buffer that the producer writes to, the front buffer that the consumer reads
+     * from, and a middle buffer that holds the most recently published frame. Publishing and acquiring only swap
+     * indices, so neither thread ever waits for the other to finish with its buffer.
+     *
+     * If the producer publishes twice before the consumer gets around to acquiring, the newer frame is merged into the
+     * older one with T::merge_newer instead of replacing it, so things like texture uploads never get dropped. T also
+     * needs a clear() method to reset a buffer before the producer reuses it.
+     *
+     * \tparam T The type of a frame
+     */
+    template <typename T>
+    class frame_mailbox {
+    public:
+        /*!
+         * \brief The frame that the producer is building. Only the producer thread may touch this
+         */
+        T& get_back_buffer() {
+            return buffers[back];
+        }
+
+        /*!
+         * \brief Hands the back buffer to the consumer and gives the producer a fresh buffer to write to
+         */
+        void publish() {
+            {
+                std::lock_guard<std::mutex> lock(swap_lock);
+                if(middle_is_new) {
+                    buffers[middle].merge_newer(std::move(buffers[back]));
+
+                } else {
+                    std::swap(back, middle);
+                    middle_is_new = true;
+                }
+            }
+            frame_published.notify_one();
+
+            // The back buffer is now either a frame that the consumer is done with or a moved-from husk. Either way,
+            // the producer owns it again
+            buffers[back].clear();
+        }
+
+        /*!
+         * \brief Waits until the producer publishes a frame, then gives it to the consumer
+         *
+         * The frame returned by the last call to acquire goes back to the producer, so don't hold on to it
+         *
+         * \return The newest frame, or nullptr if the mailbox has been closed and there's nothing left to read
+         */
+        T* acquire() {
+            std::unique_lock<std::mutex> lock(swap_lock);
+            frame_published.wait(lock, [&] { return middle_is_new || closed; });
+
+            if(!middle_is_new) {
+                return nullptr;
+            }
+
+            std::swap(front, middle);
+            middle_is_new = false;
+            return &buffers[front];
+        }
+
+        /*!
+         * \brief Wakes up the consumer and tells it that no more frames are coming
+         */
+        void close() {
+            {
+                std::lock_guard<std::mutex> lock(swap_lock);
+                closed = true;
+            }
+            frame_published.notify_all();
+        }
+
+    private:
+        T buffers[3];
+        int back = 0;
+        int middle = 1;
+        int front = 2;
+
+        bool middle_is_new = false;
+        bool closed = false;
+
+        std::mutex swap_lock;
+        std::condition_variable frame_published;
+    };
+}
+
+#endif //RENDERER_FRAME_MAILBOX_H
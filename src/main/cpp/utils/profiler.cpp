@@ -4,13 +4,17 @@
  */
 
 #include <cstring>
+#include <algorithm>
 #include "profiler.h"
 #include <easylogging++.h>
 
 namespace nova {
     std::unordered_map<std::string, profiler_data> profiler::data;
+    std::unordered_map<std::string, profiler_stat> profiler::stats;
+    std::mutex profiler::profiler_lock;
 
     void profiler::start(std::string name) {
+        std::lock_guard<std::mutex> lock(profiler_lock);
         auto section_itr = data.find(name);
         if(section_itr == data.end()) {
             data[name] = profiler_data();
@@ -21,12 +25,32 @@ namespace nova {
     }
 
     void profiler::end(std::string name) {
+        std::lock_guard<std::mutex> lock(profiler_lock);
         auto &cur_profiler_data = data[name];
         auto duration = std::chrono::high_resolution_clock::now() - cur_profiler_data.start_time;
         cur_profiler_data.total_duration += duration;
     }
 
+    void profiler::record_stat(std::string name, long long value) {
+        std::lock_guard<std::mutex> lock(profiler_lock);
+        auto &stat = stats[name];
+        stat.last_value = value;
+        stat.total += value;
+        stat.num_samples++;
+    }
+
+    profiler_stat profiler::get_stat(std::string name) {
+        std::lock_guard<std::mutex> lock(profiler_lock);
+        auto stat_itr = stats.find(name);
+        if(stat_itr == stats.end()) {
+            return {};
+        }
+
+        return stat_itr->second;
+    }
+
     void profiler::log_all_profiler_data() {
+        std::lock_guard<std::mutex> lock(profiler_lock);
         std::stringstream ss;
         for(const auto& item : data) {
             const auto& cur_profiler_data = item.second;
@@ -34,6 +58,12 @@ namespace nova {
             ss << "Profiled section " << item.first << " has taken an total of " << double(std::chrono::duration_cast<std::chrono::nanoseconds>(cur_profiler_data.total_duration).count()) / 1000000.0f << "ms to execute since the game began\n";
         }
 
+        for(const auto& item : stats) {
+            const auto& stat = item.second;
+            ss << "Stat " << item.first << " was " << stat.last_value << " last sample, and has averaged "
+               << double(stat.total) / double(std::max(stat.num_samples, 1ll)) << " over " << stat.num_samples << " samples\n";
+        }
+
         //LOG_EVERY_N(100, DEBUG) << ss.str();
     }
 }
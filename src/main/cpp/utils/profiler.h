@@ -9,6 +9,7 @@
 #include <unordered_map>
 #include <string>
 #include <chrono>
+#include <mutex>
 #include <easylogging++.h>
 
 namespace nova {
@@ -21,17 +22,45 @@ namespace nova {
         std::chrono::high_resolution_clock::duration total_duration;
     };
 
+    /*!
+     * \brief A number that we want to keep track of, like how many bytes we uploaded this frame
+     */
+    struct profiler_stat {
+        long long last_value = 0;
+        long long total = 0;
+        long long num_samples = 0;
+    };
+
     /*!
      * \brief A simple namespace to hold profiling functions
+     *
+     * Both the game thread and the render thread profile things, so every function locks the profiler. A section
+     * should only ever be started and ended by one thread, though
      */
     class profiler {
     public:
         static void start(std::string name);
         static void end(std::string name);
+
+        /*!
+         * \brief Records one sample of the stat with the given name
+         *
+         * \param name The name of the stat
+         * \param value The value of the stat for this sample, e.g. this frame
+         */
+        static void record_stat(std::string name, long long value);
+
+        /*!
+         * \brief Returns everything we know about the stat with the given name
+         */
+        static profiler_stat get_stat(std::string name);
+
         static void log_all_profiler_data();
 
     private:
         static std::unordered_map<std::string, profiler_data> data;
+        static std::unordered_map<std::string, profiler_stat> stats;
+        static std::mutex profiler_lock;
     };
 }
 
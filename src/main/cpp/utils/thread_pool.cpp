@@ -0,0 +1,94 @@
+/*!
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#include <algorithm>
+#include "thread_pool.h"
+
+namespace nova {
+    thread_pool::thread_pool(std::size_t num_threads) {
+        if(num_threads == 0) {
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        workers.reserve(num_threads);
+        for(std::size_t i = 0; i < num_threads; i++) {
+            workers.emplace_back(&thread_pool::run_worker, this);
+        }
+    }
+
+    thread_pool::~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(queue_lock);
+            stopping = true;
+        }
+        task_available.notify_all();
+
+        for(auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void thread_pool::parallel_for(std::size_t begin, std::size_t end, std::size_t grain_size, const std::function<void(std::size_t, std::size_t)> &body) {
+        if(begin >= end) {
+            return;
+        }
+
+        grain_size = std::max<std::size_t>(grain_size, 1);
+
+        std::vector<std::future<void>> chunks;
+        std::size_t first_chunk_end = std::min(begin + grain_size, end);
+        for(std::size_t chunk_begin = first_chunk_end; chunk_begin < end; chunk_begin += grain_size) {
+            std::size_t chunk_end = std::min(chunk_begin + grain_size, end);
+            chunks.push_back(submit([&body, chunk_begin, chunk_end]() { body(chunk_begin, chunk_end); }));
+        }
+
+        // The calling thread would just be sitting around otherwise, so it gets the first chunk
+        std::exception_ptr first_exception;
+        try {
+            body(begin, first_chunk_end);
+        } catch(...) {
+            first_exception = std::current_exception();
+        }
+
+        // Every chunk has to finish before we return, since they all reference body
+        for(auto& chunk : chunks) {
+            try {
+                chunk.get();
+            } catch(...) {
+                if(!first_exception) {
+                    first_exception = std::current_exception();
+                }
+            }
+        }
+
+        if(first_exception) {
+            std::rethrow_exception(first_exception);
+        }
+    }
+
+    std::size_t thread_pool::get_num_threads() const {
+        return workers.size();
+    }
+
+    void thread_pool::run_worker() {
+        while(true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(queue_lock);
+                task_available.wait(lock, [&] { return stopping || !tasks.empty(); });
+
+                if(tasks.empty()) {
+                    // Only happens when we're stopping and there's nothing left to do
+                    return;
+                }
+
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+
+            task();
+        }
+    }
+}
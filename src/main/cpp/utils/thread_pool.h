@@ -0,0 +1,89 @@
+/*!
+ * \brief A fixed-size pool of worker threads, for CPU work that splits up nicely
+ *
+ * \author ddubois
+ * \date 18-Oct-26.
+ */
+
+#ifndef RENDERER_THREAD_POOL_H
+#define RENDERER_THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace nova {
+    /*!
+     * \brief Runs tasks on a handful of threads that are started once and kept around
+     *
+     * Don't call parallel_for or wait on a future from inside one of the pool's own tasks. If every worker is waiting
+     * on work that's stuck in the queue behind it, nothing will ever finish
+     */
+    class thread_pool {
+    public:
+        /*!
+         * \param num_threads How many workers to start. Zero means one per hardware thread
+         */
+        explicit thread_pool(std::size_t num_threads = 0);
+
+        /*!
+         * \brief Finishes every task that's already been submitted, then stops the workers
+         */
+        ~thread_pool();
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        /*!
+         * \brief Queues up a task to run on one of the workers
+         *
+         * \return A future that gets the task's return value, or the exception it threw
+         */
+        template <typename Task>
+        std::future<typename std::result_of<Task()>::type> submit(Task&& task) {
+            using result_type = typename std::result_of<Task()>::type;
+
+            // std::function needs something copyable, and a packaged_task isn't
+            auto packaged = std::make_shared<std::packaged_task<result_type()>>(std::forward<Task>(task));
+            auto future = packaged->get_future();
+
+            {
+                std::lock_guard<std::mutex> lock(queue_lock);
+                tasks.push([packaged]() { (*packaged)(); });
+            }
+            task_available.notify_one();
+
+            return future;
+        }
+
+        /*!
+         * \brief Splits [begin, end) into chunks of about grain_size items and runs body on each chunk, using the
+         * calling thread as well as the workers. Returns once every chunk is done
+         *
+         * If any chunk throws, the first exception is rethrown here after every chunk has finished
+         *
+         * \param body Called with the start and end of each chunk
+         */
+        void parallel_for(std::size_t begin, std::size_t end, std::size_t grain_size, const std::function<void(std::size_t, std::size_t)> &body);
+
+        std::size_t get_num_threads() const;
+
+    private:
+        std::vector<std::thread> workers;
+
+        std::mutex queue_lock;
+        std::condition_variable task_available;
+        std::queue<std::function<void()>> tasks;
+        bool stopping = false;
+
+        void run_worker();
+    };
+}
+
+#endif //RENDERER_THREAD_POOL_H
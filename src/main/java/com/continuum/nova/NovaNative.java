@@ -231,6 +231,33 @@ public interface NovaNative extends Library {
         }
     }
 
+    class shaderpack_loading_status extends Structure implements Structure.ByValue {
+        public int is_loading;
+        public int num_shaders;
+        public int num_shaders_done;
+
+        @Override
+        protected List<String> getFieldOrder() {
+            return Arrays.asList("is_loading", "num_shaders", "num_shaders_done");
+        }
+    }
+
+    /**
+     * One block or other thing for classify_geometry to sort into shaders. Make arrays of these with toArray, so that
+     * they're next to each other in memory
+     */
+    class mc_geometry_attributes extends Structure {
+        public String name;
+        public int type;
+        public int is_transparent;
+        public int is_emissive;
+
+        @Override
+        protected List<String> getFieldOrder() {
+            return Arrays.asList("name", "type", "is_transparent", "is_emissive");
+        }
+    }
+
     enum GeometryType {
         BLOCK,
         ENTITY,
@@ -261,6 +288,10 @@ public interface NovaNative extends Library {
 
     void add_texture(mc_atlas_texture texture);
 
+    void add_sprite(mc_atlas_texture sprite);
+
+    void finalize_textures();
+
     void add_texture_location(mc_texture_atlas_location location);
 
     int get_max_texture_size();
@@ -300,4 +331,8 @@ public interface NovaNative extends Library {
     void set_player_camera_transform(double x, double y, double z, float yaw, float pitch);
 
     String get_shaders_and_filters();
+
+    shaderpack_loading_status get_shaderpack_loading_status();
+
+    int classify_geometry(mc_geometry_attributes[] items, int num_items, long[] matches, int max_filters);
 }